@@ -455,59 +455,63 @@ public class GameClient : IGameClient, IAsyncDisposable
                 continue;
             }
 
-            var line = Encoding.UTF8.GetString(result.Buffer).TrimEnd('\n', '\r');
-            AppServices.Logger.Info($"RX: {line}");
-            if (string.IsNullOrWhiteSpace(line))
+            // Server může v jednom datagramu poslat víc zpráv (každá končí \n)
+            foreach (var rawLine in Encoding.UTF8.GetString(result.Buffer).Split('\n'))
             {
-                continue;
-            }
+                var line = rawLine.TrimEnd('\r');
+                if (string.IsNullOrWhiteSpace(line))
+                {
+                    continue;
+                }
+                AppServices.Logger.Info($"RX: {line}");
 
-            var msg = ParseMessage(line);
-            if (msg == null)
-            {
-                RegisterInvalidServerMessage("PARSE_ERROR");
-                continue;
-            }
+                var msg = ParseMessage(line);
+                if (msg == null)
+                {
+                    RegisterInvalidServerMessage("PARSE_ERROR");
+                    continue;
+                }
 
-            if (!IsServerMessageValid(msg))
-            {
-                if (msg.Type == "GAME_STATE")
+                if (!IsServerMessageValid(msg))
                 {
-                    RequestGameStateResyncIfNeeded("INVALID_GAME_STATE");
+                    if (msg.Type == "GAME_STATE")
+                    {
+                        RequestGameStateResyncIfNeeded("INVALID_GAME_STATE");
+                    }
+                    RegisterInvalidServerMessage("INVALID_MESSAGE");
+                    continue;
                 }
-                RegisterInvalidServerMessage("INVALID_MESSAGE");
-                continue;
-            }
 
-            if (!IsMessageAllowedByPhase(msg))
-            {
-                RegisterInvalidServerMessage("UNEXPECTED_PHASE");
-                continue;
-            }
+                if (!IsMessageAllowedByPhase(msg))
+                {
+                    RegisterInvalidServerMessage("UNEXPECTED_PHASE");
+                    continue;
+                }
 
-            var hasPending = _pending.TryGetValue(msg.Id, out var pending);
-            var isPushType = IsPushType(msg.Type) || (msg.Type == "ERROR" && msg.Id == 0);
-            var allowedForPending = hasPending && pending!.IsAllowedResponseType(msg.Type);
+                var hasPending = _pending.TryGetValue(msg.Id, out var pending);
+                var isPushType = IsPushType(msg.Type) || (msg.Type == "ERROR" && msg.Id == 0);
+                var allowedForPending = hasPending && pending!.IsAllowedResponseType(msg.Type);
 
-            if (!hasPending && !isPushType)
-            {
-                RegisterInvalidServerMessage("UNEXPECTED_ID");
-                continue;
-            }
-            if (hasPending && !allowedForPending && !isPushType)
-            {
-                RegisterInvalidServerMessage("UNEXPECTED_RESPONSE");
-                continue;
-            }
+                if (!hasPending && !isPushType)
+                {
+                    RegisterInvalidServerMessage("UNEXPECTED_ID");
+                    continue;
+                }
+                if (hasPending && !allowedForPending && !isPushType)
+                {
+                    RegisterInvalidServerMessage("UNEXPECTED_RESPONSE");
+                    continue;
+                }
 
-            DispatchPush(msg);
+                DispatchPush(msg);
 
-            if (hasPending && allowedForPending)
-            {
-                pending!.Handle(msg);
-                if (pending.IsTerminal)
+                if (hasPending && allowedForPending)
                 {
-                    _pending.TryRemove(msg.Id, out _);
+                    pending!.Handle(msg);
+                    if (pending.IsTerminal)
+                    {
+                        _pending.TryRemove(msg.Id, out _);
+                    }
                 }
             }
         }
@@ -0,0 +1,84 @@
+#include "accounts.hpp"
+
+#include <algorithm>
+
+#include "binio.hpp"
+
+namespace {
+
+constexpr std::uint8_t ACCOUNT_VERSION = 1;
+constexpr std::size_t ACCOUNT_SIZE = 1 + 8 + 8 + 8 + 4 + 5 * 4;
+const std::string ACCOUNT_PREFIX = "account/";
+
+} // namespace
+
+std::string encodeAccount(const Account& account) {
+    std::string out;
+    out.reserve(ACCOUNT_SIZE);
+    out.push_back(static_cast<char>(ACCOUNT_VERSION));
+    putU64(out, account.id);
+    putU64(out, static_cast<std::uint64_t>(account.createdMs));
+    putU64(out, static_cast<std::uint64_t>(account.lastLoginMs));
+    putU32(out, account.logins);
+    for (int v : {account.rating.rating, account.rating.games, account.rating.wins,
+                  account.rating.losses, account.rating.draws}) {
+        putU32(out, static_cast<std::uint32_t>(v));
+    }
+    return out;
+}
+
+std::optional<Account> decodeAccount(const std::string& bytes) {
+    if (bytes.size() < ACCOUNT_SIZE || static_cast<std::uint8_t>(bytes[0]) != ACCOUNT_VERSION) return std::nullopt;
+    const auto* p = reinterpret_cast<const std::uint8_t*>(bytes.data());
+    Account account;
+    account.id = readLittleEndian(p + 1, 8);
+    account.createdMs = static_cast<std::int64_t>(readLittleEndian(p + 9, 8));
+    account.lastLoginMs = static_cast<std::int64_t>(readLittleEndian(p + 17, 8));
+    account.logins = static_cast<std::uint32_t>(readLittleEndian(p + 25, 4));
+    int* fields[] = {&account.rating.rating, &account.rating.games, &account.rating.wins,
+                     &account.rating.losses, &account.rating.draws};
+    for (std::size_t i = 0; i < 5; ++i) {
+        *fields[i] = static_cast<int>(readLittleEndian(p + 29 + 4 * i, 4));
+    }
+    return account;
+}
+
+std::unique_ptr<AccountStore> AccountStore::open(const std::string& path, std::string& error) {
+    std::unique_ptr<AccountStore> accounts(new AccountStore());
+    if (!accounts->store.open(path, error)) return nullptr;
+    for (const auto& [key, value] : accounts->store.entries()) {
+        if (key.rfind(ACCOUNT_PREFIX, 0) != 0) continue;
+        if (auto account = decodeAccount(value)) {
+            accounts->nextId = std::max(accounts->nextId, account->id + 1);
+        }
+    }
+    return accounts;
+}
+
+std::optional<Account> AccountStore::find(const std::string& nick) const {
+    const std::string* value = store.get(ACCOUNT_PREFIX + nick);
+    return value ? decodeAccount(*value) : std::nullopt;
+}
+
+Account AccountStore::login(const std::string& nick, std::int64_t nowMs) {
+    Account account = find(nick).value_or(Account{});
+    if (account.id == 0) {
+        account.id = nextId++;
+        account.createdMs = nowMs;
+    }
+    account.lastLoginMs = nowMs;
+    ++account.logins;
+    save(nick, account);
+    return account;
+}
+
+void AccountStore::saveRating(const std::string& nick, const PlayerRating& rating) {
+    Account account = find(nick).value_or(Account{});
+    if (account.id == 0) account.id = nextId++;
+    account.rating = rating;
+    save(nick, account);
+}
+
+void AccountStore::save(const std::string& nick, const Account& account) {
+    store.put(ACCOUNT_PREFIX + nick, encodeAccount(account));
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "kvstore.hpp"
+#include "rating.hpp"
+
+// Účty hráčů (dama_server --accounts FILE): stálé číslo účtu, přihlášení a hodnocení
+// se statistikou partií podle přezdívky, uložené v KvStore pod klíčem "account/<nick>".
+// Čte se jen z paměti (LOGIN), zápisy jdou na disk na pozadí.
+
+struct Account {
+    std::uint64_t id = 0;
+    std::int64_t createdMs = 0;   // unix ms
+    std::int64_t lastLoginMs = 0;
+    std::uint32_t logins = 0;
+    PlayerRating rating;
+};
+
+std::string encodeAccount(const Account& account);
+std::optional<Account> decodeAccount(const std::string& bytes);
+
+class AccountStore {
+public:
+    static std::unique_ptr<AccountStore> open(const std::string& path, std::string& error);
+
+    std::optional<Account> find(const std::string& nick) const;
+
+    // LOGIN: první přihlášení účet založí, další jen zapíše čas
+    Account login(const std::string& nick, std::int64_t nowMs);
+
+    // Hodnocení po partii (RatingTable); hráči bez účtu se účet založí
+    void saveRating(const std::string& nick, const PlayerRating& rating);
+
+    std::size_t size() const { return store.size(); }
+    void flush() { store.flush(); }
+    const KvStore& kv() const { return store; }
+
+private:
+    AccountStore() = default;
+    void save(const std::string& nick, const Account& account);
+
+    KvStore store;
+    std::uint64_t nextId = 1;
+};
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "ring.hpp"
+#include "runtime.hpp"
+
+// Pool vláken s afinitou ke stolům: každý stůl má jednoho workera a všechny jeho
+// úlohy jdou na něj, takže stav, který si worker mezi úlohami drží (u bota
+// transpoziční tabulka z minulých tahů téže partie), zůstává v cache jeho jádra.
+// Afinitu mají jen úlohy; stůl sám (deska, hráči, hodiny) i jeho handlery zůstávají
+// na herním vlákně (viz pipeline.hpp).
+//
+// Úlohy a výsledky tečou přes SpscRing mezi herním vláknem a každým workerem
+// (herní vlákno je jediný zapisovatel úloh i jediný čtenář výsledků). Worker spí na
+// atomickém čítači (std::atomic::wait), herní vlákno budí wakeFd() jako JobPool.
+//
+// Přiřazení: nový stůl dostane worker s nejméně rozpracovanými úlohami (při shodě ten
+// s méně stoly). Když má vlastník stolu o AFFINITY_POOL_MIGRATE_BACKLOG rozpracovaných
+// úloh víc než nejméně vytížený worker a stůl sám nic rozpracovaného nemá, stůl se přestěhuje
+// (ztratí tím teplou cache, proto až od rozdílu 2). Stoly bez úlohy déle než
+// AFFINITY_POOL_FORGET_MS se z přiřazení zapomenou.
+//
+// Job musí mít roomId, Result job.roomId. threads == 0 je synchronní režim jako
+// v JobPool: úlohy se spočítají až v takeResults() na volajícím vlákně (simulace).
+
+constexpr std::size_t AFFINITY_POOL_RING_SLOTS = 256;
+constexpr std::size_t AFFINITY_POOL_MIGRATE_BACKLOG = 2;
+constexpr int AFFINITY_POOL_FORGET_MS = 60000;
+constexpr int AFFINITY_POOL_STATS_MS = 10000;
+
+struct AffinityWorkerStats {
+    std::size_t rooms = 0;    // přiřazené stoly
+    std::size_t inFlight = 0; // zadané a nevyzvednuté úlohy
+    std::uint64_t jobs = 0;   // dokončené úlohy
+    std::uint64_t busyNs = 0; // čas ve výpočtu
+    std::uint64_t migratedIn = 0;
+};
+
+template <class Job, class Result>
+class AffinityPool {
+public:
+    // run(job, useTimeBudget, worker): false v synchronním režimu (worker 0)
+    using RunFn = std::function<Result(const Job&, bool, int)>;
+
+    // pinCores: worker i na i-té povolené jádro (sched_getaffinity), jinak plánuje jádro OS
+    AffinityPool(int threads, RunFn run, bool pinCores = false) : run(std::move(run)) {
+        if (threads <= 0) {
+            return;
+        }
+        int fds[2];
+        if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0) {
+            wakeRead = fds[0];
+            wakeWrite = fds[1];
+        } else {
+            perror("pipe2 affinity pool");
+        }
+        std::vector<int> cpus;
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (pinCores && sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+            }
+        }
+        for (int i = 0; i < threads; ++i) {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        lastBusyNs.assign(workers.size(), 0);
+        for (int i = 0; i < threads; ++i) {
+            workers[static_cast<std::size_t>(i)]->thread = std::thread([this, i]() { workerLoop(i); });
+            if (!cpus.empty()) {
+                cpu_set_t one;
+                CPU_ZERO(&one);
+                CPU_SET(cpus[static_cast<std::size_t>(i) % cpus.size()], &one);
+                if (pthread_setaffinity_np(workers[static_cast<std::size_t>(i)]->thread.native_handle(), sizeof(one), &one) != 0) {
+                    std::cerr << "[WARN] Cannot pin room worker " << i << std::endl;
+                }
+            }
+        }
+    }
+
+    ~AffinityPool() {
+        stopping = true;
+        for (auto& w : workers) {
+            w->signal.fetch_add(1, std::memory_order_release);
+            w->signal.notify_one();
+        }
+        for (auto& w : workers) {
+            w->thread.join();
+        }
+        if (wakeRead >= 0) close(wakeRead);
+        if (wakeWrite >= 0) close(wakeWrite);
+    }
+
+    AffinityPool(const AffinityPool&) = delete;
+    AffinityPool& operator=(const AffinityPool&) = delete;
+
+    void submit(Job job) {
+        ++submitted;
+        if (workers.empty()) {
+            syncJobs.push_back(std::move(job));
+            return;
+        }
+        int index = route(job.roomId);
+        Worker& w = *workers[static_cast<std::size_t>(index)];
+        ++w.inFlight;
+        w.overflow.push_back(std::move(job));
+        pushOverflow(w);
+    }
+
+    std::vector<Result> takeResults() {
+        std::vector<Result> out;
+        if (workers.empty()) {
+            // synchronní režim: spočítat hned, deterministicky
+            std::deque<Job> pending;
+            pending.swap(syncJobs);
+            for (const auto& job : pending) {
+                out.push_back(run(job, false, 0));
+            }
+            taken += out.size();
+            return out;
+        }
+
+        if (wakeRead >= 0) {
+            char drain[64];
+            while (read(wakeRead, drain, sizeof(drain)) > 0) {
+            }
+        }
+        for (auto& wp : workers) {
+            Worker& w = *wp;
+            for (std::size_t ready = w.results.ready(); ready > 0; ready = w.results.ready()) {
+                for (std::size_t i = 0; i < ready; ++i) {
+                    Result& result = w.results.readyAt(i);
+                    auto it = assignment.find(result.job.roomId);
+                    if (it != assignment.end() && it->second.pending > 0) --it->second.pending;
+                    out.push_back(std::move(result));
+                }
+                w.results.release(ready);
+                w.inFlight -= ready;
+            }
+            pushOverflow(w); // místo uvolněné workerem
+        }
+        taken += out.size();
+        return out;
+    }
+
+    // Úlohy zadané a ještě nevyzvednuté (ve frontě, počítané i hotové)
+    std::size_t backlog() const { return submitted - taken; }
+
+    int wakeFd() const { return wakeRead; }
+    int workerCount() const { return static_cast<int>(workers.size()); }
+    // Worker, kterému stůl patří; -1 = žádný
+    int workerOf(int roomId) const {
+        auto it = assignment.find(roomId);
+        return it == assignment.end() ? -1 : it->second.worker;
+    }
+    std::uint64_t migrations() const { return migrationCount; }
+
+    std::vector<AffinityWorkerStats> workerStats() const {
+        std::vector<AffinityWorkerStats> out(workers.size());
+        for (std::size_t i = 0; i < workers.size(); ++i) {
+            out[i].inFlight = workers[i]->inFlight;
+            out[i].jobs = workers[i]->done.load(std::memory_order_relaxed);
+            out[i].busyNs = workers[i]->busyNs.load(std::memory_order_relaxed);
+            out[i].migratedIn = workers[i]->migratedIn;
+            out[i].rooms = workers[i]->rooms;
+        }
+        return out;
+    }
+
+    // Jednou za AFFINITY_POOL_STATS_MS: zapomene nečinné stoly a vypíše vytížení workerů,
+    // když od minula nějaká úloha skončila
+    void logStats(const char* name, std::chrono::steady_clock::time_point now) {
+        if (workers.empty()) return;
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastStats).count();
+        if (elapsedMs < AFFINITY_POOL_STATS_MS) return;
+        for (auto it = assignment.begin(); it != assignment.end();) {
+            bool idle = it->second.pending == 0 &&
+                        std::chrono::duration_cast<std::chrono::milliseconds>(now - it->second.lastJob).count() > AFFINITY_POOL_FORGET_MS;
+            if (!idle) {
+                ++it;
+                continue;
+            }
+            --workers[static_cast<std::size_t>(it->second.worker)]->rooms;
+            it = assignment.erase(it);
+        }
+        auto stats = workerStats();
+        std::uint64_t jobs = 0;
+        for (const auto& s : stats) jobs += s.jobs;
+        bool first = lastStats == std::chrono::steady_clock::time_point{};
+        lastStats = now;
+        if (jobs == lastJobs) return;
+        lastJobs = jobs;
+        std::cout << "[INFO] " << name << " workers=" << stats.size() << " rooms=" << assignment.size()
+                  << " jobs=" << jobs << " migrations=" << migrationCount;
+        for (std::size_t i = 0; i < stats.size(); ++i) {
+            std::uint64_t busyDelta = stats[i].busyNs - lastBusyNs[i];
+            lastBusyNs[i] = stats[i].busyNs;
+            std::cout << " | w" << i << " rooms=" << stats[i].rooms << " queue=" << stats[i].inFlight
+                      << " jobs=" << stats[i].jobs;
+            if (!first) std::cout << " busy=" << busyDelta / 10000 / static_cast<std::uint64_t>(elapsedMs) << "%";
+        }
+        std::cout << std::endl;
+    }
+
+private:
+    struct Worker {
+        SpscRing<Job> jobs{AFFINITY_POOL_RING_SLOTS};       // herní vlákno -> worker
+        SpscRing<Result> results{AFFINITY_POOL_RING_SLOTS}; // worker -> herní vlákno
+        std::atomic<std::uint32_t> signal{0};
+        std::atomic<std::uint64_t> done{0};
+        std::atomic<std::uint64_t> busyNs{0};
+        // jen herní vlákno:
+        std::deque<Job> overflow; // čeká na místo v jobs (pořadí zachované)
+        std::size_t inFlight = 0;
+        std::size_t rooms = 0;
+        std::uint64_t migratedIn = 0;
+        std::thread thread;
+    };
+
+    struct Assignment {
+        int worker = 0;
+        std::size_t pending = 0;
+        std::chrono::steady_clock::time_point lastJob{};
+    };
+
+    int route(int roomId) {
+        int least = 0;
+        for (int i = 1; i < workerCount(); ++i) {
+            const Worker& a = *workers[static_cast<std::size_t>(i)];
+            const Worker& b = *workers[static_cast<std::size_t>(least)];
+            if (a.inFlight < b.inFlight || (a.inFlight == b.inFlight && a.rooms < b.rooms)) least = i;
+        }
+        auto [it, inserted] = assignment.try_emplace(roomId);
+        Assignment& a = it->second;
+        if (inserted) {
+            a.worker = least;
+            ++workers[static_cast<std::size_t>(least)]->rooms;
+        } else if (a.pending == 0 && a.worker != least &&
+                   workers[static_cast<std::size_t>(a.worker)]->inFlight >=
+                       workers[static_cast<std::size_t>(least)]->inFlight + AFFINITY_POOL_MIGRATE_BACKLOG) {
+            --workers[static_cast<std::size_t>(a.worker)]->rooms;
+            a.worker = least;
+            ++workers[static_cast<std::size_t>(least)]->rooms;
+            ++workers[static_cast<std::size_t>(least)]->migratedIn;
+            ++migrationCount;
+        }
+        ++a.pending;
+        a.lastJob = steadyNow();
+        return a.worker;
+    }
+
+    void pushOverflow(Worker& w) {
+        std::size_t pushed = 0;
+        while (!w.overflow.empty() && w.jobs.freeSlots() > pushed) {
+            w.jobs.freeAt(pushed++) = std::move(w.overflow.front());
+            w.overflow.pop_front();
+        }
+        if (pushed == 0) return;
+        w.jobs.publish(pushed);
+        w.signal.fetch_add(1, std::memory_order_release);
+        w.signal.notify_one();
+    }
+
+    void workerLoop(int index) {
+        Worker& w = *workers[static_cast<std::size_t>(index)];
+        while (true) {
+            std::uint32_t seen = w.signal.load(std::memory_order_acquire);
+            if (stopping) return;
+            if (w.jobs.ready() == 0) {
+                w.signal.wait(seen, std::memory_order_acquire);
+                continue;
+            }
+            auto started = std::chrono::steady_clock::now();
+            Result result = run(w.jobs.readyAt(0), true, index);
+            w.busyNs.fetch_add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - started).count()),
+                               std::memory_order_relaxed);
+            // plný kruh výsledků: počkat, až je herní vlákno vyzvedne (takeResults)
+            while (w.results.freeSlots() == 0) {
+                if (stopping) return;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            w.results.freeAt(0) = std::move(result);
+            w.results.publish();
+            w.jobs.release();
+            w.done.fetch_add(1, std::memory_order_relaxed);
+            if (wakeWrite >= 0) {
+                char byte = 1;
+                ssize_t ignored = write(wakeWrite, &byte, 1);
+                (void)ignored;
+            }
+        }
+    }
+
+    RunFn run;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::unordered_map<int, Assignment> assignment; // jen herní vlákno
+    std::deque<Job> syncJobs;                       // synchronní režim
+    std::size_t submitted = 0;
+    std::size_t taken = 0;
+    std::uint64_t migrationCount = 0;
+    std::atomic<bool> stopping{false};
+    int wakeRead = -1;
+    int wakeWrite = -1;
+    std::chrono::steady_clock::time_point lastStats{};
+    std::uint64_t lastJobs = 0;
+    std::vector<std::uint64_t> lastBusyNs;
+};
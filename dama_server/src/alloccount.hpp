@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Počítadla alokací pro dama_replay a rules_test. Nahrazuje globální operator new
+// i delete ve všech tvarech (obyčejný, pole, s velikostí, zarovnaný, nothrow), aby
+// každá alokace skončila ve stejném alokátoru. Definice nejsou inline: hlavičku
+// vkládá jen jeden soubor programu (ten s main).
+
+std::atomic<std::uint64_t> allocationCount{0};
+std::atomic<std::uint64_t> allocatedBytes{0};
+
+namespace alloccount {
+
+void* allocate(std::size_t size, std::size_t align) noexcept {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) return std::malloc(size);
+    return std::aligned_alloc(align, (size + align - 1) / align * align); // velikost násobkem zarovnání
+}
+
+void* allocateOrThrow(std::size_t size, std::size_t align) {
+    if (void* p = allocate(size, align)) return p;
+    throw std::bad_alloc();
+}
+
+} // namespace alloccount
+
+void* operator new(std::size_t size) { return alloccount::allocateOrThrow(size, 0); }
+void* operator new[](std::size_t size) { return alloccount::allocateOrThrow(size, 0); }
+void* operator new(std::size_t size, std::align_val_t align) {
+    return alloccount::allocateOrThrow(size, static_cast<std::size_t>(align));
+}
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return alloccount::allocateOrThrow(size, static_cast<std::size_t>(align));
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return alloccount::allocate(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return alloccount::allocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return alloccount::allocate(size, static_cast<std::size_t>(align));
+}
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return alloccount::allocate(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
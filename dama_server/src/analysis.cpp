@@ -0,0 +1,51 @@
+#include "analysis.hpp"
+
+#include "rules.hpp"
+
+Room analysisPosition(const AnalysisJob& job) {
+    return makePosition(job.variant, job.board, job.turn, job.captureLock, job.maxCaptureRule);
+}
+
+AnalysisPool::AnalysisPool(int threads, std::size_t tableMegabytes, const TablebaseSet* tablebases,
+                           const OpeningBook* book)
+    : table(tableMegabytes),
+      tablebases(tablebases),
+      book(book),
+      pool(threads, [this](const AnalysisJob& job, bool useTimeBudget) {
+          SearchLimits limits = job.limits;
+          limits.scoreForcedMove = true; // rozbor chce skóre i u vynuceného tahu
+          if (!useTimeBudget) {
+              limits.timeBudgetMs = 0;
+          }
+          AnalysisResult result;
+          result.job = job;
+          result.search = searchBestMove(analysisPosition(job), limits, &table, this->tablebases);
+          return result;
+      }) {
+}
+
+std::optional<AnalysisResult> AnalysisPool::lookup(const AnalysisJob& job) {
+    Room position = analysisPosition(job);
+    std::optional<SearchResult> search;
+    if (tablebases) {
+        search = tablebaseResult(position, *tablebases);
+    }
+    if (!search && book) {
+        search = bookResult(position, *book);
+    }
+    if (!search) {
+        search = tableResult(position, job.limits.maxDepth, table);
+    }
+    if (!search) return std::nullopt;
+    AnalysisResult result;
+    result.job = job;
+    result.search = std::move(*search);
+    result.cached = true;
+    return result;
+}
+
+bool AnalysisPool::submit(AnalysisJob job) {
+    if (pool.backlog() >= ANALYSIS_QUEUE_LIMIT) return false;
+    pool.submit(std::move(job));
+    return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bot.hpp"
+#include "jobpool.hpp"
+#include "transposition.hpp"
+
+// Rozbor pozice na žádost hráče (ANALYZE): stejné hledání jako bot, ale se sdílenou
+// transpoziční tabulkou a na vlastním poolu, takže analýzy nezdrží tahy botů ani UDP smyčku.
+// Limity z požadavku server ořízne; plná fronta se odmítne místo čekání.
+
+constexpr int ANALYSIS_DEFAULT_DEPTH = 12;
+constexpr int ANALYSIS_MAX_DEPTH = 30;
+constexpr int ANALYSIS_DEFAULT_MS = 1000;
+constexpr int ANALYSIS_MAX_MS = 5000;
+constexpr std::uint64_t ANALYSIS_DEFAULT_NODES = 2000000;
+constexpr std::uint64_t ANALYSIS_MAX_NODES = 20000000;
+constexpr std::size_t ANALYSIS_QUEUE_LIMIT = 16; // rozborů ve frontě a ve výpočtu, pak SERVER_BUSY
+
+struct AnalysisJob {
+    int msgId = 0;
+    std::string playerToken; // komu poslat výsledek
+    Variant variant = Variant::CZECH;
+    std::string board;
+    Turn turn = Turn::NONE;
+    std::optional<std::pair<int, int>> captureLock;
+    bool maxCaptureRule = false;
+    SearchLimits limits;
+};
+
+struct AnalysisResult {
+    AnalysisJob job;
+    SearchResult search;
+    bool cached = false; // z tabulky, databáze koncovek nebo knihy bez hledání
+};
+
+// Pozice úlohy jako Room (deska, hash a počty kamenů spočítané od nuly)
+Room analysisPosition(const AnalysisJob& job);
+
+class AnalysisPool {
+public:
+    // threads == 0: synchronní režim jako BotPool (simulace); tablebases a book můžou být nullptr
+    AnalysisPool(int threads, std::size_t tableMegabytes, const TablebaseSet* tablebases = nullptr,
+                 const OpeningBook* book = nullptr);
+
+    // Pozice z databáze koncovek, z knihy zahájení nebo už prohledaná aspoň do požadované
+    // hloubky: výsledek hned
+    std::optional<AnalysisResult> lookup(const AnalysisJob& job);
+
+    // Zadá hledání; false = fronta je plná
+    bool submit(AnalysisJob job);
+
+    std::vector<AnalysisResult> takeResults() { return pool.takeResults(); }
+    std::size_t backlog() { return pool.backlog(); }
+    int wakeFd() const { return pool.wakeFd(); }
+
+private:
+    TranspositionTable table; // před pool: vlákna poolu ji používají a končí dřív
+    const TablebaseSet* tablebases = nullptr;
+    const OpeningBook* book = nullptr;
+    JobPool<AnalysisJob, AnalysisResult> pool;
+};
@@ -0,0 +1,391 @@
+#include "archive.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "binio.hpp"
+#include "rules.hpp"
+
+namespace {
+
+constexpr std::size_t RECORD_HEADER_SIZE = 16; // magic, délka dat, kontrolní součet, rezerva
+constexpr std::size_t PAYLOAD_FIXED_SIZE = 30; // id .. počet kroků, před řetězci
+constexpr std::size_t STEP_SIZE = 6;
+constexpr std::int64_t MS_PER_DAY = 86400000;
+
+std::string encodePayload(const ArchivedGame& game) {
+    std::string out;
+    putU64(out, game.id);
+    putU64(out, static_cast<std::uint64_t>(game.startedMs));
+    putU32(out, game.durationMs);
+    out.push_back(static_cast<char>(game.variant));
+    out.push_back(static_cast<char>(game.maxCaptureRule ? 1 : 0));
+    for (const std::string* s : {&game.reason, &game.winner, &game.white, &game.black}) {
+        out.push_back(static_cast<char>(std::min<std::size_t>(s->size(), 255)));
+    }
+    putU32(out, static_cast<std::uint32_t>(game.steps.size()));
+    for (const std::string* s : {&game.reason, &game.winner, &game.white, &game.black}) {
+        out.append(*s, 0, std::min<std::size_t>(s->size(), 255));
+    }
+    for (const GameStep& step : game.steps) {
+        out.push_back(static_cast<char>(step.fromSquare | (step.white ? 0x80 : 0)));
+        out.push_back(static_cast<char>(step.toSquare));
+        putU32(out, step.atMs);
+    }
+    return out;
+}
+
+// Záznam na začátku p (zbývá avail bajtů do konce segmentu); nullopt = není tu platný záznam
+std::optional<ArchivedGame> decodeRecord(const std::uint8_t* p, std::size_t avail, std::size_t& recordSize) {
+    if (avail < RECORD_HEADER_SIZE || readLittleEndian(p, 4) != ARCHIVE_RECORD_MAGIC) return std::nullopt;
+    std::size_t len = static_cast<std::size_t>(readLittleEndian(p + 4, 4));
+    if (len < PAYLOAD_FIXED_SIZE || len > avail - RECORD_HEADER_SIZE) return std::nullopt;
+    const std::uint8_t* d = p + RECORD_HEADER_SIZE;
+    if (checksum32(d, len) != readLittleEndian(p + 8, 4)) return std::nullopt;
+
+    ArchivedGame game;
+    game.id = readLittleEndian(d, 8);
+    game.startedMs = static_cast<std::int64_t>(readLittleEndian(d + 8, 8));
+    game.durationMs = static_cast<std::uint32_t>(readLittleEndian(d + 16, 4));
+    if (d[20] >= ALL_VARIANTS.size()) return std::nullopt;
+    game.variant = ALL_VARIANTS[d[20]];
+    game.maxCaptureRule = d[21] != 0;
+    std::size_t lengths[4] = {d[22], d[23], d[24], d[25]};
+    std::size_t steps = static_cast<std::size_t>(readLittleEndian(d + 26, 4));
+    std::size_t strings = lengths[0] + lengths[1] + lengths[2] + lengths[3];
+    if (PAYLOAD_FIXED_SIZE + strings + steps * STEP_SIZE != len) return std::nullopt;
+
+    const char* s = reinterpret_cast<const char*>(d + PAYLOAD_FIXED_SIZE);
+    std::string* fields[4] = {&game.reason, &game.winner, &game.white, &game.black};
+    for (int i = 0; i < 4; ++i) {
+        fields[i]->assign(s, lengths[i]);
+        s += lengths[i];
+    }
+    const std::uint8_t* st = d + PAYLOAD_FIXED_SIZE + strings;
+    game.steps.resize(steps);
+    for (std::size_t i = 0; i < steps; ++i, st += STEP_SIZE) {
+        game.steps[i].white = (st[0] & 0x80) != 0;
+        game.steps[i].fromSquare = st[0] & 0x7F;
+        game.steps[i].toSquare = st[1];
+        game.steps[i].atMs = static_cast<std::uint32_t>(readLittleEndian(st + 2, 4));
+    }
+    recordSize = RECORD_HEADER_SIZE + len;
+    return game;
+}
+
+std::string segmentPath(const std::string& dir, std::size_t index) {
+    // segment-000001.dga; víc než 6 číslic se nezkracuje
+    std::string number = std::to_string(index + 1);
+    if (number.size() < 6) number.insert(0, 6 - number.size(), '0');
+    return dir + "/segment-" + number + ".dga";
+}
+
+// Jméno pole v PDN: a1..h8 na 8x8, 1..50 na 10x10
+std::string pdnSquare(const Room& room, int square) {
+    int size = boardSize(room);
+    int row = square / MAX_BOARD_SIZE;
+    int col = square % MAX_BOARD_SIZE;
+    if (size == 10) {
+        return std::to_string(row * (size / 2) + col / 2 + 1);
+    }
+    return std::string(1, static_cast<char>('a' + col)) + std::to_string(size - row);
+}
+
+int pdnGameType(Variant variant) {
+    switch (variant) {
+        case Variant::RUSSIAN:       return 25;
+        case Variant::ITALIAN:       return 22;
+        case Variant::INTERNATIONAL: return 20;
+        default:                     return 29;
+    }
+}
+
+std::string pdnTag(const std::string& name, const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '"' || c == '\\') escaped.push_back('\\');
+        escaped.push_back(c);
+    }
+    return "[" + name + " \"" + escaped + "\"]\n";
+}
+
+} // namespace
+
+std::int64_t ArchivedGame::day() const {
+    std::int64_t d = startedMs / MS_PER_DAY;
+    return (startedMs % MS_PER_DAY < 0) ? d - 1 : d;
+}
+
+ArchivedGame archivedGameFromRoom(const Room& room, const std::string& reason, const std::string& winner) {
+    ArchivedGame game;
+    game.startedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         room.startedWall.time_since_epoch()).count();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(steadyNow() - room.startedAt).count();
+    game.durationMs = static_cast<std::uint32_t>(std::max<long long>(0, duration));
+    game.variant = room.variant;
+    game.maxCaptureRule = room.maxCaptureRule;
+    game.reason = reason;
+    game.winner = winner;
+    game.white = room.whiteNick;
+    game.black = room.blackNick;
+    game.steps = room.steps;
+    return game;
+}
+
+std::optional<std::int64_t> parseArchiveDay(const std::string& text) {
+    if (text.size() != 10 || text[4] != '-' || text[7] != '-') return std::nullopt;
+    for (std::size_t i : {0, 1, 2, 3, 5, 6, 8, 9}) {
+        if (text[i] < '0' || text[i] > '9') return std::nullopt;
+    }
+    std::chrono::year_month_day ymd{std::chrono::year{std::stoi(text.substr(0, 4))},
+                                    std::chrono::month{static_cast<unsigned>(std::stoi(text.substr(5, 2)))},
+                                    std::chrono::day{static_cast<unsigned>(std::stoi(text.substr(8, 2)))}};
+    if (!ymd.ok()) return std::nullopt;
+    return std::chrono::sys_days{ymd}.time_since_epoch().count();
+}
+
+std::string formatArchiveDay(std::int64_t day) {
+    std::chrono::year_month_day ymd{std::chrono::sys_days{std::chrono::days{day}}};
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "%04d-%02u-%02u", static_cast<int>(ymd.year()),
+                  static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()));
+    return buf;
+}
+
+bool replayArchivedGame(const ArchivedGame& game, std::size_t ply, Room& room) {
+    if (ply > game.steps.size()) return false;
+    copyPosition(room, makePosition(game.variant, createInitialBoard(game.variant), Turn::PLAYER1, std::nullopt,
+                                    game.maxCaptureRule));
+    for (std::size_t i = 0; i < ply; ++i) {
+        const GameStep& step = game.steps[i];
+        bool white = room.turn == Turn::PLAYER1;
+        MoveResult result;
+        if (step.white != white ||
+            !applyMove(room, white, step.fromSquare / MAX_BOARD_SIZE, step.fromSquare % MAX_BOARD_SIZE,
+                       step.toSquare / MAX_BOARD_SIZE, step.toSquare % MAX_BOARD_SIZE, result).empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string exportPdn(const ArchivedGame& game) {
+    std::string result = "*";
+    if (game.reason.rfind("DRAW_", 0) == 0) {
+        result = "1-1";
+    } else if (game.winner == "WHITE") {
+        result = "2-0";
+    } else if (game.winner == "BLACK") {
+        result = "0-2";
+    }
+
+    std::string date = formatArchiveDay(game.day());
+    std::replace(date.begin(), date.end(), '-', '.');
+    std::string out = pdnTag("Event", "dama_server game " + std::to_string(game.id)) +
+                      pdnTag("Date", date) +
+                      pdnTag("White", game.white) +
+                      pdnTag("Black", game.black) +
+                      pdnTag("Result", result) +
+                      pdnTag("GameType", std::to_string(pdnGameType(game.variant))) +
+                      pdnTag("Termination", game.reason) + "\n";
+
+    // kroky jednoho tahu (řetěz skoků) se spojí do "c3xe5xc7"
+    Room room;
+    if (!replayArchivedGame(game, 0, room)) return "";
+    std::string line;
+    std::string move;
+    int moveNumber = 1;
+    auto flush = [&](const std::string& token) {
+        if (!line.empty() && line.size() + 1 + token.size() > 79) {
+            out += line + "\n";
+            line.clear();
+        }
+        line += (line.empty() ? "" : " ") + token;
+    };
+    for (const GameStep& step : game.steps) {
+        bool white = room.turn == Turn::PLAYER1;
+        if (move.empty()) {
+            if (white) flush(std::to_string(moveNumber) + ".");
+            move = pdnSquare(room, step.fromSquare);
+        }
+        MoveResult hop;
+        if (step.white != white ||
+            !applyMove(room, white, step.fromSquare / MAX_BOARD_SIZE, step.fromSquare % MAX_BOARD_SIZE,
+                       step.toSquare / MAX_BOARD_SIZE, step.toSquare % MAX_BOARD_SIZE, hop).empty()) {
+            return "";
+        }
+        move += (hop.capture ? "x" : "-") + pdnSquare(room, step.toSquare);
+        if (!hop.captureContinues) {
+            flush(move);
+            move.clear();
+            if (!white) ++moveNumber;
+        }
+    }
+    if (!move.empty()) flush(move); // partie skončila uprostřed řetězu (timeout)
+    flush(result);
+    out += line + "\n";
+    return out;
+}
+
+std::unique_ptr<GameArchive> GameArchive::open(const std::string& dir, bool readOnly, std::string& error) {
+    if (!readOnly && ::mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        error = "cannot create " + dir + ": " + std::strerror(errno);
+        return nullptr;
+    }
+    std::unique_ptr<GameArchive> archive(new GameArchive());
+    archive->dir = dir;
+    archive->readOnly = readOnly;
+
+    struct stat st{};
+    for (std::size_t i = 0; ::stat(segmentPath(dir, i).c_str(), &st) == 0; ++i) {
+        if (!archive->mapSegment(i, false, error)) return nullptr;
+    }
+    if (archive->segments.empty()) {
+        if (readOnly) {
+            error = dir + ": no archive segments";
+            return nullptr;
+        }
+        if (!archive->mapSegment(0, true, error)) return nullptr;
+    }
+
+    // index z hlaviček; první neplatný záznam je konec segmentu (tam se bude dál psát)
+    for (std::size_t s = 0; s < archive->segments.size(); ++s) {
+        Segment& segment = archive->segments[s];
+        std::size_t offset = 0;
+        std::size_t size = 0;
+        while (auto game = decodeRecord(segment.data + offset, ARCHIVE_SEGMENT_BYTES - offset, size)) {
+            if (game->id != archive->locations.size() + 1) {
+                error = segmentPath(dir, s) + ": game " + std::to_string(game->id) + " out of order";
+                return nullptr;
+            }
+            archive->indexRecord(*game, Location{static_cast<std::uint32_t>(s), static_cast<std::uint32_t>(offset)});
+            offset += size;
+        }
+        segment.used = offset;
+    }
+    return archive;
+}
+
+GameArchive::~GameArchive() {
+    for (Segment& segment : segments) {
+        if (segment.data) munmap(segment.data, ARCHIVE_SEGMENT_BYTES);
+    }
+}
+
+bool GameArchive::mapSegment(std::size_t index, bool create, std::string& error) {
+    std::string path = segmentPath(dir, index);
+    int fd = ::open(path.c_str(), (readOnly ? O_RDONLY : O_RDWR) | (create ? O_CREAT | O_EXCL : 0) | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    // nový segment je řídký soubor plný nul; nula na místě magic = konec záznamů
+    if (create && ::ftruncate(fd, static_cast<off_t>(ARCHIVE_SEGMENT_BYTES)) != 0) {
+        error = "cannot size " + path + ": " + std::strerror(errno);
+        close(fd);
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) != ARCHIVE_SEGMENT_BYTES) {
+        error = path + ": not an archive segment";
+        close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, ARCHIVE_SEGMENT_BYTES, readOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        error = "cannot map " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    segments.push_back(Segment{static_cast<std::uint8_t*>(map), 0});
+    return true;
+}
+
+void GameArchive::indexRecord(const ArchivedGame& game, Location where) {
+    locations.push_back(where);
+    byPlayer[game.white].push_back(game.id);
+    if (game.black != game.white) byPlayer[game.black].push_back(game.id);
+    byDay[game.day()].push_back(game.id);
+}
+
+std::optional<std::uint64_t> GameArchive::append(ArchivedGame game, std::string& error) {
+    if (readOnly) {
+        error = dir + " opened read-only";
+        return std::nullopt;
+    }
+    game.id = locations.size() + 1;
+    std::string payload = encodePayload(game);
+    std::size_t size = RECORD_HEADER_SIZE + payload.size();
+    if (size > ARCHIVE_SEGMENT_BYTES) {
+        error = "game " + std::to_string(game.id) + " does not fit a segment";
+        return std::nullopt;
+    }
+    if (segments.back().used + size > ARCHIVE_SEGMENT_BYTES && !mapSegment(segments.size(), true, error)) {
+        return std::nullopt;
+    }
+
+    Segment& segment = segments.back();
+    std::uint8_t* p = segment.data + segment.used;
+    std::memset(p, 0, RECORD_HEADER_SIZE); // zbytek useknutého záznamu po pádu
+    std::memcpy(p + RECORD_HEADER_SIZE, payload.data(), payload.size());
+    std::string header;
+    putU32(header, ARCHIVE_RECORD_MAGIC);
+    putU32(header, static_cast<std::uint32_t>(payload.size()));
+    putU32(header, checksum32(p + RECORD_HEADER_SIZE, payload.size()));
+    putU32(header, 0);
+    std::memcpy(p + 4, header.data() + 4, RECORD_HEADER_SIZE - 4);
+    std::memcpy(p, header.data(), 4); // magic až nakonec
+
+    indexRecord(game, Location{static_cast<std::uint32_t>(segments.size() - 1), static_cast<std::uint32_t>(segment.used)});
+    segment.used += size;
+    return game.id;
+}
+
+void GameArchive::gameFinished(const Room& room, const std::string& reason, const std::string& winner) {
+    std::string error;
+    auto id = append(archivedGameFromRoom(room, reason, winner), error);
+    if (!id) {
+        std::cout << "[WARN] ARCHIVE room=" << room.id << " failed: " << error << std::endl;
+        return;
+    }
+    std::cout << "[INFO] ARCHIVE room=" << room.id << " game=" << *id << " steps=" << room.steps.size() << std::endl;
+}
+
+std::optional<ArchivedGame> GameArchive::read(std::uint64_t id) const {
+    if (id == 0 || id > locations.size()) return std::nullopt;
+    const Location& where = locations[id - 1];
+    std::size_t size = 0;
+    return decodeRecord(segments[where.segment].data + where.offset, ARCHIVE_SEGMENT_BYTES - where.offset, size);
+}
+
+namespace {
+
+std::vector<std::uint64_t> newestFirst(const std::vector<std::uint64_t>& ids, std::uint64_t before, std::size_t limit) {
+    std::vector<std::uint64_t> out;
+    auto end = before == 0 ? ids.end() : std::lower_bound(ids.begin(), ids.end(), before);
+    for (auto it = end; it != ids.begin() && out.size() < limit;) {
+        out.push_back(*--it);
+    }
+    return out;
+}
+
+} // namespace
+
+std::vector<std::uint64_t> GameArchive::gamesOf(const std::string& nick, std::uint64_t before, std::size_t limit) const {
+    auto it = byPlayer.find(nick);
+    return it == byPlayer.end() ? std::vector<std::uint64_t>{} : newestFirst(it->second, before, limit);
+}
+
+std::vector<std::uint64_t> GameArchive::gamesOn(std::int64_t day, std::uint64_t before, std::size_t limit) const {
+    auto it = byDay.find(day);
+    return it == byDay.end() ? std::vector<std::uint64_t>{} : newestFirst(it->second, before, limit);
+}
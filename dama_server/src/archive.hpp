@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "models.hpp"
+#include "runtime.hpp"
+
+// Archiv dohraných partií. Partie se zapisují za sebou do segmentů pevné velikosti
+// (<dir>/segment-NNNNNN.dga, ARCHIVE_SEGMENT_BYTES, namapované přes mmap); nový segment
+// se založí, až se záznam do posledního nevejde. Index (id -> segment a offset, hráč,
+// den) drží archiv v paměti a při otevření ho sestaví z hlaviček záznamů, takže čtení
+// partie je jeden skok do namapovaného segmentu bez procházení archivu.
+//
+// Záznam: hlavička (ARCHIVE_RECORD_MAGIC, délka dat, kontrolní součet, rezerva; 4 × u32)
+// a data: id, začátek (unix ms), délka partie, varianta, pravidlo skoku, důvod konce,
+// vítěz, přezdívky hráčů a kroky po 6 bajtech (odkud | 0x80 za bílého, kam, ms od začátku).
+// Magic se zapisuje až po datech, takže záznam useknutý pádem serveru se při otevření
+// ignoruje a přepíše.
+
+constexpr std::size_t ARCHIVE_SEGMENT_BYTES = 4u << 20;
+constexpr std::uint32_t ARCHIVE_RECORD_MAGIC = 0x31414744; // "DGA1"
+constexpr int REPLAY_BATCH = 16;      // pozic na jeden REPLAY
+constexpr int GAMES_LIST_LIMIT = 50;  // id na jednu odpověď GAMES
+
+struct ArchivedGame {
+    std::uint64_t id = 0;
+    std::int64_t startedMs = 0; // unix ms
+    std::uint32_t durationMs = 0;
+    Variant variant = Variant::CZECH;
+    bool maxCaptureRule = false;
+    std::string reason; // jako v GAME_END
+    std::string winner; // WHITE|BLACK|NONE
+    std::string white;
+    std::string black;
+    std::vector<GameStep> steps; // key se neukládá (0), dá se dopočítat přehráním
+
+    // Den začátku partie (dny od 1970-01-01 UTC), podle něj index po dnech
+    std::int64_t day() const;
+};
+
+// ArchivedGame z partie na konci hry (id doplní archiv při zápisu)
+ArchivedGame archivedGameFromRoom(const Room& room, const std::string& reason, const std::string& winner);
+
+// "YYYY-MM-DD" <-> dny od 1970-01-01; nullopt pro neplatné datum
+std::optional<std::int64_t> parseArchiveDay(const std::string& text);
+std::string formatArchiveDay(std::int64_t day);
+
+// Pozice po prvních `ply` krocích partie (0 = výchozí). false, když krok neprojde
+// pravidly (archiv z jiné verze pravidel) nebo ply > počet kroků.
+bool replayArchivedGame(const ArchivedGame& game, std::size_t ply, Room& room);
+
+// Partie v PDN (Portable Draughts Notation). Desky 8x8 mají algebraická pole (a1 = levý
+// dolní roh bílého), 10x10 čísla 1-50; řetěz skoků je jeden tah "c3xe5xc7".
+// Prázdný řetězec, když partie nejde přehrát.
+std::string exportPdn(const ArchivedGame& game);
+
+class GameArchive : public GameRecorder {
+public:
+    // Otevře (a bez readOnly i založí) adresář archivu a sestaví index; nullptr a zpráva
+    // v error, pokud adresář nejde otevřít nebo je segment poškozený
+    static std::unique_ptr<GameArchive> open(const std::string& dir, bool readOnly, std::string& error);
+    ~GameArchive() override;
+
+    GameArchive(const GameArchive&) = delete;
+    GameArchive& operator=(const GameArchive&) = delete;
+
+    // Připíše partii na konec archivu; vrací přidělené id, nebo nullopt a zprávu v error
+    std::optional<std::uint64_t> append(ArchivedGame game, std::string& error);
+    void gameFinished(const Room& room, const std::string& reason, const std::string& winner) override;
+
+    std::size_t size() const { return locations.size(); }
+    std::optional<ArchivedGame> read(std::uint64_t id) const;
+
+    // Id partií od nejnovější, jen menší než `before` (0 = bez omezení), nejvýš `limit`
+    std::vector<std::uint64_t> gamesOf(const std::string& nick, std::uint64_t before, std::size_t limit) const;
+    std::vector<std::uint64_t> gamesOn(std::int64_t day, std::uint64_t before, std::size_t limit) const;
+
+private:
+    struct Segment {
+        std::uint8_t* data = nullptr;
+        std::size_t used = 0; // bajtů platných záznamů od začátku
+    };
+    struct Location {
+        std::uint32_t segment = 0;
+        std::uint32_t offset = 0;
+    };
+
+    GameArchive() = default;
+    bool mapSegment(std::size_t index, bool create, std::string& error);
+    void indexRecord(const ArchivedGame& game, Location where);
+
+    std::string dir;
+    bool readOnly = true;
+    std::vector<Segment> segments;
+    std::vector<Location> locations; // id - 1 -> záznam (id jdou od 1 bez mezer)
+    std::map<std::string, std::vector<std::uint64_t>> byPlayer;
+    std::map<std::int64_t, std::vector<std::uint64_t>> byDay;
+};
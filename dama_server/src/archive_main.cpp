@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "archive.hpp"
+
+// dama_archive – export partií z archivu serveru (dama_server --archive DIR) do PDN.
+// Použití: dama_archive --dir DIR [--game ID | --player NICK | --day YYYY-MM-DD]
+// Bez výběru vypíše všechny partie; PDN jde na stdout, od nejstarší partie.
+// Archiv se otevírá jen pro čtení, takže jde exportovat i za běhu serveru.
+int main(int argc, char* argv[]) {
+    std::string dir;
+    std::uint64_t gameId = 0;
+    std::string player;
+    std::optional<std::int64_t> day;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument(arg);
+                return argv[++i];
+            };
+            if (arg == "--dir") {
+                dir = next();
+            } else if (arg == "--game") {
+                gameId = std::stoull(next());
+            } else if (arg == "--player") {
+                player = next();
+            } else if (arg == "--day") {
+                day = parseArchiveDay(next());
+                if (!day) throw std::invalid_argument(arg);
+            } else {
+                std::cerr << "Unknown argument " << arg << std::endl;
+                return 2;
+            }
+        }
+    } catch (...) {
+        std::cerr << "Invalid arguments" << std::endl;
+        return 2;
+    }
+    if (dir.empty()) {
+        std::cerr << "Missing --dir DIR" << std::endl;
+        return 2;
+    }
+
+    std::string error;
+    auto archive = GameArchive::open(dir, true, error);
+    if (!archive) {
+        std::cerr << "Cannot open archive: " << error << std::endl;
+        return 1;
+    }
+
+    const std::size_t all = std::numeric_limits<std::size_t>::max();
+    std::vector<std::uint64_t> ids;
+    if (gameId != 0) {
+        ids.push_back(gameId);
+    } else if (!player.empty()) {
+        ids = archive->gamesOf(player, 0, all);
+    } else if (day) {
+        ids = archive->gamesOn(*day, 0, all);
+    } else {
+        for (std::uint64_t id = archive->size(); id > 0; --id) ids.push_back(id);
+    }
+    std::reverse(ids.begin(), ids.end());
+
+    int failed = 0;
+    for (std::uint64_t id : ids) {
+        auto game = archive->read(id);
+        std::string pdn = game ? exportPdn(*game) : std::string();
+        if (pdn.empty()) {
+            std::cerr << "[WARN] game " << id << " cannot be exported" << std::endl;
+            ++failed;
+            continue;
+        }
+        std::cout << pdn << "\n";
+    }
+    return failed == 0 ? 0 : 1;
+}
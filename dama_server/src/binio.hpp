@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Čísla v binárních souborech (databáze koncovek, kniha zahájení, archiv, účty) vždy little-endian,
+// nezávisle na stroji; čte se po bajtech, takže nevadí nezarovnaná data v mmap.
+
+inline void putU16(std::string& out, std::uint16_t v) {
+    for (int i = 0; i < 2; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+inline void putU32(std::string& out, std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+inline void putU64(std::string& out, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+inline std::uint64_t readLittleEndian(const std::uint8_t* p, int bytes) {
+    std::uint64_t v = 0;
+    for (int i = bytes - 1; i >= 0; --i) v = (v << 8) | p[i];
+    return v;
+}
+
+// FNV-1a; stačí na odhalení useknutého nebo přepsaného záznamu (archiv, účty)
+inline std::uint32_t checksum32(const std::uint8_t* p, std::size_t len) {
+    std::uint32_t h = 2166136261u;
+    for (std::size_t i = 0; i < len; ++i) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
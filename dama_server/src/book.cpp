@@ -0,0 +1,277 @@
+#include "book.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "binio.hpp"
+#include "rules.hpp"
+#include "transposition.hpp"
+
+namespace {
+
+constexpr std::size_t HEADER_SIZE = 16; // magic, počet záznamů (u64)
+
+using BookKey = std::tuple<std::uint64_t, int, int>; // klíč pozice, odkud, kam
+
+struct BookCounts {
+    std::uint32_t games = 0;
+    std::uint32_t wins = 0;
+    std::uint32_t draws = 0;
+};
+
+// "<klíč hex>:<odkud>:<kam>:<w|b>"
+bool parseLogMove(const std::string& token, GameStep& move) {
+    std::stringstream ss(token);
+    std::string key, from, to, side;
+    if (!std::getline(ss, key, ':') || !std::getline(ss, from, ':') ||
+        !std::getline(ss, to, ':') || !std::getline(ss, side) || (side != "w" && side != "b")) {
+        return false;
+    }
+    try {
+        std::size_t used = 0;
+        move.key = std::stoull(key, &used, 16);
+        if (used != key.size()) return false;
+        int f = std::stoi(from);
+        int t = std::stoi(to);
+        if (f < 0 || f >= MAX_BOARD_SIZE * MAX_BOARD_SIZE || t < 0 || t >= MAX_BOARD_SIZE * MAX_BOARD_SIZE) {
+            return false;
+        }
+        move.fromSquare = static_cast<std::uint8_t>(f);
+        move.toSquare = static_cast<std::uint8_t>(t);
+    } catch (...) {
+        return false;
+    }
+    move.white = side == "w";
+    return true;
+}
+
+// Připočte jednu partii z logu; false = poškozený řádek
+bool addLogLine(const std::string& line, std::map<BookKey, BookCounts>& counts) {
+    std::stringstream ss(line);
+    std::string variant, result, token;
+    if (!(ss >> variant >> result) || !parseVariant(variant) ||
+        (result != "W" && result != "B" && result != "D")) {
+        return false;
+    }
+    std::vector<GameStep> moves;
+    while (ss >> token) {
+        GameStep move;
+        if (!parseLogMove(token, move)) return false;
+        moves.push_back(move);
+    }
+    for (const auto& move : moves) {
+        BookCounts& c = counts[BookKey{move.key, move.fromSquare, move.toSquare}];
+        ++c.games;
+        if (result == "D") {
+            ++c.draws;
+        } else if ((result == "W") == move.white) {
+            ++c.wins;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+std::optional<char> bookGameResult(const std::string& reason, const std::string& winner) {
+    if (reason.rfind("DRAW_", 0) == 0) return 'D';
+    if (reason.find("_WIN_") == std::string::npos) return std::nullopt;
+    if (winner == "WHITE") return 'W';
+    if (winner == "BLACK") return 'B';
+    return std::nullopt;
+}
+
+std::string bookLogLine(const Room& room, char result) {
+    std::string line = variantName(room.variant) + " " + result;
+    char buf[48];
+    std::size_t plies = std::min<std::size_t>(room.steps.size(), BOOK_MAX_PLIES);
+    for (std::size_t i = 0; i < plies; ++i) {
+        const GameStep& move = room.steps[i];
+        std::snprintf(buf, sizeof(buf), " %llx:%d:%d:%c", static_cast<unsigned long long>(move.key),
+                      move.fromSquare, move.toSquare, move.white ? 'w' : 'b');
+        line += buf;
+    }
+    return line;
+}
+
+bool BookLog::open(const std::string& path, std::string& error) {
+    out.open(path, std::ios::app);
+    if (!out) {
+        error = "cannot open " + path + " for appending";
+        return false;
+    }
+    return true;
+}
+
+void BookLog::gameFinished(const Room& room, const std::string& reason, const std::string& winner) {
+    auto result = bookGameResult(reason, winner);
+    if (!result || room.steps.empty()) return;
+    // flush po každé partii: dama_book může log číst za běhu serveru
+    out << bookLogLine(room, *result) << std::endl;
+}
+
+std::unique_ptr<OpeningBook> OpeningBook::open(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "cannot open " + path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(HEADER_SIZE)) {
+        close(fd);
+        error = path + ": not an opening book";
+        return nullptr;
+    }
+    void* map = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        error = "cannot map " + path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+
+    std::unique_ptr<OpeningBook> book(new OpeningBook());
+    book->map = map;
+    book->mapSize = static_cast<std::size_t>(st.st_size);
+
+    const auto* bytes = static_cast<const std::uint8_t*>(map);
+    std::uint64_t count = readLittleEndian(bytes + 8, 8);
+    if (std::memcmp(bytes, BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0 ||
+        count != (book->mapSize - HEADER_SIZE) / BOOK_RECORD_SIZE ||
+        (book->mapSize - HEADER_SIZE) % BOOK_RECORD_SIZE != 0) {
+        error = path + ": not an opening book";
+        return nullptr;
+    }
+    book->records = bytes + HEADER_SIZE;
+    book->count = static_cast<std::size_t>(count);
+    return book;
+}
+
+OpeningBook::~OpeningBook() {
+    if (map) munmap(map, mapSize);
+}
+
+BookEntry OpeningBook::entry(std::size_t i) const {
+    const std::uint8_t* r = records + i * BOOK_RECORD_SIZE;
+    BookEntry e;
+    e.key = readLittleEndian(r, 8);
+    e.fromSquare = r[8];
+    e.toSquare = r[9];
+    e.games = static_cast<std::uint32_t>(readLittleEndian(r + 12, 4));
+    e.wins = static_cast<std::uint32_t>(readLittleEndian(r + 16, 4));
+    e.draws = static_cast<std::uint32_t>(readLittleEndian(r + 20, 4));
+    return e;
+}
+
+std::vector<BookEntry> OpeningBook::moves(std::uint64_t key) const {
+    // první záznam s klíčem >= key
+    std::size_t lo = 0;
+    std::size_t hi = count;
+    while (lo < hi) {
+        std::size_t mid = lo + (hi - lo) / 2;
+        if (readLittleEndian(records + mid * BOOK_RECORD_SIZE, 8) < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    std::vector<BookEntry> out;
+    for (std::size_t i = lo; i < count; ++i) {
+        BookEntry e = entry(i);
+        if (e.key != key) break;
+        out.push_back(e);
+    }
+    return out;
+}
+
+std::optional<BookEntry> bookMove(const OpeningBook& book, const Room& position) {
+    std::optional<BookEntry> best;
+    for (const BookEntry& e : book.moves(tableKey(position))) {
+        if (e.games < BOOK_MIN_GAMES) continue;
+        if (best && (e.scorePermille() < best->scorePermille() ||
+                     (e.scorePermille() == best->scorePermille() && e.games <= best->games))) {
+            continue;
+        }
+        // kolize klíče nebo kniha z jiné verze pravidel: krok musí být legální
+        Room trial = scratchPosition(position);
+        MoveResult result;
+        if (!applyMove(trial, position.turn == Turn::PLAYER1,
+                       e.fromSquare / MAX_BOARD_SIZE, e.fromSquare % MAX_BOARD_SIZE,
+                       e.toSquare / MAX_BOARD_SIZE, e.toSquare % MAX_BOARD_SIZE, result).empty()) {
+            continue;
+        }
+        best = e;
+    }
+    return best;
+}
+
+bool buildOpeningBook(const std::vector<std::string>& logPaths, const std::string& basePath,
+                      const std::string& outPath, std::size_t& games, std::string& error) {
+    std::map<BookKey, BookCounts> counts;
+    if (!basePath.empty()) {
+        auto base = OpeningBook::open(basePath, error);
+        if (!base) return false;
+        for (std::size_t i = 0; i < base->size(); ++i) {
+            BookEntry e = base->entry(i);
+            counts[BookKey{e.key, e.fromSquare, e.toSquare}] = BookCounts{e.games, e.wins, e.draws};
+        }
+    }
+
+    games = 0;
+    for (const auto& path : logPaths) {
+        std::ifstream in(path);
+        if (!in) {
+            error = "cannot open " + path;
+            return false;
+        }
+        std::string line;
+        std::size_t lineNo = 0;
+        while (std::getline(in, line)) {
+            ++lineNo;
+            if (line.empty()) continue;
+            if (addLogLine(line, counts)) {
+                ++games;
+            } else {
+                std::cout << "[WARN] " << path << ":" << lineNo << " malformed game skipped" << std::endl;
+            }
+        }
+    }
+
+    // map je seřazená podle (klíč, odkud, kam), jak ji čte binární hledání
+    std::string data(BOOK_MAGIC, sizeof(BOOK_MAGIC));
+    putU64(data, counts.size());
+    for (const auto& [k, c] : counts) {
+        putU64(data, std::get<0>(k));
+        data.push_back(static_cast<char>(std::get<1>(k)));
+        data.push_back(static_cast<char>(std::get<2>(k)));
+        putU16(data, 0);
+        putU32(data, c.games);
+        putU32(data, c.wins);
+        putU32(data, c.draws);
+    }
+
+    // nový soubor vedle a přejmenovat: server s namapovanou starou knihou čte dál svou kopii
+    std::string tmpPath = outPath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out || !out.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+            error = "cannot write " + tmpPath;
+            return false;
+        }
+    }
+    if (std::rename(tmpPath.c_str(), outPath.c_str()) != 0) {
+        error = "cannot replace " + outPath + ": " + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "models.hpp"
+#include "runtime.hpp"
+
+// Kniha zahájení z dohraných partií. Server zapisuje první kroky každé partie do
+// textového logu (BookLog), dama_book z logů a předchozí knihy sestaví nový soubor
+// knihy a server ho mapuje přes mmap. Bot a ANALYZE pak v zahájení netahají z hledání.
+//
+// Log: jedna partie na řádek "<varianta> <W|B|D> <klíč hex>:<odkud>:<kam>:<w|b> ...".
+// Kniha: hlavička (BOOK_MAGIC, počet záznamů) a záznamy po BOOK_RECORD_SIZE bajtech
+// seřazené podle (klíč, odkud, kam): klíč pozice (tableKey), krok, počet partií, výhry
+// a remízy strany, která krok zahrála. Klíč počítá i s captureLock, takže kniha je po
+// krocích jako hledání bota; stejná pozice z různých pořadí tahů je jeden záznam.
+
+constexpr int BOOK_MAX_PLIES = 24;   // kolik prvních kroků partie se zapisuje
+constexpr int BOOK_MIN_GAMES = 3;    // krok z méně partií se nehraje
+constexpr std::size_t BOOK_RECORD_SIZE = 24;
+constexpr char BOOK_MAGIC[8] = {'D', 'A', 'M', 'A', 'B', 'K', '1', '\n'};
+
+struct BookEntry {
+    std::uint64_t key = 0;
+    int fromSquare = 0; // row * MAX_BOARD_SIZE + col
+    int toSquare = 0;
+    std::uint32_t games = 0;
+    std::uint32_t wins = 0;  // partie vyhrané stranou, která krok zahrála
+    std::uint32_t draws = 0;
+
+    // Body za partii (výhra 1, remíza 1/2) v tisícinách
+    int scorePermille() const {
+        return games == 0 ? 0 : static_cast<int>((2000ULL * wins + 1000ULL * draws) / (2ULL * games));
+    }
+};
+
+// Výsledek partie pro knihu: 'W', 'B', 'D', nebo nullopt pro partii, která neskončila
+// na desce (odchod, timeout) a o zahájení nic neříká
+std::optional<char> bookGameResult(const std::string& reason, const std::string& winner);
+
+// Řádek logu pro dohranou partii (bez '\n')
+std::string bookLogLine(const Room& room, char result);
+
+// GameRecorder, který dohrané partie připisuje na konec logu
+class BookLog : public GameRecorder {
+public:
+    // false a zpráva v error, pokud soubor nejde otevřít pro zápis
+    bool open(const std::string& path, std::string& error);
+    void gameFinished(const Room& room, const std::string& reason, const std::string& winner) override;
+
+private:
+    std::ofstream out;
+};
+
+// Soubor knihy namapovaný do paměti (jen pro čtení)
+class OpeningBook {
+public:
+    static std::unique_ptr<OpeningBook> open(const std::string& path, std::string& error);
+    ~OpeningBook();
+
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    std::size_t size() const { return count; }
+    BookEntry entry(std::size_t i) const;
+
+    // Všechny kroky z pozice (binární hledání podle klíče)
+    std::vector<BookEntry> moves(std::uint64_t key) const;
+
+private:
+    OpeningBook() = default;
+
+    void* map = nullptr;
+    std::size_t mapSize = 0;
+    const std::uint8_t* records = nullptr;
+    std::size_t count = 0;
+};
+
+// Krok, který kniha pro pozici doporučuje: nejlepší skóre z aspoň BOOK_MIN_GAMES partií
+// (při shodě víc partií) a legální v pozici. nullopt mimo knihu.
+std::optional<BookEntry> bookMove(const OpeningBook& book, const Room& position);
+
+// Sestaví knihu z logů a volitelně z předchozí knihy (basePath prázdné = od nuly).
+// Vrací false a zprávu v error; games je počet načtených partií z logů.
+bool buildOpeningBook(const std::vector<std::string>& logPaths, const std::string& basePath,
+                      const std::string& outPath, std::size_t& games, std::string& error);
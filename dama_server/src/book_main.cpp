@@ -0,0 +1,46 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "book.hpp"
+
+// dama_book – sestaví knihu zahájení z logů dohraných partií (dama_server --book-log).
+// Použití: dama_book --log FILE [--log FILE ...] [--base BOOK] --out BOOK
+// S --base se nové partie přičtou k předchozí knize; --out může být stejný soubor jako --base
+// a server ho při dalším startu načte přes --book BOOK.
+int main(int argc, char* argv[]) {
+    std::vector<std::string> logs;
+    std::string base;
+    std::string out;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Invalid arguments" << std::endl;
+            return 2;
+        }
+        if (arg == "--log") {
+            logs.push_back(argv[++i]);
+        } else if (arg == "--base") {
+            base = argv[++i];
+        } else if (arg == "--out") {
+            out = argv[++i];
+        } else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 2;
+        }
+    }
+    if (out.empty()) {
+        std::cerr << "Missing --out BOOK" << std::endl;
+        return 2;
+    }
+
+    std::size_t games = 0;
+    std::string error;
+    if (!buildOpeningBook(logs, base, out, games, error)) {
+        std::cerr << "Opening book build failed: " << error << std::endl;
+        return 1;
+    }
+    std::cout << "[INFO] Opening book written to " << out << " games=" << games << std::endl;
+    return 0;
+}
@@ -0,0 +1,500 @@
+#include "bot.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+#include "rules.hpp"
+
+namespace {
+
+constexpr int SCORE_INF = 1000000;
+constexpr int MAX_PLY = MAX_SEARCH_PLY;
+constexpr int MAX_PV = 32;
+constexpr int MAX_SQUARES = MAX_BOARD_SIZE * MAX_BOARD_SIZE;
+
+struct SearchMove {
+    int fromRow, fromCol, toRow, toCol;
+    int order;
+};
+
+PieceColor sideToMove(const Room& pos) {
+    return pos.turn == Turn::PLAYER1 ? PieceColor::WHITE : PieceColor::BLACK;
+}
+
+// Ohodnocení z pohledu bílého: materiál, postup pěšců, zadní řada a střed
+int evaluateWhite(const Room& pos) {
+    const int size = boardSize(pos);
+    int score = 0;
+    for (int r = 0; r < size; ++r) {
+        for (int c = 0; c < size; ++c) {
+            char p = getPiece(pos, r, c);
+            if (p == '.') continue;
+            int value = 0;
+            if (isKing(p)) {
+                value = 320;
+            } else {
+                int advance = (p == 'w') ? (size - 1 - r) : r;
+                value = 100 + advance * 4;
+                if ((p == 'w' && r == size - 1) || (p == 'b' && r == 0)) {
+                    value += 8; // hlídá proměnu soupeře
+                }
+            }
+            if (r >= size / 2 - 1 && r <= size / 2 && c >= 2 && c <= size - 3) {
+                value += 5;
+            }
+            score += (pieceColor(p) == PieceColor::WHITE) ? value : -value;
+        }
+    }
+    return score;
+}
+
+class Searcher {
+public:
+    Searcher(const Room& position, const SearchLimits& limits, TranspositionTable* table,
+             const TablebaseSet* tablebases = nullptr)
+        : pos(makePosition(position.variant, position.board, position.turn, position.captureLock,
+                           position.maxCaptureRule)),
+          limits(limits), table(table), tablebases(tablebases), started(std::chrono::steady_clock::now()) {
+        for (auto& h : history) h.fill(0);
+    }
+
+    SearchResult run() {
+        if (tablebases) {
+            if (auto known = rootFromTablebase()) return *known;
+        }
+        SearchResult out;
+        std::vector<SearchMove> rootMoves;
+        if (!generate(rootMoves)) {
+            order(rootMoves, 0);
+        }
+        if (rootMoves.empty()) {
+            out.score = -SCORE_WIN;
+            return out;
+        }
+        out.found = true;
+        out.move = toBotMove(rootMoves.front());
+        out.pv = {out.move};
+        if (rootMoves.size() == 1 && !limits.scoreForcedMove) {
+            // jediný (vynucený) tah nemá smysl hledat, i s tabulkou by jen spálil časový limit
+            out.elapsedMs = elapsedMs();
+            return out;
+        }
+        TableEntry rootEntry;
+        if (table && table->probe(tableKey(pos), rootEntry)) {
+            moveToFront(rootMoves, rootEntry);
+        }
+
+        const Turn me = pos.turn;
+        for (int depth = 1; depth <= limits.maxDepth; ++depth) {
+            int alpha = -SCORE_INF;
+            int bestIndex = -1;
+            for (std::size_t i = 0; i < rootMoves.size(); ++i) {
+                MoveResult undo = make(rootMoves[i]);
+                int score = (pos.turn == me)
+                    ? search(depth, alpha, SCORE_INF, 1)
+                    : -search(depth - 1, -SCORE_INF, -alpha, 1);
+                unmake(rootMoves[i], undo);
+                if (aborted) break;
+                if (score > alpha) {
+                    alpha = score;
+                    bestIndex = static_cast<int>(i);
+                }
+            }
+            if (aborted || bestIndex < 0) break;
+
+            // nejlepší tah dopředu, další iterace ho prohledá první
+            std::rotate(rootMoves.begin(), rootMoves.begin() + bestIndex, rootMoves.begin() + bestIndex + 1);
+            out.move = toBotMove(rootMoves.front());
+            out.score = alpha;
+            out.depth = depth;
+            store(rootMoves.front(), alpha, depth, Bound::EXACT, 0);
+
+            if (alpha >= SCORE_WIN - MAX_PLY || alpha <= -SCORE_WIN + MAX_PLY) break;
+            // další iterace by se do rozpočtu stejně nevešla
+            if (limits.timeBudgetMs > 0 && elapsedMs() * 2 > limits.timeBudgetMs) break;
+        }
+        if (table) out.pv = principalVariation();
+        out.nodes = nodes;
+        out.elapsedMs = elapsedMs();
+        return out;
+    }
+
+    // Kořen přímo z tabulky (opakovaný dotaz analýzy), bez hledání
+    std::optional<SearchResult> rootFromTable(int minDepth) {
+        TableEntry e;
+        if (!table || !table->probe(tableKey(pos), e)) return std::nullopt;
+        if (e.bound != Bound::EXACT || e.depth < minDepth || e.fromSquare == NO_TABLE_SQUARE) return std::nullopt;
+        SearchResult out;
+        out.pv = principalVariation();
+        if (out.pv.empty()) return std::nullopt; // tah z tabulky už tu není legální (kolize klíče)
+        out.found = true;
+        out.move = out.pv.front();
+        out.score = e.score;
+        out.depth = e.depth;
+        out.elapsedMs = elapsedMs();
+        return out;
+    }
+
+    // Kořen z databáze koncovek: první z optimálních celých tahů, řetěz skoků jako pv
+    std::optional<SearchResult> rootFromTablebase() {
+        auto moves = tablebaseBestMoves(*tablebases, pos);
+        if (!moves) return std::nullopt;
+        SearchResult out;
+        const auto& best = moves->best.front();
+        for (std::size_t i = 1; i < best.size(); ++i) {
+            out.pv.push_back(BotMove{best[i - 1].first, best[i - 1].second, best[i].first, best[i].second});
+        }
+        out.found = true;
+        out.move = out.pv.front();
+        out.score = tablebaseScore(moves->value, 0);
+        out.tablebase = moves->value;
+        out.elapsedMs = elapsedMs();
+        return out;
+    }
+
+private:
+    // Výhra z databáze jako vynucená výhra za ply + tahy do konce (v rozsahu skóre výhry)
+    static int tablebaseScore(const TablebaseValue& v, int ply) {
+        int distance = std::min(ply + v.moves, MAX_PLY - 1);
+        switch (v.outcome) {
+            case TablebaseOutcome::WIN:  return SCORE_WIN - distance;
+            case TablebaseOutcome::LOSS: return -SCORE_WIN + distance;
+            case TablebaseOutcome::DRAW: break;
+        }
+        return 0;
+    }
+
+    // index do history nezávislý na velikosti desky varianty
+    static int square(int row, int col) {
+        return row * MAX_BOARD_SIZE + col;
+    }
+
+    static BotMove toBotMove(const SearchMove& m) {
+        return BotMove{m.fromRow, m.fromCol, m.toRow, m.toCol};
+    }
+
+    long long elapsedMs() const {
+        // skutečný čas výpočtu, ne serverové hodiny (ty v simulaci stojí)
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count();
+    }
+
+    // Skóre výhry v tabulce relativně k uzlu, ne ke kořeni (jinak by se lišilo podle cesty)
+    static int scoreToTable(int score, int ply) {
+        if (score >= SCORE_WIN - MAX_PLY) return score + ply;
+        if (score <= -SCORE_WIN + MAX_PLY) return score - ply;
+        return score;
+    }
+
+    static int scoreFromTable(int score, int ply) {
+        if (score >= SCORE_WIN - MAX_PLY) return score - ply;
+        if (score <= -SCORE_WIN + MAX_PLY) return score + ply;
+        return score;
+    }
+
+    void store(const SearchMove& best, int score, int depth, Bound bound, int ply) {
+        if (!table) return;
+        TableEntry e;
+        e.score = scoreToTable(score, ply);
+        e.depth = std::clamp(depth, 0, 255); // pod nulou je to stejné klidové hledání
+        e.bound = bound;
+        e.fromSquare = square(best.fromRow, best.fromCol);
+        e.toSquare = square(best.toRow, best.toCol);
+        table->store(tableKey(pos), e);
+    }
+
+    // Tah z tabulky na začátek seznamu (nejlepší tah minulého hledání téže pozice)
+    static bool moveToFront(std::vector<SearchMove>& moves, const TableEntry& e) {
+        for (std::size_t i = 0; i < moves.size(); ++i) {
+            if (square(moves[i].fromRow, moves[i].fromCol) == e.fromSquare &&
+                square(moves[i].toRow, moves[i].toCol) == e.toSquare) {
+                std::rotate(moves.begin(), moves.begin() + static_cast<std::ptrdiff_t>(i),
+                            moves.begin() + static_cast<std::ptrdiff_t>(i) + 1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Hlavní varianta po tazích z tabulky; každý tah se ověří proti vygenerovaným
+    std::vector<BotMove> principalVariation() {
+        std::vector<BotMove> line;
+        std::vector<SearchMove> played;
+        std::vector<MoveResult> undos;
+        std::vector<SearchMove> moves;
+        TableEntry e;
+        while (static_cast<int>(line.size()) < MAX_PV && table->probe(tableKey(pos), e) &&
+               e.fromSquare != NO_TABLE_SQUARE) {
+            generate(moves);
+            if (!moveToFront(moves, e)) break;
+            line.push_back(toBotMove(moves.front()));
+            played.push_back(moves.front());
+            undos.push_back(make(moves.front()));
+        }
+        for (std::size_t i = played.size(); i-- > 0;) {
+            unmake(played[i], undos[i]);
+        }
+        return line;
+    }
+
+    bool outOfBudget() {
+        if (limits.maxNodes > 0 && nodes >= limits.maxNodes) return true;
+        if (limits.timeBudgetMs > 0 && (nodes & 1023) == 0 && elapsedMs() >= limits.timeBudgetMs) return true;
+        return false;
+    }
+
+    // Vygeneruje tahy strany na tahu; vrací true, pokud jde o (povinné) skoky
+    bool generate(std::vector<SearchMove>& out) {
+        out.clear();
+        PieceColor side = sideToMove(pos);
+        bool white = side == PieceColor::WHITE;
+
+        auto addFrom = [&](int r, int c, bool capturesOnly) {
+            char p = getPiece(pos, r, c);
+            MoveTargets dests;
+            if (isKing(p)) {
+                dests = capturesOnly ? kingCaptureMoves(pos, r, c, side) : kingSimpleMoves(pos, r, c);
+            } else {
+                dests = capturesOnly ? manCaptureMoves(pos, r, c, white, side) : manSimpleMoves(pos, r, c, white);
+            }
+            for (auto [tr, tc] : dests) {
+                out.push_back(SearchMove{r, c, tr, tc, 0});
+            }
+        };
+
+        bool captures = pos.captureLock.has_value() || playerHasAnyCapture(pos, side);
+        if (captures && pos.maxCaptureRule) {
+            // jen první skoky nejdelších řetězů
+            chains.generate(pos);
+            for (std::size_t i = 0; i < chains.size(); ++i) {
+                auto chain = chains.chain(i);
+                if (static_cast<int>(chain.size()) - 1 != chains.maxHops()) continue;
+                SearchMove m{chain[0].first, chain[0].second, chain[1].first, chain[1].second, 0};
+                bool seen = std::any_of(out.begin(), out.end(), [&](const SearchMove& o) {
+                    return o.fromRow == m.fromRow && o.fromCol == m.fromCol && o.toRow == m.toRow && o.toCol == m.toCol;
+                });
+                if (!seen) out.push_back(m);
+            }
+            return true;
+        }
+        if (pos.captureLock.has_value()) {
+            addFrom(pos.captureLock->first, pos.captureLock->second, true);
+            return true;
+        }
+        const int size = boardSize(pos);
+        for (int r = 0; r < size; ++r) {
+            for (int c = 0; c < size; ++c) {
+                if (pieceColor(getPiece(pos, r, c)) != side) continue;
+                addFrom(r, c, captures);
+            }
+        }
+        return captures;
+    }
+
+    MoveResult make(const SearchMove& m) {
+        MoveResult undo;
+        playMove(pos, m.fromRow, m.fromCol, m.toRow, m.toCol, undo);
+        return undo;
+    }
+
+    void unmake(const SearchMove& m, const MoveResult& undo) {
+        undoMove(pos, m.fromRow, m.fromCol, m.toRow, m.toCol, undo);
+    }
+
+    // Řazení: skoky jsou povinné, takže mezi tichými tahy rozhoduje killer a historie
+    void order(std::vector<SearchMove>& moves, int ply) {
+        for (auto& m : moves) {
+            m.order = history[square(m.fromRow, m.fromCol)][square(m.toRow, m.toCol)];
+            for (int k = 0; k < 2; ++k) {
+                const BotMove& killer = killers[ply][k];
+                if (killer.fromRow == m.fromRow && killer.fromCol == m.fromCol &&
+                    killer.toRow == m.toRow && killer.toCol == m.toCol) {
+                    m.order += 1000000 - k;
+                }
+            }
+            if (!isKing(getPiece(pos, m.fromRow, m.fromCol)) &&
+                (m.toRow == 0 || m.toRow == boardSize(pos) - 1)) {
+                m.order += 500000; // proměna
+            }
+        }
+        std::stable_sort(moves.begin(), moves.end(),
+                         [](const SearchMove& a, const SearchMove& b) { return a.order > b.order; });
+    }
+
+    void rememberCutoff(const SearchMove& m, int depth, int ply) {
+        BotMove bm = toBotMove(m);
+        const BotMove& first = killers[ply][0];
+        if (first.fromRow != bm.fromRow || first.fromCol != bm.fromCol ||
+            first.toRow != bm.toRow || first.toCol != bm.toCol) {
+            killers[ply][1] = killers[ply][0];
+            killers[ply][0] = bm;
+        }
+        history[square(m.fromRow, m.fromCol)][square(m.toRow, m.toCol)] += std::max(1, depth * depth);
+    }
+
+    int search(int depth, int alpha, int beta, int ply) {
+        ++nodes;
+        if (outOfBudget()) {
+            aborted = true;
+            return 0;
+        }
+
+        if (tablebases && ply > 0) {
+            if (auto known = tablebases->probe(pos)) return tablebaseScore(*known, ply);
+        }
+
+        const int alphaOrig = alpha;
+        TableEntry entry;
+        bool hit = table && table->probe(tableKey(pos), entry);
+        if (hit && entry.depth >= std::max(depth, 0)) {
+            int stored = scoreFromTable(entry.score, ply);
+            if (entry.bound == Bound::EXACT ||
+                (entry.bound == Bound::LOWER && stored >= beta) ||
+                (entry.bound == Bound::UPPER && stored <= alpha)) {
+                return stored;
+            }
+        }
+
+        std::vector<SearchMove>& moves = moveStack[ply];
+        bool captures = generate(moves);
+        if (moves.empty()) {
+            return -SCORE_WIN + ply; // bez tahu = prohra
+        }
+        // po hloubce pokračují jen vynucené skoky (klidová pozice se hodnotí)
+        if ((depth <= 0 && !captures) || ply >= MAX_PLY - 1) {
+            int eval = evaluateWhite(pos);
+            return sideToMove(pos) == PieceColor::WHITE ? eval : -eval;
+        }
+        if (!captures) {
+            order(moves, ply);
+        }
+        if (hit) {
+            moveToFront(moves, entry);
+        }
+
+        const Turn me = pos.turn;
+        int best = -SCORE_INF;
+        std::size_t bestIndex = 0;
+        for (std::size_t i = 0; i < moves.size(); ++i) {
+            const SearchMove m = moves[i];
+            MoveResult undo = make(m);
+            // pokračování skoku hraje stejná strana: bez negace a bez snížení hloubky
+            int score = (pos.turn == me)
+                ? search(depth, alpha, beta, ply + 1)
+                : -search(depth - 1, -beta, -alpha, ply + 1);
+            unmake(m, undo);
+            if (aborted) return 0;
+
+            if (score > best) {
+                best = score;
+                bestIndex = i;
+                if (score > alpha) {
+                    alpha = score;
+                    if (alpha >= beta) {
+                        if (!captures) {
+                            rememberCutoff(m, depth, ply);
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+        Bound bound = best >= beta ? Bound::LOWER : (best <= alphaOrig ? Bound::UPPER : Bound::EXACT);
+        store(moves[bestIndex], best, depth, bound, ply);
+        return best;
+    }
+
+    Room pos;
+    SearchLimits limits;
+    TranspositionTable* table = nullptr; // nullptr = bot bez tabulky (deterministický jako dřív)
+    const TablebaseSet* tablebases = nullptr;
+    std::chrono::steady_clock::time_point started;
+    std::uint64_t nodes = 0;
+    bool aborted = false;
+    std::array<std::vector<SearchMove>, MAX_PLY> moveStack;
+    CaptureChainGenerator chains;
+    BotMove killers[MAX_PLY][2];
+    std::array<std::array<int, MAX_SQUARES>, MAX_SQUARES> history;
+};
+
+BotResult runJob(const BotJob& job, bool useTimeBudget, const TablebaseSet* tablebases, const OpeningBook* book,
+                 TranspositionTable* table) {
+    Room position = makePosition(job.variant, job.board, job.turn, job.captureLock, job.maxCaptureRule);
+
+    SearchLimits limits = botLimitsForLevel(job.level);
+    if (!useTimeBudget) {
+        limits.timeBudgetMs = 0;
+    }
+    BotResult result;
+    result.job = job;
+    if (book && job.level >= BOT_BOOK_LEVEL) {
+        if (auto known = bookResult(position, *book)) {
+            result.search = std::move(*known);
+            return result;
+        }
+    }
+    if (job.level < BOT_TABLEBASE_LEVEL) {
+        tablebases = nullptr;
+    }
+    result.search = searchBestMove(position, limits, table, tablebases);
+    return result;
+}
+
+} // namespace
+
+SearchLimits botLimitsForLevel(int level) {
+    level = std::clamp(level, BOT_MIN_LEVEL, BOT_MAX_LEVEL);
+    switch (level) {
+        case 1:  return SearchLimits{1, 100, 20000};
+        case 2:  return SearchLimits{2, 200, 50000};
+        case 3:  return SearchLimits{4, 400, 200000};
+        case 4:  return SearchLimits{6, 700, 1000000};
+        default: return SearchLimits{12, 1000, 4000000};
+    }
+}
+
+SearchResult searchBestMove(const Room& position, const SearchLimits& limits, TranspositionTable* table,
+                            const TablebaseSet* tablebases) {
+    Searcher searcher(position, limits, table, tablebases);
+    return searcher.run();
+}
+
+std::optional<SearchResult> tableResult(const Room& position, int minDepth, TranspositionTable& table) {
+    Searcher searcher(position, SearchLimits{}, &table);
+    return searcher.rootFromTable(minDepth);
+}
+
+std::optional<SearchResult> tablebaseResult(const Room& position, const TablebaseSet& tablebases) {
+    Searcher searcher(position, SearchLimits{}, nullptr, &tablebases);
+    return searcher.rootFromTablebase();
+}
+
+std::optional<SearchResult> bookResult(const Room& position, const OpeningBook& book) {
+    auto entry = bookMove(book, position);
+    if (!entry) return std::nullopt;
+    SearchResult out;
+    out.found = true;
+    out.move = BotMove{entry->fromSquare / MAX_BOARD_SIZE, entry->fromSquare % MAX_BOARD_SIZE,
+                       entry->toSquare / MAX_BOARD_SIZE, entry->toSquare % MAX_BOARD_SIZE};
+    out.pv = {out.move};
+    out.book = entry;
+    return out;
+}
+
+BotPool::BotPool(int threads, const TablebaseSet* tablebases, const OpeningBook* book, bool pinCores)
+    : tables([threads]() {
+          std::vector<std::unique_ptr<TranspositionTable>> perWorker;
+          for (int i = 0; i < threads; ++i) {
+              perWorker.push_back(std::make_unique<TranspositionTable>(BOT_WORKER_TABLE_MB));
+          }
+          return perWorker;
+      }()),
+      pool(threads,
+           [this, tablebases, book](const BotJob& job, bool useTimeBudget, int worker) {
+               // synchronní režim (simulace) bez tabulky: deterministický jako dřív
+               TranspositionTable* table = useTimeBudget ? tables[static_cast<std::size_t>(worker)].get() : nullptr;
+               return runJob(job, useTimeBudget, tablebases, book, table);
+           },
+           pinCores) {
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "affinitypool.hpp"
+#include "book.hpp"
+#include "models.hpp"
+#include "tablebase.hpp"
+#include "transposition.hpp"
+
+// Počítačový soupeř: iterativně prohlubované alfa-beta nad pravidly z rules.hpp.
+// Jeden "tah" bota je jeden krok/skok; dokud drží captureLock, je bot na tahu znovu.
+
+constexpr int BOT_MIN_LEVEL = 1;
+constexpr int BOT_MAX_LEVEL = 5;
+
+struct BotMove {
+    int fromRow = -1;
+    int fromCol = -1;
+    int toRow = -1;
+    int toCol = -1;
+};
+
+struct SearchLimits {
+    int maxDepth = 6;
+    int timeBudgetMs = 0;        // 0 = bez časového limitu
+    std::uint64_t maxNodes = 0;  // 0 = bez limitu uzlů
+    bool scoreForcedMove = false; // i jediný tah prohledat kvůli skóre (ANALYZE); bot hraje hned
+};
+
+struct SearchResult {
+    bool found = false;  // false = strana na tahu nemá žádný tah
+    BotMove move;
+    int score = 0;       // z pohledu strany na tahu
+    int depth = 0;       // hloubka poslední dokončené iterace
+    std::uint64_t nodes = 0;
+    long long elapsedMs = 0;
+    std::vector<BotMove> pv; // hlavní varianta od move (s tabulkou delší, jinak jen move)
+    std::optional<TablebaseValue> tablebase; // kořen rozhodla databáze koncovek (bez hledání)
+    std::optional<BookEntry> book;           // krok z knihy zahájení (bez hledání)
+};
+
+// Skóre nad SCORE_WIN - MAX_SEARCH_PLY je vynucená výhra (prohra se záporným znaménkem)
+constexpr int SCORE_WIN = 100000;
+constexpr int MAX_SEARCH_PLY = 128;
+
+// Limity hledání pro úroveň 1..5 (hloubka, čas na tah, počet uzlů)
+SearchLimits botLimitsForLevel(int level);
+
+// Najde nejlepší tah pro stranu position.turn (variant, board, turn, captureLock); position nemění.
+// S tabulkou ukládá a čte výsledky podstromů (sdílená mezi vlákny) a vrací i hlavní variantu.
+// S databází koncovek se pozice v ní nehledají: kořen vrátí optimální tah, uzly přesné skóre.
+SearchResult searchBestMove(const Room& position, const SearchLimits& limits, TranspositionTable* table = nullptr,
+                            const TablebaseSet* tablebases = nullptr);
+
+// Optimální tah podle databáze koncovek (celý řetěz jako pv), jinak nullopt
+std::optional<SearchResult> tablebaseResult(const Room& position, const TablebaseSet& tablebases);
+
+// Krok z knihy zahájení (bookMove), jinak nullopt
+std::optional<SearchResult> bookResult(const Room& position, const OpeningBook& book);
+
+// Výsledek už uložený v tabulce: přesné skóre kořene aspoň do minDepth, jinak nullopt
+std::optional<SearchResult> tableResult(const Room& position, int minDepth, TranspositionTable& table);
+
+// Úloha pro pool: snímek pozice v místnosti
+struct BotJob {
+    int roomId = 0;
+    int level = BOT_MIN_LEVEL;
+    Variant variant = Variant::CZECH;
+    std::string board;
+    Turn turn = Turn::NONE;
+    std::optional<std::pair<int, int>> captureLock;
+    std::uint64_t hash = 0; // Room::hash v okamžiku zadání
+    bool maxCaptureRule = false;
+};
+
+// Hotový výsledek; hash snímku slouží k zahození zastaralých výsledků
+struct BotResult {
+    BotJob job;
+    SearchResult search;
+};
+
+// Úroveň, od které bot hraje koncovky z databáze a zahájení z knihy (slabší úrovně dál jen hledají)
+constexpr int BOT_TABLEBASE_LEVEL = 3;
+constexpr int BOT_BOOK_LEVEL = 3;
+
+// Transpoziční tabulka každého workeru BotPool (jen s vlákny; synchronní bot hledá bez ní)
+constexpr std::size_t BOT_WORKER_TABLE_MB = 8;
+
+// Pool vláken pro hledání tahů bota, aby výpočet neblokoval UDP smyčku. Stoly jsou
+// přiřazené workerům (AffinityPool): worker si drží vlastní transpoziční tabulku, takže další
+// tah téže partie navazuje na podstromy prohledané v minulém tahu.
+class BotPool {
+public:
+    // tablebases a book můžou být nullptr; jinak musí přežít pool.
+    // pinCores: worker i na i-té povolené jádro
+    explicit BotPool(int threads, const TablebaseSet* tablebases = nullptr, const OpeningBook* book = nullptr,
+                     bool pinCores = false);
+
+    void submit(BotJob job) { pool.submit(std::move(job)); }
+    std::vector<BotResult> takeResults() { return pool.takeResults(); }
+    std::size_t backlog() const { return pool.backlog(); }
+    int wakeFd() const { return pool.wakeFd(); }
+
+    int workerOf(int roomId) const { return pool.workerOf(roomId); }
+    std::vector<AffinityWorkerStats> workerStats() const { return pool.workerStats(); }
+    std::uint64_t migrations() const { return pool.migrations(); }
+    void logStats(std::chrono::steady_clock::time_point now) { pool.logStats("BOT_WORKERS", now); }
+
+private:
+    std::vector<std::unique_ptr<TranspositionTable>> tables; // před pool: workery je používají a končí dřív
+    AffinityPool<BotJob, BotResult> pool;
+};
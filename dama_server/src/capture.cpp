@@ -0,0 +1,100 @@
+#include "capture.hpp"
+
+#include <cstring>
+#include <iterator>
+
+#include "binio.hpp"
+#include "runtime.hpp"
+
+bool CaptureWriter::open(const std::string& path, std::uint64_t seed, const ServerConfig& config,
+                         const ServerLimits& limits, std::string& error) {
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "cannot open " + path + " for writing";
+        return false;
+    }
+    std::string header(CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    putU64(header, seed);
+    for (int v : {config.timeoutMs, config.timeoutGrace, config.turnTimeoutMs, config.timeoutCheckIntervalMs,
+                  config.reconnectWindowMs, limits.maxPlayers, limits.maxRooms}) {
+        putU32(header, static_cast<std::uint32_t>(v));
+    }
+    out.write(header.data(), static_cast<std::streamsize>(header.size()));
+    out.flush();
+    start = steadyNow();
+    lastFlush = start;
+    return static_cast<bool>(out);
+}
+
+void CaptureWriter::record(const sockaddr_storage& from, const char* data, std::size_t len) {
+    auto now = steadyNow();
+    std::string rec;
+    rec.reserve(CAPTURE_RECORD_HEADER_SIZE + len);
+    putU64(rec, static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(now - start).count()));
+    EndpointKey key = endpointKey(from);
+    rec.append(reinterpret_cast<const char*>(key.ip.data()), key.ip.size());
+    putU16(rec, key.port);
+    putU16(rec, static_cast<std::uint16_t>(len));
+    rec.append(data, len);
+    out.write(rec.data(), static_cast<std::streamsize>(rec.size()));
+
+    if (++unflushed >= CAPTURE_FLUSH_RECORDS || now - lastFlush >= std::chrono::seconds(1)) {
+        out.flush();
+        unflushed = 0;
+        lastFlush = now;
+    }
+}
+
+void CaptureWriter::flush() {
+    if (unflushed == 0) return;
+    out.flush();
+    unflushed = 0;
+    lastFlush = steadyNow();
+}
+
+bool readCapture(const std::string& path, Capture& capture, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const auto* p = reinterpret_cast<const std::uint8_t*>(bytes.data());
+    bool v1 = bytes.size() >= CAPTURE_HEADER_SIZE && std::memcmp(p, CAPTURE_MAGIC_V1, sizeof(CAPTURE_MAGIC_V1)) == 0;
+    if (bytes.size() < CAPTURE_HEADER_SIZE || (!v1 && std::memcmp(p, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0)) {
+        error = path + ": not a traffic capture";
+        return false;
+    }
+    const std::size_t recordHeader = v1 ? CAPTURE_RECORD_HEADER_SIZE_V1 : CAPTURE_RECORD_HEADER_SIZE;
+    const std::size_t ipSize = v1 ? 4 : 16;
+    capture.seed = readLittleEndian(p + 8, 8);
+    int* fields[] = {&capture.config.timeoutMs, &capture.config.timeoutGrace, &capture.config.turnTimeoutMs,
+                     &capture.config.timeoutCheckIntervalMs, &capture.config.reconnectWindowMs,
+                     &capture.limits.maxPlayers, &capture.limits.maxRooms};
+    for (std::size_t i = 0; i < std::size(fields); ++i) {
+        *fields[i] = static_cast<int>(readLittleEndian(p + 16 + 4 * i, 4));
+    }
+
+    capture.datagrams.clear();
+    std::size_t offset = CAPTURE_HEADER_SIZE;
+    while (offset + recordHeader <= bytes.size()) {
+        const std::uint8_t* r = p + offset;
+        std::size_t len = static_cast<std::size_t>(readLittleEndian(r + 8 + ipSize + 2, 2));
+        if (offset + recordHeader + len > bytes.size()) break;
+        CapturedDatagram d;
+        d.atUs = readLittleEndian(r, 8);
+        EndpointKey key;
+        if (v1) {
+            key.ip[10] = 0xFF;
+            key.ip[11] = 0xFF;
+        }
+        std::memcpy(key.ip.data() + (16 - ipSize), r + 8, ipSize);
+        key.port = static_cast<std::uint16_t>(readLittleEndian(r + 8 + ipSize, 2));
+        d.from = endpointAddress(key);
+        d.data.assign(reinterpret_cast<const char*>(r + recordHeader), len);
+        capture.datagrams.push_back(std::move(d));
+        offset += recordHeader + len;
+    }
+    return true;
+}
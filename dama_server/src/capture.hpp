@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+
+#include "models.hpp"
+#include "server.hpp"
+
+// Záznam příchozího provozu (dama_server --capture FILE) pro dama_replay: každý přijatý
+// datagram s časem a odesílatelem, v pořadí, v jakém ho server zpracoval.
+//
+// Soubor: hlavička (CAPTURE_MAGIC, seed serverRandom, nastavení serveru a limity, které
+// ovlivňují zpracování) a záznamy: µs od začátku záznamu (u64), IPv6 adresa (16 bajtů,
+// IPv4 jako ::ffff:a.b.c.d), port (u16), délka (u16) a data datagramu.
+// Starší záznamy DAMACAP1 mají místo IPv6 adresy jen IPv4 (4 bajty); čtou se také.
+
+constexpr char CAPTURE_MAGIC[8] = {'D', 'A', 'M', 'A', 'C', 'A', 'P', '2'};
+constexpr char CAPTURE_MAGIC_V1[8] = {'D', 'A', 'M', 'A', 'C', 'A', 'P', '1'};
+constexpr std::size_t CAPTURE_HEADER_SIZE = 8 + 8 + 7 * 4;
+constexpr std::size_t CAPTURE_RECORD_HEADER_SIZE = 28;
+constexpr std::size_t CAPTURE_RECORD_HEADER_SIZE_V1 = 16;
+
+struct CapturedDatagram {
+    std::uint64_t atUs = 0; // od začátku záznamu
+    sockaddr_storage from{};
+    std::string data;
+};
+
+struct Capture {
+    std::uint64_t seed = 0; // seedServerRandom při záznamu (stejné tokeny při přehrání)
+    ServerConfig config;
+    ServerLimits limits;
+    std::vector<CapturedDatagram> datagrams;
+};
+
+class CaptureWriter {
+public:
+    // Založí soubor a zapíše hlavičku; false a zpráva v error
+    bool open(const std::string& path, std::uint64_t seed, const ServerConfig& config,
+              const ServerLimits& limits, std::string& error);
+    bool isOpen() const { return out.is_open(); }
+
+    // Zapisuje se přes buffer; na disk nejpozději po sekundě nebo CAPTURE_FLUSH_RECORDS záznamech
+    void record(const sockaddr_storage& from, const char* data, std::size_t len);
+
+    // Zbytek bufferu na disk (main.cpp, když je chvíli klid)
+    void flush();
+
+private:
+    static constexpr int CAPTURE_FLUSH_RECORDS = 256;
+
+    std::ofstream out;
+    std::chrono::steady_clock::time_point start{};
+    std::chrono::steady_clock::time_point lastFlush{};
+    int unflushed = 0;
+};
+
+// Načte celý záznam do paměti; useknutý poslední záznam (server skončil uprostřed zápisu)
+// se zahodí. false a zpráva v error pro soubor, který není záznam.
+bool readCapture(const std::string& path, Capture& capture, std::string& error);
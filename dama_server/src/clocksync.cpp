@@ -0,0 +1,46 @@
+#include "clocksync.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void ClockSync::ponged(std::int64_t t0, std::int64_t t1, std::int64_t t2) {
+    lastT0 = t0;
+    lastT1 = t1;
+    lastT2 = t2;
+    awaitingT3 = true;
+}
+
+bool ClockSync::completed(std::int64_t t2, std::int64_t t3) {
+    if (!awaitingT3 || t2 != lastT2) return false;
+    awaitingT3 = false;
+    std::int64_t rtt = (t3 - lastT0) - (lastT2 - lastT1);
+    if (t3 < lastT0 || rtt < 0 || rtt > CLOCK_SYNC_MAX_RTT_MS) return false;
+    // dělení dvěma zaokrouhlí k nule; chyba do 1 ms je pod přesností hodin klienta
+    std::int64_t offset = ((lastT0 - lastT1) + (t3 - lastT2)) / 2;
+
+    if (samples == 0) {
+        srttMs = static_cast<double>(rtt);
+        rttvarMs = rtt / 2.0;
+    } else {
+        rttvarMs = 0.75 * rttvarMs + 0.25 * std::abs(srttMs - static_cast<double>(rtt));
+        srttMs = 0.875 * srttMs + 0.125 * static_cast<double>(rtt);
+    }
+    recent[static_cast<std::size_t>(samples) % CLOCK_SYNC_SAMPLES] = Sample{rtt, offset};
+    ++samples;
+
+    std::size_t filled = std::min<std::size_t>(static_cast<std::size_t>(samples), CLOCK_SYNC_SAMPLES);
+    auto best = std::min_element(recent.begin(), recent.begin() + static_cast<std::ptrdiff_t>(filled),
+                                 [](const Sample& a, const Sample& b) { return a.rttMs < b.rttMs; });
+    offsetMs = best->offsetMs;
+    return true;
+}
+
+std::int64_t ClockSync::oneWayMs() const {
+    return samples > 0 ? static_cast<std::int64_t>(srttMs / 2) : 0;
+}
+
+int ClockSync::rtoMs() const {
+    if (samples == 0) return RTO_MAX_MS;
+    double rto = srttMs + std::max(1.0, 4 * rttvarMs);
+    return std::clamp(static_cast<int>(std::ceil(rto)), RTO_MIN_MS, RTO_MAX_MS);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Odhad zpoždění a posunu hodin klienta z výměny PING/PONG (jako NTP). Klient pošle
+// v PINGu svůj čas t0, server v PONGu vrátí t0, čas příjmu t1 a odeslání t2 (epoch ms
+// serveru). V dalším PINGu klient vrátí t2 posledního PONGu, který dostal, a čas t3,
+// kdy dorazil; server tak má celou výměnu:
+//   rtt    = (t3 - t0) - (t2 - t1)
+//   posun  = ((t0 - t1) + (t3 - t2)) / 2      (hodiny klienta minus hodiny serveru)
+// RTT se vyhlazuje jako v TCP (SRTT a RTTVAR, RFC 6298) a dává timeout pro opakované
+// odeslání. Posun se bere ze vzorku s nejmenším RTT mezi posledními CLOCK_SYNC_SAMPLES
+// (u něj je nejmenší chyba z nesouměrné cesty), stejně jako filtr hodin v NTP.
+
+constexpr std::size_t CLOCK_SYNC_SAMPLES = 8;
+constexpr std::int64_t CLOCK_SYNC_MAX_RTT_MS = 10000; // delší výměna se zahodí
+constexpr int RTO_MIN_MS = 200;
+constexpr int RTO_MAX_MS = 3000;                       // i výchozí hodnota bez vzorků
+
+struct ClockSync {
+    // poslední PONG, na který ještě nepřišla odpověď s t3
+    std::int64_t lastT0 = 0;
+    std::int64_t lastT1 = 0;
+    std::int64_t lastT2 = 0;
+    bool awaitingT3 = false;
+
+    double srttMs = 0;
+    double rttvarMs = 0;
+    int samples = 0;
+
+    struct Sample {
+        std::int64_t rttMs = 0;
+        std::int64_t offsetMs = 0;
+    };
+    std::array<Sample, CLOCK_SYNC_SAMPLES> recent{};
+    std::int64_t offsetMs = 0; // hodiny klienta minus hodiny serveru
+
+    bool synced() const { return samples > 0; }
+
+    // Odeslaný PONG s časy t0, t1, t2
+    void ponged(std::int64_t t0, std::int64_t t1, std::int64_t t2);
+
+    // PING s t2 a t3 posledního PONGu; false, když k výměně nepatří nebo je nesmyslná
+    bool completed(std::int64_t t2, std::int64_t t3);
+
+    // Jednosměrné zpoždění (polovina SRTT), 0 bez vzorků
+    std::int64_t oneWayMs() const;
+
+    // Čas serveru (epoch ms) v hodinách klienta
+    std::int64_t toClientMs(std::int64_t serverMs) const { return serverMs + offsetMs; }
+
+    // Timeout pro opakované odeslání: SRTT + 4 * RTTVAR v mezích RTO_MIN_MS..RTO_MAX_MS
+    int rtoMs() const;
+};
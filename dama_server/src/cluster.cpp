@@ -0,0 +1,321 @@
+#include "cluster.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "runtime.hpp"
+#include "zobrist.hpp"
+
+namespace {
+
+std::uint64_t fnv1a64(const std::string& s) {
+    std::uint64_t h = 0xCBF29CE484222325ull;
+    for (unsigned char ch : s) {
+        h ^= ch;
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+bool parseHeartbeat(const std::string& s, std::uint64_t& out) {
+    if (s.empty() || s.size() > 19 || !std::all_of(s.begin(), s.end(), [](unsigned char ch) { return ch >= '0' && ch <= '9'; })) {
+        return false;
+    }
+    out = std::stoull(s);
+    return true;
+}
+
+bool validNode(const std::string& node) {
+    sockaddr_storage addr{};
+    return parseNodeAddress(node, addr);
+}
+
+// SipHash-2-4 (Aumasson, Bernstein): 64bitový klíčovaný hash, kód pro GOSSIP;mac=
+std::uint64_t rotl(std::uint64_t x, int b) {
+    return (x << b) | (x >> (64 - b));
+}
+
+std::uint64_t sipHash24(const std::uint64_t key[2], const std::string& data) {
+    std::uint64_t v0 = 0x736f6d6570736575ull ^ key[0];
+    std::uint64_t v1 = 0x646f72616e646f6dull ^ key[1];
+    std::uint64_t v2 = 0x6c7967656e657261ull ^ key[0];
+    std::uint64_t v3 = 0x7465646279746573ull ^ key[1];
+    auto round = [&]() {
+        v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+        v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+        v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+        v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+    };
+    std::size_t full = data.size() / 8 * 8;
+    for (std::size_t i = 0; i < full; i += 8) {
+        std::uint64_t m = 0;
+        for (int b = 7; b >= 0; --b) m = (m << 8) | static_cast<unsigned char>(data[i + static_cast<std::size_t>(b)]);
+        v3 ^= m;
+        round();
+        round();
+        v0 ^= m;
+    }
+    std::uint64_t last = static_cast<std::uint64_t>(data.size() & 0xFF) << 56;
+    for (std::size_t i = full; i < data.size(); ++i) {
+        last |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[i])) << (8 * (i - full));
+    }
+    v3 ^= last;
+    round();
+    round();
+    v0 ^= last;
+    v2 ^= 0xFF;
+    for (int i = 0; i < 4; ++i) round();
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+std::string hex16(std::uint64_t value) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out(16, '0');
+    for (int i = 15; i >= 0; --i, value >>= 4) out[static_cast<std::size_t>(i)] = digits[value & 0xF];
+    return out;
+}
+
+constexpr const char* MAC_FIELD = ";mac=";
+
+} // namespace
+
+bool parseNodeAddress(const std::string& node, sockaddr_storage& out) {
+    auto colon = node.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 >= node.size() || node.size() - colon > 6) return false;
+    int port = 0;
+    for (std::size_t i = colon + 1; i < node.size(); ++i) {
+        if (node[i] < '0' || node[i] > '9') return false;
+        port = port * 10 + (node[i] - '0');
+    }
+    if (port <= 0) return false;
+    std::string host = node.substr(0, colon);
+    if (host.front() == '[') {
+        if (host.size() < 3 || host.back() != ']') return false;
+        host = host.substr(1, host.size() - 2);
+        if (host.find(':') == std::string::npos) return false; // [1.2.3.4] ne
+    } else if (host.find(':') != std::string::npos) {
+        return false; // IPv6 jen v hranatých závorkách
+    }
+    return parseAddress(host, port, out);
+}
+
+std::string nodeAddress(const std::string& host, int port) {
+    if (host.find(':') != std::string::npos) return "[" + host + "]:" + std::to_string(port);
+    return host + ":" + std::to_string(port);
+}
+
+HashRing::HashRing(const std::vector<std::string>& nodes, int vnodes) : nodes_(nodes) {
+    std::sort(nodes_.begin(), nodes_.end());
+    nodes_.erase(std::unique(nodes_.begin(), nodes_.end()), nodes_.end());
+    points.reserve(nodes_.size() * static_cast<std::size_t>(vnodes));
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        for (int r = 0; r < vnodes; ++r) {
+            points.emplace_back(hashNode(nodes_[i], r), i);
+        }
+    }
+    std::sort(points.begin(), points.end());
+}
+
+std::uint64_t HashRing::hashNode(const std::string& node, int replica) {
+    std::uint64_t state = fnv1a64(node + "#" + std::to_string(replica));
+    return splitmix64(state);
+}
+
+std::uint64_t HashRing::hashRoom(int roomId) {
+    std::uint64_t state = static_cast<std::uint64_t>(roomId);
+    return splitmix64(state);
+}
+
+const std::string& HashRing::owner(std::uint64_t key) const {
+    static const std::string none;
+    if (points.empty()) return none;
+    auto it = std::lower_bound(points.begin(), points.end(), std::make_pair(key, std::size_t{0}));
+    if (it == points.end()) it = points.begin();
+    return nodes_[it->second];
+}
+
+const std::string& HashRing::ownerOfRoom(int roomId) const {
+    return owner(hashRoom(roomId));
+}
+
+// Heartbeat začíná na čase spuštění (epoch ms), takže uzel po restartu hned přebije
+// heartbeat, který si o něm ostatní pamatují
+Cluster::Cluster(std::string self, std::vector<std::string> seeds, const std::string& secret)
+    : self_(std::move(self)),
+      heartbeat_(static_cast<std::uint64_t>(
+          std::chrono::duration_cast<std::chrono::milliseconds>(systemNow().time_since_epoch()).count())) {
+    for (auto& seed : seeds) {
+        if (seed == self_) continue;
+        members_[seed].seed = true;
+    }
+    if (!secret.empty()) {
+        // klíč z tajemství libovolné délky: SipHash s pevnými klíči
+        const std::uint64_t k0[2] = {0x6461'6d61'6b65'7930ull, 0};
+        const std::uint64_t k1[2] = {0x6461'6d61'6b65'7931ull, 0};
+        key_[0] = sipHash24(k0, secret);
+        key_[1] = sipHash24(k1, secret);
+        secured_ = true;
+    }
+    rebuildRing();
+}
+
+std::vector<std::pair<std::string, std::string>> Cluster::tick(std::chrono::steady_clock::time_point now) {
+    std::vector<std::pair<std::string, std::string>> out;
+    if (lastGossip_ != std::chrono::steady_clock::time_point{} &&
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - lastGossip_).count() < CLUSTER_GOSSIP_MS) {
+        return out;
+    }
+    lastGossip_ = now;
+    ++heartbeat_;
+
+    bool changed = false;
+    std::vector<std::string> alive;
+    std::vector<std::string> silentSeeds;
+    for (auto it = members_.begin(); it != members_.end();) {
+        ClusterMember& m = it->second;
+        auto silentMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - m.lastSeen).count();
+        if (m.alive && silentMs > CLUSTER_FAIL_MS) {
+            m.alive = false;
+            changed = true;
+            std::cout << "[WARN] CLUSTER node=" << it->first << " DEAD silentMs=" << silentMs << std::endl;
+        }
+        if (!m.alive && !m.seed && m.heartbeat > 0 && silentMs > CLUSTER_FORGET_MS) {
+            it = members_.erase(it);
+            continue;
+        }
+        if (m.alive) {
+            alive.push_back(it->first);
+        } else if (m.seed) {
+            silentSeeds.push_back(it->first);
+        }
+        ++it;
+    }
+    if (changed) rebuildRing();
+    if (rejected_ != rejectedLogged_) {
+        std::cout << "[WARN] CLUSTER rejected gossip=" << rejected_ - rejectedLogged_
+                  << (secured_ ? " (bad mac)" : " (unknown source)") << std::endl;
+        rejectedLogged_ = rejected_;
+    }
+
+    // náhodný výběr (částečné zamíchání)
+    auto pick = [](std::vector<std::string>& from, std::size_t count) {
+        count = std::min(count, from.size());
+        for (std::size_t i = 0; i < count; ++i) {
+            std::size_t j = i + static_cast<std::size_t>(serverRandom() % (from.size() - i));
+            std::swap(from[i], from[j]);
+        }
+        from.resize(count);
+    };
+
+    std::vector<std::string> shared = alive;
+    pick(shared, CLUSTER_GOSSIP_MEMBERS);
+    std::string msg = "0;GOSSIP;from=" + self_ + ";hb=" + std::to_string(heartbeat_) + ";members=";
+    // místo na ;mac=<16 hex> a \n; kdo se nevejde, půjde v dalším kole (výběr je náhodný)
+    const std::size_t budget = CLUSTER_GOSSIP_BYTES - (secured_ ? std::strlen(MAC_FIELD) + 16 : 0) - 1;
+    bool first = true;
+    for (const auto& node : shared) {
+        std::string entry = (first ? "" : "|") + node + "@" + std::to_string(members_[node].heartbeat);
+        if (msg.size() + entry.size() > budget) break;
+        msg += entry;
+        first = false;
+    }
+    if (secured_) msg += MAC_FIELD + hex16(sipHash24(key_, msg));
+    msg += "\n";
+
+    std::vector<std::string> targets = alive;
+    pick(targets, static_cast<std::size_t>(CLUSTER_FANOUT));
+    pick(silentSeeds, 1);
+    targets.insert(targets.end(), silentSeeds.begin(), silentSeeds.end());
+    for (const auto& target : targets) {
+        out.emplace_back(target, msg);
+    }
+    return out;
+}
+
+bool Cluster::authentic(const std::string& line, const Message& msg, const sockaddr_storage& from) const {
+    if (secured_) {
+        auto mac = msg.kvParams.find("mac");
+        auto at = line.rfind(MAC_FIELD);
+        // kód je poslední pole a pokrývá vše před ním
+        return mac != msg.kvParams.end() && at != std::string::npos && at + 5 + 16 == line.size() &&
+               mac->second == hex16(sipHash24(key_, line.substr(0, at)));
+    }
+    EndpointKey source = endpointKey(from);
+    for (const auto& [node, member] : members_) {
+        sockaddr_storage addr{};
+        if (parseNodeAddress(node, addr) && endpointKey(addr) == source) return true;
+    }
+    return false;
+}
+
+bool Cluster::receive(const std::string& line, const Message& msg, const sockaddr_storage& source,
+                      std::chrono::steady_clock::time_point now) {
+    if (!authentic(line, msg, source)) {
+        ++rejected_;
+        return false;
+    }
+    auto from = msg.kvParams.find("from");
+    auto hb = msg.kvParams.find("hb");
+    std::uint64_t heartbeat = 0;
+    if (from == msg.kvParams.end() || hb == msg.kvParams.end() || !validNode(from->second) ||
+        !parseHeartbeat(hb->second, heartbeat)) {
+        return false;
+    }
+    std::size_t before = aliveNodes().size();
+    updateMember(from->second, heartbeat, now);
+
+    auto members = msg.kvParams.find("members");
+    if (members != msg.kvParams.end() && !members->second.empty()) {
+        for (const auto& entry : split(members->second, '|')) {
+            auto at = entry.find('@');
+            std::uint64_t memberHb = 0;
+            if (at == std::string::npos || !parseHeartbeat(entry.substr(at + 1), memberHb)) continue;
+            std::string node = entry.substr(0, at);
+            if (!validNode(node)) continue;
+            updateMember(node, memberHb, now);
+        }
+    }
+    if (aliveNodes().size() != before) rebuildRing();
+    return true;
+}
+
+void Cluster::updateMember(const std::string& node, std::uint64_t heartbeat, std::chrono::steady_clock::time_point now) {
+    if (node == self_ || heartbeat == 0) return;
+    ClusterMember& m = members_[node];
+    if (heartbeat <= m.heartbeat) return;
+    m.heartbeat = heartbeat;
+    m.lastSeen = now;
+    if (!m.alive) {
+        m.alive = true;
+        std::cout << "[INFO] CLUSTER node=" << node << " ALIVE hb=" << heartbeat << std::endl;
+    }
+}
+
+std::vector<std::string> Cluster::aliveNodes() const {
+    std::vector<std::string> nodes{self_};
+    for (const auto& [node, m] : members_) {
+        if (m.alive) nodes.push_back(node);
+    }
+    std::sort(nodes.begin(), nodes.end());
+    return nodes;
+}
+
+int Cluster::nextOwnedRoomId(int from) const {
+    // při N uzlech patří uzlu zhruba každé N-té id
+    int id = std::max(from, 1);
+    while (!owns(id)) ++id;
+    return id;
+}
+
+void Cluster::rebuildRing() {
+    auto ring = std::make_shared<const HashRing>(aliveNodes());
+    std::cout << "[INFO] CLUSTER ring nodes=" << ring->nodeCount() << std::endl;
+    std::lock_guard<std::mutex> lock(ringMutex_);
+    ring_ = std::move(ring);
+}
+
+std::shared_ptr<const HashRing> Cluster::ringSnapshot() const {
+    std::lock_guard<std::mutex> lock(ringMutex_);
+    return ring_;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "protocol.hpp"
+
+// Cluster (--cluster, --join): víc uzlů dama_server na jedné síti (nebo na loopbacku
+// s různými porty). Uzel je určený adresou "host:port" herního socketu.
+//
+// Členství se šíří gossipem po herním socketu: každý uzel jednou za CLUSTER_GOSSIP_MS
+// zvýší svůj heartbeat a pošle CLUSTER_FANOUT náhodným živým uzlům (a jednomu ze
+// startovních uzlů z --join, který zatím neodpovídá)
+//   0;GOSSIP;from=<host:port>;hb=<n>;members=<host:port>@<hb>|...
+// s nejvýš CLUSTER_GOSSIP_MEMBERS dalšími členy, kolik se jich vejde do CLUSTER_GOSSIP_BYTES.
+// Gossip má vlastní limit délky: čtyři IPv6 členové přesáhnou 256 znaků zpráv klientů.
+// Příjemce si u každého člena nechá vyšší heartbeat; kdo ho nezvýšil za CLUSTER_FAIL_MS,
+// je mrtvý, po CLUSTER_FORGET_MS se zapomene (2× déle, aby ho starý gossip nevzkřísil).
+//
+// Gossip chodí na herní port, kam smí psát kdokoli, a mění vlastnictví stolů, proto se
+// ověřuje. Se sdíleným tajemstvím (--cluster-secret) nese každý GOSSIP na konci
+// ;mac=<16 hex> (SipHash-2-4 celé zprávy před ním, klíč odvozený z tajemství) a přijme se
+// jen s platným kódem; nový uzel se pak může připojit přes kterýkoli známý. Bez tajemství
+// se přijme jen gossip ze zdrojové adresy startovního uzlu (--join) nebo už známého člena,
+// takže členství je statické: uzly se musí navzájem uvést v --join. Odmítnutý gossip
+// zůstane bez odpovědi (počítá se v rejectedGossip).
+//
+// Stoly se rozmisťují konzistentním hashováním: každý živý uzel má na kruhu
+// CLUSTER_VNODES virtuálních bodů a id stolu patří uzlu prvního bodu za hashem id.
+// Uzel zakládá jen stoly s id, která patří jemu, takže id jsou v clusteru jednoznačná
+// a DISCOVER;room=<id> i JOIN_ROOM na cizím uzlu ukážou na vlastníka. Příchod nebo
+// odchod uzlu přesune jen zhruba 1/N id; rozehrané partie se nestěhují, dohrají se na
+// uzlu, kde vznikly (ten je má ve svém seznamu stolů dál).
+
+constexpr int CLUSTER_GOSSIP_MS = 500;
+constexpr int CLUSTER_FANOUT = 2;
+constexpr std::size_t CLUSTER_GOSSIP_MEMBERS = 4;
+constexpr std::size_t CLUSTER_GOSSIP_BYTES = 512; // celý řádek včetně ;mac= a \n
+constexpr int CLUSTER_FAIL_MS = 3000;
+constexpr int CLUSTER_FORGET_MS = 2 * CLUSTER_FAIL_MS;
+constexpr int CLUSTER_VNODES = 64;
+
+// Konzistentní hashování adres uzlů; jen čtení po sestavení, sdílí se s vláknem discovery
+class HashRing {
+public:
+    HashRing() = default;
+    explicit HashRing(const std::vector<std::string>& nodes, int vnodes = CLUSTER_VNODES);
+
+    bool empty() const { return points.empty(); }
+    std::size_t nodeCount() const { return nodes_.size(); }
+    const std::vector<std::string>& nodes() const { return nodes_; }
+
+    // Vlastník klíče; prázdný řetězec u prázdného kruhu
+    const std::string& owner(std::uint64_t key) const;
+    const std::string& ownerOfRoom(int roomId) const;
+
+    static std::uint64_t hashRoom(int roomId);
+    static std::uint64_t hashNode(const std::string& node, int replica);
+
+private:
+    std::vector<std::string> nodes_;                          // seřazené
+    std::vector<std::pair<std::uint64_t, std::size_t>> points; // bod na kruhu -> index uzlu
+};
+
+struct ClusterMember {
+    std::uint64_t heartbeat = 0;
+    std::chrono::steady_clock::time_point lastSeen{}; // kdy heartbeat naposledy vzrostl
+    bool alive = false;
+    bool seed = false; // z --join; zkouší se i mrtvý
+};
+
+class Cluster {
+public:
+    Cluster(std::string self, std::vector<std::string> seeds, const std::string& secret = {});
+
+    const std::string& self() const { return self_; }
+
+    // Datagramy GOSSIP k odeslání (adresa uzlu, zpráva), nejvýš jednou za CLUSTER_GOSSIP_MS;
+    // zároveň vyhodnotí výpadky a přestaví kruh
+    std::vector<std::pair<std::string, std::string>> tick(std::chrono::steady_clock::time_point now);
+
+    // Přijatý GOSSIP (line je celý řádek bez \n, from zdrojová adresa datagramu);
+    // false, když zpráva není platná nebo neprošla ověřením
+    bool receive(const std::string& line, const Message& msg, const sockaddr_storage& from,
+                 std::chrono::steady_clock::time_point now);
+    std::uint64_t rejectedGossip() const { return rejected_; }
+
+    std::vector<std::string> aliveNodes() const; // včetně sebe, seřazené
+    bool owns(int roomId) const { return ring_->ownerOfRoom(roomId) == self_; }
+    const std::string& ownerOfRoom(int roomId) const { return ring_->ownerOfRoom(roomId); }
+    // Nejmenší id >= from, které patří tomuto uzlu
+    int nextOwnedRoomId(int from) const;
+
+    // Aktuální kruh pro vlákno discovery (herní vlákno ho jen vyměňuje celý)
+    std::shared_ptr<const HashRing> ringSnapshot() const;
+
+private:
+    void updateMember(const std::string& node, std::uint64_t heartbeat, std::chrono::steady_clock::time_point now);
+    void rebuildRing();
+    bool authentic(const std::string& line, const Message& msg, const sockaddr_storage& from) const;
+
+    std::string self_;
+    bool secured_ = false;
+    std::uint64_t key_[2] = {0, 0}; // klíč SipHash z --cluster-secret
+    std::uint64_t rejected_ = 0;
+    std::uint64_t rejectedLogged_ = 0;
+    std::uint64_t heartbeat_ = 0;
+    std::map<std::string, ClusterMember> members_; // bez sebe
+    std::chrono::steady_clock::time_point lastGossip_{};
+    std::shared_ptr<const HashRing> ring_;
+    mutable std::mutex ringMutex_;
+};
+
+// "host:port" nebo "[v6]:port" -> sockaddr_storage (jen číselné adresy)
+bool parseNodeAddress(const std::string& node, sockaddr_storage& out);
+
+// Adresa uzlu v zápisu, který čte parseNodeAddress
+std::string nodeAddress(const std::string& host, int port);
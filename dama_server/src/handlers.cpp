@@ -1,13 +1,17 @@
 #include "handlers.hpp"
 #include "models.hpp"
+#include "rules.hpp"
+#include "runtime.hpp"
+#include "book.hpp"
+#include "bot.hpp"
+#include "tablebase.hpp"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <chrono>
-#include <random>
-#include <arpa/inet.h> // inet_ntop, sendto, ...
+#include <arpa/inet.h> // inet_ntop, ...
 
 // Lokální pomocné funkce jen pro tento soubor
 namespace {
@@ -20,35 +24,6 @@ std::string turnToString(Turn t) {
     }
 }
 
-bool isDarkSquare(int row, int col) {
-    return ((row + col) % 2) == 1;
-}
-
-PieceColor pieceColor(char piece) {
-    if (piece == 'w' || piece == 'W') return PieceColor::WHITE;
-    if (piece == 'b' || piece == 'B') return PieceColor::BLACK;
-    return PieceColor::NONE;
-}
-
-bool isKing(char piece) {
-    return piece == 'W' || piece == 'B';
-}
-
-std::vector<std::pair<int, int>> moveDirections(char piece) {
-    // pěšci jdou jen dopředu, dáma oběma směry
-    if (isKing(piece)) {
-        return {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
-    }
-    if (piece == 'w') {
-        return {{-1, -1}, {-1, 1}};
-    }
-    return {{1, -1}, {1, 1}}; // tahy pro černého
-}
-
-bool inBoard(int row, int col) {
-    return row >= 0 && row < BOARD_SIZE && col >= 0 && col < BOARD_SIZE;
-}
-
 bool hasInvalidDelims(const std::string& s) {
     return s.find(';') != std::string::npos || s.find('=') != std::string::npos;
 }
@@ -66,94 +41,17 @@ bool parseInt(const std::string& s, int& out) {
     }
 }
 
-bool canCaptureFrom(const Room& room, int row, int col, char piece) {
-    auto dirs = moveDirections(piece);
-    PieceColor myColor = pieceColor(piece);
-    PieceColor enemy   = (myColor == PieceColor::WHITE) ? PieceColor::BLACK : PieceColor::WHITE;
-
-    for (auto [dr, dc] : dirs) {
-        if (!isKing(piece)) {
-            int midRow = row + dr;
-            int midCol = col + dc;
-            int dstRow = row + 2 * dr;
-            int dstCol = col + 2 * dc;
-
-            if (!inBoard(dstRow, dstCol) || !isDarkSquare(dstRow, dstCol)) continue;
-            char middle = getPiece(room, midRow, midCol);
-            char dest   = getPiece(room, dstRow, dstCol);
-
-            if (dest != '.') continue;
-            if (pieceColor(middle) != enemy) continue;
-            return true;
-        } else {
-            int r = row + dr;
-            int c = col + dc;
-            bool enemyFound = false;
-
-            while (inBoard(r, c) && isDarkSquare(r, c)) {
-                char cur = getPiece(room, r, c);
-                if (cur == '.') {
-                    if (enemyFound) {
-                        return true; // našli jsme nepřítele a za ním volné pole
-                    }
-                } else if (pieceColor(cur) == myColor) {
-                    break; // blokuje vlastní figura
-                } else { // nepřítel
-                    if (enemyFound) break; // druhá figurka, konec
-                    enemyFound = true;
-                }
-                r += dr;
-                c += dc;
-            }
-        }
-    }
-    return false;
-}
-
-bool playerHasAnyCapture(const Room& room, PieceColor color) {
-    for (int r = 0; r < BOARD_SIZE; ++r) {
-        for (int c = 0; c < BOARD_SIZE; ++c) {
-            char p = getPiece(room, r, c);
-            if (pieceColor(p) != color) continue;
-            if (canCaptureFrom(room, r, c, p)) return true;
-        }
-    }
-    return false;
-}
-
-bool hasAnyPiece(const Room& room, PieceColor color) {
-    for (int r = 0; r < BOARD_SIZE; ++r) {
-        for (int c = 0; c < BOARD_SIZE; ++c) {
-            if (pieceColor(getPiece(room, r, c)) == color) {
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
-bool playerHasAnySimpleMove(const Room& room, PieceColor color) {
-    for (int r = 0; r < BOARD_SIZE; ++r) {
-        for (int c = 0; c < BOARD_SIZE; ++c) {
-            char p = getPiece(room, r, c);
-            if (pieceColor(p) != color) continue;
-
-            for (auto [dr, dc] : moveDirections(p)) {
-                int nr = r + dr;
-                int nc = c + dc;
-                if (!inBoard(nr, nc) || !isDarkSquare(nr, nc)) continue;
-                if (getPiece(room, nr, nc) == '.') {
-                    return true;
-                }
-            }
-        }
+bool parseInt64(const std::string& s, std::int64_t& out) {
+    try {
+        out = std::stoll(s);
+        return true;
+    } catch (...) {
+        return false;
     }
-    return false;
 }
 
-bool playerHasAnyMove(const Room& room, PieceColor color) {
-    if (playerHasAnyCapture(room, color)) return true;
-    return playerHasAnySimpleMove(room, color);
+std::string botToken(int roomId) {
+    return "bot-" + std::to_string(roomId);
 }
 
 bool roomHasPausedPlayer(const Room& room, const PlayersMap& players) {
@@ -171,8 +69,8 @@ bool roomHasPausedPlayer(const Room& room, const PlayersMap& players) {
 
 void sendGameEnd(int msgId, Room& room, const PlayersMap& players, int sockfd, const std::string& reason, const std::string& winnerOverride = "NONE") {
     room.status = RoomStatus::FINISHED;
-    room.turn   = Turn::NONE;
-    room.captureLock.reset();
+    setTurn(room, Turn::NONE);
+    setCaptureLock(room, std::nullopt);
 
     std::string winner = winnerOverride;
     if (winner == "NONE") {
@@ -185,24 +83,24 @@ void sendGameEnd(int msgId, Room& room, const PlayersMap& players, int sockfd, c
 
     for (const auto& pKey : room.playerKeys) {
         auto pit = players.find(pKey);
-        if (pit == players.end()) continue;
+        if (pit == players.end() || pit->second.isBot) continue;
 
         const Player& p = pit->second;
-        sockaddr_in pAddr = p.addr;
-        socklen_t pLen = sizeof(pAddr);
+        const sockaddr_storage& pAddr = p.addr;
+        socklen_t pLen = addrLength(pAddr);
 
         std::string resp = std::to_string(msgId) +
                            ";GAME_END;room=" + std::to_string(room.id) +
                            ";reason=" + reason +
                            ";winner=" + winner + "\n";
 
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&pAddr), pLen);
+        sendDatagram(sockfd, resp, pAddr, pLen);
     }
 
     std::cout << "[INFO] GAME_END room=" << room.id
               << " reason=" << reason
               << " winner=" << winner << std::endl;
+    recordFinishedGame(room, reason, winner);
 }
 
 static void resetRoom(Room& room) {
@@ -210,9 +108,151 @@ static void resetRoom(Room& room) {
     room.turn = Turn::NONE;
     room.board.clear();
     room.captureLock.reset();
+    room.hash = 0;
+    room.material = Material{};
+    room.positionHistory.clear();
+    room.noProgressPlies = 0;
+    room.steps.clear();
+    room.whiteNick.clear();
+    room.blackNick.clear();
     room.lastTurnAt = std::chrono::steady_clock::time_point{};
     room.remainingTurnMs = -1;
+    room.clockMs = {};
+    room.turnUsedMs = 0;
+    room.flagAt = std::chrono::steady_clock::time_point{};
+    cancelRoomDeadline(room.id);
     room.playerKeys.clear();
+    room.botThinking = false;
+}
+
+// === Časovač tahu ===
+// Bez hodin má každý tah turnTimeoutMs od lastTurnAt; při pauze se zbytek uloží do
+// remainingTurnMs a lastTurnAt se vynuluje. S hodinami (TimeControl) běží od lastTurnAt
+// čas hráče na tahu, clockMs se vyúčtuje až na konci tahu a flagAt je okamžik, kdy mu
+// čas dojde; ten se zadá do armRoomDeadline, takže pád praporku nečeká na checkTimeouts.
+
+static bool hasClock(const Room& room) {
+    return room.timeControl.baseMs > 0;
+}
+
+// 0 bílý, 1 černý
+static std::size_t sideToMove(const Room& room) {
+    return room.turn == Turn::PLAYER2 ? 1 : 0;
+}
+
+// Čas, který hráč na tahu spotřeboval od začátku tahu (včetně úseků před pauzou)
+static long long turnUsedAt(const Room& room, std::chrono::steady_clock::time_point now) {
+    long long used = room.turnUsedMs;
+    if (room.lastTurnAt != std::chrono::steady_clock::time_point{}) {
+        used += std::max<long long>(0, std::chrono::duration_cast<std::chrono::milliseconds>(now - room.lastTurnAt).count());
+    }
+    return used;
+}
+
+static long long clockRemainingMs(const Room& room, std::size_t side, std::chrono::steady_clock::time_point now) {
+    long long remaining = room.clockMs[side];
+    if (room.turn != Turn::NONE && side == sideToMove(room)) remaining -= turnUsedAt(room, now);
+    return std::max(0LL, remaining);
+}
+
+// remainingMs v GAME_STATE: zbytek tahu, s hodinami čas hráče na tahu
+static long long turnRemainingMs(const Room& room, std::chrono::steady_clock::time_point now, int turnTimeoutMs) {
+    if (hasClock(room)) return clockRemainingMs(room, sideToMove(room), now);
+    long long remainingMs = turnTimeoutMs;
+    if (room.lastTurnAt != std::chrono::steady_clock::time_point{}) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - room.lastTurnAt).count();
+        remainingMs = std::max(0LL, static_cast<long long>(turnTimeoutMs) - elapsed);
+    } else if (room.remainingTurnMs >= 0) {
+        remainingMs = room.remainingTurnMs;
+    }
+    return remainingMs;
+}
+
+// Hodiny hráče na tahu běží od now
+static void runClock(Room& room, std::chrono::steady_clock::time_point now) {
+    room.lastTurnAt = now;
+    room.flagAt = now + std::chrono::milliseconds(std::max(0LL, room.clockMs[sideToMove(room)] - room.turnUsedMs));
+    armRoomDeadline(room.id, room.flagAt);
+}
+
+// Na tahu je bot: termín hned, hledání zadá do BotPool processDeadlines (server.cpp)
+static void armBotTurn(const Room& room, std::chrono::steady_clock::time_point now) {
+    if (room.botLevel > 0 && room.status == RoomStatus::IN_GAME && room.turn == Turn::PLAYER2) {
+        armRoomDeadline(room.id, now);
+    }
+}
+
+// Nový tah: začátek partie nebo tah předaný soupeři
+static void startTurnTimer(Room& room, std::chrono::steady_clock::time_point now, int turnTimeoutMs) {
+    if (!hasClock(room)) {
+        room.remainingTurnMs = turnTimeoutMs;
+        room.lastTurnAt = now;
+        return;
+    }
+    room.turnUsedMs = 0;
+    runClock(room, now);
+}
+
+// Konec tahu hráče side: odečte spotřebovaný čas a přidá increment
+static void chargeClock(Room& room, std::size_t side, std::chrono::steady_clock::time_point now) {
+    long long used = turnUsedAt(room, now);
+    long long increment = room.timeControl.incrementMs;
+    if (room.timeControl.bronstein) increment = std::min(increment, used);
+    room.clockMs[side] = std::max(0LL, room.clockMs[side] - used) + increment;
+    room.turnUsedMs = 0;
+}
+
+// Zastaví časovač (pauza, výpadek serveru); čas po okamžiku at se hráči nepočítá
+static void freezeTurnTimer(Room& room, std::chrono::steady_clock::time_point at, int turnTimeoutMs) {
+    if (room.lastTurnAt == std::chrono::steady_clock::time_point{}) return;
+    auto elapsed = std::max<long long>(0, std::chrono::duration_cast<std::chrono::milliseconds>(at - room.lastTurnAt).count());
+    if (hasClock(room)) {
+        room.turnUsedMs += elapsed;
+        room.flagAt = std::chrono::steady_clock::time_point{};
+        cancelRoomDeadline(room.id);
+    } else {
+        room.remainingTurnMs = std::max(0, turnTimeoutMs - static_cast<int>(elapsed));
+    }
+    room.lastTurnAt = std::chrono::steady_clock::time_point{};
+}
+
+// Znovu spustí zastavený časovač; běžící tah se nemění
+static void resumeTurnTimer(Room& room, std::chrono::steady_clock::time_point now, int turnTimeoutMs) {
+    if (room.lastTurnAt != std::chrono::steady_clock::time_point{}) return;
+    if (hasClock(room)) {
+        runClock(room, now);
+    } else if (room.remainingTurnMs >= 0) {
+        room.lastTurnAt = now - std::chrono::milliseconds(turnTimeoutMs - room.remainingTurnMs);
+        room.remainingTurnMs = -1;
+    } else {
+        room.lastTurnAt = now;
+    }
+}
+
+// ";clockMs=<ms>;incrementMs=<ms>[;bronstein=1]" u stolu s hodinami (CREATE_ROOM_OK, ROOM, GAME_START)
+static std::string timeControlFields(const Room& room) {
+    if (!hasClock(room)) return "";
+    std::string fields = ";clockMs=" + std::to_string(room.timeControl.baseMs) +
+                         ";incrementMs=" + std::to_string(room.timeControl.incrementMs);
+    if (room.timeControl.bronstein) fields += ";bronstein=1";
+    return fields;
+}
+
+// ";whiteMs=<ms>;blackMs=<ms>" do GAME_STATE u stolu s hodinami
+static std::string clockFields(const Room& room, std::chrono::steady_clock::time_point now) {
+    if (!hasClock(room)) return "";
+    return ";whiteMs=" + std::to_string(clockRemainingMs(room, 0, now)) +
+           ";blackMs=" + std::to_string(clockRemainingMs(room, 1, now));
+}
+
+// Krok do záznamu partie (kniha zahájení, archiv); key je tableKey pozice před krokem
+static void recordStep(Room& room, std::uint64_t key, bool white, int fromRow, int fromCol, int toRow, int toCol) {
+    auto atMs = std::chrono::duration_cast<std::chrono::milliseconds>(steadyNow() - room.startedAt).count();
+    room.steps.push_back(GameStep{key,
+                                  static_cast<std::uint8_t>(fromRow * MAX_BOARD_SIZE + fromCol),
+                                  static_cast<std::uint8_t>(toRow * MAX_BOARD_SIZE + toCol),
+                                  white,
+                                  static_cast<std::uint32_t>(std::max<long long>(0, atMs))});
 }
 
 void dropPlayerForInvalid(const std::string& playerToken, PlayersMap& players, RoomsMap& rooms, int sockfd) {
@@ -233,81 +273,17 @@ void dropPlayerForInvalid(const std::string& playerToken, PlayersMap& players, R
     players.erase(playerToken);
 }
 
-std::vector<std::pair<int, int>> kingSimpleMoves(const Room& room, int row, int col) {
-    std::vector<std::pair<int, int>> out;
-    for (auto [dr, dc] : moveDirections('W')) {
-        int r = row + dr;
-        int c = col + dc;
-        while (inBoard(r, c) && isDarkSquare(r, c)) {
-            if (getPiece(room, r, c) != '.') break;
-            out.emplace_back(r, c);
-            r += dr;
-            c += dc;
-        }
-    }
-    return out;
-}
-
-std::vector<std::pair<int, int>> kingCaptureMoves(const Room& room, int row, int col, PieceColor myColor) {
-    std::vector<std::pair<int, int>> out;
-    for (auto [dr, dc] : moveDirections('W')) {
-        int r = row + dr;
-        int c = col + dc;
-        bool enemyFound = false;
-        while (inBoard(r, c) && isDarkSquare(r, c)) {
-            char cur = getPiece(room, r, c);
-            if (cur == '.') {
-                if (enemyFound) {
-                    out.emplace_back(r, c);
-                }
-            } else if (pieceColor(cur) == myColor) {
-                break;
-            } else { // enemy
-                if (enemyFound) break;
-                enemyFound = true;
-            }
-            r += dr;
-            c += dc;
-        }
-    }
-    return out;
-}
-
-std::vector<std::pair<int, int>> manSimpleMoves(const Room& room, int row, int col, bool isWhite) {
-    std::vector<std::pair<int, int>> out;
-    int dir = isWhite ? -1 : 1;
-    for (int dc : {-1, 1}) {
-        int nr = row + dir;
-        int nc = col + dc;
-        if (!inBoard(nr, nc) || !isDarkSquare(nr, nc)) continue;
-        if (getPiece(room, nr, nc) == '.') {
-            out.emplace_back(nr, nc);
-        }
-    }
-    return out;
-}
 
-std::vector<std::pair<int, int>> manCaptureMoves(const Room& room, int row, int col, bool isWhite, PieceColor myColor) {
-    std::vector<std::pair<int, int>> out;
-    int dir = isWhite ? -1 : 1;
-    for (int dc : {-1, 1}) {
-        int midRow = row + dir;
-        int midCol = col + dc;
-        int dstRow = row + 2 * dir;
-        int dstCol = col + 2 * dc;
-        if (!inBoard(dstRow, dstCol) || !isDarkSquare(dstRow, dstCol)) continue;
-        char middle = getPiece(room, midRow, midCol);
-        char dest = getPiece(room, dstRow, dstCol);
-        if (dest != '.') continue;
-        if (pieceColor(middle) == myColor || pieceColor(middle) == PieceColor::NONE) continue;
-        out.emplace_back(dstRow, dstCol);
-    }
-    return out;
+// ";material=<whiteMen>,<whiteKings>,<blackMen>,<blackKings>" z počítadel v Room
+static std::string materialField(const Room& room) {
+    const Material& m = room.material;
+    return ";material=" + std::to_string(m.whiteMen) + "," + std::to_string(m.whiteKings) + "," +
+           std::to_string(m.blackMen) + "," + std::to_string(m.blackKings);
 }
 
-
 // Broadcast GAME_STATE to all players in room
-// Response: ID;GAME_STATE;room=<roomId>;turn=<PLAYER1|PLAYER2|NONE>;board=<64 chars>
+// Response: ID;GAME_STATE;room=<roomId>;turn=<PLAYER1|PLAYER2|NONE>;board=<size*size chars>;remainingMs=<ms>
+//           [;whiteMs=<ms>;blackMs=<ms>];material=<whiteMen>,<whiteKings>,<blackMen>,<blackKings>[;lock=<row>,<col>]
 void broadcastGameState(
     int msgId,
     const Room& room,
@@ -315,77 +291,196 @@ void broadcastGameState(
     int sockfd,
     int turnTimeoutMs
 ) {
-    auto now = std::chrono::steady_clock::now();
-    long long remainingMs = turnTimeoutMs;
-    if (room.lastTurnAt != std::chrono::steady_clock::time_point{}) {
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - room.lastTurnAt).count();
-        remainingMs = std::max(0LL, static_cast<long long>(turnTimeoutMs) - elapsed);
-    } else if (room.remainingTurnMs >= 0) {
-        remainingMs = room.remainingTurnMs;
-    }
+    auto now = steadyNow();
 
     for (const auto& pKey : room.playerKeys) {
         auto pit = players.find(pKey);
-        if (pit == players.end()) continue;
+        if (pit == players.end() || pit->second.isBot) continue;
 
         const Player& p = pit->second;
-        sockaddr_in pAddr = p.addr;
-        socklen_t pLen = sizeof(pAddr);
+        // časy k okamžiku, kdy zpráva ke klientovi dorazí (polovina jeho SRTT)
+        auto arrival = now + std::chrono::milliseconds(p.sync.oneWayMs());
+        long long remainingMs = turnRemainingMs(room, arrival, turnTimeoutMs);
+        std::string clocks = clockFields(room, arrival);
+        const sockaddr_storage& pAddr = p.addr;
+        socklen_t pLen = addrLength(pAddr);
 
         std::string resp = std::to_string(msgId) +
                            ";GAME_STATE;room=" + std::to_string(room.id) +
                            ";turn=" + turnToString(room.turn) +
                            ";board=" + room.board +
-                           ";remainingMs=" + std::to_string(remainingMs);
+                           ";remainingMs=" + std::to_string(remainingMs) + clocks +
+                           materialField(room);
         if (room.captureLock.has_value()) {
             resp += ";lock=" + std::to_string(room.captureLock->first) + "," + std::to_string(room.captureLock->second);
         }
         resp += "\n";
 
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&pAddr), pLen);
+        sendDatagram(sockfd, resp, pAddr, pLen);
+    }
+}
+
+// Společné kontroly MOVE a MOVE_SEQ: místnost ve hře, hráč u stolu, deduplikace
+// podle msg.id, kdo je na tahu a pauza. Chybu pošle klientovi sám a vrátí nullptr.
+Room* roomForMove(
+    const Message& msg,
+    int roomId,
+    const std::string& playerToken,
+    RoomsMap& rooms,
+    PlayersMap& players,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen,
+    bool& isWhitePlayer
+) {
+    auto registerInvalid = [&](const std::string& code) {
+        registerInvalidMessage(playerToken, players, rooms, sockfd, code);
+    };
+
+    auto itRoom = rooms.find(roomId);
+    if (itRoom == rooms.end()) {
+        std::string resp = std::to_string(msg.id) +
+                           ";ERROR;ROOM_NOT_FOUND\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        registerInvalid("ROOM_NOT_FOUND");
+        return nullptr;
+    }
+
+    Room& room = itRoom->second;
+
+    if (room.status != RoomStatus::IN_GAME) {
+        std::string resp = std::to_string(msg.id) +
+                           ";ERROR;ROOM_NOT_IN_GAME\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        registerInvalid("ROOM_NOT_IN_GAME");
+        return nullptr;
+    }
+
+    // najdeme index hráče v room
+    auto itKey = std::find(room.playerKeys.begin(), room.playerKeys.end(), playerToken);
+    if (itKey == room.playerKeys.end()) {
+        std::string resp = std::to_string(msg.id) +
+                           ";ERROR;NOT_IN_ROOM\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        registerInvalid("NOT_IN_ROOM");
+        return nullptr;
+    }
+
+    std::size_t playerIndex = static_cast<std::size_t>(itKey - room.playerKeys.begin());
+    auto itPlayerObj = players.find(playerToken);
+    if (itPlayerObj == players.end()) {
+        std::string resp = std::to_string(msg.id) +
+                           ";ERROR;NOT_LOGGED_IN\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        registerInvalid("NOT_LOGGED_IN");
+        return nullptr;
+    }
+    // deduplikace MOVE (ignoruj stejné nebo starší msg.id)
+    if (msg.id <= itPlayerObj->second.lastMoveMsgId) {
+        return nullptr;
+    }
+    itPlayerObj->second.lastMoveMsgId = msg.id;
+
+    // kontrola, jestli je na tahu
+    if ((room.turn == Turn::PLAYER1 && playerIndex != 0) ||
+        (room.turn == Turn::PLAYER2 && playerIndex != 1)) {
+        std::string resp = std::to_string(msg.id) +
+                           ";ERROR;NOT_YOUR_TURN\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        registerInvalid("NOT_YOUR_TURN");
+        return nullptr;
+    }
+
+    if (roomHasPausedPlayer(room, players)) {
+        std::string resp = std::to_string(msg.id) +
+                           ";ERROR;GAME_PAUSED\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        registerInvalid("GAME_PAUSED");
+        return nullptr;
+    }
+
+    // určíme barvu hráče: 0 = WHITE (w), 1 = BLACK (b)
+    isWhitePlayer = (playerIndex == 0);
+    return &room;
+}
+
+// Dokončí už provedený tah (applyMove/playMove): log, časovač tahu, GAME_STATE
+// oběma hráčům a vyhodnocení konce hry. Sdílí ho MOVE od klienta i tah bota.
+void finishMove(int msgId, Room& room, PlayersMap& players, int sockfd, int turnTimeoutMs,
+                bool isWhitePlayer, int fromRow, int fromCol, int toRow, int toCol,
+                const MoveResult& result) {
+    std::cout << "[INFO] MOVE room=" << room.id
+              << " from=" << fromRow << "," << fromCol
+              << " to=" << toRow << "," << toCol
+              << " player=" << (isWhitePlayer ? 1 : 2)
+              << " capture=" << (result.capture ? 1 : 0)
+              << " king=" << (isKing(getPiece(room, toRow, toCol)) ? 1 : 0)
+              << std::endl;
+
+    // s hodinami se čas vyúčtuje, až hráč předá tah (ne po každém skoku řetězu)
+    auto now = steadyNow();
+    Turn mover = isWhitePlayer ? Turn::PLAYER1 : Turn::PLAYER2;
+    if (!hasClock(room)) {
+        startTurnTimer(room, now, turnTimeoutMs);
+    } else if (room.turn != mover) {
+        chargeClock(room, isWhitePlayer ? 0 : 1, now);
+        startTurnTimer(room, now, turnTimeoutMs);
+    }
+    recordPosition(room, result);
+
+    // vyhodnocení konce hry
+    PieceColor opponentColor = isWhitePlayer ? PieceColor::BLACK : PieceColor::WHITE;
+    bool opponentHasPieces = hasAnyPiece(room, opponentColor);
+    bool opponentHasMoves  = playerHasAnyMove(room, opponentColor);
+    std::string draw = drawReason(room);
+
+    broadcastGameState(msgId, room, players, sockfd, turnTimeoutMs);
+
+    if (!opponentHasPieces) {
+        std::string reason = isWhitePlayer ? "WHITE_WIN_NO_PIECES" : "BLACK_WIN_NO_PIECES";
+        sendGameEnd(msgId, room, players, sockfd, reason);
+        resetRoom(room);
+    } else if (!opponentHasMoves) {
+        std::string reason = isWhitePlayer ? "WHITE_WIN_NO_MOVES" : "BLACK_WIN_NO_MOVES";
+        sendGameEnd(msgId, room, players, sockfd, reason);
+        resetRoom(room);
+    } else if (!draw.empty()) {
+        // remíza uvolní stůl, jinak by dvě dámy tahaly do TURN_TIMEOUT
+        sendGameEnd(msgId, room, players, sockfd, draw);
+        resetRoom(room);
     }
+    armBotTurn(room, now);
 }
 
 } // namespace
 
 void sendGameStateToPlayer(int msgId, const Room& room, const Player& p, int sockfd, int turnTimeoutMs)
 {
-    auto now = std::chrono::steady_clock::now();
-    long long remainingMs = turnTimeoutMs;
-    if (room.lastTurnAt != std::chrono::steady_clock::time_point{}) {
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - room.lastTurnAt).count();
-        remainingMs = std::max(0LL, static_cast<long long>(turnTimeoutMs) - elapsed);
-    } else if (room.remainingTurnMs >= 0) {
-        remainingMs = room.remainingTurnMs;
-    }
+    auto arrival = steadyNow() + std::chrono::milliseconds(p.sync.oneWayMs());
+    long long remainingMs = turnRemainingMs(room, arrival, turnTimeoutMs);
+    std::string clocks = clockFields(room, arrival);
 
-    sockaddr_in pAddr = p.addr;
-    socklen_t pLen = sizeof(pAddr);
+    const sockaddr_storage& pAddr = p.addr;
+    socklen_t pLen = addrLength(pAddr);
     std::string resp = std::to_string(msgId) +
                        ";GAME_STATE;room=" + std::to_string(room.id) +
                        ";turn=" + turnToString(room.turn) +
                        ";board=" + room.board +
-                       ";remainingMs=" + std::to_string(remainingMs);
+                       ";remainingMs=" + std::to_string(remainingMs) + clocks +
+                       materialField(room);
     if (room.captureLock.has_value()) {
         resp += ";lock=" + std::to_string(room.captureLock->first) + "," + std::to_string(room.captureLock->second);
     }
     resp += "\n";
-    sendto(sockfd, resp.c_str(), resp.size(), 0,
-           reinterpret_cast<const sockaddr*>(&pAddr), pLen);
+    sendDatagram(sockfd, resp, pAddr, pLen);
 }
 
 void pauseRoom(Room& room, PlayersMap& players, int sockfd, int reconnectWindowMs, int turnTimeoutMs, const std::string& offenderKey)
 {
     room.status = RoomStatus::IN_GAME;
-    if (room.lastTurnAt != std::chrono::steady_clock::time_point{}) {
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - room.lastTurnAt).count();
-        room.remainingTurnMs = std::max(0, turnTimeoutMs - static_cast<int>(elapsed));
-    }
-    room.lastTurnAt = std::chrono::steady_clock::time_point{}; // stop turn timer
-    auto now = std::chrono::steady_clock::now();
-    auto nowSys = std::chrono::system_clock::now();
+    auto now = steadyNow();
+    freezeTurnTimer(room, now, turnTimeoutMs);
+    auto nowSys = systemNow();
     auto resumeByEpochMs = std::chrono::duration_cast<std::chrono::milliseconds>(
         nowSys.time_since_epoch() + std::chrono::milliseconds(reconnectWindowMs)).count();
     for (const auto& key : room.playerKeys) {
@@ -405,13 +500,12 @@ void pauseRoom(Room& room, PlayersMap& players, int sockfd, int reconnectWindowM
         auto it = players.find(key);
         if (it == players.end()) continue;
         const Player& p = it->second;
-        if (p.connected) {
-            sockaddr_in pAddr = p.addr;
-            socklen_t pLen = sizeof(pAddr);
+        if (p.connected && !p.isBot) {
+            const sockaddr_storage& pAddr = p.addr;
+            socklen_t pLen = addrLength(pAddr);
             std::string msg = "0;GAME_PAUSED;room=" + std::to_string(room.id) +
-                              ";resumeBy=" + std::to_string(resumeByEpochMs) + "\n";
-            sendto(sockfd, msg.c_str(), msg.size(), 0,
-                   reinterpret_cast<const sockaddr*>(&pAddr), pLen);
+                              ";resumeBy=" + std::to_string(p.sync.toClientMs(resumeByEpochMs)) + "\n";
+            sendDatagram(sockfd, msg, pAddr, pLen);
             std::cout << "[INFO] GAME_PAUSED room=" << room.id << " resumeBy=" << p.resumeDeadline.time_since_epoch().count() << std::endl;
         }
     }
@@ -419,17 +513,23 @@ void pauseRoom(Room& room, PlayersMap& players, int sockfd, int reconnectWindowM
 
 void sendConfig(Player& player, int sockfd, int turnTimeoutMs)
 {
-    sockaddr_in pAddr = player.addr;
-    socklen_t pLen = sizeof(pAddr);
+    const sockaddr_storage& pAddr = player.addr;
+    socklen_t pLen = addrLength(pAddr);
     std::string msg = "0;CONFIG;turnTimeoutMs=" + std::to_string(turnTimeoutMs) + "\n";
-    sendto(sockfd, msg.c_str(), msg.size(), 0,
-           reinterpret_cast<const sockaddr*>(&pAddr), pLen);
-    player.lastConfigSent = std::chrono::steady_clock::now();
+    sendDatagram(sockfd, msg, pAddr, pLen);
+    player.lastConfigSent = steadyNow();
+}
+
+// ";account=<id>;rating=<elo>;games=<n>" do LOGIN_OK
+static std::string accountFields(const Account& account) {
+    return ";account=" + std::to_string(account.id) +
+           ";rating=" + std::to_string(account.rating.rating) +
+           ";games=" + std::to_string(account.rating.games);
 }
 
 // LOGIN
 // Klient → server:  ID;LOGIN;<nick>
-// Server → klient:  ID;LOGIN_OK;player=<playerId>
+// Server → klient:  ID;LOGIN_OK;player=<playerId>;token=<token>[;account=<id>;rating=<elo>;games=<n>]
 //                  nebo ID;ERROR;INVALID_FORMAT;Missing nick
 //                  nebo ID;ERROR;INVALID_FORMAT;Invalid chars in nick
 //                  nebo ID;ERROR;INVALID_FORMAT;Nick too long
@@ -437,22 +537,22 @@ void sendConfig(Player& player, int sockfd, int turnTimeoutMs)
 // Příklad: 1;LOGIN;alice -> 1;LOGIN_OK;player=1
 void handleLogin(
     const Message& msg,
-    const std::string& clientKey,
+    const EndpointKey& clientKey,
     PlayersMap& players,
     int& nextPlayerId,
     const ServerLimits& limits,
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen,
     int turnTimeoutMs,
     int reconnectWindowMs,
-    EndpointMap& endpointToToken
+    EndpointMap& endpointToToken,
+    AccountStore* accounts
 ) {
     if (msg.rawParams.size() < 1) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;INVALID_FORMAT;Missing nick\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         return;
     }
 
@@ -461,15 +561,13 @@ void handleLogin(
     if (hasInvalidDelims(nick)) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;INVALID_FORMAT;Invalid chars in nick\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         return;
     }
     if (exceedsLimit(nick, 64)) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;INVALID_FORMAT;Nick too long\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         return;
     }
 
@@ -481,17 +579,17 @@ void handleLogin(
             if (!existing.nick.empty() && existing.nick != nick) {
                 std::string resp = std::to_string(msg.id) +
                                    ";ERROR;ALREADY_LOGGED_IN\n";
-                sendto(sockfd, resp.c_str(), resp.size(), 0,
-                       reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+                sendDatagram(sockfd, resp, clientAddr, clientLen);
                 std::cout << "[INFO] LOGIN rejected for " << clientKey
                           << " (nick mismatch)" << std::endl;
                 return;
             }
+            std::optional<Account> account = accounts ? accounts->find(nick) : std::nullopt;
             std::string resp = std::to_string(msg.id) +
                                ";LOGIN_OK;player=" + std::to_string(existing.id) +
-                               ";token=" + existing.token + "\n";
-            sendto(sockfd, resp.c_str(), resp.size(), 0,
-                   reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+                               ";token=" + existing.token +
+                               (account ? accountFields(*account) : std::string()) + "\n";
+            sendDatagram(sockfd, resp, clientAddr, clientLen);
             sendConfig(pit->second, sockfd, turnTimeoutMs);
             std::cout << "[INFO] LOGIN repeat key=" << clientKey
                       << " player=" << existing.id << std::endl;
@@ -503,8 +601,7 @@ void handleLogin(
     if (players.size() >= static_cast<std::size_t>(limits.maxPlayers)) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;SERVER_FULL;Vyčerpán limit hráčů\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         return;
     }
 
@@ -513,12 +610,11 @@ void handleLogin(
     p.nick = nick;
     p.addr = clientAddr;
     p.connected = true;
-    p.lastSeen = std::chrono::steady_clock::now();
+    p.lastSeen = steadyNow();
     p.configAcked = false;
     p.turnTimeoutMs = turnTimeoutMs;
     {
-        static std::mt19937_64 rng{std::random_device{}()};
-        uint64_t v = rng();
+        uint64_t v = serverRandom();
         std::stringstream ss;
         ss << std::hex << v;
         p.token = ss.str();
@@ -531,12 +627,19 @@ void handleLogin(
               << " nick=" << p.nick
               << " from " << clientKey << std::endl;
 
+    // účet je v paměti, zápis přihlášení jde na disk na pozadí
+    std::optional<Account> account;
+    if (accounts) {
+        auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(systemNow().time_since_epoch()).count();
+        account = accounts->login(nick, nowMs);
+    }
+
     std::string resp = std::to_string(msg.id) +
                        ";LOGIN_OK;player=" + std::to_string(p.id) +
-                       ";token=" + p.token + "\n";
+                       ";token=" + p.token +
+                       (account ? accountFields(*account) : std::string()) + "\n";
 
-    sendto(sockfd, resp.c_str(), resp.size(), 0,
-           reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
 
     sendConfig(players[p.token], sockfd, turnTimeoutMs);
 
@@ -554,7 +657,7 @@ void registerInvalidMessage(const std::string& playerToken, PlayersMap& players,
     if (pit == players.end()) return;
 
     auto& player = pit->second;
-    auto now = std::chrono::steady_clock::now();
+    auto now = steadyNow();
     if (player.invalidWindowStart == std::chrono::steady_clock::time_point{} ||
         now - player.invalidWindowStart > std::chrono::seconds(30)) {
         player.invalidCount = 0;
@@ -573,37 +676,86 @@ void registerInvalidMessage(const std::string& playerToken, PlayersMap& players,
 }
 
 // PING
-// Klient → server:  ID;PING
-// Server → klient:  ID;PONG
+// Klient → server:  ID;PING[;t0=<ms>[;t2=<ms>;t3=<ms>]]
+// Server → klient:  ID;PONG[;t0=<ms>;t1=<ms>;t2=<ms>[;rtt=<ms>;offset=<ms>]]
+// Bez t0 je to jen heartbeat. t0 je čas klienta při odeslání, t1 a t2 čas serveru (epoch
+// ms) při příjmu a odeslání PONGu. t2 a t3 v dalším PINGu (t2 posledního PONGu, který
+// klient dostal, a kdy ho dostal) dokončí výměnu (ClockSync); rtt a offset (hodiny
+// klienta minus hodiny serveru) jsou pak vyhlazené odhady serveru.
 // Příklad: 2;PING -> 2;PONG
 void handlePing(
     const Message& msg,
+    Player* player,
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen
 ) {
-    std::string resp = std::to_string(msg.id) + ";PONG\n";
-    sendto(sockfd, resp.c_str(), resp.size(), 0,
-           reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+    auto epochMs = []() {
+        return static_cast<std::int64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(systemNow().time_since_epoch()).count());
+    };
+    std::int64_t t1 = epochMs();
+    std::int64_t t0 = 0;
+    auto itT0 = msg.kvParams.find("t0");
+    if (itT0 == msg.kvParams.end() || !parseInt64(itT0->second, t0)) {
+        std::string resp = std::to_string(msg.id) + ";PONG\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        return;
+    }
+
+    std::string estimate;
+    if (player) {
+        auto itT2 = msg.kvParams.find("t2");
+        auto itT3 = msg.kvParams.find("t3");
+        std::int64_t t2 = 0;
+        std::int64_t t3 = 0;
+        if (itT2 != msg.kvParams.end() && itT3 != msg.kvParams.end() &&
+            parseInt64(itT2->second, t2) && parseInt64(itT3->second, t3)) {
+            player->sync.completed(t2, t3);
+        }
+        if (player->sync.synced()) {
+            estimate = ";rtt=" + std::to_string(static_cast<std::int64_t>(player->sync.srttMs)) +
+                       ";offset=" + std::to_string(player->sync.offsetMs);
+        }
+    }
+
+    std::int64_t t2 = epochMs();
+    std::string resp = std::to_string(msg.id) + ";PONG;t0=" + std::to_string(t0) +
+                       ";t1=" + std::to_string(t1) +
+                       ";t2=" + std::to_string(t2) + estimate + "\n";
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
+    if (player) player->sync.ponged(t0, t1, t2);
 }
 
 // LIST_ROOMS
 // Klient → server:  ID;LIST_ROOMS
 // Server → klient:  ID;ROOMS_EMPTY
-//    nebo pro každou room: ID;ROOM;id=<id>;name=<name>;players=<count>;status=<WAITING|IN_GAME|FINISHED>
+//    nebo pro každou room: ID;ROOM;id=<id>;name=<name>;players=<count>;status=<WAITING|IN_GAME|FINISHED>[;bot=<level>][;variant=<name>][;maxCapture=1]
+//                          [;clockMs=<ms>;incrementMs=<ms>[;bronstein=1]]
 // Příklad: 3;LIST_ROOMS -> 3;ROOMS_EMPTY (pokud žádné místnosti)
 void handleListRooms(
     const Message& msg,
     const RoomsMap& rooms,
+    const Cluster* cluster,
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen
 ) {
+    // ostatní živé uzly clusteru; jejich stoly vypíše jejich vlastní LIST_ROOMS
+    auto sendNodes = [&]() {
+        if (!cluster) return;
+        for (const auto& node : cluster->aliveNodes()) {
+            if (node == cluster->self()) continue;
+            std::string resp = std::to_string(msg.id) + ";NODE;addr=" + node + "\n";
+            sendDatagram(sockfd, resp, clientAddr, clientLen);
+        }
+    };
+
     if (rooms.empty()) {
         std::string resp = std::to_string(msg.id) +
                            ";ROOMS_EMPTY\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        sendNodes();
         return;
     }
 
@@ -620,22 +772,95 @@ void handleListRooms(
             case RoomStatus::IN_GAME:  ss << "IN_GAME";  break;
             case RoomStatus::FINISHED: ss << "FINISHED"; break;
         }
+        if (room.botLevel > 0) {
+            ss << ";bot=" << room.botLevel;
+        }
+        if (room.variant != Variant::CZECH) {
+            ss << ";variant=" << variantName(room.variant);
+        }
+        if (room.maxCaptureRule) {
+            ss << ";maxCapture=1";
+        }
+        ss << timeControlFields(room);
+        if (cluster) {
+            ss << ";node=" << cluster->self();
+        }
         ss << "\n";
 
         auto s = ss.str();
-    sendto(sockfd, s.c_str(), s.size(), 0,
-           reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+    sendDatagram(sockfd, s, clientAddr, clientLen);
     std::cout << "[LIST_ROOMS] key=" << addrToKey(clientAddr) << " rooms=" << rooms.size() << std::endl;
 }
+    sendNodes();
+}
+
+// Pravidla stolu z "variant=" a "maxCapture=" (CREATE_ROOM, QUICK_MATCH); bez nich czech
+// a nejdelší skok podle varianty. Vrací text chyby pro INVALID_FORMAT, jinak prázdný.
+static std::string parseRulesParams(const Message& msg, Variant& variant, bool& maxCaptureRule) {
+    variant = Variant::CZECH;
+    auto itVariant = msg.kvParams.find("variant");
+    if (itVariant != msg.kvParams.end()) {
+        auto parsed = parseVariant(itVariant->second);
+        if (!parsed) return "Invalid variant";
+        variant = *parsed;
+    }
+    maxCaptureRule = variantMaxCapture(variant);
+    auto itMaxCapture = msg.kvParams.find("maxCapture");
+    if (itMaxCapture != msg.kvParams.end()) {
+        if (itMaxCapture->second != "0" && itMaxCapture->second != "1") return "Invalid maxCapture";
+        maxCaptureRule = itMaxCapture->second == "1";
+    }
+    return "";
+}
+
+// Šachové hodiny z "clockMs=", "incrementMs=" a "bronstein=" (CREATE_ROOM); bez clockMs
+// stůl hodiny nemá. Vrací text chyby pro INVALID_FORMAT, jinak prázdný.
+static std::string parseClockParams(const Message& msg, TimeControl& timeControl) {
+    timeControl = TimeControl{};
+    auto itClock = msg.kvParams.find("clockMs");
+    auto itIncrement = msg.kvParams.find("incrementMs");
+    auto itBronstein = msg.kvParams.find("bronstein");
+    if (itClock == msg.kvParams.end()) {
+        if (itIncrement != msg.kvParams.end() || itBronstein != msg.kvParams.end()) return "Increment without clockMs";
+        return "";
+    }
+    if (!parseInt(itClock->second, timeControl.baseMs) || timeControl.baseMs < CLOCK_MIN_MS ||
+        timeControl.baseMs > CLOCK_MAX_MS) {
+        return "Invalid clockMs";
+    }
+    if (itIncrement != msg.kvParams.end() &&
+        (!parseInt(itIncrement->second, timeControl.incrementMs) || timeControl.incrementMs < 0 ||
+         timeControl.incrementMs > CLOCK_MAX_INCREMENT_MS)) {
+        return "Invalid incrementMs";
+    }
+    if (itBronstein != msg.kvParams.end()) {
+        if (itBronstein->second != "0" && itBronstein->second != "1") return "Invalid bronstein";
+        timeControl.bronstein = itBronstein->second == "1";
+    }
+    return "";
 }
 
 // CREATE_ROOM
-// Klient → server:  ID;CREATE_ROOM;<name>
-// Server → klient:  ID;CREATE_ROOM_OK;room=<roomId>
+// Klient → server:  ID;CREATE_ROOM;<name>[;bot=<1-5>][;variant=<czech|russian|italian|international>][;maxCapture=<0|1>]
+//                     [;clockMs=<ms>[;incrementMs=<ms>][;bronstein=<0|1>]]
+// Server → klient:  ID;CREATE_ROOM_OK;room=<roomId>[;bot=<level>][;variant=<name>][;maxCapture=1]
+//                     [;clockMs=<ms>;incrementMs=<ms>[;bronstein=1]]
 //                  nebo ID;ERROR;INVALID_FORMAT;Missing room name
 //                  nebo ID;ERROR;INVALID_FORMAT;Invalid chars in room name
 //                  nebo ID;ERROR;INVALID_FORMAT;Room name too long
+//                  nebo ID;ERROR;INVALID_FORMAT;Invalid bot level
+//                  nebo ID;ERROR;INVALID_FORMAT;Invalid variant
+//                  nebo ID;ERROR;INVALID_FORMAT;Invalid maxCapture
+//                  nebo ID;ERROR;INVALID_FORMAT;Invalid clockMs|Invalid incrementMs|Invalid bronstein|Increment without clockMs
 //                  nebo ID;ERROR;SERVER_FULL;Rooms limit reached
+//                  nebo ID;ERROR;SERVER_FULL;Players limit reached (bot zabírá místo hráče)
+// S bot=<level> sedí u stolu počítač jako PLAYER2 (BLACK); hra začne, jakmile se připojí hráč.
+// variant volí pravidla i velikost desky (výchozí czech 8x8, international 10x10).
+// S maxCapture=1 je povinné skákat nejdelší možný řetěz (jinak MUST_CAPTURE_MAX);
+// bez něj platí výchozí hodnota varianty (italian a international ano).
+// S clockMs má každý hráč na celou partii clockMs a po každém tahu dostane incrementMs
+// (Fischer; s bronstein=1 nejvýš tolik, kolik na tah spotřeboval). Komu čas dojde, prohrává
+// (GAME_END;reason=FLAG_FALL); limit jednoho tahu (turnTimeoutMs) u takového stolu neplatí.
 // Příklad: 4;CREATE_ROOM;Room1 -> 4;CREATE_ROOM_OK;room=1
 void handleCreateRoom(
     const Message& msg,
@@ -645,15 +870,14 @@ void handleCreateRoom(
     int& nextRoomId,
     const ServerLimits& limits,
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen,
     ServerLimits& mutableLimits
 ) {
     if (msg.rawParams.size() < 1) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;INVALID_FORMAT;Missing room name\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalidMessage(playerToken, players, rooms, sockfd, "INVALID_FORMAT");
         return;
     }
@@ -663,16 +887,39 @@ void handleCreateRoom(
     if (hasInvalidDelims(name)) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;INVALID_FORMAT;Invalid chars in room name\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalidMessage(playerToken, players, rooms, sockfd, "INVALID_FORMAT");
         return;
     }
     if (exceedsLimit(name, 64)) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;INVALID_FORMAT;Room name too long\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        registerInvalidMessage(playerToken, players, rooms, sockfd, "INVALID_FORMAT");
+        return;
+    }
+
+    int botLevel = 0;
+    auto itBot = msg.kvParams.find("bot");
+    if (itBot != msg.kvParams.end()) {
+        if (!parseInt(itBot->second, botLevel) || botLevel < BOT_MIN_LEVEL || botLevel > BOT_MAX_LEVEL) {
+            std::string resp = std::to_string(msg.id) +
+                               ";ERROR;INVALID_FORMAT;Invalid bot level\n";
+            sendDatagram(sockfd, resp, clientAddr, clientLen);
+            registerInvalidMessage(playerToken, players, rooms, sockfd, "INVALID_FORMAT");
+            return;
+        }
+    }
+
+    Variant variant = Variant::CZECH;
+    bool maxCaptureRule = false;
+    std::string rulesError = parseRulesParams(msg, variant, maxCaptureRule);
+    TimeControl timeControl;
+    if (rulesError.empty()) rulesError = parseClockParams(msg, timeControl);
+    if (!rulesError.empty()) {
+        std::string resp = std::to_string(msg.id) +
+                           ";ERROR;INVALID_FORMAT;" + rulesError + "\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalidMessage(playerToken, players, rooms, sockfd, "INVALID_FORMAT");
         return;
     }
@@ -680,41 +927,144 @@ void handleCreateRoom(
     if (rooms.size() >= static_cast<std::size_t>(limits.maxRooms)) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;SERVER_FULL;Vyčerpán limit místností\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         return;
     }
 
-    Room room;
-    room.id     = nextRoomId++;
-    room.name   = "Stůl " + std::to_string(mutableLimits.nextTableIndex++);
-    room.status = RoomStatus::WAITING;
+    // bot drží místo hráče po celou dobu života místnosti
+    if (botLevel > 0 && players.size() >= static_cast<std::size_t>(limits.maxPlayers)) {
+        std::string resp = std::to_string(msg.id) +
+                           ";ERROR;SERVER_FULL;Vyčerpán limit hráčů\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        return;
+    }
+
+    Room room;
+    room.id     = nextRoomId++;
+    room.name   = "Stůl " + std::to_string(mutableLimits.nextTableIndex++);
+    room.status = RoomStatus::WAITING;
     room.turn   = Turn::NONE;
     room.board.clear();
+    room.botLevel = botLevel;
+    room.variant = variant;
+    room.maxCaptureRule = maxCaptureRule;
+    room.timeControl = timeControl;
 
     rooms[room.id] = room;
 
+    if (botLevel > 0) {
+        Player bot;
+        bot.nick = "Bot-L" + std::to_string(botLevel);
+        bot.token = botToken(room.id);
+        bot.connected = true;
+        bot.configAcked = true;
+        bot.isBot = true;
+        players[bot.token] = bot;
+    }
+
     std::string resp = std::to_string(msg.id) +
                        ";CREATE_ROOM_OK;room=" +
                        std::to_string(room.id) +
-                       ";name=" + room.name + "\n";
+                       ";name=" + room.name;
+    if (botLevel > 0) {
+        resp += ";bot=" + std::to_string(botLevel);
+    }
+    if (variant != Variant::CZECH) {
+        resp += ";variant=" + variantName(variant);
+    }
+    if (maxCaptureRule) {
+        resp += ";maxCapture=1";
+    }
+    resp += timeControlFields(room);
+    resp += "\n";
 
-    sendto(sockfd, resp.c_str(), resp.size(), 0,
-           reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
 
     std::cout << "[INFO] CREATE_ROOM room=" << room.id
               << " name=" << room.name
-              << " cap=" << ROOM_CAPACITY << std::endl;
-    ;
+              << " cap=" << ROOM_CAPACITY
+              << " bot=" << botLevel
+              << " variant=" << variantName(variant)
+              << " maxCapture=" << (maxCaptureRule ? 1 : 0)
+              << " clockMs=" << timeControl.baseMs
+              << " incrementMs=" << timeControl.incrementMs << std::endl;
+}
+
+// Plný stůl -> nová partie: počáteční pozice, GAME_START každému hráči (role podle
+// pořadí v playerKeys) a GAME_STATE. Volá JOIN_ROOM a párování QUICK_MATCH.
+void startGame(int msgId, Room& room, PlayersMap& players, int sockfd, int turnTimeoutMs) {
+    room.status = RoomStatus::IN_GAME;
+    room.turn   = Turn::PLAYER1;
+    room.board  = createInitialBoard(room.variant);
+    room.captureLock.reset();
+    room.hash   = computePositionHash(room);
+    room.material = computeMaterial(room);
+    startPositionHistory(room);
+    room.steps.clear();
+    room.startedAt = steadyNow();
+    room.startedWall = systemNow();
+    auto nickOf = [&](const std::string& key) {
+        auto it = players.find(key);
+        return it != players.end() ? it->second.nick : std::string();
+    };
+    room.whiteNick = nickOf(room.playerKeys[0]);
+    room.blackNick = nickOf(room.playerKeys[1]);
+    room.clockMs = {room.timeControl.baseMs, room.timeControl.baseMs};
+    startTurnTimer(room, steadyNow(), turnTimeoutMs);
+
+    // každému hráči pošleme GAME_START (role WHITE/BLACK)
+    for (std::size_t i = 0; i < ROOM_CAPACITY; i++) {
+        const std::string& pKey = room.playerKeys[i];
+        auto pit = players.find(pKey);
+        if (pit == players.end() || pit->second.isBot) continue;
+
+        const Player& p = pit->second;
+        const sockaddr_storage& pAddr = p.addr;
+        socklen_t pLen = addrLength(pAddr);
+
+        std::string role = (i == 0) ? "WHITE" : "BLACK";
+        std::string opponentNick;
+        if (ROOM_CAPACITY == 2 && room.playerKeys.size() >= 2) {
+            std::size_t oppIndex = (i == 0) ? 1 : 0;
+            const std::string& oppKey = room.playerKeys[oppIndex];
+            auto oppIt = players.find(oppKey);
+            if (oppIt != players.end()) {
+                opponentNick = oppIt->second.nick;
+            }
+        }
+
+        std::string startMsg = std::to_string(msgId) +
+                               ";GAME_START;room=" + std::to_string(room.id) +
+                               ";you=" + role +
+                               ";variant=" + variantName(room.variant);
+        if (room.maxCaptureRule) {
+            startMsg += ";maxCapture=1";
+        }
+        startMsg += timeControlFields(room);
+        if (!opponentNick.empty()) {
+            startMsg += ";opponent=" + opponentNick;
+        }
+        startMsg += "\n";
+
+        sendDatagram(sockfd, startMsg, pAddr, pLen);
+    }
+
+    // immediately send GAME_STATE with board to all
+    broadcastGameState(msgId, room, players, sockfd, turnTimeoutMs);
+
+    std::cout << "[INFO] GAME_START room=" << room.id
+              << " white=" << room.playerKeys[0]
+              << " black=" << room.playerKeys[1] << std::endl;
+    std::cout << "[INFO] GAME_STATE turn=" << turnToString(room.turn) << " board=" << room.board << std::endl;
 }
 
 // JOIN_ROOM
 // Klient → server:  ID;JOIN_ROOM;<roomId>
 // Server → klient:  ID;JOIN_ROOM_OK;room=<roomId>;players=<count>/<ROOM_CAPACITY>
-//                  nebo ID;ERROR;ROOM_NOT_FOUND|NOT_LOGGED_IN|ROOM_FULL|ROOM_NOT_AVAILABLE
+//                  nebo ID;ERROR;ROOM_NOT_FOUND|NOT_LOGGED_IN|ROOM_FULL|ROOM_NOT_AVAILABLE|ALREADY_IN_ROOM
 // Když se room naplní:
-//    všem:          ID;GAME_START;room=<roomId>;you=<WHITE|BLACK>
-//    všem:          ID;GAME_STATE;room=<roomId>;turn=PLAYER1;board=<64 chars>
+//    všem:          ID;GAME_START;room=<roomId>;you=<WHITE|BLACK>;variant=<name>[;maxCapture=1];opponent=<nick>
+//    všem:          ID;GAME_STATE;room=<roomId>;turn=PLAYER1;board=<size*size chars>
 // Příklad: 5;JOIN_ROOM;1 -> 5;JOIN_ROOM_OK;room=1;players=1/2
 void handleJoinRoom(
     const Message& msg,
@@ -722,7 +1072,7 @@ void handleJoinRoom(
     RoomsMap& rooms,
     PlayersMap& players,
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen,
     int turnTimeoutMs
 ) {
@@ -733,8 +1083,7 @@ void handleJoinRoom(
     if (msg.rawParams.size() < 1) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;INVALID_FORMAT;Missing roomId\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("INVALID_FORMAT");
         return;
     }
@@ -743,8 +1092,7 @@ void handleJoinRoom(
     if (!parseInt(msg.rawParams[0], roomId)) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;INVALID_FORMAT;roomId must be number\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("INVALID_FORMAT");
         return;
     }
@@ -753,8 +1101,7 @@ void handleJoinRoom(
     if (itRoom == rooms.end()) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;ROOM_NOT_FOUND\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("ROOM_NOT_FOUND");
         return;
     }
@@ -763,27 +1110,35 @@ void handleJoinRoom(
     if (itPlayer == players.end()) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;NOT_LOGGED_IN\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("NOT_LOGGED_IN");
         return;
     }
 
     Room& room = itRoom->second;
 
+    // hráč smí sedět jen u jednoho stolu (opakovaný JOIN po ztrátě odpovědi)
+    for (const auto& [otherId, other] : rooms) {
+        if (otherId == roomId) continue;
+        if (std::find(other.playerKeys.begin(), other.playerKeys.end(), playerToken) != other.playerKeys.end()) {
+            std::string resp = std::to_string(msg.id) +
+                               ";ERROR;ALREADY_IN_ROOM\n";
+            sendDatagram(sockfd, resp, clientAddr, clientLen);
+            return;
+        }
+    }
+
     if (room.status != RoomStatus::WAITING) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;ROOM_NOT_AVAILABLE\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         return;
     }
 
     if (room.playerKeys.size() >= ROOM_CAPACITY) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;ROOM_FULL\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         return;
     }
 
@@ -792,6 +1147,10 @@ void handleJoinRoom(
         room.playerKeys.end()) {
         room.playerKeys.push_back(playerToken);
     }
+    // u stolu s botem si bot hned přisedne jako PLAYER2
+    if (room.botLevel > 0 && room.playerKeys.size() == 1 && players.count(botToken(room.id))) {
+        room.playerKeys.push_back(botToken(room.id));
+    }
 
     // odpověď JOIN_ROOM_OK jen volajícímu klientovi
     std::string resp = std::to_string(msg.id) +
@@ -799,8 +1158,7 @@ void handleJoinRoom(
                        ";players=" + std::to_string(room.playerKeys.size()) +
                        "/" + std::to_string(ROOM_CAPACITY) + "\n";
 
-    sendto(sockfd, resp.c_str(), resp.size(), 0,
-           reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
 
     std::cout << "[INFO] JOIN room=" << room.id
               << " key=" << playerToken
@@ -810,54 +1168,84 @@ void handleJoinRoom(
 
     // pokud je room plná -> spustit hru
     if (room.playerKeys.size() >= ROOM_CAPACITY) {
-        room.status = RoomStatus::IN_GAME;
-        room.turn   = Turn::PLAYER1;
-        room.board  = createInitialBoard();
-        room.captureLock.reset();
-        room.remainingTurnMs = turnTimeoutMs;
-        room.lastTurnAt = std::chrono::steady_clock::now();
+        startGame(msg.id, room, players, sockfd, turnTimeoutMs);
+    }
+}
 
-        // každému hráči pošleme GAME_START (role WHITE/BLACK)
-        for (std::size_t i = 0; i < ROOM_CAPACITY; i++) {
-            const std::string& pKey = room.playerKeys[i];
-            auto pit = players.find(pKey);
-            if (pit == players.end()) continue;
-
-            const Player& p = pit->second;
-            sockaddr_in pAddr = p.addr;
-            socklen_t pLen = sizeof(pAddr);
-
-            std::string role = (i == 0) ? "WHITE" : "BLACK";
-            std::string opponentNick;
-            if (ROOM_CAPACITY == 2 && room.playerKeys.size() >= 2) {
-                std::size_t oppIndex = (i == 0) ? 1 : 0;
-                const std::string& oppKey = room.playerKeys[oppIndex];
-                auto oppIt = players.find(oppKey);
-                if (oppIt != players.end()) {
-                    opponentNick = oppIt->second.nick;
-                }
-            }
+// QUICK_MATCH
+// Klient → server:  ID;QUICK_MATCH[;variant=<name>][;maxCapture=<0|1>]
+// Server → klient:  ID;QUICK_MATCH_OK;rating=<elo>;waiting=<count>
+//                  nebo ID;ERROR;INVALID_FORMAT;Invalid variant|Invalid maxCapture
+//                  nebo ID;ERROR;ALREADY_IN_ROOM
+// Hráč čeká ve frontě, dokud server nenajde soupeře s podobným hodnocením; pak oběma
+// přijde 0;GAME_START a GAME_STATE u nového stolu jako po JOIN_ROOM. Opakovaný
+// QUICK_MATCH změní jen pravidla, čekání běží dál (okno hodnocení se nezužuje).
+// Příklad: 8;QUICK_MATCH -> 8;QUICK_MATCH_OK;rating=1500;waiting=3
+void handleQuickMatch(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    MatchQueue& matches,
+    const RatingTable& ratings,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+) {
+    auto itPlayer = players.find(playerToken);
+    if (itPlayer == players.end()) return;
 
-            std::string startMsg = std::to_string(msg.id) +
-                                   ";GAME_START;room=" + std::to_string(room.id) +
-                                   ";you=" + role;
-            if (!opponentNick.empty()) {
-                startMsg += ";opponent=" + opponentNick;
-            }
-            startMsg += "\n";
+    Variant variant = Variant::CZECH;
+    bool maxCaptureRule = false;
+    std::string rulesError = parseRulesParams(msg, variant, maxCaptureRule);
+    if (!rulesError.empty()) {
+        std::string resp = std::to_string(msg.id) +
+                           ";ERROR;INVALID_FORMAT;" + rulesError + "\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        registerInvalidMessage(playerToken, players, rooms, sockfd, "INVALID_FORMAT");
+        return;
+    }
 
-            sendto(sockfd, startMsg.c_str(), startMsg.size(), 0,
-                   reinterpret_cast<const sockaddr*>(&pAddr), pLen);
+    for (const auto& [roomId, room] : rooms) {
+        if (std::find(room.playerKeys.begin(), room.playerKeys.end(), playerToken) != room.playerKeys.end()) {
+            std::string resp = std::to_string(msg.id) +
+                               ";ERROR;ALREADY_IN_ROOM\n";
+            sendDatagram(sockfd, resp, clientAddr, clientLen);
+            return;
         }
+    }
 
-        // immediately send GAME_STATE with board to all
-        broadcastGameState(msg.id, room, players, sockfd, turnTimeoutMs);
+    int rating = ratings.get(itPlayer->second.nick).rating;
+    matches.enqueue(playerToken, rating, variant, maxCaptureRule, steadyNow());
 
-    std::cout << "[INFO] GAME_START room=" << room.id
-              << " white=" << room.playerKeys[0]
-              << " black=" << room.playerKeys[1] << std::endl;
-    std::cout << "[INFO] GAME_STATE turn=" << turnToString(room.turn) << " board=" << room.board << std::endl;
+    std::string resp = std::to_string(msg.id) +
+                       ";QUICK_MATCH_OK;rating=" + std::to_string(rating) +
+                       ";waiting=" + std::to_string(matches.size()) + "\n";
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
+
+    std::cout << "[INFO] QUICK_MATCH key=" << playerToken
+              << " rating=" << rating
+              << " variant=" << variantName(variant)
+              << " maxCapture=" << (maxCaptureRule ? 1 : 0)
+              << " waiting=" << matches.size() << std::endl;
 }
+
+// QUICK_MATCH_CANCEL
+// Klient → server:  ID;QUICK_MATCH_CANCEL
+// Server → klient:  ID;QUICK_MATCH_CANCEL_OK;cancelled=<0|1>
+// cancelled=0: hráč ve frontě nebyl (už je spárovaný, nebo se ztratil QUICK_MATCH).
+void handleQuickMatchCancel(
+    const Message& msg,
+    const std::string& playerToken,
+    MatchQueue& matches,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+) {
+    bool cancelled = matches.cancel(playerToken);
+    std::string resp = std::to_string(msg.id) +
+                       ";QUICK_MATCH_CANCEL_OK;cancelled=" + (cancelled ? "1" : "0") + "\n";
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
 }
 
 // MOVE
@@ -866,8 +1254,9 @@ void handleJoinRoom(
 //   kódy: INVALID_FORMAT|ROOM_NOT_FOUND|ROOM_NOT_IN_GAME|NOT_LOGGED_IN|NOT_IN_ROOM|
 //         NOT_YOUR_TURN|OUT_OF_BOARD|INVALID_SQUARE|NO_PIECE|NOT_YOUR_PIECE|
 //         DEST_NOT_EMPTY|INVALID_MOVE|INVALID_DIRECTION|MUST_CAPTURE|
-//         MUST_CONTINUE_CAPTURE|NO_OPPONENT_TO_CAPTURE
-// Při úspěchu: všem v room: ID;GAME_STATE;room=<roomId>;turn=<PLAYER1|PLAYER2>;board=<64 chars>
+//         MUST_CONTINUE_CAPTURE|NO_OPPONENT_TO_CAPTURE|MUST_CAPTURE_MAX|
+//         MAN_CANNOT_CAPTURE_KING (italian)
+// Při úspěchu: všem v room: ID;GAME_STATE;room=<roomId>;turn=<PLAYER1|PLAYER2>;board=<size*size chars>
 // Příklad: 6;MOVE;1;5;0;4;1 -> 6;GAME_STATE;room=1;turn=PLAYER2;board=...
 void handleMove(
     const Message& msg,
@@ -875,7 +1264,7 @@ void handleMove(
     RoomsMap& rooms,
     PlayersMap& players,
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen,
     int turnTimeoutMs
 ) {
@@ -886,8 +1275,7 @@ void handleMove(
     if (msg.rawParams.size() < 5) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;INVALID_FORMAT;Missing roomId/fromRow/fromCol/toRow/toCol\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("INVALID_FORMAT");
         return;
     }
@@ -900,330 +1288,133 @@ void handleMove(
         !parseInt(msg.rawParams[4], toCol)) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;INVALID_FORMAT;Coordinates must be numbers\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("INVALID_FORMAT");
         return;
     }
 
-    auto itRoom = rooms.find(roomId);
-    if (itRoom == rooms.end()) {
-        std::string resp = std::to_string(msg.id) +
-                           ";ERROR;ROOM_NOT_FOUND\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-        registerInvalid("ROOM_NOT_FOUND");
-        return;
-    }
-
-    Room& room = itRoom->second;
-
-    if (room.status != RoomStatus::IN_GAME) {
-        std::string resp = std::to_string(msg.id) +
-                           ";ERROR;ROOM_NOT_IN_GAME\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-        registerInvalid("ROOM_NOT_IN_GAME");
-        return;
-    }
-
-    // najdeme index hráče v room
-    auto itKey = std::find(room.playerKeys.begin(), room.playerKeys.end(), playerToken);
-    if (itKey == room.playerKeys.end()) {
-        std::string resp = std::to_string(msg.id) +
-                           ";ERROR;NOT_IN_ROOM\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-        registerInvalid("NOT_IN_ROOM");
-        return;
-    }
-
-    std::size_t playerIndex = static_cast<std::size_t>(itKey - room.playerKeys.begin());
-    auto itPlayerObj = players.find(playerToken);
-    if (itPlayerObj == players.end()) {
-        std::string resp = std::to_string(msg.id) +
-                           ";ERROR;NOT_LOGGED_IN\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-        registerInvalid("NOT_LOGGED_IN");
-        return;
-    }
-    // deduplikace MOVE (ignoruj stejné nebo starší msg.id)
-    if (msg.id <= itPlayerObj->second.lastMoveMsgId) {
-        return;
-    }
-    itPlayerObj->second.lastMoveMsgId = msg.id;
-
-    // kontrola, jestli je na tahu
-    if ((room.turn == Turn::PLAYER1 && playerIndex != 0) ||
-        (room.turn == Turn::PLAYER2 && playerIndex != 1)) {
-        std::string resp = std::to_string(msg.id) +
-                           ";ERROR;NOT_YOUR_TURN\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-        registerInvalid("NOT_YOUR_TURN");
-        return;
-    }
-
-    if (roomHasPausedPlayer(room, players)) {
-        std::string resp = std::to_string(msg.id) +
-                           ";ERROR;GAME_PAUSED\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-        registerInvalid("GAME_PAUSED");
-        return;
-    }
-
-    if (room.captureLock.has_value()) {
-        auto [lockRow, lockCol] = *room.captureLock;
-        if (fromRow != lockRow || fromCol != lockCol) {
-            std::string resp = std::to_string(msg.id) +
-                               ";ERROR;MUST_CONTINUE_CAPTURE\n";
-            sendto(sockfd, resp.c_str(), resp.size(), 0,
-                   reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-            registerInvalid("MUST_CONTINUE_CAPTURE");
-            return;
-        }
-    }
-
-    // kontrola rozsahu
-    auto inRange = [](int v) { return v >= 0 && v < BOARD_SIZE; };
-    if (!inRange(fromRow) || !inRange(fromCol) ||
-        !inRange(toRow)   || !inRange(toCol)) {
-        std::string resp = std::to_string(msg.id) +
-                           ";ERROR;OUT_OF_BOARD\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-        registerInvalid("OUT_OF_BOARD");
+    bool isWhitePlayer = false;
+    Room* movingRoom = roomForMove(msg, roomId, playerToken, rooms, players,
+                                   sockfd, clientAddr, clientLen, isWhitePlayer);
+    if (!movingRoom) {
         return;
     }
+    Room& room = *movingRoom;
 
-    if (!isDarkSquare(fromRow, fromCol) || !isDarkSquare(toRow, toCol)) {
+    MoveResult result;
+    std::uint64_t key = tableKey(room);
+    std::string error = applyMove(room, isWhitePlayer, fromRow, fromCol, toRow, toCol, result);
+    if (!error.empty()) {
         std::string resp = std::to_string(msg.id) +
-                           ";ERROR;INVALID_SQUARE\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-        registerInvalid("INVALID_SQUARE");
+                           ";ERROR;" + error + "\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        registerInvalid(error);
         return;
     }
+    recordStep(room, key, isWhitePlayer, fromRow, fromCol, toRow, toCol);
 
-    char pieceFrom = getPiece(room, fromRow, fromCol);
-    char pieceTo   = getPiece(room, toRow, toCol);
+    finishMove(msg.id, room, players, sockfd, turnTimeoutMs, isWhitePlayer,
+               fromRow, fromCol, toRow, toCol, result);
+}
 
-    if (pieceFrom == '.') {
-        std::string resp = std::to_string(msg.id) +
-                           ";ERROR;NO_PIECE\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-        registerInvalid("NO_PIECE");
-        return;
-    }
+// MOVE_SEQ
+// Klient → server:  ID;MOVE_SEQ;<roomId>;<row,col>;<row,col>;...
+//   celý tah jedním datagramem: start a postupně všechna pole dopadu řetězu skoků
+//   (nebo start a cíl obyčejného tahu). Provede se celý, nebo vůbec.
+// Server → klient:  ID;ERROR;<CODE> se stejnými kódy jako MOVE; nedokončený řetěz
+//                  je MUST_CONTINUE_CAPTURE, pole za koncem řetězu INVALID_MOVE
+// Při úspěchu: všem v room jeden ID;GAME_STATE po celém řetězu
+// Příklad: 8;MOVE_SEQ;1;5,0;3,2;1,4 -> 8;GAME_STATE;room=1;turn=PLAYER2;board=...
+void handleMoveSeq(
+    const Message& msg,
+    const std::string& playerToken,
+    RoomsMap& rooms,
+    PlayersMap& players,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen,
+    int turnTimeoutMs
+) {
+    auto registerInvalid = [&](const std::string& code) {
+        registerInvalidMessage(playerToken, players, rooms, sockfd, code);
+    };
+    auto sendError = [&](const std::string& code, const std::string& text = "") {
+        std::string resp = std::to_string(msg.id) + ";ERROR;" + code;
+        if (!text.empty()) resp += ";" + text;
+        resp += "\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        registerInvalid(code);
+    };
 
-    // určíme barvu hráče: 0 = WHITE (w), 1 = BLACK (b)
-    bool isWhitePlayer = (playerIndex == 0);
-    if (pieceColor(pieceFrom) == PieceColor::NONE ||
-        (isWhitePlayer && pieceColor(pieceFrom) != PieceColor::WHITE) ||
-        (!isWhitePlayer && pieceColor(pieceFrom) != PieceColor::BLACK)) {
-        std::string resp = std::to_string(msg.id) +
-                           ";ERROR;NOT_YOUR_PIECE\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-        registerInvalid("NOT_YOUR_PIECE");
+    if (msg.rawParams.size() < 3) {
+        sendError("INVALID_FORMAT", "Missing roomId/squares");
         return;
     }
 
-    if (pieceTo != '.') {
-        std::string resp = std::to_string(msg.id) +
-                           ";ERROR;DEST_NOT_EMPTY\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-        registerInvalid("DEST_NOT_EMPTY");
+    int roomId = 0;
+    std::vector<std::pair<int, int>> squares;
+    bool parsed = parseInt(msg.rawParams[0], roomId);
+    for (std::size_t i = 1; parsed && i < msg.rawParams.size(); ++i) {
+        auto parts = split(msg.rawParams[i], ',');
+        int row = 0, col = 0;
+        parsed = parts.size() == 2 && parseInt(parts[0], row) && parseInt(parts[1], col);
+        squares.emplace_back(row, col);
+    }
+    if (!parsed) {
+        sendError("INVALID_FORMAT", "Squares must be row,col");
         return;
     }
 
-    int dRow = toRow - fromRow;
-    int dCol = toCol - fromCol;
-
-    if (std::abs(dRow) != std::abs(dCol) || dRow == 0) {
-        std::string resp = std::to_string(msg.id) +
-                           ";ERROR;INVALID_MOVE\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-        registerInvalid("INVALID_MOVE");
+    bool isWhitePlayer = false;
+    Room* movingRoom = roomForMove(msg, roomId, playerToken, rooms, players,
+                                   sockfd, clientAddr, clientLen, isWhitePlayer);
+    if (!movingRoom) {
         return;
     }
+    Room& room = *movingRoom;
 
-    PieceColor currentColor = isWhitePlayer ? PieceColor::WHITE : PieceColor::BLACK;
-    bool captureAvailable   = playerHasAnyCapture(room, currentColor);
-
-    bool isCapture = false;
-    int captureRow = -1, captureCol = -1;
-    bool pathInvalid = false;
-
-    if (isKing(pieceFrom)) {
-        int stepRow = (dRow > 0) ? 1 : -1;
-        int stepCol = (dCol > 0) ? 1 : -1;
-        int r = fromRow + stepRow;
-        int c = fromCol + stepCol;
-        int enemies = 0;
-
-        while (r != toRow || c != toCol) {
-            char cur = getPiece(room, r, c);
-            if (cur != '.') {
-                if (pieceColor(cur) == currentColor) {
-                    pathInvalid = true;
-                    break;
-                }
-                enemies++;
-                captureRow = r;
-                captureCol = c;
-                if (enemies > 1) {
-                    pathInvalid = true;
-                    break;
-                }
-            }
-            r += stepRow;
-            c += stepCol;
-        }
-
-        if (pathInvalid) {
-            std::string resp = std::to_string(msg.id) +
-                               ";ERROR;INVALID_MOVE\n";
-            sendto(sockfd, resp.c_str(), resp.size(), 0,
-                   reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-            registerInvalid("INVALID_MOVE");
-            return;
-        }
-
-        isCapture = (enemies == 1);
-        if (enemies == 0 && captureAvailable) {
-            std::string resp = std::to_string(msg.id) +
-                               ";ERROR;MUST_CAPTURE\n";
-            sendto(sockfd, resp.c_str(), resp.size(), 0,
-                   reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-            registerInvalid("MUST_CAPTURE");
-            return;
-        }
-    } else {
-        bool isSimple = (std::abs(dRow) == 1 && std::abs(dCol) == 1);
-        bool manCapture = (std::abs(dRow) == 2 && std::abs(dCol) == 2);
-
-        auto dirOkForMan = [&](int stepRow) {
-            if (isWhitePlayer) return stepRow == -1 || stepRow == -2;
-            return stepRow == 1 || stepRow == 2;
-        };
-
-        if (!isSimple && !manCapture) {
-            std::string resp = std::to_string(msg.id) +
-                               ";ERROR;INVALID_MOVE\n";
-            sendto(sockfd, resp.c_str(), resp.size(), 0,
-                   reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-            registerInvalid("INVALID_MOVE");
-            return;
-        }
+    // řetěz se zkouší na kopii pozice, místnost se změní až po celém platném tahu
+    Room trial = scratchPosition(room);
 
-        if (!dirOkForMan(dRow)) {
-            std::string resp = std::to_string(msg.id) +
-                               ";ERROR;INVALID_DIRECTION\n";
-            sendto(sockfd, resp.c_str(), resp.size(), 0,
-                   reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-            registerInvalid("INVALID_DIRECTION");
+    MoveResult result;
+    bool anyCapture = false;
+    std::vector<std::uint64_t> keys; // pro knihu zahájení, zapíše se až po celém tahu
+    for (std::size_t i = 1; i < squares.size(); ++i) {
+        if (i > 1 && !trial.captureLock.has_value()) {
+            sendError("INVALID_MOVE");
             return;
         }
-
-        if (isSimple && captureAvailable) {
-            std::string resp = std::to_string(msg.id) +
-                               ";ERROR;MUST_CAPTURE\n";
-            sendto(sockfd, resp.c_str(), resp.size(), 0,
-                   reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-            registerInvalid("MUST_CAPTURE");
+        keys.push_back(tableKey(trial));
+        std::string error = applyMove(trial, isWhitePlayer, squares[i - 1].first, squares[i - 1].second,
+                                      squares[i].first, squares[i].second, result);
+        if (!error.empty()) {
+            sendError(error);
             return;
         }
-
-        if (manCapture) {
-            captureRow = fromRow + dRow / 2;
-            captureCol = fromCol + dCol / 2;
-            char middlePiece = getPiece(room, captureRow, captureCol);
-            if (pieceColor(middlePiece) == PieceColor::NONE ||
-                pieceColor(middlePiece) == currentColor) {
-                std::string resp = std::to_string(msg.id) +
-                                   ";ERROR;NO_OPPONENT_TO_CAPTURE\n";
-                sendto(sockfd, resp.c_str(), resp.size(), 0,
-                       reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
-                registerInvalid("NO_OPPONENT_TO_CAPTURE");
-                return;
-            }
-            isCapture = true;
-        }
-    }
-
-    if (isCapture) {
-        setPiece(room, captureRow, captureCol, '.');
-    }
-
-    // provedeme tah
-    setPiece(room, toRow, toCol, pieceFrom);
-    setPiece(room, fromRow, fromCol, '.');
-
-    // povýšení na dámu
-    char placed = getPiece(room, toRow, toCol);
-    if (!isKing(placed)) {
-        if ((isWhitePlayer && toRow == 0) || (!isWhitePlayer && toRow == BOARD_SIZE - 1)) {
-            placed = isWhitePlayer ? 'W' : 'B';
-            setPiece(room, toRow, toCol, placed);
-        }
+        anyCapture = anyCapture || result.capture;
     }
-
-    bool captureContinues = false;
-    if (isCapture) {
-        PieceColor myColor = isWhitePlayer ? PieceColor::WHITE : PieceColor::BLACK;
-        std::vector<std::pair<int, int>> furtherCaptures;
-        if (isKing(placed)) {
-            furtherCaptures = kingCaptureMoves(room, toRow, toCol, myColor);
-        } else {
-            furtherCaptures = manCaptureMoves(room, toRow, toCol, isWhitePlayer, myColor);
-        }
-        captureContinues = !furtherCaptures.empty();
-    }
-
-    std::cout << "[INFO] MOVE room=" << room.id
-              << " from=" << fromRow << "," << fromCol
-              << " to=" << toRow << "," << toCol
-              << " player=" << (isWhitePlayer ? 1 : 2)
-              << " capture=" << (isCapture ? 1 : 0)
-              << " king=" << (isKing(placed) ? 1 : 0)
-              << std::endl;
-
-    if (captureContinues) {
-        room.captureLock = std::make_pair(toRow, toCol);
-    } else {
-        room.captureLock.reset();
-        room.turn = (room.turn == Turn::PLAYER1) ? Turn::PLAYER2 : Turn::PLAYER1;
+    if (trial.captureLock.has_value()) {
+        sendError("MUST_CONTINUE_CAPTURE");
+        return;
     }
-    room.remainingTurnMs = turnTimeoutMs;
-    room.lastTurnAt = std::chrono::steady_clock::now();
-
-    // vyhodnocení konce hry
-    PieceColor opponentColor = isWhitePlayer ? PieceColor::BLACK : PieceColor::WHITE;
-    bool opponentHasPieces = hasAnyPiece(room, opponentColor);
-    bool opponentHasMoves  = playerHasAnyMove(room, opponentColor);
 
-    broadcastGameState(msg.id, room, players, sockfd, turnTimeoutMs);
-
-    if (!opponentHasPieces) {
-        std::string reason = isWhitePlayer ? "WHITE_WIN_NO_PIECES" : "BLACK_WIN_NO_PIECES";
-        sendGameEnd(msg.id, room, players, sockfd, reason);
-        resetRoom(room);
-    } else if (!opponentHasMoves) {
-        std::string reason = isWhitePlayer ? "WHITE_WIN_NO_MOVES" : "BLACK_WIN_NO_MOVES";
-        sendGameEnd(msg.id, room, players, sockfd, reason);
-        resetRoom(room);
+    copyPosition(room, trial);
+    for (std::size_t i = 1; i < squares.size(); ++i) {
+        recordStep(room, keys[i - 1], isWhitePlayer, squares[i - 1].first, squares[i - 1].second,
+                          squares[i].first, squares[i].second);
     }
+    result.capture = anyCapture;
+    finishMove(msg.id, room, players, sockfd, turnTimeoutMs, isWhitePlayer,
+               squares.front().first, squares.front().second,
+               squares.back().first, squares.back().second, result);
 }
 
 // LEGAL_MOVES
-// Klient → server:  ID;LEGAL_MOVES;<roomId>;<row>;<col>
+// Klient → server:  ID;LEGAL_MOVES;<roomId>;<row>;<col>[;chains=1]
 // Server → klient:  ID;LEGAL_MOVES;room=<roomId>;from=<row,col>;to=<r1,c1>|<r2,c2>;mustCapture=<0|1>
+//                  s chains=1 navíc ;chains=<r,c>r,c>...|... (úplné řetězy skoků z pole row,col)
+//                  na tahu a v databázi koncovek navíc ;tb=<WIN|DRAW|LOSS>:<tahů>;tbBest=<r,c>|...
+//                  (cíle z row,col, kterými začíná některý optimální tah)
 // nebo:             ID;ERROR;INVALID_FORMAT|ROOM_NOT_FOUND|ROOM_NOT_IN_GAME|NOT_LOGGED_IN|NOT_IN_ROOM|NOT_YOUR_PIECE|NO_PIECE|MUST_CONTINUE_CAPTURE
 void handleLegalMoves(
     const Message& msg,
@@ -1231,8 +1422,9 @@ void handleLegalMoves(
     RoomsMap& rooms,
     PlayersMap& players,
     int sockfd,
-    const sockaddr_in& clientAddr,
-    socklen_t clientLen
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen,
+    const TablebaseSet* tablebases
 ) {
     auto registerInvalid = [&](const std::string& code) {
         registerInvalidMessage(playerToken, players, rooms, sockfd, code);
@@ -1241,8 +1433,7 @@ void handleLegalMoves(
     if (msg.rawParams.size() < 3) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;INVALID_FORMAT;Missing roomId/row/col\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("INVALID_FORMAT");
         return;
     }
@@ -1253,8 +1444,7 @@ void handleLegalMoves(
         !parseInt(msg.rawParams[2], col)) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;INVALID_FORMAT;roomId/row/col must be numbers\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("INVALID_FORMAT");
         return;
     }
@@ -1263,8 +1453,7 @@ void handleLegalMoves(
     if (itRoom == rooms.end()) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;ROOM_NOT_FOUND\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("ROOM_NOT_FOUND");
         return;
     }
@@ -1273,8 +1462,7 @@ void handleLegalMoves(
     if (room.status != RoomStatus::IN_GAME) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;ROOM_NOT_IN_GAME\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("ROOM_NOT_IN_GAME");
         return;
     }
@@ -1283,8 +1471,7 @@ void handleLegalMoves(
     if (itPlayer == players.end()) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;NOT_LOGGED_IN\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("NOT_LOGGED_IN");
         return;
     }
@@ -1293,8 +1480,7 @@ void handleLegalMoves(
     if (itKey == room.playerKeys.end()) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;NOT_IN_ROOM\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("NOT_IN_ROOM");
         return;
     }
@@ -1305,18 +1491,15 @@ void handleLegalMoves(
     if (roomHasPausedPlayer(room, players)) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;GAME_PAUSED\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("GAME_PAUSED");
         return;
     }
 
-    auto inRange = [](int v) { return v >= 0 && v < BOARD_SIZE; };
-    if (!inRange(row) || !inRange(col) || !isDarkSquare(row, col)) {
+    if (!inBoard(room, row, col) || !isDarkSquare(row, col)) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;INVALID_SQUARE\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("INVALID_SQUARE");
         return;
     }
@@ -1326,8 +1509,7 @@ void handleLegalMoves(
         if (row != lockRow || col != lockCol) {
             std::string resp = std::to_string(msg.id) +
                                ";ERROR;MUST_CONTINUE_CAPTURE\n";
-            sendto(sockfd, resp.c_str(), resp.size(), 0,
-                   reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+            sendDatagram(sockfd, resp, clientAddr, clientLen);
             registerInvalid("MUST_CONTINUE_CAPTURE");
             return;
         }
@@ -1337,8 +1519,7 @@ void handleLegalMoves(
     if (pieceFrom == '.') {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;NO_PIECE\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("NO_PIECE");
         return;
     }
@@ -1347,16 +1528,15 @@ void handleLegalMoves(
         (!isWhitePlayer && pieceColor(pieceFrom) != PieceColor::BLACK)) {
         std::string resp = std::to_string(msg.id) +
                            ";ERROR;NOT_YOUR_PIECE\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("NOT_YOUR_PIECE");
         return;
     }
 
     PieceColor myColor = isWhitePlayer ? PieceColor::WHITE : PieceColor::BLACK;
     bool globalCaptureAvailable = playerHasAnyCapture(room, myColor) || room.captureLock.has_value();
-    std::vector<std::pair<int, int>> captureMoves;
-    std::vector<std::pair<int, int>> simpleMoves;
+    MoveTargets captureMoves;
+    MoveTargets simpleMoves;
 
     if (isKing(pieceFrom)) {
         captureMoves = kingCaptureMoves(room, row, col, myColor);
@@ -1370,7 +1550,7 @@ void handleLegalMoves(
         }
     }
 
-    std::vector<std::pair<int, int>> dests;
+    MoveTargets dests;
     bool mustCaptureFlag = false;
 
     if (!captureMoves.empty()) {
@@ -1384,6 +1564,20 @@ void handleLegalMoves(
         mustCaptureFlag = false;
     }
 
+    auto itChains = msg.kvParams.find("chains");
+    bool wantChains = itChains != msg.kvParams.end() && itChains->second == "1";
+    static thread_local CaptureChainGenerator chains;
+    if (mustCaptureFlag && (room.maxCaptureRule || wantChains)) {
+        chains.generate(room);
+    }
+    if (mustCaptureFlag && room.maxCaptureRule) {
+        MoveTargets longest;
+        for (auto [toRow, toCol] : dests) {
+            if (chains.startsLongestChain(row, col, toRow, toCol)) longest.push_back(toRow, toCol);
+        }
+        dests = longest;
+    }
+
     std::stringstream ss;
     ss << msg.id << ";LEGAL_MOVES;"
        << "room=" << room.id
@@ -1393,11 +1587,42 @@ void handleLegalMoves(
         ss << dests[i].first << "," << dests[i].second;
         if (i + 1 < dests.size()) ss << "|";
     }
-    ss << ";mustCapture=" << (mustCaptureFlag ? 1 : 0) << "\n";
+    ss << ";mustCapture=" << (mustCaptureFlag ? 1 : 0);
+    if (wantChains) {
+        ss << ";chains=";
+        bool first = true;
+        for (std::size_t i = 0; mustCaptureFlag && i < chains.size(); ++i) {
+            auto chain = chains.chain(i);
+            if (chain.front() != std::make_pair(row, col)) continue;
+            if (room.maxCaptureRule && static_cast<int>(chain.size()) - 1 != chains.maxHops()) continue;
+            if (!first) ss << "|";
+            first = false;
+            for (std::size_t k = 0; k < chain.size(); ++k) {
+                if (k > 0) ss << ">";
+                ss << chain[k].first << "," << chain[k].second;
+            }
+        }
+    }
+    bool myTurn = room.turn == (isWhitePlayer ? Turn::PLAYER1 : Turn::PLAYER2);
+    if (tablebases && myTurn) {
+        if (auto tb = tablebaseBestMoves(*tablebases, room)) {
+            ss << ";tb=" << formatTablebaseValue(tb->value) << ";tbBest=";
+            bool first = true;
+            for (auto [toRow, toCol] : dests) {
+                bool optimal = std::any_of(tb->best.begin(), tb->best.end(), [&](const auto& move) {
+                    return move[0] == std::make_pair(row, col) && move[1] == std::make_pair(toRow, toCol);
+                });
+                if (!optimal) continue;
+                if (!first) ss << "|";
+                first = false;
+                ss << toRow << "," << toCol;
+            }
+        }
+    }
+    ss << "\n";
 
     auto resp = ss.str();
-    sendto(sockfd, resp.c_str(), resp.size(), 0,
-           reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
 }
 
 // LEAVE_ROOM
@@ -1413,7 +1638,7 @@ void handleLeaveRoom(
     RoomsMap& rooms,
     PlayersMap& players,
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen,
     int reconnectWindowMs
 ) {
@@ -1424,8 +1649,7 @@ void handleLeaveRoom(
     if (msg.rawParams.size() < 1) {
         std::string resp = std::to_string(msg.id) +
                             ";ERROR;INVALID_FORMAT;Missing roomId\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-                reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("INVALID_FORMAT");
         return;
     }
@@ -1434,8 +1658,7 @@ void handleLeaveRoom(
     if (!parseInt(msg.rawParams[0], roomId)) {
         std::string resp = std::to_string(msg.id) +
                             ";ERROR;INVALID_FORMAT;roomId must be number\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-                reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("INVALID_FORMAT");
         return;
     }
@@ -1444,8 +1667,7 @@ void handleLeaveRoom(
     if (itRoom == rooms.end()) {
         std::string resp = std::to_string(msg.id) +
             ";ERROR;ROOM_NOT_FOUND\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("ROOM_NOT_FOUND");
         return;
     }
@@ -1454,8 +1676,7 @@ void handleLeaveRoom(
     if (itPlayer == players.end()) {
         std::string resp = std::to_string(msg.id) +
             ";ERROR;NOT_LOGGED_IN\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-                reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("NOT_LOGGED_IN");
         return;
     }
@@ -1467,8 +1688,7 @@ void handleLeaveRoom(
     if (itKey == room.playerKeys.end()) {
         std::string resp = std::to_string(msg.id) +
                           ";ERROR;NOT_IN_ROOM\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         registerInvalid("NOT_IN_ROOM");
         return;
     }
@@ -1480,8 +1700,7 @@ void handleLeaveRoom(
     // potvrzení
     std::string resp = std::to_string(msg.id) +
                         ";LEAVE_ROOM_OK;room=" + std::to_string(roomId) + "\n";
-    sendto(sockfd, resp.c_str(), resp.size(), 0,
-            reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
 
     std::cout << "[INFO] LEAVE room=" << room.id
               << " key=" << playerToken << std::endl;
@@ -1498,10 +1717,6 @@ void handleLeaveRoom(
         const std::string& remainingKey = room.playerKeys[0];
         auto pit = players.find(remainingKey);
         if (pit != players.end()) {
-            const Player& player = pit->second;
-            sockaddr_in playerAddr = player.addr;
-            socklen_t playerLen = sizeof(playerAddr);
-
             std::string winner = leavingWasWhite ? "BLACK" : "WHITE";
             sendGameEnd(msg.id, room, players, sockfd, "OPPONENT_LEFT", winner);
 
@@ -1510,6 +1725,133 @@ void handleLeaveRoom(
         resetRoom(room);
     }
 }
+
+// RECONNECT
+// Klient → server:  ID;RECONNECT;<token>
+// Server → klient:  ID;RECONNECT_OK
+//                  nebo ID;ERROR;INVALID_FORMAT;Missing token
+//                  nebo ID;ERROR;TOKEN_NOT_FOUND|TOKEN_EXPIRED
+// Pokud jsou v místnosti oba hráči připojeni, oba dostanou GAME_STATE, jinak
+// volající dostane 0;GAME_PAUSED;room=<roomId>;resumeBy=<epochMs>
+void handleReconnect(
+    const Message& msg,
+    const EndpointKey& clientKey,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    EndpointMap& endpointToToken,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen,
+    int turnTimeoutMs,
+    int reconnectWindowMs
+) {
+    if (msg.rawParams.empty()) {
+        std::string resp = std::to_string(msg.id) + ";ERROR;INVALID_FORMAT;Missing token\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        return;
+    }
+    std::string token = msg.rawParams[0];
+    auto pitToken = players.find(token);
+    if (pitToken == players.end()) {
+        std::string resp = std::to_string(msg.id) + ";ERROR;TOKEN_NOT_FOUND\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        return;
+    }
+    Player& p = pitToken->second;
+    auto nowTs = steadyNow();
+    if (p.resumeDeadline != std::chrono::steady_clock::time_point{} &&
+        nowTs > p.resumeDeadline) {
+        std::string resp = std::to_string(msg.id) + ";ERROR;TOKEN_EXPIRED\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        return;
+    }
+
+    p.addr = clientAddr;
+    p.connected = true;
+    p.lastSeen = nowTs;
+    p.paused = false;
+    p.resumeDeadline = std::chrono::steady_clock::time_point{};
+    for (auto it = endpointToToken.begin(); it != endpointToToken.end();) {
+        if (it->second == token) {
+            it = endpointToToken.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    endpointToToken[clientKey] = token;
+    std::string resp = std::to_string(msg.id) + ";RECONNECT_OK\n";
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
+    std::cout << "[INFO] RECONNECT_OK token=" << token << " key=" << clientKey << std::endl;
+    // pošle poslední game state jen pokud jsou oba hráči připojeni (jinak zůstává pauza)
+    auto nowSys = systemNow();
+    for (auto& [roomId, room] : rooms) {
+        auto it = std::find(room.playerKeys.begin(), room.playerKeys.end(), token);
+        if (it == room.playerKeys.end()) continue;
+        if (room.status != RoomStatus::IN_GAME) continue;
+
+        bool allReady = true;
+        std::chrono::milliseconds::rep resumeByEpochMs = 0;
+        for (const auto& pKey : room.playerKeys) {
+            auto pit = players.find(pKey);
+            if (pit == players.end()) {
+                allReady = false;
+                continue;
+            }
+            const Player& rp = pit->second;
+            if (rp.paused || !rp.connected) {
+                allReady = false;
+            }
+            if (rp.paused && rp.resumeDeadline != std::chrono::steady_clock::time_point{}) {
+                auto remaining = rp.resumeDeadline - nowTs;
+                if (remaining > std::chrono::milliseconds::zero()) {
+                    auto candidate = nowSys + remaining;
+                    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        candidate.time_since_epoch()).count();
+                    resumeByEpochMs = std::max(resumeByEpochMs, ms);
+                }
+            }
+        }
+
+        if (allReady) {
+            // obnovit jen zmrazený časovač; běžící tah se reconnectem neresetuje
+            resumeTurnTimer(room, nowTs, turnTimeoutMs);
+            armBotTurn(room, nowTs);
+            for (const auto& pKey : room.playerKeys) {
+                auto pit = players.find(pKey);
+                if (pit == players.end() || pit->second.isBot) continue;
+                sendGameStateToPlayer(msg.id, room, pit->second, sockfd, turnTimeoutMs);
+            }
+        } else {
+            if (resumeByEpochMs == 0) {
+                resumeByEpochMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    (nowSys + std::chrono::milliseconds(reconnectWindowMs)).time_since_epoch()).count();
+            }
+            std::string pauseMsg = "0;GAME_PAUSED;room=" + std::to_string(room.id) +
+                                   ";resumeBy=" + std::to_string(p.sync.toClientMs(resumeByEpochMs)) + "\n";
+            sendDatagram(sockfd, pauseMsg, clientAddr, clientLen);
+        }
+    }
+}
+
+void checkFlagFall(Room& room, PlayersMap& players, int sockfd) {
+    if (room.status != RoomStatus::IN_GAME || !hasClock(room) ||
+        room.flagAt == std::chrono::steady_clock::time_point{}) {
+        return;
+    }
+    auto now = steadyNow();
+    if (now < room.flagAt) return;
+
+    std::size_t side = sideToMove(room);
+    std::string winner = "NONE";
+    if (room.playerKeys.size() > 1) winner = side == 0 ? "BLACK" : "WHITE";
+    std::cout << "[WARN] FLAG_FALL room=" << room.id
+              << " side=" << (side == 0 ? "WHITE" : "BLACK")
+              << " lateUs=" << std::chrono::duration_cast<std::chrono::microseconds>(now - room.flagAt).count()
+              << std::endl;
+    sendGameEnd(0, room, players, sockfd, "FLAG_FALL", winner);
+    resetRoom(room);
+}
+
 void checkTimeouts(
     PlayersMap& players,
     RoomsMap& rooms,
@@ -1520,7 +1862,7 @@ void checkTimeouts(
     int reconnectWindowMs,
     EndpointMap& endpointToToken
 ) {
-    auto now = std::chrono::steady_clock::now();
+    auto now = steadyNow();
 
     if (pauseThresholdMs > 0) {
         for (auto& [roomId, room] : rooms) {
@@ -1533,7 +1875,7 @@ void checkTimeouts(
             auto freezeAt = std::chrono::steady_clock::time_point{};
             for (const auto& key : room.playerKeys) {
                 auto pit = players.find(key);
-                if (pit == players.end()) continue;
+                if (pit == players.end() || pit->second.isBot) continue;
                 anyPlayer = true;
                 if (freezeAt == std::chrono::steady_clock::time_point{} || pit->second.lastSeen > freezeAt) {
                     freezeAt = pit->second.lastSeen;
@@ -1547,17 +1889,13 @@ void checkTimeouts(
 
             if (anyPlayer && allStale) {
                 auto effectiveFreezeAt = freezeAt == std::chrono::steady_clock::time_point{} ? now : freezeAt;
-                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(effectiveFreezeAt - room.lastTurnAt).count();
-                if (elapsed < 0) {
-                    elapsed = 0;
-                }
-                room.remainingTurnMs = std::max(0, turnTimeoutMs - static_cast<int>(elapsed));
-                room.lastTurnAt = std::chrono::steady_clock::time_point{}; // freeze timer during server outage
+                freezeTurnTimer(room, effectiveFreezeAt, turnTimeoutMs); // freeze timer during server outage
             }
         }
     }
 
     for (auto& [key, player] : players) {
+        if (player.isBot) continue;
         auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - player.lastSeen).count();
         if (elapsed > heartbeatTimeoutMs && !player.paused) {
             std::cout << "Player timeout: " << player.nick
@@ -1589,6 +1927,7 @@ void checkTimeouts(
     for (auto& [roomId, room] : rooms) {
         if (room.status != RoomStatus::IN_GAME) continue;
         if (room.lastTurnAt == std::chrono::steady_clock::time_point{}) continue;
+        if (hasClock(room)) continue; // hodiny hlídá checkFlagFall
 
         auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - room.lastTurnAt).count();
         if (elapsed > turnTimeoutMs) {
@@ -1692,14 +2031,13 @@ void handleBye(
     RoomsMap& rooms,
     EndpointMap& endpointToToken,
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen
 ) {
     auto pit = players.find(playerToken);
     if (pit == players.end()) {
         std::string resp = std::to_string(msg.id) + ";BYE_OK\n";
-        sendto(sockfd, resp.c_str(), resp.size(), 0,
-               reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
         return;
     }
 
@@ -1726,7 +2064,629 @@ void handleBye(
     players.erase(playerToken);
 
     std::string resp = std::to_string(msg.id) + ";BYE_OK\n";
-    sendto(sockfd, resp.c_str(), resp.size(), 0,
-           reinterpret_cast<const sockaddr*>(&clientAddr), clientLen);
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
     std::cout << "[INFO] BYE key=" << playerToken << " - removed player" << std::endl;
 }
+
+bool botToMove(const Room& room, const PlayersMap& players) {
+    return room.botLevel > 0 &&
+           room.status == RoomStatus::IN_GAME &&
+           room.turn == Turn::PLAYER2 &&
+           room.playerKeys.size() == ROOM_CAPACITY &&
+           room.playerKeys[1] == botToken(room.id) &&
+           !roomHasPausedPlayer(room, players);
+}
+
+void applyBotMove(Room& room, PlayersMap& players, int sockfd, int turnTimeoutMs, const BotMove& move)
+{
+    MoveResult result;
+    std::uint64_t key = tableKey(room);
+    std::string error = applyMove(room, false, move.fromRow, move.fromCol, move.toRow, move.toCol, result);
+    if (!error.empty()) {
+        // nemělo by nastat: bot hledá nad stejnými pravidly
+        std::cout << "[WARN] BOT_MOVE_REJECTED room=" << room.id << " code=" << error << std::endl;
+        return;
+    }
+    recordStep(room, key, false, move.fromRow, move.fromCol, move.toRow, move.toCol);
+    finishMove(0, room, players, sockfd, turnTimeoutMs, false,
+               move.fromRow, move.fromCol, move.toRow, move.toCol, result);
+}
+
+// ANALYZE
+// Klient → server:  ID;ANALYZE;<board>;<PLAYER1|PLAYER2>[;variant=<name>][;lock=<row>,<col>][;maxCapture=0|1]
+//                   [;depth=<n>][;ms=<n>][;nodes=<n>]
+// Server → klient:  ID;ANALYSIS;best=<r,c>r,c>;score=<n>;depth=<n>;nodes=<n>;pv=<r,c>r,c>|...;cached=<0|1>
+//                   [;tb=<WIN|DRAW|LOSS>:<tahů>] (pozici rozhodla databáze koncovek, pv je optimální tah)
+//                   [;book=<partií>:<výher>:<remíz>] (krok z knihy zahájení)
+//                   (hned z databáze, knihy nebo tabulky, jinak až po hledání v AnalysisPool)
+// nebo:             ID;ERROR;INVALID_FORMAT|INVALID_BOARD|ANALYSIS_PENDING|SERVER_BUSY
+void handleAnalyze(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    AnalysisPool& analysis,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+) {
+    auto sendError = [&](const std::string& code, const std::string& detail) {
+        std::string resp = std::to_string(msg.id) + ";ERROR;" + code + (detail.empty() ? "" : ";" + detail) + "\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+    };
+    auto rejectInvalid = [&](const std::string& code, const std::string& detail) {
+        sendError(code, detail);
+        registerInvalidMessage(playerToken, players, rooms, sockfd, code);
+    };
+
+    if (msg.rawParams.size() < 2) {
+        rejectInvalid("INVALID_FORMAT", "Missing board/turn");
+        return;
+    }
+
+    AnalysisJob job;
+    job.msgId = msg.id;
+    job.playerToken = playerToken;
+
+    auto itVariant = msg.kvParams.find("variant");
+    if (itVariant != msg.kvParams.end()) {
+        auto parsed = parseVariant(itVariant->second);
+        if (!parsed) {
+            rejectInvalid("INVALID_FORMAT", "Invalid variant");
+            return;
+        }
+        job.variant = *parsed;
+    }
+    job.maxCaptureRule = variantMaxCapture(job.variant);
+    auto itMaxCapture = msg.kvParams.find("maxCapture");
+    if (itMaxCapture != msg.kvParams.end()) {
+        if (itMaxCapture->second != "0" && itMaxCapture->second != "1") {
+            rejectInvalid("INVALID_FORMAT", "Invalid maxCapture");
+            return;
+        }
+        job.maxCaptureRule = itMaxCapture->second == "1";
+    }
+
+    const std::string& turn = msg.rawParams[1];
+    if (turn == "PLAYER1") {
+        job.turn = Turn::PLAYER1;
+    } else if (turn == "PLAYER2") {
+        job.turn = Turn::PLAYER2;
+    } else {
+        rejectInvalid("INVALID_FORMAT", "turn must be PLAYER1 or PLAYER2");
+        return;
+    }
+
+    // deska: size*size znaků .wbWB, kameny jen na tmavých polích
+    job.board = msg.rawParams[0];
+    int size = variantBoardSize(job.variant);
+    bool boardOk = job.board.size() == static_cast<std::size_t>(size * size);
+    for (std::size_t i = 0; boardOk && i < job.board.size(); ++i) {
+        char p = job.board[i];
+        int row = static_cast<int>(i) / size;
+        int col = static_cast<int>(i) % size;
+        boardOk = p == '.' || (pieceColor(p) != PieceColor::NONE && isDarkSquare(row, col));
+    }
+    if (!boardOk) {
+        rejectInvalid("INVALID_BOARD", "");
+        return;
+    }
+
+    auto itLock = msg.kvParams.find("lock");
+    if (itLock != msg.kvParams.end()) {
+        auto parts = split(itLock->second, ',');
+        int row = -1, col = -1;
+        bool lockOk = parts.size() == 2 && parseInt(parts[0], row) && parseInt(parts[1], col) &&
+                      row >= 0 && row < size && col >= 0 && col < size;
+        PieceColor side = job.turn == Turn::PLAYER1 ? PieceColor::WHITE : PieceColor::BLACK;
+        if (!lockOk || pieceColor(job.board[static_cast<std::size_t>(row * size + col)]) != side) {
+            rejectInvalid("INVALID_BOARD", "lock must be a piece of the side to move");
+            return;
+        }
+        job.captureLock = std::make_pair(row, col);
+    }
+
+    // limity hledání: výchozí, nebo z požadavku oříznuté na maximum serveru
+    job.limits = SearchLimits{ANALYSIS_DEFAULT_DEPTH, ANALYSIS_DEFAULT_MS, ANALYSIS_DEFAULT_NODES};
+    for (const char* key : {"depth", "ms", "nodes"}) {
+        auto it = msg.kvParams.find(key);
+        if (it == msg.kvParams.end()) continue;
+        int value = 0;
+        if (!parseInt(it->second, value) || value <= 0) {
+            rejectInvalid("INVALID_FORMAT", std::string(key) + " must be a positive number");
+            return;
+        }
+        if (std::string(key) == "depth") {
+            job.limits.maxDepth = std::min(value, ANALYSIS_MAX_DEPTH);
+        } else if (std::string(key) == "ms") {
+            job.limits.timeBudgetMs = std::min(value, ANALYSIS_MAX_MS);
+        } else {
+            job.limits.maxNodes = std::min(static_cast<std::uint64_t>(value), ANALYSIS_MAX_NODES);
+        }
+    }
+
+    auto itPlayer = players.find(playerToken);
+    if (itPlayer == players.end()) {
+        sendError("NOT_LOGGED_IN", "");
+        return;
+    }
+    Player& player = itPlayer->second;
+    if (player.analysisPending) {
+        sendError("ANALYSIS_PENDING", "");
+        return;
+    }
+
+    if (auto cached = analysis.lookup(job)) {
+        sendAnalysisResult(*cached, players, sockfd);
+        return;
+    }
+    if (!analysis.submit(job)) {
+        sendError("SERVER_BUSY", "");
+        std::cout << "[WARN] ANALYZE rejected, queue full key=" << playerToken << std::endl;
+        return;
+    }
+    player.analysisPending = true;
+    std::cout << "[INFO] ANALYZE queued key=" << playerToken
+              << " variant=" << variantName(job.variant)
+              << " depth=" << job.limits.maxDepth << std::endl;
+}
+
+void sendAnalysisResult(const AnalysisResult& result, PlayersMap& players, int sockfd)
+{
+    auto pit = players.find(result.job.playerToken);
+    if (pit == players.end()) return; // hráč mezitím odešel
+    Player& p = pit->second;
+    if (!result.cached) p.analysisPending = false;
+
+    auto formatMove = [](const BotMove& m) {
+        return std::to_string(m.fromRow) + "," + std::to_string(m.fromCol) + ">" +
+               std::to_string(m.toRow) + "," + std::to_string(m.toCol);
+    };
+    const SearchResult& search = result.search;
+    std::string resp = std::to_string(result.job.msgId) + ";ANALYSIS;best=" +
+                       (search.found ? formatMove(search.move) : std::string{}) +
+                       ";score=" + std::to_string(search.score) +
+                       ";depth=" + std::to_string(search.depth) +
+                       ";nodes=" + std::to_string(search.nodes) +
+                       ";pv=";
+    for (std::size_t i = 0; i < search.pv.size(); ++i) {
+        if (i > 0) resp += "|";
+        resp += formatMove(search.pv[i]);
+    }
+    resp += ";cached=" + std::string(result.cached ? "1" : "0");
+    if (search.tablebase) {
+        resp += ";tb=" + formatTablebaseValue(*search.tablebase);
+    }
+    if (search.book) {
+        resp += ";book=" + std::to_string(search.book->games) + ":" + std::to_string(search.book->wins) +
+                ":" + std::to_string(search.book->draws);
+    }
+    resp += "\n";
+
+    const sockaddr_storage& pAddr = p.addr;
+    sendDatagram(sockfd, resp, pAddr, addrLength(pAddr));
+    std::cout << "[INFO] ANALYSIS key=" << p.token
+              << " depth=" << search.depth
+              << " nodes=" << search.nodes
+              << " cached=" << (result.cached ? 1 : 0) << std::endl;
+}
+
+// GAMES
+// Klient → server:  ID;GAMES;player=<nick>|day=<YYYY-MM-DD>[;before=<gameId>]
+// Server → klient:  ID;GAMES;games=<id>|<id>|...;more=<0|1>
+//                   (z archivu, nejnovější první, nejvýš GAMES_LIST_LIMIT; další stránka přes before=<poslední id>)
+// nebo:             ID;ERROR;INVALID_FORMAT
+void handleGames(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    const GameArchive& archive,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+) {
+    auto rejectInvalid = [&](const std::string& detail) {
+        std::string resp = std::to_string(msg.id) + ";ERROR;INVALID_FORMAT;" + detail + "\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        registerInvalidMessage(playerToken, players, rooms, sockfd, "INVALID_FORMAT");
+    };
+
+    std::uint64_t before = 0;
+    auto itBefore = msg.kvParams.find("before");
+    if (itBefore != msg.kvParams.end()) {
+        try {
+            before = std::stoull(itBefore->second);
+        } catch (...) {
+            rejectInvalid("Invalid before");
+            return;
+        }
+    }
+
+    // o jednu víc, ať víme, jestli je další stránka
+    const std::size_t limit = GAMES_LIST_LIMIT + 1;
+    std::vector<std::uint64_t> ids;
+    auto itPlayer = msg.kvParams.find("player");
+    auto itDay = msg.kvParams.find("day");
+    if (itPlayer != msg.kvParams.end()) {
+        ids = archive.gamesOf(itPlayer->second, before, limit);
+    } else if (itDay != msg.kvParams.end()) {
+        auto day = parseArchiveDay(itDay->second);
+        if (!day) {
+            rejectInvalid("Invalid day");
+            return;
+        }
+        ids = archive.gamesOn(*day, before, limit);
+    } else {
+        rejectInvalid("Missing player/day");
+        return;
+    }
+
+    bool more = ids.size() > static_cast<std::size_t>(GAMES_LIST_LIMIT);
+    if (more) ids.pop_back();
+    std::string resp = std::to_string(msg.id) + ";GAMES;games=";
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        if (i > 0) resp += "|";
+        resp += std::to_string(ids[i]);
+    }
+    resp += ";more=" + std::string(more ? "1" : "0") + "\n";
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
+}
+
+// REPLAY
+// Klient → server:  ID;REPLAY;<gameId>[;from=<ply>]
+// Server → klient:  ID;REPLAY;game=<id>;variant=<name>[;maxCapture=1];white=<nick>;black=<nick>;date=<YYYY-MM-DD>
+//                   ;durationMs=<n>;reason=<...>;winner=<WHITE|BLACK|NONE>;steps=<n>
+//                   pak pozice od ply=from (nejvýš REPLAY_BATCH):
+//                   ID;REPLAY_POS;game=<id>;ply=<n>;turn=<PLAYER1|PLAYER2>;board=<...>;atMs=<n>[;step=<r,c>r,c>][;lock=<r>,<c>]
+//                   a nakonec ID;REPLAY_MORE;game=<id>;next=<ply> nebo ID;REPLAY_END;game=<id>
+//                   (pozice ply vznikla krokem step; datagramy se můžou ztratit, klient si dovyžádá from=)
+// nebo:             ID;ERROR;INVALID_FORMAT|GAME_NOT_FOUND|GAME_CORRUPT
+void handleReplay(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    const GameArchive& archive,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+) {
+    auto sendError = [&](const std::string& code) {
+        std::string resp = std::to_string(msg.id) + ";ERROR;" + code + "\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+    };
+
+    std::uint64_t gameId = 0;
+    int from = 0;
+    try {
+        if (msg.rawParams.empty()) throw std::invalid_argument("gameId");
+        gameId = std::stoull(msg.rawParams[0]);
+        auto itFrom = msg.kvParams.find("from");
+        if (itFrom != msg.kvParams.end()) from = std::stoi(itFrom->second);
+        if (from < 0) throw std::invalid_argument("from");
+    } catch (...) {
+        sendError("INVALID_FORMAT");
+        registerInvalidMessage(playerToken, players, rooms, sockfd, "INVALID_FORMAT");
+        return;
+    }
+
+    auto game = archive.read(gameId);
+    if (!game) {
+        sendError("GAME_NOT_FOUND");
+        registerInvalidMessage(playerToken, players, rooms, sockfd, "GAME_NOT_FOUND");
+        return;
+    }
+    std::size_t steps = game->steps.size();
+    if (static_cast<std::size_t>(from) > steps) {
+        sendError("INVALID_FORMAT");
+        registerInvalidMessage(playerToken, players, rooms, sockfd, "INVALID_FORMAT");
+        return;
+    }
+    Room room;
+    if (!replayArchivedGame(*game, static_cast<std::size_t>(from), room)) {
+        sendError("GAME_CORRUPT");
+        std::cout << "[WARN] REPLAY game=" << gameId << " does not replay" << std::endl;
+        return;
+    }
+
+    const std::string prefix = std::to_string(msg.id) + ";";
+    const std::string gameField = "game=" + std::to_string(gameId);
+    std::string header = prefix + "REPLAY;" + gameField + ";variant=" + variantName(game->variant) +
+                         (game->maxCaptureRule ? ";maxCapture=1" : "") +
+                         ";white=" + game->white + ";black=" + game->black +
+                         ";date=" + formatArchiveDay(game->day()) +
+                         ";durationMs=" + std::to_string(game->durationMs) +
+                         ";reason=" + game->reason + ";winner=" + game->winner +
+                         ";steps=" + std::to_string(steps) + "\n";
+    sendDatagram(sockfd, header, clientAddr, clientLen);
+
+    auto square = [](int sq) {
+        return std::to_string(sq / MAX_BOARD_SIZE) + "," + std::to_string(sq % MAX_BOARD_SIZE);
+    };
+    std::size_t end = std::min(steps, static_cast<std::size_t>(from) + REPLAY_BATCH - 1);
+    for (std::size_t ply = static_cast<std::size_t>(from); ply <= end; ++ply) {
+        if (ply > static_cast<std::size_t>(from)) {
+            const GameStep& step = game->steps[ply - 1];
+            MoveResult result;
+            if (!applyMove(room, step.white, step.fromSquare / MAX_BOARD_SIZE, step.fromSquare % MAX_BOARD_SIZE,
+                           step.toSquare / MAX_BOARD_SIZE, step.toSquare % MAX_BOARD_SIZE, result).empty()) {
+                sendError("GAME_CORRUPT");
+                return;
+            }
+        }
+        std::string pos = prefix + "REPLAY_POS;" + gameField + ";ply=" + std::to_string(ply) +
+                          ";turn=" + turnToString(room.turn) + ";board=" + room.board +
+                          ";atMs=" + std::to_string(ply == 0 ? 0 : game->steps[ply - 1].atMs);
+        if (ply > 0) {
+            pos += ";step=" + square(game->steps[ply - 1].fromSquare) + ">" + square(game->steps[ply - 1].toSquare);
+        }
+        if (room.captureLock) {
+            pos += ";lock=" + std::to_string(room.captureLock->first) + "," + std::to_string(room.captureLock->second);
+        }
+        sendDatagram(sockfd, pos + "\n", clientAddr, clientLen);
+    }
+    std::string tail = end < steps ? prefix + "REPLAY_MORE;" + gameField + ";next=" + std::to_string(end + 1) + "\n"
+                                   : prefix + "REPLAY_END;" + gameField + "\n";
+    sendDatagram(sockfd, tail, clientAddr, clientLen);
+}
+
+// Turnaj podle <tournamentId> v prvním parametru; jinak pošle chybu a vrátí nullptr
+static Tournament* tournamentFromParams(const Message& msg, const std::string& playerToken, TournamentSet& tournaments,
+                                        PlayersMap& players, RoomsMap& rooms, int sockfd,
+                                        const sockaddr_storage& clientAddr, socklen_t clientLen) {
+    int tournamentId = 0;
+    if (msg.rawParams.empty() || !parseInt(msg.rawParams[0], tournamentId)) {
+        std::string resp = std::to_string(msg.id) + ";ERROR;INVALID_FORMAT;Missing tournamentId\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        registerInvalidMessage(playerToken, players, rooms, sockfd, "INVALID_FORMAT");
+        return nullptr;
+    }
+    auto it = tournaments.byId.find(tournamentId);
+    if (it == tournaments.byId.end()) {
+        std::string resp = std::to_string(msg.id) + ";ERROR;TOURNAMENT_NOT_FOUND\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        return nullptr;
+    }
+    return &it->second;
+}
+
+// TOURNAMENT_CREATE
+// Klient → server:  ID;TOURNAMENT_CREATE;<name>;format=<swiss|roundrobin>[;rounds=<n>][;variant=<name>][;maxCapture=<0|1>]
+// Server → klient:  ID;TOURNAMENT_CREATE_OK;tournament=<id>
+//                  nebo ID;ERROR;INVALID_FORMAT;<detail>
+//                  nebo ID;ERROR;SERVER_FULL;Tournaments limit reached
+// Zakladatel je pořadatel (jen on smí TOURNAMENT_START); hrát chce-li, přihlásí se jako ostatní.
+// rounds= jen u švýcarského systému (výchozí log2 počtu hráčů), každý s každým hraje všechna kola.
+void handleTournamentCreate(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    TournamentSet& tournaments,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+) {
+    auto rejectInvalid = [&](const std::string& detail) {
+        std::string resp = std::to_string(msg.id) + ";ERROR;INVALID_FORMAT;" + detail + "\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        registerInvalidMessage(playerToken, players, rooms, sockfd, "INVALID_FORMAT");
+    };
+
+    if (msg.rawParams.empty() || msg.rawParams[0].find('=') != std::string::npos) {
+        rejectInvalid("Missing tournament name");
+        return;
+    }
+    const std::string& name = msg.rawParams[0];
+    if (hasInvalidDelims(name) || exceedsLimit(name, 64)) {
+        rejectInvalid("Invalid tournament name");
+        return;
+    }
+    auto itFormat = msg.kvParams.find("format");
+    auto format = itFormat != msg.kvParams.end() ? parseTournamentFormat(itFormat->second) : std::nullopt;
+    if (!format) {
+        rejectInvalid("Invalid format");
+        return;
+    }
+    int rounds = 0;
+    auto itRounds = msg.kvParams.find("rounds");
+    if (itRounds != msg.kvParams.end() &&
+        (!parseInt(itRounds->second, rounds) || rounds < 1 || rounds > TOURNAMENT_MAX_ROUNDS)) {
+        rejectInvalid("Invalid rounds");
+        return;
+    }
+    Variant variant = Variant::CZECH;
+    bool maxCaptureRule = false;
+    std::string rulesError = parseRulesParams(msg, variant, maxCaptureRule);
+    if (!rulesError.empty()) {
+        rejectInvalid(rulesError);
+        return;
+    }
+
+    auto open = std::count_if(tournaments.byId.begin(), tournaments.byId.end(), [](const auto& entry) {
+        return entry.second.status != TournamentStatus::FINISHED;
+    });
+    if (open >= TOURNAMENT_MAX_OPEN) {
+        std::string resp = std::to_string(msg.id) + ";ERROR;SERVER_FULL;Tournaments limit reached\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        return;
+    }
+
+    Tournament tournament;
+    tournament.id = tournaments.nextId++;
+    tournament.name = name;
+    tournament.organizer = players.at(playerToken).nick;
+    tournament.format = *format;
+    tournament.rounds = *format == TournamentFormat::SWISS ? rounds : 0;
+    tournament.variant = variant;
+    tournament.maxCaptureRule = maxCaptureRule;
+    int id = tournament.id;
+    tournaments.byId[id] = std::move(tournament);
+
+    std::string resp = std::to_string(msg.id) + ";TOURNAMENT_CREATE_OK;tournament=" + std::to_string(id) + "\n";
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
+    std::cout << "[INFO] TOURNAMENT_CREATE tournament=" << id
+              << " name=" << name
+              << " format=" << tournamentFormatName(*format)
+              << " variant=" << variantName(variant) << std::endl;
+}
+
+// TOURNAMENT_JOIN
+// Klient → server:  ID;TOURNAMENT_JOIN;<tournamentId>
+// Server → klient:  ID;TOURNAMENT_JOIN_OK;tournament=<id>;players=<count>
+//                  nebo ID;ERROR;TOURNAMENT_NOT_FOUND|TOURNAMENT_STARTED|TOURNAMENT_FULL
+// Nasazení podle hodnocení při přihlášení; opakovaný JOIN nic nemění.
+void handleTournamentJoin(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    TournamentSet& tournaments,
+    const RatingTable& ratings,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+) {
+    Tournament* tournament = tournamentFromParams(msg, playerToken, tournaments, players, rooms,
+                                                  sockfd, clientAddr, clientLen);
+    if (!tournament) return;
+    const std::string& nick = players.at(playerToken).nick;
+    if (tournament->status != TournamentStatus::REGISTERING && !tournament->entrantOf(nick)) {
+        std::string resp = std::to_string(msg.id) + ";ERROR;TOURNAMENT_STARTED\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        return;
+    }
+    if (tournament->addEntrant(nick, ratings.get(nick).rating) < 0) {
+        std::string resp = std::to_string(msg.id) + ";ERROR;TOURNAMENT_FULL\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        return;
+    }
+    std::string resp = std::to_string(msg.id) + ";TOURNAMENT_JOIN_OK;tournament=" + std::to_string(tournament->id) +
+                       ";players=" + std::to_string(tournament->entrants.size()) + "\n";
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
+}
+
+// TOURNAMENT_LEAVE
+// Klient → server:  ID;TOURNAMENT_LEAVE;<tournamentId>
+// Server → klient:  ID;TOURNAMENT_LEAVE_OK;tournament=<id>
+//                  nebo ID;ERROR;TOURNAMENT_NOT_FOUND|NOT_IN_TOURNAMENT
+// Před startem odhlásí, za běhu hráč odstoupí: rozehranou partii dohraje, dál se nepáruje.
+void handleTournamentLeave(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    TournamentSet& tournaments,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+) {
+    Tournament* tournament = tournamentFromParams(msg, playerToken, tournaments, players, rooms,
+                                                  sockfd, clientAddr, clientLen);
+    if (!tournament) return;
+    auto entrant = tournament->entrantOf(players.at(playerToken).nick);
+    if (!entrant || tournament->entrants[static_cast<std::size_t>(*entrant)].withdrawn) {
+        std::string resp = std::to_string(msg.id) + ";ERROR;NOT_IN_TOURNAMENT\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        return;
+    }
+    if (tournament->status == TournamentStatus::REGISTERING) {
+        tournament->entrants.erase(tournament->entrants.begin() + *entrant);
+    } else {
+        tournament->entrants[static_cast<std::size_t>(*entrant)].withdrawn = true;
+    }
+    std::string resp = std::to_string(msg.id) + ";TOURNAMENT_LEAVE_OK;tournament=" +
+                       std::to_string(tournament->id) + "\n";
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
+}
+
+// TOURNAMENT_START
+// Klient → server:  ID;TOURNAMENT_START;<tournamentId>
+// Server → klient:  ID;TOURNAMENT_START_OK;tournament=<id>;players=<count>;rounds=<n>
+//                  nebo ID;ERROR;TOURNAMENT_NOT_FOUND|NOT_ORGANIZER|TOURNAMENT_STARTED|NOT_ENOUGH_PLAYERS
+// Spáruje první kolo; stoly založí server při nejbližším kole runTournaments, hráčům přijde
+// 0;TOURNAMENT_GAME a GAME_START (nebo 0;TOURNAMENT_BYE).
+void handleTournamentStart(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    TournamentSet& tournaments,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+) {
+    Tournament* tournament = tournamentFromParams(msg, playerToken, tournaments, players, rooms,
+                                                  sockfd, clientAddr, clientLen);
+    if (!tournament) return;
+    std::string error;
+    if (tournament->organizer != players.at(playerToken).nick) {
+        error = "NOT_ORGANIZER";
+    } else if (tournament->status != TournamentStatus::REGISTERING) {
+        error = "TOURNAMENT_STARTED";
+    } else if (tournament->entrants.size() < 2) {
+        error = "NOT_ENOUGH_PLAYERS";
+    }
+    if (!error.empty()) {
+        std::string resp = std::to_string(msg.id) + ";ERROR;" + error + "\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        return;
+    }
+
+    tournament->startNextRound(steadyNow());
+    std::string resp = std::to_string(msg.id) + ";TOURNAMENT_START_OK;tournament=" + std::to_string(tournament->id) +
+                       ";players=" + std::to_string(tournament->entrants.size()) +
+                       ";rounds=" + std::to_string(tournament->rounds) + "\n";
+    sendDatagram(sockfd, resp, clientAddr, clientLen);
+    std::cout << "[INFO] TOURNAMENT_START tournament=" << tournament->id
+              << " players=" << tournament->entrants.size()
+              << " rounds=" << tournament->rounds
+              << " boards=" << tournament->boards.size() << std::endl;
+}
+
+// TOURNAMENT_STANDINGS
+// Klient → server:  ID;TOURNAMENT_STANDINGS;<tournamentId>
+// Server → klient:  ID;TOURNAMENT;tournament=<id>;name=<name>;format=<swiss|roundrobin>;status=<REGISTERING|RUNNING|FINISHED>
+//                     ;round=<n>;rounds=<n>;players=<count>
+//                   ID;STANDING;tournament=<id>;rank=<n>;nick=<nick>;score=<s>;buchholz=<s>;sb=<s>  (prvních
+//                     TOURNAMENT_STANDINGS_LIMIT a volající, pokud mezi nimi není; každý řádek zvlášť)
+//                  nebo ID;ERROR;TOURNAMENT_NOT_FOUND
+void handleTournamentStandings(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    TournamentSet& tournaments,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+) {
+    Tournament* tournament = tournamentFromParams(msg, playerToken, tournaments, players, rooms,
+                                                  sockfd, clientAddr, clientLen);
+    if (!tournament) return;
+    std::string prefix = std::to_string(msg.id) + ";";
+    std::string idField = "tournament=" + std::to_string(tournament->id);
+    std::string header = prefix + "TOURNAMENT;" + idField +
+                         ";name=" + tournament->name +
+                         ";format=" + tournamentFormatName(tournament->format) +
+                         ";status=" + tournamentStatusName(tournament->status) +
+                         ";round=" + std::to_string(tournament->round) +
+                         ";rounds=" + std::to_string(tournament->rounds) +
+                         ";players=" + std::to_string(tournament->entrants.size()) + "\n";
+    sendDatagram(sockfd, header, clientAddr, clientLen);
+
+    auto own = tournament->entrantOf(players.at(playerToken).nick);
+    auto standings = tournament->standings();
+    for (std::size_t rank = 0; rank < standings.size(); ++rank) {
+        const TournamentStanding& s = standings[rank];
+        if (rank >= TOURNAMENT_STANDINGS_LIMIT && (!own || s.entrant != *own)) continue;
+        std::string line = prefix + "STANDING;" + idField +
+                           ";rank=" + std::to_string(rank + 1) +
+                           ";nick=" + tournament->entrants[static_cast<std::size_t>(s.entrant)].nick +
+                           ";score=" + formatScore(s.score) +
+                           ";buchholz=" + formatScore(s.buchholz) +
+                           ";sb=" + formatScore(s.sonnebornBerger) + "\n";
+        sendDatagram(sockfd, line, clientAddr, clientLen);
+    }
+}
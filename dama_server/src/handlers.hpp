@@ -1,15 +1,24 @@
 #pragma once
 
 #include <map>
+#include <unordered_map>
 #include <netinet/in.h>
 
 #include "protocol.hpp"
+#include "accounts.hpp"
 #include "models.hpp"
+#include "analysis.hpp"
+#include "archive.hpp"
+#include "bot.hpp"
+#include "cluster.hpp"
+#include "matchmaking.hpp"
+#include "rating.hpp"
+#include "tournament.hpp"
 
 // Pro zkrácení zápisu
 
 using PlayersMap = std::map<std::string, Player>; // token -> Player
-using EndpointMap = std::map<std::string, std::string>; // clientKey -> token
+using EndpointMap = std::unordered_map<EndpointKey, std::string, EndpointKeyHash>; // clientKey -> token
 using RoomsMap   = std::map<int, Room>;           // roomId   -> Room
 
 void sendConfig(Player& player, int sockfd, int turnTimeoutMs);
@@ -21,30 +30,33 @@ void registerInvalidMessage(const std::string& playerToken, PlayersMap& players,
 
 void handleLogin(
     const Message& msg,
-    const std::string& clientKey,
+    const EndpointKey& clientKey,
     PlayersMap& players,
     int& nextPlayerId,
     const ServerLimits& limits,
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen,
     int turnTimeoutMs,
     int reconnectWindowMs,
-    EndpointMap& endpointToToken
+    EndpointMap& endpointToToken,
+    AccountStore* accounts = nullptr // s účty (--accounts) LOGIN_OK nese i číslo účtu a hodnocení
 );
 
 void handlePing(
     const Message& msg,
+    Player* player, // nullptr před LOGIN: jen časy, bez odhadu
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen
 );
 
 void handleListRooms(
     const Message& msg,
     const RoomsMap& rooms,
+    const Cluster* cluster, // nullptr mimo cluster: bez node= a řádků NODE
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen
 );
 
@@ -56,7 +68,7 @@ void handleCreateRoom(
     int& nextRoomId,
     const ServerLimits& limits,
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen,
     ServerLimits& mutableLimits
 );
@@ -67,18 +79,110 @@ void handleJoinRoom(
     RoomsMap& rooms,
     PlayersMap& players,
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen,
     int turnTimeoutMs
 );
 
+// Plný stůl (playerKeys[0] bílý, [1] černý): počáteční pozice, GAME_START a GAME_STATE
+void startGame(int msgId, Room& room, PlayersMap& players, int sockfd, int turnTimeoutMs);
+
+void handleQuickMatch(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    MatchQueue& matches,
+    const RatingTable& ratings,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+);
+
+void handleQuickMatchCancel(
+    const Message& msg,
+    const std::string& playerToken,
+    MatchQueue& matches,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+);
+
+// TOURNAMENT_*: správa turnajů; stoly pro kola zakládá runTournaments v server.cpp
+void handleTournamentCreate(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    TournamentSet& tournaments,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+);
+
+void handleTournamentJoin(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    TournamentSet& tournaments,
+    const RatingTable& ratings,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+);
+
+void handleTournamentLeave(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    TournamentSet& tournaments,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+);
+
+void handleTournamentStart(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    TournamentSet& tournaments,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+);
+
+void handleTournamentStandings(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    TournamentSet& tournaments,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+);
+
 void handleMove(
     const Message& msg,
     const std::string& playerToken,
     RoomsMap& rooms,
     PlayersMap& players,
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen,
+    int turnTimeoutMs
+);
+
+void handleMoveSeq(
+    const Message& msg,
+    const std::string& playerToken,
+    RoomsMap& rooms,
+    PlayersMap& players,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen,
     int turnTimeoutMs
 );
@@ -89,21 +193,40 @@ void handleLeaveRoom(
     RoomsMap& rooms,
     PlayersMap& players,
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen,
     int reconnectWindowMs
 );
 
+// tablebases může být nullptr (bez značek tb=/tbBest=)
 void handleLegalMoves(
     const Message& msg,
     const std::string& playerToken,
     RoomsMap& rooms,
     PlayersMap& players,
     int sockfd,
-    const sockaddr_in& clientAddr,
-    socklen_t clientLen
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen,
+    const TablebaseSet* tablebases = nullptr
 );
 
+void handleReconnect(
+    const Message& msg,
+    const EndpointKey& clientKey,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    EndpointMap& endpointToToken,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen,
+    int turnTimeoutMs,
+    int reconnectWindowMs
+);
+
+// Termín z armRoomDeadline: hráči na tahu došel čas na hodinách -> GAME_END;reason=FLAG_FALL
+// a vyhrává soupeř. Termín, který mezitím přestal platit (tah, pauza, konec partie), nic nedělá.
+void checkFlagFall(Room& room, PlayersMap& players, int sockfd);
+
 void checkTimeouts(
     PlayersMap& players,
     RoomsMap& rooms,
@@ -122,6 +245,48 @@ void handleBye(
     RoomsMap& rooms,
     EndpointMap& endpointToToken,
     int sockfd,
-    const sockaddr_in& clientAddr,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+);
+
+// Bot (CREATE_ROOM;...;bot=<level>): je na tahu a hra není pozastavená?
+bool botToMove(const Room& room, const PlayersMap& players);
+
+// Provede tah spočítaný v BotPool stejnou cestou jako MOVE od klienta
+void applyBotMove(Room& room, PlayersMap& players, int sockfd, int turnTimeoutMs, const BotMove& move);
+
+void handleAnalyze(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    AnalysisPool& analysis,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+);
+
+// Pošle ANALYSIS hráči, který rozbor zadal (z tabulky hned, jinak z AnalysisPool)
+void sendAnalysisResult(const AnalysisResult& result, PlayersMap& players, int sockfd);
+
+void handleGames(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    const GameArchive& archive,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
+    socklen_t clientLen
+);
+
+void handleReplay(
+    const Message& msg,
+    const std::string& playerToken,
+    PlayersMap& players,
+    RoomsMap& rooms,
+    const GameArchive& archive,
+    int sockfd,
+    const sockaddr_storage& clientAddr,
     socklen_t clientLen
 );
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Pool vláken pro výpočty mimo UDP smyčku (tahy bota, analýzy).
+// Hotové výsledky si vyzvedává herní vlákno přes takeResults(); wakeFd() je
+// čitelný, když nějaký výsledek čeká (pro poll v main.cpp).
+// threads == 0 je synchronní režim pro simulaci: úlohy se spočítají až v
+// takeResults() na volajícím vlákně a bez časového limitu, takže běh je deterministický.
+template <class Job, class Result>
+class JobPool {
+public:
+    // run(job, useTimeBudget): false v synchronním režimu
+    using RunFn = std::function<Result(const Job&, bool)>;
+
+    JobPool(int threads, RunFn run) : run(std::move(run)) {
+        if (threads <= 0) {
+            return;
+        }
+        int fds[2];
+        if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0) {
+            wakeRead = fds[0];
+            wakeWrite = fds[1];
+        } else {
+            perror("pipe2 job pool");
+        }
+        for (int i = 0; i < threads; ++i) {
+            workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ~JobPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        jobReady.notify_all();
+        for (auto& t : workers) {
+            t.join();
+        }
+        if (wakeRead >= 0) close(wakeRead);
+        if (wakeWrite >= 0) close(wakeWrite);
+    }
+
+    JobPool(const JobPool&) = delete;
+    JobPool& operator=(const JobPool&) = delete;
+
+    void submit(Job job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        jobReady.notify_one();
+    }
+
+    std::vector<Result> takeResults() {
+        std::vector<Result> out;
+        if (workers.empty()) {
+            // synchronní režim: spočítat hned, deterministicky
+            std::deque<Job> pending;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending.swap(jobs);
+            }
+            for (const auto& job : pending) {
+                out.push_back(run(job, false));
+            }
+            return out;
+        }
+
+        if (wakeRead >= 0) {
+            char drain[64];
+            while (read(wakeRead, drain, sizeof(drain)) > 0) {
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        out.swap(done);
+        inFlight -= out.size();
+        return out;
+    }
+
+    // Úlohy zadané a ještě nevyzvednuté (ve frontě, počítané i hotové)
+    std::size_t backlog() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return jobs.size() + inFlight;
+    }
+
+    int wakeFd() const { return wakeRead; }
+
+private:
+    void workerLoop() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                jobReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (stopping) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                ++inFlight;
+            }
+
+            Result result = run(job, true);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.push_back(std::move(result));
+            }
+            if (wakeWrite >= 0) {
+                char byte = 1;
+                ssize_t ignored = write(wakeWrite, &byte, 1);
+                (void)ignored;
+            }
+        }
+    }
+
+    RunFn run;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    std::deque<Job> jobs;
+    std::vector<Result> done;
+    std::size_t inFlight = 0; // vzaté workerem, dokud je nevyzvedne takeResults
+    bool stopping = false;
+    int wakeRead = -1;
+    int wakeWrite = -1;
+};
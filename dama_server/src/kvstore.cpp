@@ -0,0 +1,245 @@
+#include "kvstore.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "binio.hpp"
+
+namespace {
+
+std::string encodeRecord(std::uint8_t type, const std::string& key, const std::string& value) {
+    std::string body;
+    body.reserve(KV_RECORD_HEADER_SIZE - 4 + key.size() + value.size());
+    body.push_back(static_cast<char>(type));
+    putU16(body, static_cast<std::uint16_t>(key.size()));
+    putU32(body, static_cast<std::uint32_t>(value.size()));
+    body += key;
+    body += value;
+    std::string record;
+    putU32(record, checksum32(reinterpret_cast<const std::uint8_t*>(body.data()), body.size()));
+    return record + body;
+}
+
+std::uint64_t recordSize(const std::string& key, const std::string& value) {
+    return KV_RECORD_HEADER_SIZE + key.size() + value.size();
+}
+
+bool writeAll(int fd, const std::string& bytes) {
+    std::size_t done = 0;
+    while (done < bytes.size()) {
+        ssize_t n = ::write(fd, bytes.data() + done, bytes.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+std::string directoryOf(const std::string& path) {
+    auto slash = path.rfind('/');
+    if (slash == std::string::npos) return ".";
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+} // namespace
+
+KvStore::~KvStore() {
+    if (writer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        jobReady.notify_one();
+        writer.join(); // dopíše, co zbylo ve frontě
+    }
+    if (fd >= 0) close(fd);
+}
+
+bool KvStore::open(const std::string& filePath, std::string& error) {
+    path = filePath;
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (in) bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    if (bytes.empty()) {
+        bytes.assign(KV_MAGIC, sizeof(KV_MAGIC));
+        if (!writeAll(fd, bytes) || fdatasync(fd) != 0) {
+            error = path + ": " + std::strerror(errno);
+            return false;
+        }
+    } else if (bytes.size() < sizeof(KV_MAGIC) || std::memcmp(bytes.data(), KV_MAGIC, sizeof(KV_MAGIC)) != 0) {
+        error = path + ": not a key-value store";
+        return false;
+    }
+
+    const auto* p = reinterpret_cast<const std::uint8_t*>(bytes.data());
+    std::size_t offset = sizeof(KV_MAGIC);
+    liveSize = offset;
+    while (offset + KV_RECORD_HEADER_SIZE <= bytes.size()) {
+        const std::uint8_t* r = p + offset;
+        std::uint8_t type = r[4];
+        std::size_t keyLen = static_cast<std::size_t>(readLittleEndian(r + 5, 2));
+        std::size_t valueLen = static_cast<std::size_t>(readLittleEndian(r + 7, 4));
+        std::size_t total = KV_RECORD_HEADER_SIZE + keyLen + valueLen;
+        if (total > bytes.size() - offset || (type != KV_PUT && type != KV_ERASE) ||
+            checksum32(r + 4, total - 4) != readLittleEndian(r, 4)) {
+            break;
+        }
+        std::string key(reinterpret_cast<const char*>(r + KV_RECORD_HEADER_SIZE), keyLen);
+        auto it = values.find(key);
+        if (it != values.end()) liveSize -= recordSize(key, it->second);
+        if (type == KV_PUT) {
+            std::string value(reinterpret_cast<const char*>(r + KV_RECORD_HEADER_SIZE + keyLen), valueLen);
+            liveSize += recordSize(key, value);
+            values[std::move(key)] = std::move(value);
+        } else if (it != values.end()) {
+            values.erase(it);
+        }
+        offset += total;
+    }
+    if (offset < bytes.size()) {
+        std::cout << "[WARN] " << path << ": dropping " << (bytes.size() - offset)
+                  << " damaged bytes at offset " << offset << std::endl;
+        if (ftruncate(fd, static_cast<off_t>(offset)) != 0 || fdatasync(fd) != 0) {
+            error = path + ": " + std::strerror(errno);
+            return false;
+        }
+    }
+    fileSize = offset;
+    if (lseek(fd, 0, SEEK_END) < 0) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    writer = std::thread([this]() { writerLoop(); });
+    return true;
+}
+
+const std::string* KvStore::get(const std::string& key) const {
+    auto it = values.find(key);
+    return it != values.end() ? &it->second : nullptr;
+}
+
+void KvStore::put(const std::string& key, const std::string& value) {
+    if (key.size() > KV_MAX_KEY) return;
+    auto it = values.find(key);
+    if (it != values.end()) {
+        liveSize -= recordSize(key, it->second);
+        it->second = value;
+    } else {
+        values.emplace(key, value);
+    }
+    std::uint64_t size = recordSize(key, value);
+    liveSize += size;
+    fileSize += size;
+    submit(encodeRecord(KV_PUT, key, value), false);
+    maybeCompact();
+}
+
+bool KvStore::erase(const std::string& key) {
+    auto it = values.find(key);
+    if (it == values.end()) return false;
+    liveSize -= recordSize(key, it->second);
+    values.erase(it);
+    fileSize += recordSize(key, std::string());
+    submit(encodeRecord(KV_ERASE, key, std::string()), false);
+    maybeCompact();
+    return true;
+}
+
+void KvStore::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    drained.wait(lock, [this]() { return jobs.empty() && !writing; });
+}
+
+void KvStore::submit(std::string record, bool rewrite) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // po sobě jdoucí zápisy jedním write a jedním fdatasync
+        if (!rewrite && !jobs.empty() && !jobs.back().rewrite) {
+            jobs.back().bytes += record;
+        } else {
+            jobs.push_back(WriteJob{rewrite, std::move(record)});
+        }
+    }
+    jobReady.notify_one();
+}
+
+// Obraz nového souboru se skládá tady (má ho jen toto vlákno), zapisuje ho vlákno
+void KvStore::maybeCompact() {
+    if (fileSize < KV_COMPACT_MIN_BYTES || fileSize < 2 * liveSize) return;
+    std::string image(KV_MAGIC, sizeof(KV_MAGIC));
+    image.reserve(liveSize);
+    for (const auto& [key, value] : values) {
+        image += encodeRecord(KV_PUT, key, value);
+    }
+    fileSize = image.size();
+    ++compactionCount;
+    submit(std::move(image), true);
+}
+
+void KvStore::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        jobReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+        if (jobs.empty()) break;
+        std::deque<WriteJob> batch;
+        batch.swap(jobs);
+        writing = true;
+        lock.unlock();
+
+        for (const WriteJob& job : batch) {
+            if (job.rewrite) {
+                replaceFile(job.bytes);
+            } else if (!writeAll(fd, job.bytes)) {
+                std::cout << "[WARN] " << path << ": write failed: " << std::strerror(errno) << std::endl;
+            }
+        }
+        if (fdatasync(fd) != 0) {
+            std::cout << "[WARN] " << path << ": fdatasync failed: " << std::strerror(errno) << std::endl;
+        }
+
+        lock.lock();
+        writing = false;
+        drained.notify_all();
+    }
+}
+
+// Nový soubor vedle starého, na disk, pak rename; při chybě se pokračuje ve starém
+// (ten má všechny dřívější zápisy, takže o nic nepřijdeme)
+bool KvStore::replaceFile(const std::string& image) {
+    std::string tmp = path + ".compact";
+    int out = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = out >= 0 && writeAll(out, image) && fsync(out) == 0 && std::rename(tmp.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        std::cout << "[WARN] " << path << ": compaction failed: " << std::strerror(errno) << std::endl;
+        if (out >= 0) close(out);
+        std::remove(tmp.c_str());
+        return false;
+    }
+    int dir = ::open(directoryOf(path).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir >= 0) {
+        fsync(dir);
+        close(dir);
+    }
+    close(fd);
+    fd = out;
+    std::cout << "[INFO] " << path << ": compacted to " << image.size() << " bytes" << std::endl;
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Malé úložiště klíč -> hodnota v jednom souboru (účty hráčů). Soubor je log: každý
+// zápis i smazání se připíše na konec, hodnoty všech klíčů drží paměť, takže čtení
+// nejde na disk. Při otevření se log přečte celý; useknutý nebo poškozený konec (pád
+// uprostřed zápisu) se zahodí a soubor se na něm zkrátí.
+//
+// put a erase jen změní paměť a připraví záznam; na disk ho zapisuje vlákno na pozadí,
+// co se mezitím nasbírá, jde jedním write a jedním fdatasync. Když mrtvé záznamy
+// (přepsané a smazané klíče) zaberou víc než polovinu souboru, zapíše se vedle nový
+// soubor jen s živými klíči a přejmenuje se přes starý.
+//
+// Soubor: KV_MAGIC a záznamy: kontrolní součet (u32, z dalších bajtů záznamu), typ
+// (u8, KV_PUT/KV_ERASE), délka klíče (u16), délka hodnoty (u32), klíč a hodnota.
+
+constexpr char KV_MAGIC[8] = {'D', 'A', 'M', 'A', 'K', 'V', '1', '\n'};
+constexpr std::size_t KV_RECORD_HEADER_SIZE = 11;
+constexpr std::uint8_t KV_PUT = 1;
+constexpr std::uint8_t KV_ERASE = 2;
+constexpr std::size_t KV_MAX_KEY = 65535;
+constexpr std::uint64_t KV_COMPACT_MIN_BYTES = 1 << 20; // menší soubor se nepřepisuje
+
+class KvStore {
+public:
+    KvStore() = default;
+    ~KvStore();
+
+    KvStore(const KvStore&) = delete;
+    KvStore& operator=(const KvStore&) = delete;
+
+    // Otevře nebo založí soubor a spustí zapisovací vlákno; false a zpráva v error
+    bool open(const std::string& path, std::string& error);
+
+    // nullptr, pokud klíč není; ukazatel platí do další změny stejného klíče
+    const std::string* get(const std::string& key) const;
+    void put(const std::string& key, const std::string& value);
+    bool erase(const std::string& key);
+
+    std::size_t size() const { return values.size(); }
+    const std::unordered_map<std::string, std::string>& entries() const { return values; }
+
+    // Počká, až je všechno dosud zapsané na disku
+    void flush();
+
+    std::uint64_t fileBytes() const { return fileSize; }
+    std::uint64_t liveBytes() const { return liveSize; }
+    std::uint64_t compactions() const { return compactionCount; }
+
+private:
+    // Zápis pro vlákno: připsat bajty na konec, nebo nahradit soubor (rewrite)
+    struct WriteJob {
+        bool rewrite = false;
+        std::string bytes;
+    };
+
+    void submit(std::string record, bool rewrite);
+    void maybeCompact();
+    void writerLoop();
+    bool replaceFile(const std::string& image);
+
+    std::string path;
+    int fd = -1;
+    std::unordered_map<std::string, std::string> values;
+    std::uint64_t fileSize = 0; // včetně záznamů, které vlákno ještě nezapsalo
+    std::uint64_t liveSize = 0; // hlavička a poslední záznam každého živého klíče
+    std::uint64_t compactionCount = 0;
+
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    std::condition_variable drained;
+    std::deque<WriteJob> jobs;
+    bool writing = false;
+    bool stopping = false;
+    std::thread writer;
+};
@@ -0,0 +1,42 @@
+#include "load.hpp"
+
+#include <bit>
+#include <cmath>
+
+std::size_t LatencyHistogram::bucketOf(std::int64_t us) {
+    if (us < 16) return static_cast<std::size_t>(us < 0 ? 0 : us);
+    auto v = static_cast<std::uint64_t>(us);
+    int exponent = std::bit_width(v) - 1; // >= 4
+    std::size_t sub = static_cast<std::size_t>((v >> (exponent - 3)) & (SUB_BUCKETS - 1));
+    std::size_t bucket = 16 + static_cast<std::size_t>(exponent - 4) * SUB_BUCKETS + sub;
+    return bucket < BUCKETS ? bucket : BUCKETS - 1;
+}
+
+std::int64_t LatencyHistogram::bucketUpperUs(std::size_t bucket) {
+    if (bucket < 16) return static_cast<std::int64_t>(bucket);
+    std::size_t exponent = 4 + (bucket - 16) / SUB_BUCKETS;
+    std::size_t sub = (bucket - 16) % SUB_BUCKETS;
+    return static_cast<std::int64_t>(((SUB_BUCKETS + sub + 1) << (exponent - 3)) - 1);
+}
+
+void LatencyHistogram::record(std::int64_t us) {
+    ++counts[bucketOf(us)];
+    ++total;
+}
+
+std::int64_t LatencyHistogram::percentile(double p) const {
+    if (total == 0) return 0;
+    auto rank = static_cast<std::uint64_t>(std::ceil(p * static_cast<double>(total)));
+    if (rank == 0) rank = 1;
+    std::uint64_t seen = 0;
+    for (std::size_t b = 0; b < BUCKETS; ++b) {
+        seen += counts[b];
+        if (seen >= rank) return bucketUpperUs(b);
+    }
+    return bucketUpperUs(BUCKETS - 1);
+}
+
+void LatencyHistogram::clear() {
+    counts.fill(0);
+    total = 0;
+}
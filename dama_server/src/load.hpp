@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Zatížení serveru pro odpovědi na DISCOVER: herní vlákno jednou za LOAD_PUBLISH_MS
+// zapíše do atomických proměnných počet hráčů, volné stoly a 99. percentil latence
+// datagramů za poslední okno; vlákno discovery je jen čte (bez zámku, každé číslo
+// zvlášť, takže se můžou o jedno zveřejnění rozejít).
+//
+// Latence je doba od příchodu datagramu do socketu (časová značka jádra,
+// SO_TIMESTAMPNS) po konec jeho zpracování, tedy včetně čekání ve frontě socketu.
+
+constexpr int LOAD_PUBLISH_MS = 1000;
+
+// Histogram latencí v µs: do 16 µs přesně, dál 8 košů na každou mocninu dvou
+// (chyba percentilu do 12,5 %), nad ~67 s jeden poslední koš
+class LatencyHistogram {
+public:
+    static constexpr std::size_t SUB_BUCKETS = 8;
+    static constexpr std::size_t BUCKETS = 16 + 22 * SUB_BUCKETS;
+
+    void record(std::int64_t us);
+    std::uint64_t count() const { return total; }
+    // Horní mez koše, do kterého padne percentil p (0..1); 0 bez vzorků
+    std::int64_t percentile(double p) const;
+    void clear();
+
+    static std::size_t bucketOf(std::int64_t us);
+    static std::int64_t bucketUpperUs(std::size_t bucket);
+
+private:
+    std::array<std::uint64_t, BUCKETS> counts{};
+    std::uint64_t total = 0;
+};
+
+struct LoadHints {
+    std::atomic<int> players{0};
+    std::atomic<int> maxPlayers{0};
+    std::atomic<int> freeRooms{0};  // nové stoly do limitu a prázdné čekající stoly bez bota
+    std::atomic<std::int64_t> p99Us{0};
+
+    static_assert(std::atomic<int>::is_always_lock_free && std::atomic<std::int64_t>::is_always_lock_free);
+};
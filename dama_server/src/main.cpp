@@ -2,32 +2,57 @@
 #include <map>
 #include <cstring>
 #include <string>
+#include <vector>
 #include <chrono>
 #include <thread>
 #include <algorithm>
+#include <random>
 
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <poll.h>
 #include <errno.h>
 
+#include "book.hpp"
+#include "capture.hpp"
+#include "pipeline.hpp"
 #include "protocol.hpp"
 #include "models.hpp"
 #include "handlers.hpp"
+#include "runtime.hpp"
+#include "server.hpp"
+#include "tablebase.hpp"
 
 int main(int argc, char* argv[]) {
     int port = 5000;
     std::string host = "0.0.0.0";
-    ServerLimits limits;
-    int timeoutMs = 20000;
-    int timeoutGrace = 1;
-    int turnTimeoutMs = 60000;
-    const int timeoutCheckIntervalMs = 500;
-    int reconnectWindowMs = 60000;
+    // Stav serveru
+    ServerState server;
+    BookLog bookLog; // --book-log; registrovaný přes addGameRecorder
+    std::string capturePath; // --capture; příchozí datagramy pro dama_replay
+    bool clusterMode = false;    // --cluster nebo --join
+    std::vector<std::string> clusterSeeds; // --join HOST:PORT (lze opakovat)
+    std::string advertise;       // --advertise HOST; adresa, na které uzel vidí ostatní
+    std::string clusterSecret;   // --cluster-secret S; ověřuje GOSSIP (bez něj jen od známých uzlů)
+    ServerLimits& limits = server.limits;
+    int& timeoutMs = server.config.timeoutMs;
+    int& timeoutGrace = server.config.timeoutGrace;
+    int& turnTimeoutMs = server.config.turnTimeoutMs;
+    const int timeoutCheckIntervalMs = server.config.timeoutCheckIntervalMs;
+    int& reconnectWindowMs = server.config.reconnectWindowMs;
+    int botThreads = std::clamp(static_cast<int>(std::thread::hardware_concurrency()) / 2, 1, 4);
+    bool botPin = false;
+    int analysisThreads = 1;
+    int analysisTableMb = 64;
 
-    // jednoduché zpracování argumentů --players X --rooms Y --host IP --port port --timeout-ms --turn-timeout-ms --timeout-grace
+    // jednoduché zpracování argumentů --players X --rooms Y --host IP --port port --timeout-ms --turn-timeout-ms --timeout-grace --bot-threads N
+    // --bot-pin (workery bota na jádra)
+    // --analysis-threads N --analysis-table-mb MB --tablebase FILE (lze opakovat, soubor z dama_tbgen)
+    // --cluster --join HOST:PORT (lze opakovat) --advertise HOST --cluster-secret S
+    // --mtu BYTES (0 = bez skládání odpovědí do společného datagramu)
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "--players" && i + 1 < argc) {
@@ -90,6 +115,109 @@ int main(int argc, char* argv[]) {
                 std::cerr << "Invalid argument for --turn-timeout-ms" << std::endl;
                 return 1;
             }
+        } else if (arg == "--bot-threads" && i + 1 < argc) {
+            try {
+                botThreads = std::stoi(argv[++i]);
+                if (botThreads < 1) {
+                    std::cerr << "Bot threads must be >= 1" << std::endl;
+                    return 1;
+                }
+            } catch (...) {
+                std::cerr << "Invalid argument for --bot-threads" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--bot-pin") {
+            botPin = true;
+        } else if (arg == "--analysis-threads" && i + 1 < argc) {
+            try {
+                analysisThreads = std::stoi(argv[++i]);
+                if (analysisThreads < 1) {
+                    std::cerr << "Analysis threads must be >= 1" << std::endl;
+                    return 1;
+                }
+            } catch (...) {
+                std::cerr << "Invalid argument for --analysis-threads" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--analysis-table-mb" && i + 1 < argc) {
+            try {
+                analysisTableMb = std::stoi(argv[++i]);
+                if (analysisTableMb < 1) {
+                    std::cerr << "Analysis table size must be >= 1 MB" << std::endl;
+                    return 1;
+                }
+            } catch (...) {
+                std::cerr << "Invalid argument for --analysis-table-mb" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--tablebase" && i + 1 < argc) {
+            std::string path = argv[++i];
+            std::string error;
+            auto tablebase = Tablebase::open(path, error);
+            if (!tablebase) {
+                std::cerr << "Invalid tablebase: " << error << std::endl;
+                return 1;
+            }
+            std::cout << "[INFO] Tablebase " << path << " variant=" << variantName(tablebase->variant())
+                      << " maxCapture=" << (tablebase->maxCaptureRule() ? 1 : 0)
+                      << " pieces=" << tablebase->maxPieces() << std::endl;
+            server.tablebases.add(std::move(tablebase));
+        } else if (arg == "--book" && i + 1 < argc) {
+            std::string path = argv[++i];
+            std::string error;
+            server.book = OpeningBook::open(path, error);
+            if (!server.book) {
+                std::cerr << "Invalid opening book: " << error << std::endl;
+                return 1;
+            }
+            std::cout << "[INFO] Opening book " << path << " entries=" << server.book->size() << std::endl;
+        } else if (arg == "--archive" && i + 1 < argc) {
+            std::string path = argv[++i];
+            std::string error;
+            server.archive = GameArchive::open(path, false, error);
+            if (!server.archive) {
+                std::cerr << "Invalid game archive: " << error << std::endl;
+                return 1;
+            }
+            addGameRecorder(server.archive.get());
+            std::cout << "[INFO] Game archive " << path << " games=" << server.archive->size() << std::endl;
+        } else if (arg == "--accounts" && i + 1 < argc) {
+            std::string path = argv[++i];
+            std::string error;
+            server.accounts = AccountStore::open(path, error);
+            if (!server.accounts) {
+                std::cerr << "Invalid account store: " << error << std::endl;
+                return 1;
+            }
+            server.ratings.attach(server.accounts.get());
+            std::cout << "[INFO] Accounts " << path << " accounts=" << server.accounts->size()
+                      << " bytes=" << server.accounts->kv().fileBytes() << std::endl;
+        } else if (arg == "--cluster") {
+            clusterMode = true;
+        } else if (arg == "--join" && i + 1 < argc) {
+            std::string seed = argv[++i];
+            sockaddr_storage seedAddr{};
+            if (!parseNodeAddress(seed, seedAddr)) {
+                std::cerr << "Invalid argument for --join (expected IPv4:port or [IPv6]:port)" << std::endl;
+                return 1;
+            }
+            clusterSeeds.push_back(seed);
+            clusterMode = true;
+        } else if (arg == "--cluster-secret" && i + 1 < argc) {
+            clusterSecret = argv[++i];
+        } else if (arg == "--advertise" && i + 1 < argc) {
+            advertise = argv[++i];
+        } else if (arg == "--capture" && i + 1 < argc) {
+            capturePath = argv[++i];
+        } else if (arg == "--book-log" && i + 1 < argc) {
+            std::string path = argv[++i];
+            std::string error;
+            if (!bookLog.open(path, error)) {
+                std::cerr << "Invalid book log: " << error << std::endl;
+                return 1;
+            }
+            addGameRecorder(&bookLog);
+            std::cout << "[INFO] Finished games logged to " << path << std::endl;
         } else if (arg == "--reconnect-window-ms" && i + 1 < argc) {
             try {
                 reconnectWindowMs = std::stoi(argv[++i]);
@@ -101,15 +229,39 @@ int main(int argc, char* argv[]) {
                 std::cerr << "Invalid argument for --reconnect-window-ms" << std::endl;
                 return 1;
             }
+        } else if (arg == "--mtu" && i + 1 < argc) {
+            try {
+                int mtu = std::stoi(argv[++i]);
+                if (mtu != 0 && (mtu < 256 || mtu > 65507)) {
+                    std::cerr << "MTU must be 0 or in range 256-65507" << std::endl;
+                    return 1;
+                }
+                setEgressMtu(static_cast<std::size_t>(mtu));
+            } catch (...) {
+                std::cerr << "Invalid argument for --mtu" << std::endl;
+                return 1;
+            }
         }
     }
 
-    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    // IPv4 adresa (i výchozí 0.0.0.0): socket AF_INET jako dřív. IPv6 adresa, např. "::":
+    // socket AF_INET6 bez IPV6_V6ONLY, takže přijímá i IPv4 (jako ::ffff:a.b.c.d).
+    sockaddr_storage servAddr{};
+    if (!parseAddress(host, port, servAddr)) {
+        std::cerr << "Invalid IPv4 or IPv6 address: " << host << std::endl;
+        return 1;
+    }
+    const int family = servAddr.ss_family;
+    int sockfd = socket(family, SOCK_DGRAM, 0);
     if (sockfd < 0) {
         perror("socket");
         return 1;
     }
     int reuse = 1;
+    int v6only = 0;
+    if (family == AF_INET6 && setsockopt(sockfd, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only)) < 0) {
+        perror("setsockopt IPV6_V6ONLY");
+    }
     if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
         perror("setsockopt SO_REUSEADDR");
     }
@@ -122,39 +274,41 @@ int main(int argc, char* argv[]) {
     if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &recvTimeout, sizeof(recvTimeout)) < 0) {
         perror("setsockopt SO_RCVTIMEO");
     }
-
-    sockaddr_in servAddr{};
-    servAddr.sin_family = AF_INET;
-    servAddr.sin_port = htons(port);
-
-    if (host == "0.0.0.0") {
-        servAddr.sin_addr.s_addr = INADDR_ANY;
-    } else {
-        if (inet_pton(AF_INET, host.c_str(), &servAddr.sin_addr) != 1) {
-            std::cerr << "Invalid IPv4 address: " << host << std::endl;
-            close(sockfd);
-            return 1;
-        }
+    // čas příchodu od jádra: latence v LoadHints zahrne i čekání ve frontě socketu
+    if (setsockopt(sockfd, SOL_SOCKET, SO_TIMESTAMPNS, &reuse, sizeof(reuse)) < 0) {
+        perror("setsockopt SO_TIMESTAMPNS");
+    }
+    // počet datagramů, které jádro zahodilo pro plnou frontu socketu (PipelineStats::kernelDrops)
+    if (setsockopt(sockfd, SOL_SOCKET, SO_RXQ_OVFL, &reuse, sizeof(reuse)) < 0) {
+        perror("setsockopt SO_RXQ_OVFL");
     }
 
     if (bind(sockfd, reinterpret_cast<sockaddr*>(&servAddr),
-             sizeof(servAddr)) < 0) {
+             addrLength(servAddr)) < 0) {
         perror("bind");
         close(sockfd);
         return 1;
     }
 
-    std::cout << "Dama UDP server running on " << host << ":" << port << std::endl;
+    std::cout << "Dama UDP server running on " << nodeAddress(host, port) << std::endl;
+    server.sockFamily = family;
 
-    // Stav serveru
-    PlayersMap players;
-    EndpointMap endpointToToken; // clientKey -> token
-    RoomsMap rooms;
-    int nextPlayerId = 1;
-    int nextRoomId   = 1;
+    if (clusterMode) {
+        if (advertise.empty()) advertise = host == "0.0.0.0" || host == "::" ? "127.0.0.1" : host;
+        std::string self = nodeAddress(advertise, port);
+        sockaddr_storage selfAddr{};
+        if (!parseNodeAddress(self, selfAddr)) {
+            std::cerr << "Invalid argument for --advertise (expected IPv4 or IPv6)" << std::endl;
+            close(sockfd);
+            return 1;
+        }
+        server.cluster = std::make_unique<Cluster>(self, clusterSeeds, clusterSecret);
+        std::cout << "[INFO] Cluster node " << self << " seeds=" << clusterSeeds.size()
+                  << (clusterSecret.empty() ? " gossip=seeds-only" : " gossip=secret") << std::endl;
+    }
 
     // Discovery socket (UDP, fixed port 9999).
-    int discSock = socket(AF_INET, SOCK_DGRAM, 0);
+    int discSock = socket(family, SOCK_DGRAM, 0);
     bool discoveryActive = true;
     if (discSock < 0) {
         perror("socket discovery");
@@ -166,10 +320,11 @@ int main(int argc, char* argv[]) {
         if (setsockopt(discSock, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) < 0) {
             perror("setsockopt discovery SO_REUSEPORT");
         }
-        sockaddr_in discAddr{};
-        discAddr.sin_family = AF_INET;
-        discAddr.sin_port = htons(9999);
-        discAddr.sin_addr.s_addr = INADDR_ANY;
+        if (family == AF_INET6 && setsockopt(discSock, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only)) < 0) {
+            perror("setsockopt discovery IPV6_V6ONLY");
+        }
+        sockaddr_storage discAddr{};
+        parseAddress(family == AF_INET6 ? "::" : "0.0.0.0", 9999, discAddr);
         if (bind(discSock, reinterpret_cast<sockaddr*>(&discAddr), sizeof(discAddr)) < 0) {
             perror("bind discovery");
             discoveryActive = false;
@@ -181,7 +336,7 @@ int main(int argc, char* argv[]) {
         discoveryThread = std::thread([&]() {
             char buf[256];
             while (true) {
-                sockaddr_in cli{};
+                sockaddr_storage cli{};
                 socklen_t clen = sizeof(cli);
                 ssize_t n = recvfrom(discSock, buf, sizeof(buf) - 1, 0,
                                      reinterpret_cast<sockaddr*>(&cli), &clen);
@@ -191,333 +346,136 @@ int main(int argc, char* argv[]) {
                 buf[n] = '\0';
                 std::string line(buf);
                 rtrim(line);
-                if (line == "DISCOVER") {
+                // v clusteru: kterému uzlu patří stůl (kruh je snímek od herního vlákna)
+                if (line.rfind("DISCOVER;room=", 0) == 0 && server.cluster) {
+                    int roomId = 0;
+                    try {
+                        roomId = std::stoi(line.substr(14));
+                    } catch (...) {
+                        continue;
+                    }
+                    std::string owner = server.cluster->ringSnapshot()->ownerOfRoom(roomId);
+                    sockaddr_storage ownerAddr{};
+                    if (!parseNodeAddress(owner, ownerAddr)) continue;
+                    std::string resp = "0;ENDPOINT;host=" + addrHost(ownerAddr) +
+                                       ";port=" + std::to_string(endpointKey(ownerAddr).port) +
+                                       ";room=" + std::to_string(roomId) + "\n";
+                    sendto(discSock, resp.c_str(), resp.size(), 0,
+                           reinterpret_cast<sockaddr*>(&cli), clen);
+                    std::cout << "[DISCOVERY] Reply to " << addrToKey(cli) << " room=" << roomId << " owner=" << owner << std::endl;
+                } else if (line == "DISCOVER") {
                     std::string respHost = host;
-                    if (host == "0.0.0.0") {
+                    if (host == "0.0.0.0" || host == "::") {
                         // vrací konkrétní IP, kterou klient použil k dotazu
-                        auto key = addrToKey(cli);
-                        auto pos = key.find(':');
-                        if (pos != std::string::npos) {
-                            respHost = key.substr(0, pos);
-                        } else {
-                            respHost = key;
-                        }
+                        respHost = addrHost(cli);
+                    }
+                    std::string resp = "0;ENDPOINT;host=" + respHost + ";port=" + std::to_string(port) +
+                                       ";players=" + std::to_string(server.load.players.load(std::memory_order_relaxed)) +
+                                       ";maxPlayers=" + std::to_string(server.load.maxPlayers.load(std::memory_order_relaxed)) +
+                                       ";freeRooms=" + std::to_string(server.load.freeRooms.load(std::memory_order_relaxed)) +
+                                       ";p99Us=" + std::to_string(server.load.p99Us.load(std::memory_order_relaxed));
+                    if (server.cluster) {
+                        resp += ";nodes=" + std::to_string(server.cluster->ringSnapshot()->nodeCount());
                     }
-                    std::string resp = "0;ENDPOINT;host=" + respHost + ";port=" + std::to_string(port) + "\n";
+                    resp += "\n";
                     sendto(discSock, resp.c_str(), resp.size(), 0,
                            reinterpret_cast<sockaddr*>(&cli), clen);
-                    std::cout << "[DISCOVERY] Reply to " << addrToKey(cli) << " endpoint=" << respHost << ":" << port << std::endl;
+                    std::cout << "[DISCOVERY] Reply to " << addrToKey(cli) << " endpoint=" << nodeAddress(respHost, port) << std::endl;
                 }
             }
         });
     } else {
         std::cerr << "[WARN] Discovery socket not started; port busy. Manual host/port required." << std::endl;
     }
-    char buffer[1024];
-    auto lastTimeoutCheck = std::chrono::steady_clock::now();
-
-    while (true) {
-        sockaddr_in clientAddr{};
-        socklen_t clientLen = sizeof(clientAddr);
-
-        ssize_t n = recvfrom(sockfd, buffer, sizeof(buffer) - 1, 0,
-                             reinterpret_cast<sockaddr*>(&clientAddr), &clientLen);
-        if (n < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                auto nowTimeout = std::chrono::steady_clock::now();
-                if (std::chrono::duration_cast<std::chrono::milliseconds>(
-                        nowTimeout - lastTimeoutCheck).count() > timeoutCheckIntervalMs) {
-                    int effectiveHeartbeatMs = timeoutMs * timeoutGrace;
-                    int pauseThresholdMs = std::min(12000, effectiveHeartbeatMs);
-                    checkTimeouts(players, rooms, effectiveHeartbeatMs, pauseThresholdMs, turnTimeoutMs,
-                                  sockfd, reconnectWindowMs, endpointToToken);
-                    lastTimeoutCheck = nowTimeout;
-                }
-            } else {
-                perror("recvfrom");
-            }
-            continue;
-        }
-
-        bool hasBinary = false;
-        for (ssize_t i = 0; i < n; ++i) {
-            unsigned char ch = static_cast<unsigned char>(buffer[i]);
-            if (ch == 0x09 || ch == 0x0A || ch == 0x0D) {
-                continue;
-            }
-            if (ch < 0x20 || ch == 0x7F) {
-                hasBinary = true;
-                break;
-            }
-        }
-        if (hasBinary) {
-            std::cerr << "Invalid binary data from " << addrToKey(clientAddr) << std::endl;
-            std::string invalidKey = addrToKey(clientAddr);
-            auto itInvalidEndpoint = endpointToToken.find(invalidKey);
-            if (itInvalidEndpoint != endpointToToken.end()) {
-                registerInvalidMessage(itInvalidEndpoint->second, players, rooms, sockfd, "BINARY_DATA");
-                std::string resp = "0;ERROR;INVALID_FORMAT;Binary data\n";
-                sendto(sockfd, resp.c_str(), resp.size(), 0,
-                       reinterpret_cast<sockaddr*>(&clientAddr), clientLen);
-            }
-            continue;
-        }
-
-        buffer[n] = '\0';
-        std::string line(buffer);
-        rtrim(line);
-
-        if (line.size() > 256) {
-            std::string resp = "0;ERROR;INVALID_FORMAT;Message too long\n";
-            sendto(sockfd, resp.c_str(), resp.size(), 0,
-                   reinterpret_cast<sockaddr*>(&clientAddr), clientLen);
-            continue;
-        }
-
-        std::cout << "Received: [" << line << "]" << std::endl;
-
-        Message msg;
-        if (!parseMessage(line, msg)) {
-            std::cerr << "Invalid message format" << std::endl;
-            std::string resp = "0;ERROR;INVALID_FORMAT;Cannot parse message\n";
-            sendto(sockfd, resp.c_str(), resp.size(), 0,
-                   reinterpret_cast<sockaddr*>(&clientAddr), clientLen);
-            std::string invalidKey = addrToKey(clientAddr);
-            auto itInvalidEndpoint = endpointToToken.find(invalidKey);
-            if (itInvalidEndpoint != endpointToToken.end()) {
-                registerInvalidMessage(itInvalidEndpoint->second, players, rooms, sockfd, "INVALID_FORMAT");
-            }
-            continue;
+    // seed náhody jde do záznamu, aby dama_replay rozdal stejné tokeny
+    CaptureWriter capture;
+    if (!capturePath.empty()) {
+        std::uint64_t seed = (static_cast<std::uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+        seedServerRandom(seed);
+        std::string error;
+        if (!capture.open(capturePath, seed, server.config, server.limits, error)) {
+            std::cerr << "Invalid capture file: " << error << std::endl;
+            return 1;
         }
+        std::cout << "[INFO] Capturing inbound traffic to " << capturePath << std::endl;
+    }
 
-        std::string clientKey = addrToKey(clientAddr);
-        std::string playerToken;
-        auto now = std::chrono::steady_clock::now();
+    server.sockfd = sockfd;
+    server.lastTimeoutCheck = steadyNow();
+    const TablebaseSet* tablebases = server.tablebases.empty() ? nullptr : &server.tablebases;
+    server.bots = std::make_unique<BotPool>(botThreads, tablebases, server.book.get(), botPin);
+    server.analysis = std::make_unique<AnalysisPool>(analysisThreads, static_cast<std::size_t>(analysisTableMb), tablebases,
+                                                     server.book.get());
 
-        auto itEndpoint = endpointToToken.find(clientKey);
-        if (itEndpoint != endpointToToken.end()) {
-            playerToken = itEndpoint->second;
-            auto itPlayerSeen = players.find(playerToken);
-            if (itPlayerSeen != players.end()) {
-                itPlayerSeen->second.lastSeen = now;
-                if (!itPlayerSeen->second.paused) {
-                    itPlayerSeen->second.connected = true;
-                    itPlayerSeen->second.addr = clientAddr;
-                }
-            } else {
-                endpointToToken.erase(itEndpoint);
-                playerToken.clear();
-            }
-        }
+    // příjem a odesílání běží ve vlastních vláknech (pipeline.hpp); herní vlákno čte
+    // přijaté datagramy z fronty a odpovědi do fronty zapisuje přes Transport
+    NetPipeline pipeline(sockfd);
+    setServerTransport(&pipeline);
 
-        auto sendNotLoggedIn = [&]() {
-            std::string resp = std::to_string(msg.id) + ";ERROR;NOT_LOGGED_IN\n";
-            sendto(sockfd, resp.c_str(), resp.size(), 0,
-                   reinterpret_cast<sockaddr*>(&clientAddr), clientLen);
-        };
+    // fronta příchozích datagramů + probuzení od BotPool a AnalysisPool (hledání běží mimo tuto smyčku)
+    pollfd fds[3]{};
+    fds[0].fd = pipeline.wakeFd();
+    fds[0].events = POLLIN;
+    fds[1].fd = server.bots->wakeFd();
+    fds[1].events = POLLIN;
+    fds[2].fd = server.analysis->wakeFd();
+    fds[2].events = POLLIN;
 
-        if (msg.type == "LOGIN") {
-            handleLogin(msg, clientKey, players, nextPlayerId, limits,
-                        sockfd, clientAddr, clientLen, turnTimeoutMs, reconnectWindowMs, endpointToToken);
-        }
-        else if (msg.type == "PING") {
-            if (!playerToken.empty()) {
-                std::cout << "[PING] token=" << playerToken
-                          << " addr=" << clientKey << std::endl;
-            }
-            handlePing(msg, sockfd, clientAddr, clientLen);
-        }
-        else if (msg.type == "LIST_ROOMS") {
-            if (playerToken.empty()) {
-                sendNotLoggedIn();
-            } else {
-                handleListRooms(msg, rooms, sockfd, clientAddr, clientLen);
-            }
-        }
-        else if (msg.type == "CREATE_ROOM") {
-            if (playerToken.empty()) {
-                sendNotLoggedIn();
-            } else {
-                handleCreateRoom(msg, playerToken, rooms, players, nextRoomId, limits,
-                             sockfd, clientAddr, clientLen, limits);
-            }
-        }
-        else if (msg.type == "JOIN_ROOM") {
-            if (playerToken.empty()) {
-                sendNotLoggedIn();
-            } else {
-                handleJoinRoom(msg, playerToken, rooms, players,
-                               sockfd, clientAddr, clientLen, turnTimeoutMs);
-            }
-        }
-        else if (msg.type == "MOVE") {
-            if (playerToken.empty()) {
-                sendNotLoggedIn();
-            } else {
-                handleMove(msg, playerToken, rooms, players,
-                            sockfd, clientAddr, clientLen, turnTimeoutMs);
-            }
-        }
-        else if (msg.type == "LEAVE_ROOM") {
-            if (playerToken.empty()) {
-                sendNotLoggedIn();
-            } else {
-                handleLeaveRoom(msg, playerToken, rooms, players,
-                                sockfd, clientAddr, clientLen, reconnectWindowMs);
-            }
-        }
-        else if (msg.type == "LEGAL_MOVES") {
-            if (playerToken.empty()) {
-                sendNotLoggedIn();
-            } else {
-                handleLegalMoves(msg, playerToken, rooms, players,
-                                 sockfd, clientAddr, clientLen);
-            }
+    while (true) {
+        // co předchozí iterace poslala (celá dávka datagramů, termíny, periodické úlohy, boty),
+        // odejde teď najednou, po adresátech složené do datagramů
+        flushDatagrams();
+        pipeline.logStats(steadyNow());
+        server.bots->logStats(steadyNow());
+        // nejpozději v nejbližším termínu stolu (pád praporku); ppoll kvůli přesnosti pod 1 ms
+        auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::milliseconds(timeoutCheckIntervalMs));
+        if (auto deadline = nextRoomDeadline()) {
+            wait = std::clamp(std::chrono::duration_cast<std::chrono::nanoseconds>(*deadline - steadyNow()),
+                              std::chrono::nanoseconds::zero(), wait);
         }
-        else if (msg.type == "BYE") {
-            if (playerToken.empty()) {
-                sendNotLoggedIn();
-            } else {
-                handleBye(msg, playerToken, players, rooms, endpointToToken, sockfd, clientAddr, clientLen);
-                endpointToToken.erase(clientKey);
+        // zbytek fronty z minulé dávky: jen se podívat na boty a termíny, nečekat
+        bool backlog = pipeline.hasInbound();
+        if (backlog) wait = std::chrono::nanoseconds::zero();
+        timespec waitTs{};
+        waitTs.tv_sec = static_cast<time_t>(wait.count() / 1000000000);
+        waitTs.tv_nsec = static_cast<long>(wait.count() % 1000000000);
+        int ready = ppoll(fds, 3, &waitTs, nullptr);
+        if (ready < 0) {
+            if (errno != EINTR) {
+                perror("poll");
             }
             continue;
         }
-        else if (msg.type == "CONFIG_ACK") {
-            auto pit = players.find(playerToken);
-            if (pit != players.end()) {
-                pit->second.configAcked = true;
-                std::cout << "[INFO] CONFIG_ACK from " << clientKey << std::endl;
-            }
-        }
-        else if (msg.type == "RECONNECT") {
-            // handled in receive loop níže
-        }
-        else {
-            std::string resp = std::to_string(msg.id) +
-                               ";ERROR;UNSUPPORTED_TYPE;Nepodporovaný typ zprávy\n";
-            sendto(sockfd, resp.c_str(), resp.size(), 0,
-                   reinterpret_cast<sockaddr*>(&clientAddr), clientLen);
-            if (!playerToken.empty()) {
-                registerInvalidMessage(playerToken, players, rooms, sockfd, "UNSUPPORTED_TYPE");
-            }
+        // termíny stolů a periodické úlohy; ty mají vlastní intervaly, takže běží i při trvalém provozu
+        processIdle(server);
+        if (ready == 0 && !backlog) {
+            if (capture.isOpen()) capture.flush();
+            continue;
         }
 
-        if (std::chrono::duration_cast<std::chrono::milliseconds>(
-                now - lastTimeoutCheck).count() > timeoutCheckIntervalMs) {
-            int effectiveHeartbeatMs = timeoutMs * timeoutGrace;
-            int pauseThresholdMs = std::min(12000, effectiveHeartbeatMs);
-            checkTimeouts(players, rooms, effectiveHeartbeatMs, pauseThresholdMs, turnTimeoutMs, sockfd, reconnectWindowMs, endpointToToken);
-            lastTimeoutCheck = now;
+        if (fds[1].revents & POLLIN) {
+            processBotResults(server);
         }
-
-        auto pit = players.find(playerToken);
-        if (pit != players.end() && !pit->second.configAcked) {
-            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - pit->second.lastConfigSent).count();
-            if (pit->second.lastConfigSent == std::chrono::steady_clock::time_point{} || elapsed > 3000) {
-                sendConfig(pit->second, sockfd, pit->second.turnTimeoutMs);
-                std::cout << "[INFO] RESEND_CONFIG to " << clientKey
-                          << " timeoutMs=" << pit->second.turnTimeoutMs << std::endl;
-            }
+        if (fds[2].revents & POLLIN) {
+            processAnalysisResults(server);
+        }
+        if (fds[0].revents & POLLIN) {
+            pipeline.clearWake(); // před čtením fronty, aby se nepropásl pozdější zápis
         }
 
-        // RECONNECT handling: if message type is RECONNECT, validate token
-        if (msg.type == "RECONNECT") {
-            if (msg.rawParams.empty()) {
-                std::string resp = std::to_string(msg.id) + ";ERROR;INVALID_FORMAT;Missing token\n";
-                sendto(sockfd, resp.c_str(), resp.size(), 0,
-                       reinterpret_cast<sockaddr*>(&clientAddr), clientLen);
-                continue;
-            }
-            std::string token = msg.rawParams[0];
-            auto pitToken = players.find(token);
-            if (pitToken == players.end()) {
-                std::string resp = std::to_string(msg.id) + ";ERROR;TOKEN_NOT_FOUND\n";
-                sendto(sockfd, resp.c_str(), resp.size(), 0,
-                       reinterpret_cast<sockaddr*>(&clientAddr), clientLen);
-                continue;
-            }
-            Player& p = pitToken->second;
-            auto nowTs = std::chrono::steady_clock::now();
-            if (p.resumeDeadline != std::chrono::steady_clock::time_point{} &&
-                nowTs > p.resumeDeadline) {
-                std::string resp = std::to_string(msg.id) + ";ERROR;TOKEN_EXPIRED\n";
-                sendto(sockfd, resp.c_str(), resp.size(), 0,
-                       reinterpret_cast<sockaddr*>(&clientAddr), clientLen);
-                continue;
-            }
-
-            p.addr = clientAddr;
-            p.connected = true;
-            p.lastSeen = nowTs;
-            p.paused = false;
-            p.resumeDeadline = std::chrono::steady_clock::time_point{};
-            for (auto it = endpointToToken.begin(); it != endpointToToken.end();) {
-                if (it->second == token) {
-                    it = endpointToToken.erase(it);
-                } else {
-                    ++it;
-                }
-            }
-            endpointToToken[clientKey] = token;
-            std::string resp = std::to_string(msg.id) + ";RECONNECT_OK\n";
-            sendto(sockfd, resp.c_str(), resp.size(), 0,
-                   reinterpret_cast<sockaddr*>(&clientAddr), clientLen);
-            std::cout << "[INFO] RECONNECT_OK token=" << token << " key=" << clientKey << std::endl;
-            // pošle poslední game state jen pokud jsou oba hráči připojeni (jinak zůstává pauza)
-            auto nowSys = std::chrono::system_clock::now();
-            for (auto& [roomId, room] : rooms) {
-                auto it = std::find(room.playerKeys.begin(), room.playerKeys.end(), token);
-                if (it == room.playerKeys.end()) continue;
-                if (room.status != RoomStatus::IN_GAME) continue;
-
-                bool allReady = true;
-                std::chrono::milliseconds::rep resumeByEpochMs = 0;
-                for (const auto& pKey : room.playerKeys) {
-                    auto pit = players.find(pKey);
-                    if (pit == players.end()) {
-                        allReady = false;
-                        continue;
-                    }
-                    const Player& rp = pit->second;
-                    if (rp.paused || !rp.connected) {
-                        allReady = false;
-                    }
-                    if (rp.paused && rp.resumeDeadline != std::chrono::steady_clock::time_point{}) {
-                        auto remaining = rp.resumeDeadline - nowTs;
-                        if (remaining > std::chrono::milliseconds::zero()) {
-                            auto candidate = nowSys + remaining;
-                            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                                candidate.time_since_epoch()).count();
-                            resumeByEpochMs = std::max(resumeByEpochMs, ms);
-                        }
-                    }
-                }
-
-                if (allReady) {
-                    if (room.remainingTurnMs >= 0) {
-                        room.lastTurnAt = nowTs - std::chrono::milliseconds(turnTimeoutMs - room.remainingTurnMs);
-                        room.remainingTurnMs = -1;
-                    } else if (room.lastTurnAt == std::chrono::steady_clock::time_point{}) {
-                        room.lastTurnAt = nowTs;
-                    }
-                    for (const auto& pKey : room.playerKeys) {
-                        auto pit = players.find(pKey);
-                        if (pit == players.end()) continue;
-                        sendGameStateToPlayer(msg.id, room, pit->second, sockfd, turnTimeoutMs);
-                    }
-                } else {
-                    if (resumeByEpochMs == 0) {
-                        resumeByEpochMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-                            (nowSys + std::chrono::milliseconds(reconnectWindowMs)).time_since_epoch()).count();
-                    }
-                    std::string pauseMsg = "0;GAME_PAUSED;room=" + std::to_string(room.id) +
-                                           ";resumeBy=" + std::to_string(resumeByEpochMs) + "\n";
-                    sendto(sockfd, pauseMsg.c_str(), pauseMsg.size(), 0,
-                           reinterpret_cast<sockaddr*>(&clientAddr), clientLen);
-                }
+        // nejvýš PIPELINE_BATCH datagramů, pak znovu boty a termíny
+        for (std::size_t i = 0; i < PIPELINE_BATCH; ++i) {
+            InboundDatagram* d = pipeline.nextInbound();
+            if (d == nullptr) break;
+            if (capture.isOpen()) {
+                capture.record(d->from, d->data.data(), d->len);
             }
-            continue;
+            processDatagram(server, d->data.data(), d->len, d->from, d->fromLen);
+            // odpovědi jsou složené k odeslání; odejdou s celou dávkou na začátku další iterace
+            server.latency.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now() - d->arrived).count());
+            pipeline.popInbound();
         }
     }
 
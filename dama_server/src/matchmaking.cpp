@@ -0,0 +1,119 @@
+#include "matchmaking.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include "runtime.hpp"
+
+void MatchQueue::enqueue(const std::string& token, int rating, Variant variant, bool maxCaptureRule,
+                         std::chrono::steady_clock::time_point now) {
+    auto it = seqOf.find(token);
+    if (it != seqOf.end()) {
+        MatchRequest& request = order.at(it->second);
+        pools[poolOf(request.variant, request.maxCaptureRule)].erase({request.rating, it->second});
+        request.rating = rating;
+        request.variant = variant;
+        request.maxCaptureRule = maxCaptureRule;
+        pools[poolOf(variant, maxCaptureRule)].insert({rating, it->second});
+        return;
+    }
+    std::uint64_t seq = nextSeq++;
+    order[seq] = MatchRequest{token, rating, variant, maxCaptureRule, now};
+    seqOf[token] = seq;
+    pools[poolOf(variant, maxCaptureRule)].insert({rating, seq});
+}
+
+bool MatchQueue::cancel(const std::string& token) {
+    auto it = seqOf.find(token);
+    if (it == seqOf.end()) return false;
+    remove(it->second);
+    return true;
+}
+
+void MatchQueue::remove(std::uint64_t seq) {
+    auto it = order.find(seq);
+    if (it == order.end()) return;
+    const MatchRequest& request = it->second;
+    pools[poolOf(request.variant, request.maxCaptureRule)].erase({request.rating, seq});
+    seqOf.erase(request.token);
+    order.erase(it);
+}
+
+int MatchQueue::window(const MatchRequest& request, std::chrono::steady_clock::time_point now) {
+    auto waitedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - request.since).count();
+    auto grown = MATCH_WINDOW_BASE + std::max<long long>(0, waitedMs) * MATCH_WINDOW_PER_SECOND / 1000;
+    return static_cast<int>(std::min<long long>(MATCH_WINDOW_MAX, grown));
+}
+
+std::vector<MatchPair> MatchQueue::pairUp(std::chrono::steady_clock::time_point now, std::size_t maxPairs,
+                                          const std::function<bool(const std::string&)>& eligible) {
+    std::vector<MatchPair> pairs;
+    for (auto it = order.begin(); it != order.end() && pairs.size() < maxPairs;) {
+        const std::uint64_t seq = it->first;
+        const MatchRequest& request = it->second;
+        if (!eligible(request.token)) {
+            ++it;
+            remove(seq);
+            continue;
+        }
+
+        std::set<Slot>& pool = pools[poolOf(request.variant, request.maxCaptureRule)];
+        auto self = pool.find({request.rating, seq});
+        const int own = window(request, now);
+
+        // nejbližší soupeř v hodnocení, kterého oba hráči přijmou (sousedé, co už
+        // nemůžou hrát, se cestou vyřadí)
+        std::uint64_t best = 0;
+        int bestDiff = own + 1;
+        auto consider = [&](std::set<Slot>::iterator candidate) {
+            int diff = std::abs(candidate->first - request.rating);
+            if (diff < bestDiff && diff <= window(order.at(candidate->second), now)) {
+                best = candidate->second;
+                bestDiff = diff;
+            }
+        };
+        int tried = 0;
+        for (auto up = std::next(self); up != pool.end() && tried < MATCH_NEIGHBOURS;) {
+            if (up->first - request.rating > own) break;
+            if (!eligible(order.at(up->second).token)) {
+                std::uint64_t stale = up->second;
+                ++up;
+                remove(stale);
+                continue;
+            }
+            consider(up++);
+            ++tried;
+        }
+        tried = 0;
+        for (auto down = self; down != pool.begin() && tried < MATCH_NEIGHBOURS;) {
+            auto candidate = std::prev(down);
+            if (request.rating - candidate->first > own) break;
+            if (!eligible(order.at(candidate->second).token)) {
+                remove(candidate->second);
+                continue;
+            }
+            consider(candidate);
+            down = candidate;
+            ++tried;
+        }
+
+        if (best == 0) {
+            ++it;
+            continue;
+        }
+        MatchPair pair;
+        const std::string& opponent = order.at(best).token;
+        bool firstWhite = (serverRandom() & 1) != 0;
+        pair.white = firstWhite ? request.token : opponent;
+        pair.black = firstWhite ? opponent : request.token;
+        pair.variant = request.variant;
+        pair.maxCaptureRule = request.maxCaptureRule;
+        pairs.push_back(std::move(pair));
+
+        // soupeř může být hned další v pořadí -> iterátor posunout až po jeho odebrání
+        remove(best);
+        ++it;
+        remove(seq);
+    }
+    return pairs;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "variants.hpp"
+
+// Fronta QUICK_MATCH: čekající hráči seřazení podle hodnocení, zvlášť pro každá
+// pravidla (varianta, nejdelší skok). Jednou za MATCH_TICK_MS server vezme hráče od
+// nejdéle čekajícího a hledá soupeře mezi nejbližšími sousedy v hodnocení; dvojice se
+// přijme, když rozdíl hodnocení vejde do okna obou hráčů. Okno se s čekáním rozšiřuje.
+//
+// Zařazení, zrušení i nalezení soupeře jsou O(log n). Hráči, kteří mezitím odešli nebo
+// si sedli ke stolu, se z fronty vyřadí až při párování (predikát eligible).
+
+constexpr int MATCH_TICK_MS = 1000;
+constexpr int MATCH_WINDOW_BASE = 50;        // rozdíl hodnocení hned po zařazení
+constexpr int MATCH_WINDOW_PER_SECOND = 10;  // o kolik se okno rozšíří za sekundu čekání
+constexpr int MATCH_WINDOW_MAX = 400;
+constexpr int MATCH_NEIGHBOURS = 4;          // kolik sousedů na každou stranu se zkouší
+
+struct MatchRequest {
+    std::string token;
+    int rating = 0;
+    Variant variant = Variant::CZECH;
+    bool maxCaptureRule = false;
+    std::chrono::steady_clock::time_point since{};
+};
+
+struct MatchPair {
+    std::string white;
+    std::string black;
+    Variant variant = Variant::CZECH;
+    bool maxCaptureRule = false;
+};
+
+class MatchQueue {
+public:
+    // Zařadí hráče; už čekající hráč si nechá čas zařazení a změní jen hodnocení a pravidla
+    void enqueue(const std::string& token, int rating, Variant variant, bool maxCaptureRule,
+                 std::chrono::steady_clock::time_point now);
+    bool cancel(const std::string& token);
+    bool contains(const std::string& token) const { return seqOf.count(token) > 0; }
+    std::size_t size() const { return order.size(); }
+
+    // Povolený rozdíl hodnocení pro hráče, který čeká od since
+    static int window(const MatchRequest& request, std::chrono::steady_clock::time_point now);
+
+    // Nejvýš maxPairs dvojic (tolik je volných stolů); spárovaní hráči z fronty odcházejí.
+    // Barvy se losují přes serverRandom.
+    std::vector<MatchPair> pairUp(std::chrono::steady_clock::time_point now, std::size_t maxPairs,
+                                  const std::function<bool(const std::string&)>& eligible);
+
+private:
+    using Slot = std::pair<int, std::uint64_t>; // hodnocení, pořadí zařazení
+
+    static int poolOf(Variant variant, bool maxCaptureRule) {
+        return static_cast<int>(variant) * 2 + (maxCaptureRule ? 1 : 0);
+    }
+    void remove(std::uint64_t seq);
+
+    std::map<std::uint64_t, MatchRequest> order; // pořadí zařazení -> požadavek (nejstarší první)
+    std::unordered_map<std::string, std::uint64_t> seqOf; // token -> pořadí zařazení
+    std::map<int, std::set<Slot>> pools;                   // pravidla -> čekající podle hodnocení
+    std::uint64_t nextSeq = 1;
+};
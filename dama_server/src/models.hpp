@@ -1,24 +1,29 @@
 #pragma once
 
+#include <array>
 #include <string>
 #include <vector>
 #include <cstddef>
 #include <optional>
 #include <utility>
 #include <chrono>
+#include <cstdint>
 #include <netinet/in.h>
 
+#include "clocksync.hpp"
+#include "variants.hpp"
+#include "zobrist.hpp"
+
 // Herní globální config
 constexpr std::size_t ROOM_CAPACITY = 2;
-constexpr int BOARD_SIZE = 8;
 
 // Hráč
 struct Player {
     int id = 0;
     std::string nick;
-    sockaddr_in addr{}; // adresa hráče, kam se posílají Message
+    sockaddr_storage addr{}; // adresa hráče, kam se posílají Message
     bool connected = true;
-    std::chrono::steady_clock::time_point lastSeen = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point lastSeen{};
     int lastMoveMsgId = -1; // pro deduplikaci MOVE
     bool configAcked = false;
     int turnTimeoutMs = 60000;
@@ -29,6 +34,9 @@ struct Player {
     std::chrono::steady_clock::time_point resumeDeadline{};
     int invalidCount = 0;
     std::chrono::steady_clock::time_point invalidWindowStart{};
+    bool isBot = false; // sedadlo počítačového soupeře, nemá adresu ani heartbeat
+    bool analysisPending = false; // ANALYZE se počítá v AnalysisPool (nejvýš jeden naráz)
+    ClockSync sync; // PING/PONG: zpoždění a posun hodin klienta (resumeBy, GAME_STATE, opakování CONFIG)
 };
 
 // Stav místnosti
@@ -52,6 +60,37 @@ enum class PieceColor {
     BLACK
 };
 
+// Počty kamenů na desce podle barvy a druhu
+struct Material {
+    int whiteMen = 0;
+    int whiteKings = 0;
+    int blackMen = 0;
+    int blackKings = 0;
+
+    bool operator==(const Material&) const = default;
+};
+
+// Jeden krok/skok partie (kniha zahájení, archiv partií)
+struct GameStep {
+    std::uint64_t key = 0;      // tableKey pozice před krokem (hash + varianta + pravidlo skoku)
+    std::uint8_t fromSquare = 0; // row * MAX_BOARD_SIZE + col
+    std::uint8_t toSquare = 0;
+    bool white = false;          // táhl bílý
+    std::uint32_t atMs = 0;      // ms od začátku partie
+};
+
+// Šachové hodiny stolu (CREATE_ROOM;...;clockMs=); baseMs 0 = bez hodin, tah hlídá jen
+// turnTimeoutMs. Přídavek po každém tahu: Fischer celý, Bronstein nejvýš spotřebovaný čas tahu.
+constexpr int CLOCK_MIN_MS = 1000;
+constexpr int CLOCK_MAX_MS = 3 * 3600 * 1000;
+constexpr int CLOCK_MAX_INCREMENT_MS = 60000;
+
+struct TimeControl {
+    int baseMs = 0;
+    int incrementMs = 0;
+    bool bronstein = false;
+};
+
 // Herní místnost
 struct Room {
     int id = 0;
@@ -59,10 +98,27 @@ struct Room {
     RoomStatus status = RoomStatus::WAITING;
     std::vector<std::string> playerKeys; // identifikace hráčů podle tokenu
     Turn turn = Turn::NONE;
-    std::string board; // hrací deska (8x8)
+    Variant variant = Variant::CZECH; // pravidla a velikost desky (CREATE_ROOM;...;variant=)
+    std::string board; // hrací deska (size x size podle varianty, řádek po řádku)
     std::optional<std::pair<int, int>> captureLock; // position of piece that must continue capturing
+    std::uint64_t hash = 0; // Zobrist hash (board + turn + captureLock), drží setPiece/setTurn/setCaptureLock
+    Material material; // kameny na desce, drží setPiece (konec hry bez skenování desky)
+    std::vector<std::uint64_t> positionHistory; // hashe od posledního nevratného tahu (remíza opakováním)
+    int noProgressPlies = 0; // tahy jen dámami bez skoku za sebou (remíza bez postupu)
+    std::vector<GameStep> steps; // všechny kroky partie; při konci hry do knihy a archivu
+    std::chrono::steady_clock::time_point startedAt{};   // začátek partie (čas kroků)
+    std::chrono::system_clock::time_point startedWall{}; // začátek partie (datum v archivu)
+    std::string whiteNick; // hráči při startu partie (soupeř mohl mezitím odejít)
+    std::string blackNick;
     std::chrono::steady_clock::time_point lastTurnAt{};
     int remainingTurnMs = -1; // ulozeny zbyvajici cas tahu pri pauze
+    TimeControl timeControl;
+    std::array<long long, 2> clockMs{}; // hodiny bílého a černého na začátku tahu
+    long long turnUsedMs = 0;           // čas tahu spotřebovaný před poslední pauzou
+    std::chrono::steady_clock::time_point flagAt{}; // pád praporku hráče na tahu; {} = hodiny stojí
+    int botLevel = 0;         // 0 = bez bota, jinak bot sedí jako PLAYER2
+    bool maxCaptureRule = false; // povinnost skákat nejdelší řetěz (CREATE_ROOM;...;maxCapture=1)
+    bool botThinking = false; // pro tuto pozici už běží hledání v BotPool
 };
 
 struct ServerLimits {
@@ -74,43 +130,101 @@ struct ServerLimits {
 
 // === Pomocné funkce pro práci s deskou ===
 
-// Vytvoří počáteční rozložení kamenů pro dámu
-inline std::string createInitialBoard() {
-    std::string b;
-    b.resize(BOARD_SIZE * BOARD_SIZE, '.');
-
-    for (int r = 0; r < BOARD_SIZE; ++r) {
-        for (int c = 0; c < BOARD_SIZE; ++c) {
-            bool dark = ((r + c) % 2 == 1);
-            int idx = r * BOARD_SIZE + c;
-
-            if (!dark) continue;
+inline int boardSize(const Room& room) {
+    return variantBoardSize(room.variant);
+}
 
-            if (r < 3) {
-                b[idx] = 'b';
-            } else if (r > 4) {
-                b[idx] = 'w';
+// Vytvoří počáteční rozložení kamenů pro dámu
+inline std::string createInitialBoard(Variant variant = Variant::CZECH) {
+    return withVariantRules(variant, [](auto rules) {
+        using R = decltype(rules);
+        std::string b;
+        b.resize(R::squares, '.');
+
+        for (int r = 0; r < R::size; ++r) {
+            for (int c = 0; c < R::size; ++c) {
+                bool dark = ((r + c) % 2 == 1);
+                int idx = R::index(r, c);
+
+                if (!dark) continue;
+
+                if (r < R::rowsPerSide) {
+                    b[idx] = 'b';
+                } else if (r >= R::size - R::rowsPerSide) {
+                    b[idx] = 'w';
+                }
             }
         }
-    }
 
-    return b;
+        return b;
+    });
 }
 
 // Vrátí figurku na pozici (row, col)
 inline char getPiece(const Room& room, int row, int col) {
-    int idx = row * BOARD_SIZE + col;
+    int idx = row * boardSize(room) + col;
     if (idx < 0 || idx >= static_cast<int>(room.board.size())) {
         return '.'; // pojistka
     }
     return room.board[idx];
 }
 
+// Počítadlo v Material pro daný kámen, nullptr pro prázdné pole
+inline int* materialCounter(Material& material, char piece) {
+    switch (piece) {
+        case 'w': return &material.whiteMen;
+        case 'W': return &material.whiteKings;
+        case 'b': return &material.blackMen;
+        case 'B': return &material.blackKings;
+        default:  return nullptr;
+    }
+}
+
 // Nastaví figurku na pozici (row, col)
 inline void setPiece(Room& room, int row, int col, char piece) {
-    int idx = row * BOARD_SIZE + col;
+    int idx = row * boardSize(room) + col;
     if (idx < 0 || idx >= static_cast<int>(room.board.size())) {
         return; // pojistka
     }
+    room.hash ^= zobristPiece(idx, room.board[idx]) ^ zobristPiece(idx, piece);
+    if (int* removed = materialCounter(room.material, room.board[idx])) --*removed;
+    if (int* added = materialCounter(room.material, piece)) ++*added;
     room.board[idx] = piece;
 }
+
+inline std::uint64_t zobristTurn(Turn turn) {
+    return turn == Turn::PLAYER2 ? ZOBRIST.blackToMove : 0;
+}
+
+inline std::uint64_t zobristLock(const std::optional<std::pair<int, int>>& lock) {
+    // řádek * MAX_BOARD_SIZE, aby klíč pole nezávisel na variantě
+    return lock ? ZOBRIST.lock[lock->first * MAX_BOARD_SIZE + lock->second] : 0;
+}
+
+// Hash pozice spočítaný od nuly; po přímém přiřazení room.board je potřeba ho nastavit
+inline std::uint64_t computePositionHash(const Room& room) {
+    std::uint64_t h = zobristTurn(room.turn) ^ zobristLock(room.captureLock);
+    for (int idx = 0; idx < static_cast<int>(room.board.size()); ++idx) {
+        h ^= zobristPiece(idx, room.board[idx]);
+    }
+    return h;
+}
+
+// Kameny spočítané od nuly; po přímém přiřazení room.board je potřeba je nastavit (jako hash)
+inline Material computeMaterial(const Room& room) {
+    Material material;
+    for (char piece : room.board) {
+        if (int* counter = materialCounter(material, piece)) ++*counter;
+    }
+    return material;
+}
+
+inline void setTurn(Room& room, Turn turn) {
+    room.hash ^= zobristTurn(room.turn) ^ zobristTurn(turn);
+    room.turn = turn;
+}
+
+inline void setCaptureLock(Room& room, const std::optional<std::pair<int, int>>& lock) {
+    room.hash ^= zobristLock(room.captureLock) ^ zobristLock(lock);
+    room.captureLock = lock;
+}
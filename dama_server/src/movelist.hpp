@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+#include "rays.hpp"
+
+// Seznam polí s pevnou kapacitou uložený přímo v objektu, bez haldy.
+// Pole je zabalené do jednoho bajtu (řádek << 4 | sloupec, deska má nejvýš 16 řad);
+// ven se čte jako std::pair<int, int>, takže "for (auto [r, c] : list)" funguje jako dřív.
+template <std::size_t Capacity>
+class SquareList {
+public:
+    using value_type = std::pair<int, int>;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<int, int>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        explicit const_iterator(const std::uint8_t* at) : at(at) {}
+        value_type operator*() const { return unpack(*at); }
+        const_iterator& operator++() { ++at; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++at; return old; }
+        bool operator==(const const_iterator& other) const { return at == other.at; }
+        bool operator!=(const const_iterator& other) const { return at != other.at; }
+
+    private:
+        const std::uint8_t* at;
+    };
+
+    void push_back(int row, int col) {
+        assert(count < Capacity);
+        items[count++] = static_cast<std::uint8_t>((row << 4) | col);
+    }
+    void push_back(const value_type& square) { push_back(square.first, square.second); }
+    void clear() { count = 0; }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    value_type operator[](std::size_t i) const { return unpack(items[i]); }
+
+    const_iterator begin() const { return const_iterator(items.data()); }
+    const_iterator end() const { return const_iterator(items.data() + count); }
+
+private:
+    static value_type unpack(std::uint8_t packed) { return {packed >> 4, packed & 0x0F}; }
+
+    std::array<std::uint8_t, Capacity> items{};
+    std::uint8_t count = 0;
+};
+
+// Nejvíc cílových polí jedné figurky: dáma uprostřed největší desky (13 na 8x8)
+template <int N>
+constexpr int maxKingReach() {
+    int best = 0;
+    for (int sq = 0; sq < RayTables<N>::DARK_SQUARES; ++sq) {
+        int reach = 0;
+        for (int d : ALL_DIRECTIONS) reach += RAYS<N>.rayLength[sq][d];
+        best = reach > best ? reach : best;
+    }
+    return best;
+}
+
+static_assert(maxKingReach<8>() == 13, "a dark-square king on 8x8 reaches at most 13 squares");
+static_assert(MAX_BOARD_SIZE <= 16, "squares are packed into 4-bit row and column");
+
+using MoveTargets = SquareList<static_cast<std::size_t>(maxKingReach<MAX_BOARD_SIZE>())>;
@@ -0,0 +1,238 @@
+#include "pipeline.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+
+void wake(int fd) {
+    if (fd < 0) return;
+    char byte = 1;
+    ssize_t ignored = write(fd, &byte, 1);
+    (void)ignored;
+}
+
+void drainWake(int fd) {
+    if (fd < 0) return;
+    char drain[64];
+    while (read(fd, drain, sizeof(drain)) > 0) {
+    }
+}
+
+bool openWakePipe(int& readFd, int& writeFd) {
+    int fds[2];
+    if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+        perror("pipe2 pipeline");
+        return false;
+    }
+    readFd = fds[0];
+    writeFd = fds[1];
+    return true;
+}
+
+// časová značka a počet zahozených datagramů z řídicích zpráv recvmmsg
+constexpr std::size_t CONTROL_BYTES = CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(std::uint32_t));
+
+} // namespace
+
+NetPipeline::NetPipeline(int sockfd) : sockfd(sockfd) {
+    openWakePipe(ingressWakeRead, ingressWakeWrite);
+    openWakePipe(egressWakeRead, egressWakeWrite);
+    receiver = std::thread([this]() { receiveLoop(); });
+    sender = std::thread([this]() { sendLoop(); });
+}
+
+NetPipeline::~NetPipeline() {
+    stopping = true;
+    wake(egressWakeWrite);
+    if (receiver.joinable()) receiver.join(); // nejpozději po SO_RCVTIMEO
+    if (sender.joinable()) sender.join();
+    for (int fd : {ingressWakeRead, ingressWakeWrite, egressWakeRead, egressWakeWrite}) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+void NetPipeline::receiveLoop() {
+    std::array<mmsghdr, PIPELINE_BATCH> msgs{};
+    std::array<iovec, PIPELINE_BATCH> iovs{};
+    alignas(cmsghdr) std::array<std::array<char, CONTROL_BYTES>, PIPELINE_BATCH> control{};
+    // sem se čte, když je vstupní fronta plná (datagramy se zahodí, ale socket se vyprázdní)
+    std::vector<InboundDatagram> overflow(PIPELINE_BATCH);
+
+    while (!stopping) {
+        std::size_t room = std::min(ingress.freeSlots(PIPELINE_BATCH), PIPELINE_BATCH);
+        bool dropping = room == 0;
+        std::size_t batch = dropping ? PIPELINE_BATCH : room;
+        for (std::size_t i = 0; i < batch; ++i) {
+            InboundDatagram& slot = dropping ? overflow[i] : ingress.freeAt(i);
+            iovs[i].iov_base = slot.data.data();
+            iovs[i].iov_len = slot.data.size() - 1;
+            msgs[i].msg_hdr = msghdr{};
+            msgs[i].msg_hdr.msg_name = &slot.from;
+            msgs[i].msg_hdr.msg_namelen = sizeof(slot.from);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_control = control[i].data();
+            msgs[i].msg_hdr.msg_controllen = control[i].size();
+        }
+
+        int n = recvmmsg(sockfd, msgs.data(), static_cast<unsigned>(batch), MSG_WAITFORONE, nullptr);
+        if (n <= 0) {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                perror("recvmmsg");
+            }
+            continue;
+        }
+        auto received = std::chrono::system_clock::now();
+        std::uint64_t count = static_cast<std::uint64_t>(n);
+        stats_.rxDatagrams.fetch_add(count, std::memory_order_relaxed);
+        stats_.rxBatches.fetch_add(1, std::memory_order_relaxed);
+        if (dropping) {
+            stats_.ingressDrops.fetch_add(count, std::memory_order_relaxed);
+            continue;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            InboundDatagram& slot = ingress.freeAt(static_cast<std::size_t>(i));
+            msghdr& hdr = msgs[static_cast<std::size_t>(i)].msg_hdr;
+            slot.len = msgs[static_cast<std::size_t>(i)].msg_len;
+            slot.fromLen = hdr.msg_namelen;
+            slot.arrived = received;
+            for (cmsghdr* c = CMSG_FIRSTHDR(&hdr); c != nullptr; c = CMSG_NXTHDR(&hdr, c)) {
+                if (c->cmsg_level != SOL_SOCKET) continue;
+                if (c->cmsg_type == SCM_TIMESTAMPNS) {
+                    timespec ts{};
+                    std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                    slot.arrived = std::chrono::system_clock::time_point{} +
+                                   std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                       std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec));
+                } else if (c->cmsg_type == SO_RXQ_OVFL) {
+                    std::uint32_t dropped = 0;
+                    std::memcpy(&dropped, CMSG_DATA(c), sizeof(dropped));
+                    stats_.kernelDrops.store(dropped, std::memory_order_relaxed);
+                }
+            }
+        }
+        ingress.publish(count);
+        std::uint64_t depth = ingress.size();
+        if (depth > stats_.ingressHighWater.load(std::memory_order_relaxed)) {
+            stats_.ingressHighWater.store(depth, std::memory_order_relaxed);
+        }
+        wake(ingressWakeWrite);
+    }
+}
+
+void NetPipeline::clearWake() {
+    drainWake(ingressWakeRead);
+}
+
+InboundDatagram* NetPipeline::nextInbound() {
+    return ingress.ready() > 0 ? &ingress.readyAt(0) : nullptr;
+}
+
+void NetPipeline::popInbound() {
+    ingress.release();
+    stats_.processed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void NetPipeline::send(int fd, const std::string& data, const sockaddr_storage& addr, socklen_t addrLen) {
+    if (egress.freeSlots() == 0) {
+        // protitlak: odesílání nestíhá, herní vlákno počká (zprávy se nezahazují)
+        stats_.egressStalls.fetch_add(1, std::memory_order_relaxed);
+        wake(egressWakeWrite);
+        unsignalled = 0;
+        while (egress.freeSlots() == 0) std::this_thread::yield();
+    }
+    OutboundDatagram& slot = egress.freeAt(0);
+    slot.sockfd = fd;
+    slot.addr = addr;
+    slot.addrLen = addrLen;
+    slot.data.assign(data);
+    egress.publish();
+    ++unsignalled;
+}
+
+void NetPipeline::flush() {
+    if (unsignalled == 0) return;
+    unsignalled = 0;
+    wake(egressWakeWrite);
+}
+
+void NetPipeline::sendLoop() {
+    std::array<mmsghdr, PIPELINE_BATCH> msgs{};
+    std::array<iovec, PIPELINE_BATCH> iovs{};
+    pollfd pfd{egressWakeRead, POLLIN, 0};
+
+    while (true) {
+        std::size_t ready = egress.ready(PIPELINE_BATCH);
+        if (ready == 0) {
+            if (stopping) return;
+            poll(&pfd, 1, 100);
+            drainWake(egressWakeRead);
+            continue;
+        }
+        // sendmmsg posílá jen na jeden socket; dávka končí u prvního jiného
+        std::size_t batch = std::min(ready, PIPELINE_BATCH);
+        int fd = egress.readyAt(0).sockfd;
+        std::size_t count = 0;
+        for (; count < batch; ++count) {
+            OutboundDatagram& slot = egress.readyAt(count);
+            if (slot.sockfd != fd) break;
+            iovs[count].iov_base = slot.data.data();
+            iovs[count].iov_len = slot.data.size();
+            msgs[count].msg_hdr = msghdr{};
+            msgs[count].msg_hdr.msg_name = &slot.addr;
+            msgs[count].msg_hdr.msg_namelen = slot.addrLen;
+            msgs[count].msg_hdr.msg_iov = &iovs[count];
+            msgs[count].msg_hdr.msg_iovlen = 1;
+        }
+
+        int sent = sendmmsg(fd, msgs.data(), static_cast<unsigned>(count), 0);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            // první datagram dávky neprošel (ENOBUFS, špatná adresa); zahodit a pokračovat
+            stats_.sendErrors.fetch_add(1, std::memory_order_relaxed);
+            egress.release();
+            continue;
+        }
+        stats_.txDatagrams.fetch_add(static_cast<std::uint64_t>(sent), std::memory_order_relaxed);
+        stats_.txBatches.fetch_add(1, std::memory_order_relaxed);
+        egress.release(static_cast<std::size_t>(sent));
+    }
+}
+
+void NetPipeline::logStats(std::chrono::steady_clock::time_point now) {
+    if (std::chrono::duration_cast<std::chrono::milliseconds>(now - lastStats).count() < PIPELINE_STATS_MS) return;
+    lastStats = now;
+    std::uint64_t rx = stats_.rxDatagrams.load(std::memory_order_relaxed);
+    std::uint64_t tx = stats_.txDatagrams.load(std::memory_order_relaxed);
+    std::uint64_t drops = stats_.kernelDrops.load(std::memory_order_relaxed) +
+                          stats_.ingressDrops.load(std::memory_order_relaxed) +
+                          stats_.egressStalls.load(std::memory_order_relaxed) +
+                          stats_.sendErrors.load(std::memory_order_relaxed);
+    if (rx == lastRx && tx == lastTx && drops == lastDrops) return;
+    bool worse = drops != lastDrops;
+    lastRx = rx;
+    lastTx = tx;
+    lastDrops = drops;
+    std::cout << (worse ? "[WARN]" : "[INFO]") << " PIPELINE rx=" << rx
+              << " rxBatches=" << stats_.rxBatches.load(std::memory_order_relaxed)
+              << " kernelDrops=" << stats_.kernelDrops.load(std::memory_order_relaxed)
+              << " ingressDrops=" << stats_.ingressDrops.load(std::memory_order_relaxed)
+              << " ingressQueue=" << ingress.size() << "/" << ingress.capacity()
+              << " ingressHigh=" << stats_.ingressHighWater.load(std::memory_order_relaxed)
+              << " processed=" << stats_.processed.load(std::memory_order_relaxed)
+              << " tx=" << tx
+              << " txBatches=" << stats_.txBatches.load(std::memory_order_relaxed)
+              << " egressQueue=" << egress.size() << "/" << egress.capacity()
+              << " egressStalls=" << stats_.egressStalls.load(std::memory_order_relaxed)
+              << " sendErrors=" << stats_.sendErrors.load(std::memory_order_relaxed) << std::endl;
+}
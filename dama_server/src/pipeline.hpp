@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "ring.hpp"
+#include "runtime.hpp"
+
+// Síťové I/O mimo herní vlákno (jen dama_server; simulace a replay volají herní
+// funkce přímo):
+//
+//   vlákno příjmu --SpscRing<InboundDatagram>--> herní vlákno --SpscRing<OutboundDatagram>--> vlákno odesílání
+//
+// Vlákno příjmu čte dávkami přes recvmmsg přímo do slotů fronty, takže pomalý handler
+// (rozbor, LEGAL_MOVES s řetězci) nezastaví vyprazdňování socketu. Odpovědi (už složené
+// po adresátech, viz flushDatagrams) jdou přes Transport do druhé fronty a vlákno
+// odesílání je posílá dávkami přes sendmmsg.
+//
+// Herní stupeň je jediné vlákno a vlastní všechny stoly i hráče, výstupní fronta má tedy
+// jediného zapisovatele. Rozdělit stoly mezi workery (směrování podle id stolu, výstupní
+// fronta pro každého workera) by znamenalo rozdělit i stav, který handlery sdílejí napříč
+// stoly: hráče a jejich koncové body, QUICK_MATCH, turnaje, účty a hodnocení, termíny
+// stolů a skládání odpovědí (runtime.cpp). Mimo herní vlákno tak běží jen práce bez
+// tohoto stavu: hledání bota (BotPool) a rozbory (AnalysisPool).
+//
+// Protitlak a zahazování na každém stupni:
+//  - jádro: přetečení fronty socketu (SO_RXQ_OVFL) -> kernelDrops
+//  - příjem: plná vstupní fronta -> datagram se přečte a zahodí (ingressDrops), aby
+//    zahazování bylo vidět a socket se dál vyprazdňoval
+//  - odesílání: plná výstupní fronta -> herní vlákno počká na místo (egressStalls);
+//    odpovědi se nezahazují, zpomalí se tím jen příjem nových zpráv
+//  - sendmmsg selže (ENOBUFS, nedostupná adresa) -> datagram se zahodí (sendErrors)
+
+constexpr std::size_t PIPELINE_INGRESS_SLOTS = 4096;
+constexpr std::size_t PIPELINE_EGRESS_SLOTS = 4096;
+constexpr std::size_t PIPELINE_BATCH = 32;          // recvmmsg/sendmmsg a zpracování najednou
+constexpr std::size_t PIPELINE_DATAGRAM_BYTES = 1024;
+constexpr int PIPELINE_STATS_MS = 10000;
+
+struct InboundDatagram {
+    sockaddr_storage from{};
+    socklen_t fromLen = 0;
+    std::chrono::system_clock::time_point arrived{}; // časová značka jádra (SO_TIMESTAMPNS)
+    std::size_t len = 0;
+    std::array<char, PIPELINE_DATAGRAM_BYTES> data{};
+};
+
+struct OutboundDatagram {
+    int sockfd = -1;
+    sockaddr_storage addr{};
+    socklen_t addrLen = 0;
+    std::string data; // slot si nechává kapacitu, v ustáleném stavu se nealokuje
+};
+
+// Čítače od spuštění; zapisuje je vždy jen jedno vlákno, číst je smí kdokoli
+struct PipelineStats {
+    std::atomic<std::uint64_t> rxDatagrams{0};
+    std::atomic<std::uint64_t> rxBatches{0};
+    std::atomic<std::uint64_t> kernelDrops{0};   // poslední hodnota SO_RXQ_OVFL
+    std::atomic<std::uint64_t> ingressDrops{0};
+    std::atomic<std::uint64_t> ingressHighWater{0};
+    std::atomic<std::uint64_t> processed{0};
+    std::atomic<std::uint64_t> txDatagrams{0};
+    std::atomic<std::uint64_t> txBatches{0};
+    std::atomic<std::uint64_t> egressStalls{0};
+    std::atomic<std::uint64_t> sendErrors{0};
+};
+
+class NetPipeline : public Transport {
+public:
+    // sockfd musí mít SO_RCVTIMEO (vlákno příjmu podle něj kontroluje zastavení)
+    explicit NetPipeline(int sockfd);
+    ~NetPipeline() override;
+    NetPipeline(const NetPipeline&) = delete;
+    NetPipeline& operator=(const NetPipeline&) = delete;
+
+    // --- herní vlákno ---
+    // čitelný, když vlákno příjmu přidalo datagramy (pro poll v main.cpp)
+    int wakeFd() const { return ingressWakeRead; }
+    void clearWake();
+    // Další přijatý datagram (zůstává ve frontě do popInbound) nebo nullptr
+    InboundDatagram* nextInbound();
+    void popInbound();
+    bool hasInbound() { return ingress.ready() > 0; }
+
+    void send(int sockfd, const std::string& data, const sockaddr_storage& addr, socklen_t addrLen) override;
+    void flush() override;
+
+    const PipelineStats& stats() const { return stats_; }
+    // Jednou za PIPELINE_STATS_MS vypíše čítače, když se od minula něco změnilo
+    void logStats(std::chrono::steady_clock::time_point now);
+
+private:
+    void receiveLoop();
+    void sendLoop();
+
+    int sockfd;
+    SpscRing<InboundDatagram> ingress{PIPELINE_INGRESS_SLOTS};
+    SpscRing<OutboundDatagram> egress{PIPELINE_EGRESS_SLOTS};
+    PipelineStats stats_;
+    std::atomic<bool> stopping{false};
+    std::size_t unsignalled = 0; // datagramy zařazené od posledního probuzení odesílání
+    int ingressWakeRead = -1;
+    int ingressWakeWrite = -1;
+    int egressWakeRead = -1;
+    int egressWakeWrite = -1;
+    std::chrono::steady_clock::time_point lastStats{};
+    std::uint64_t lastRx = 0;
+    std::uint64_t lastTx = 0;
+    std::uint64_t lastDrops = 0;
+    std::thread receiver;
+    std::thread sender;
+};
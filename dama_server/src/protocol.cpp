@@ -2,7 +2,9 @@
 
 #include <sstream>
 #include <iostream>
-#include <arpa/inet.h>   // inet_ntop
+#include <cstring>
+#include <arpa/inet.h>   // inet_ntop, inet_pton
+#include <net/if.h>      // if_nametoindex
 
 std::vector<std::string> split(const std::string& s, char delim) {
     std::vector<std::string> parts;
@@ -53,11 +55,141 @@ bool parseMessage(const std::string& line, Message& msg) {
     return true;
 }
 
-std::string addrToKey(const sockaddr_in& addr) {
-    char ip[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
-    uint16_t port = ntohs(addr.sin_port);
+namespace {
+
+bool isMappedV4(const std::uint8_t* ip) {
+    static constexpr std::uint8_t prefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+    return std::memcmp(ip, prefix, sizeof(prefix)) == 0;
+}
+
+} // namespace
+
+EndpointKey endpointKey(const sockaddr_storage& addr) {
+    EndpointKey key;
+    if (addr.ss_family == AF_INET6) {
+        const auto& a6 = reinterpret_cast<const sockaddr_in6&>(addr);
+        std::memcpy(key.ip.data(), &a6.sin6_addr, 16);
+        key.port = ntohs(a6.sin6_port);
+        key.scope = a6.sin6_scope_id;
+    } else {
+        const auto& a4 = reinterpret_cast<const sockaddr_in&>(addr);
+        key.ip[10] = 0xFF;
+        key.ip[11] = 0xFF;
+        std::memcpy(key.ip.data() + 12, &a4.sin_addr, 4);
+        key.port = ntohs(a4.sin_port);
+    }
+    return key;
+}
+
+sockaddr_storage endpointAddress(const EndpointKey& key) {
+    sockaddr_storage addr{};
+    if (isMappedV4(key.ip.data())) {
+        auto& a4 = reinterpret_cast<sockaddr_in&>(addr);
+        a4.sin_family = AF_INET;
+        a4.sin_port = htons(key.port);
+        std::memcpy(&a4.sin_addr, key.ip.data() + 12, 4);
+    } else {
+        auto& a6 = reinterpret_cast<sockaddr_in6&>(addr);
+        a6.sin6_family = AF_INET6;
+        a6.sin6_port = htons(key.port);
+        std::memcpy(&a6.sin6_addr, key.ip.data(), 16);
+        a6.sin6_scope_id = key.scope;
+    }
+    return addr;
+}
+
+std::size_t EndpointKeyHash::operator()(const EndpointKey& key) const {
+    // IPv4 je celá v posledních 4 bajtech; horních 8 bajtů se přimíchá kvůli IPv6
+    std::uint64_t hi = 0;
+    std::uint64_t lo = 0;
+    std::memcpy(&hi, key.ip.data(), 8);
+    std::memcpy(&lo, key.ip.data() + 8, 8);
+    std::uint64_t h = (lo ^ (hi * 0x9E3779B97F4A7C15ull) ^ (static_cast<std::uint64_t>(key.port) << 17) ^
+                       (static_cast<std::uint64_t>(key.scope) << 33)) *
+                      0xBF58476D1CE4E5B9ull;
+    return static_cast<std::size_t>(h ^ (h >> 31));
+}
+
+namespace {
+
+std::string ipText(const std::uint8_t* ip, bool& v6) {
+    char text[INET6_ADDRSTRLEN];
+    v6 = !isMappedV4(ip);
+    if (v6) {
+        inet_ntop(AF_INET6, ip, text, sizeof(text));
+    } else {
+        inet_ntop(AF_INET, ip + 12, text, sizeof(text));
+    }
+    return text;
+}
+
+} // namespace
+
+std::ostream& operator<<(std::ostream& out, const EndpointKey& key) {
+    bool v6 = false;
+    std::string ip = ipText(key.ip.data(), v6);
+    if (v6 && key.scope != 0) return out << '[' << ip << '%' << key.scope << "]:" << key.port;
+    if (v6) return out << '[' << ip << "]:" << key.port;
+    return out << ip << ':' << key.port;
+}
+
+std::string addrToKey(const sockaddr_storage& addr) {
     std::stringstream ss;
-    ss << ip << ":" << port;
+    ss << endpointKey(addr);
     return ss.str();
-}
\ No newline at end of file
+}
+
+std::string addrHost(const sockaddr_storage& addr) {
+    bool v6 = false;
+    return ipText(endpointKey(addr).ip.data(), v6);
+}
+
+socklen_t addrLength(const sockaddr_storage& addr) {
+    return addr.ss_family == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+}
+
+sockaddr_storage toSocketFamily(const sockaddr_storage& addr, int family) {
+    if (family != AF_INET6 || addr.ss_family != AF_INET) return addr;
+    const auto& a4 = reinterpret_cast<const sockaddr_in&>(addr);
+    sockaddr_storage mapped{};
+    auto& a6 = reinterpret_cast<sockaddr_in6&>(mapped);
+    a6.sin6_family = AF_INET6;
+    a6.sin6_port = a4.sin_port;
+    a6.sin6_addr.s6_addr[10] = 0xFF;
+    a6.sin6_addr.s6_addr[11] = 0xFF;
+    std::memcpy(&a6.sin6_addr.s6_addr[12], &a4.sin_addr, 4);
+    return mapped;
+}
+
+bool parseAddress(const std::string& host, int port, sockaddr_storage& out) {
+    if (port < 0 || port > 65535) return false;
+    sockaddr_storage addr{};
+    auto& a4 = reinterpret_cast<sockaddr_in&>(addr);
+    auto& a6 = reinterpret_cast<sockaddr_in6&>(addr);
+    if (inet_pton(AF_INET, host.c_str(), &a4.sin_addr) == 1) {
+        a4.sin_family = AF_INET;
+        a4.sin_port = htons(static_cast<std::uint16_t>(port));
+    } else {
+        // fe80::1%eth0 nebo fe80::1%2: scope jako jméno rozhraní nebo jeho číslo
+        auto percent = host.find('%');
+        std::string ip = host.substr(0, percent);
+        if (inet_pton(AF_INET6, ip.c_str(), &a6.sin6_addr) != 1) return false;
+        a6.sin6_family = AF_INET6;
+        a6.sin6_port = htons(static_cast<std::uint16_t>(port));
+        if (percent != std::string::npos) {
+            std::string zone = host.substr(percent + 1);
+            if (zone.empty()) return false;
+            if (zone.find_first_not_of("0123456789") == std::string::npos) {
+                if (zone.size() > 10) return false;
+                unsigned long index = std::stoul(zone);
+                if (index > 0xFFFFFFFFul) return false;
+                a6.sin6_scope_id = static_cast<std::uint32_t>(index);
+            } else {
+                a6.sin6_scope_id = if_nametoindex(zone.c_str());
+                if (a6.sin6_scope_id == 0) return false;
+            }
+        }
+    }
+    out = addr;
+    return true;
+}
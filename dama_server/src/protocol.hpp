@@ -2,8 +2,13 @@
 
 #include <string>
 #include <vector>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
 #include <map>
-#include <netinet/in.h>   // sockaddr_in
+#include <netinet/in.h>   // sockaddr_in, sockaddr_in6
+#include <sys/socket.h>   // sockaddr_storage
 
 // Struktura jedné zprávy
 struct Message {
@@ -22,5 +27,44 @@ void rtrim(std::string& s);
 // parsování "ID;TYPE;param;key=val;..."
 bool parseMessage(const std::string& line, Message& msg);
 
-// IP:port -> "127.0.0.1:5000"
-std::string addrToKey(const sockaddr_in& addr);
\ No newline at end of file
+// Adresy klientů jsou sockaddr_storage: IPv4 (AF_INET) nebo IPv6 (AF_INET6). Na socketu
+// s oběma rodinami (--host ::) chodí IPv4 klienti jako ::ffff:a.b.c.d; klíč i text adresy
+// je pro ně stejný jako na čistě IPv4 socketu.
+
+// Kompaktní klíč koncového bodu pro EndpointMap: IPv6 adresa (IPv4 jako ::ffff:a.b.c.d),
+// port a sin6_scope_id, bez skládání řetězce pro každý datagram. fe80::1 na dvou rozhraních
+// jsou dva různí klienti, proto je scope součástí klíče (u IPv4 a globálních adres 0).
+struct EndpointKey {
+    std::array<std::uint8_t, 16> ip{};
+    std::uint16_t port = 0;
+    std::uint32_t scope = 0;
+
+    bool operator==(const EndpointKey& other) const = default;
+};
+
+struct EndpointKeyHash {
+    std::size_t operator()(const EndpointKey& key) const;
+};
+
+EndpointKey endpointKey(const sockaddr_storage& addr);
+// Zpět na adresu: ::ffff:a.b.c.d jako AF_INET, jinak AF_INET6
+sockaddr_storage endpointAddress(const EndpointKey& key);
+
+// "127.0.0.1:5000", "[2001:db8::1]:5000", "[fe80::1%2]:5000" (stejně jako addrToKey)
+std::ostream& operator<<(std::ostream& out, const EndpointKey& key);
+
+// IP:port -> "127.0.0.1:5000", "[2001:db8::1]:5000"
+std::string addrToKey(const sockaddr_storage& addr);
+
+// Jen adresa: "127.0.0.1", "2001:db8::1"
+std::string addrHost(const sockaddr_storage& addr);
+
+// Délka adresy podle rodiny (pro sendto)
+socklen_t addrLength(const sockaddr_storage& addr);
+
+// IPv4 adresa pro socket AF_INET6 jako ::ffff:a.b.c.d; jinak beze změny
+sockaddr_storage toSocketFamily(const sockaddr_storage& addr, int family);
+
+// Číselná IPv4 nebo IPv6 adresa (i se scope: fe80::1%eth0, fe80::1%2) a port ->
+// sockaddr_storage; false pro cokoliv jiného
+bool parseAddress(const std::string& host, int port, sockaddr_storage& out);
\ No newline at end of file
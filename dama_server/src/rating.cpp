@@ -0,0 +1,75 @@
+#include "rating.hpp"
+
+#include "accounts.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+double eloExpected(int a, int b) {
+    return 1.0 / (1.0 + std::pow(10.0, (b - a) / 400.0));
+}
+
+int eloUpdate(const PlayerRating& player, int opponent, double score) {
+    int k = player.games < RATING_PROVISIONAL_GAMES ? RATING_K_PROVISIONAL : RATING_K;
+    double next = player.rating + k * (score - eloExpected(player.rating, opponent));
+    return std::max(RATING_MIN, static_cast<int>(std::lround(next)));
+}
+
+PlayerRating RatingTable::get(const std::string& nick) const {
+    if (accounts) {
+        auto account = accounts->find(nick);
+        return account ? account->rating : PlayerRating{};
+    }
+    auto it = ratings.find(nick);
+    return it != ratings.end() ? it->second : PlayerRating{};
+}
+
+void RatingTable::set(const std::string& nick, const PlayerRating& rating) {
+    if (accounts) {
+        accounts->saveRating(nick, rating);
+        return;
+    }
+    ratings[nick] = rating;
+}
+
+void RatingTable::gameFinished(const Room& room, const std::string& reason, const std::string& winner) {
+    if (room.botLevel > 0 || room.whiteNick.empty() || room.blackNick.empty() ||
+        room.whiteNick == room.blackNick) {
+        return;
+    }
+    double whiteScore;
+    if (reason.rfind("DRAW_", 0) == 0) {
+        whiteScore = 0.5;
+    } else if (winner == "WHITE") {
+        whiteScore = 1.0;
+    } else if (winner == "BLACK") {
+        whiteScore = 0.0;
+    } else {
+        return;
+    }
+
+    PlayerRating white = get(room.whiteNick);
+    PlayerRating black = get(room.blackNick);
+    auto played = [](PlayerRating before, int opponent, double score) {
+        PlayerRating after = before;
+        after.rating = eloUpdate(before, opponent, score);
+        after.games++;
+        if (score == 1.0) {
+            after.wins++;
+        } else if (score == 0.0) {
+            after.losses++;
+        } else {
+            after.draws++;
+        }
+        return after;
+    };
+    PlayerRating newWhite = played(white, black.rating, whiteScore);
+    PlayerRating newBlack = played(black, white.rating, 1.0 - whiteScore);
+    set(room.whiteNick, newWhite);
+    set(room.blackNick, newBlack);
+
+    std::cout << "[INFO] RATING room=" << room.id
+              << " " << room.whiteNick << "=" << white.rating << "->" << newWhite.rating
+              << " " << room.blackNick << "=" << black.rating << "->" << newBlack.rating << std::endl;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include "models.hpp"
+#include "runtime.hpp"
+
+// Elo hodnocení hráčů podle přezdívky. Mění se po každé dohrané partii dvou lidí
+// (GAME_END s vítězem nebo remízou); partie s botem a partie bez výsledku
+// (oba odešli, server končí) se nepočítají. QUICK_MATCH podle něj páruje.
+// S účty (--accounts) se hodnocení čte z AccountStore a po partii se do něj zapíše.
+
+constexpr int RATING_INITIAL = 1500;
+constexpr int RATING_PROVISIONAL_GAMES = 20; // prvních N partií se hodnocení hýbe rychleji
+constexpr int RATING_K_PROVISIONAL = 40;
+constexpr int RATING_K = 20;
+constexpr int RATING_MIN = 100;
+
+struct PlayerRating {
+    int rating = RATING_INITIAL;
+    int games = 0; // hodnocené partie
+    int wins = 0;
+    int losses = 0;
+    int draws = 0;
+};
+
+class AccountStore;
+
+// Očekávaný počet bodů hráče s hodnocením a proti b (0..1)
+double eloExpected(int a, int b);
+
+// Nové hodnocení po partii; score je 1 výhra, 0.5 remíza, 0 prohra
+int eloUpdate(const PlayerRating& player, int opponent, double score);
+
+class RatingTable : public GameRecorder {
+public:
+    // Od teď čte a zapisuje hodnocení v účtech (store musí přežít tabulku)
+    void attach(AccountStore* store) { accounts = store; }
+
+    // Hráč bez odehrané partie má RATING_INITIAL
+    PlayerRating get(const std::string& nick) const;
+    void set(const std::string& nick, const PlayerRating& rating);
+
+    void gameFinished(const Room& room, const std::string& reason, const std::string& winner) override;
+
+private:
+    AccountStore* accounts = nullptr;
+    std::unordered_map<std::string, PlayerRating> ratings; // bez účtů jen do restartu
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "variants.hpp"
+
+// Předpočítané tabulky tmavých polí pro desku N x N: sousedé, cíle skoku a celé
+// paprsky po diagonálách. Generují se při překladu, takže pravidla místo
+// inBoard/isDarkSquare/row*N+col v každém kroku jen čtou z tabulky.
+// Směr d je index do KING_DIRECTIONS; pole v tabulkách jsou indexy do Room::board.
+
+constexpr std::int8_t NO_SQUARE = -1;
+
+template <int N>
+struct RayTables {
+    static constexpr int DARK_SQUARES = N * N / 2;
+
+    std::array<std::int8_t, N * N> darkOf{};                  // index desky -> tmavé pole, jinak NO_SQUARE
+    std::array<std::uint8_t, DARK_SQUARES> boardIndex{};      // tmavé pole -> index desky
+    std::array<std::array<std::int8_t, 4>, DARK_SQUARES> neighbor{}; // o jedno pole ve směru d
+    std::array<std::array<std::int8_t, 4>, DARK_SQUARES> jump{};     // o dvě pole (dopad skoku)
+    std::array<std::array<std::uint8_t, 4>, DARK_SQUARES> rayLength{};
+    std::array<std::array<std::array<std::uint8_t, N - 1>, 4>, DARK_SQUARES> ray{}; // pole od nejbližšího
+};
+
+template <int N>
+constexpr RayTables<N> makeRayTables() {
+    RayTables<N> t;
+    auto onBoard = [](int row, int col) { return row >= 0 && row < N && col >= 0 && col < N; };
+
+    for (auto& d : t.darkOf) d = NO_SQUARE;
+    int dark = 0;
+    for (int row = 0; row < N; ++row) {
+        for (int col = 0; col < N; ++col) {
+            if ((row + col) % 2 != 1) continue;
+            t.darkOf[row * N + col] = static_cast<std::int8_t>(dark);
+            t.boardIndex[dark] = static_cast<std::uint8_t>(row * N + col);
+            ++dark;
+        }
+    }
+
+    for (int sq = 0; sq < RayTables<N>::DARK_SQUARES; ++sq) {
+        int row = t.boardIndex[sq] / N;
+        int col = t.boardIndex[sq] % N;
+        for (int d = 0; d < 4; ++d) {
+            auto [dr, dc] = KING_DIRECTIONS[d];
+            t.neighbor[sq][d] = onBoard(row + dr, col + dc)
+                ? static_cast<std::int8_t>((row + dr) * N + col + dc) : NO_SQUARE;
+            t.jump[sq][d] = onBoard(row + 2 * dr, col + 2 * dc)
+                ? static_cast<std::int8_t>((row + 2 * dr) * N + col + 2 * dc) : NO_SQUARE;
+            int len = 0;
+            for (int r = row + dr, c = col + dc; onBoard(r, c); r += dr, c += dc) {
+                t.ray[sq][d][len++] = static_cast<std::uint8_t>(r * N + c);
+            }
+            t.rayLength[sq][d] = static_cast<std::uint8_t>(len);
+        }
+    }
+    return t;
+}
+
+template <int N>
+inline constexpr RayTables<N> RAYS = makeRayTables<N>();
+
+// Index směru v KING_DIRECTIONS podle znamének kroku
+constexpr int directionIndex(int dr, int dc) {
+    return (dr > 0 ? 2 : 0) + (dc > 0 ? 1 : 0);
+}
+
+static_assert(RAYS<8>.darkOf[1] == 0 && RAYS<8>.boardIndex[31] == 62, "dark square numbering");
+static_assert(RAYS<8>.rayLength[RAYS<8>.darkOf[7 * 8 + 0]][directionIndex(-1, 1)] == 7, "long diagonal");
+static_assert(RAYS<10>.jump[RAYS<10>.darkOf[0 * 10 + 1]][directionIndex(-1, 1)] == NO_SQUARE, "jump off board");
+static_assert(KING_DIRECTIONS[WHITE_MAN_DIRECTIONS[0]].dr == -1 && KING_DIRECTIONS[BLACK_MAN_DIRECTIONS[0]].dr == 1,
+              "white men move up, black men down");
+static_assert(KING_DIRECTIONS[directionIndex(1, -1)].dr == 1 && KING_DIRECTIONS[directionIndex(1, -1)].dc == -1,
+              "directionIndex must match KING_DIRECTIONS");
@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+#include "alloccount.hpp"
+#include "capture.hpp"
+#include "runtime.hpp"
+#include "server.hpp"
+
+// dama_replay – přehraje záznam provozu (dama_server --capture FILE) celou cestou
+// parsování, dispatch a handlery na virtuálních hodinách, bez sítě. Vypíše CPU čas
+// a alokace po typech zpráv; stejný záznam před a po změně = A/B srovnání.
+// Použití: dama_replay --capture FILE [--repeat N] [--analysis-table-mb MB] [--mtu BYTES] [--verbose]
+// Bot a ANALYZE počítají synchronně jako v dama_sim (řádky <bot> a <analysis>), logy
+// serveru se bez --verbose zahazují.
+
+namespace {
+
+struct ReplayClock : Clock {
+    std::chrono::steady_clock::time_point base = std::chrono::steady_clock::now();
+    std::chrono::system_clock::time_point wallBase = std::chrono::system_clock::now();
+    std::uint64_t nowUs = 0;
+
+    std::chrono::steady_clock::time_point now() const override {
+        return base + std::chrono::microseconds(nowUs);
+    }
+    std::chrono::system_clock::time_point wallNow() const override {
+        return wallBase + std::chrono::microseconds(nowUs);
+    }
+};
+
+// Odpovědi serveru se jen počítají
+struct CountingTransport : Transport {
+    std::uint64_t datagrams = 0;
+    std::uint64_t messages = 0; // datagram nese víc zpráv, když se skládají (--mtu)
+    std::uint64_t bytes = 0;
+    std::uint64_t errors = 0;
+
+    void send(int, const std::string& data, const sockaddr_storage&, socklen_t) override {
+        ++datagrams;
+        bytes += data.size();
+        messages += static_cast<std::uint64_t>(std::count(data.begin(), data.end(), '\n'));
+        for (auto at = data.find(";ERROR;"); at != std::string::npos; at = data.find(";ERROR;", at + 1)) ++errors;
+    }
+};
+
+struct CommandStats {
+    std::uint64_t count = 0;
+    std::uint64_t cpuNs = 0;
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+};
+
+std::uint64_t threadCpuNs() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+// Typ zprávy "ID;TYPE;..." pro statistiku; nesmysly pod jedním řádkem
+std::string commandOf(const std::string& data) {
+    std::size_t first = data.find(';');
+    if (first == std::string::npos) return "<invalid>";
+    std::size_t second = data.find_first_of(";\r\n", first + 1);
+    std::string type = data.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1);
+    bool plain = !type.empty() && type.size() <= 24 &&
+                 std::all_of(type.begin(), type.end(), [](char c) { return (c >= 'A' && c <= 'Z') || c == '_'; });
+    return plain ? type : "<invalid>";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    int repeat = 1;
+    int analysisTableMb = 4;
+    bool verbose = false;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument(arg);
+                return argv[++i];
+            };
+            if (arg == "--capture") {
+                path = next();
+            } else if (arg == "--repeat") {
+                repeat = std::max(1, std::stoi(next()));
+            } else if (arg == "--analysis-table-mb") {
+                analysisTableMb = std::max(1, std::stoi(next()));
+            } else if (arg == "--mtu") {
+                setEgressMtu(static_cast<std::size_t>(std::max(0, std::stoi(next()))));
+            } else if (arg == "--verbose") {
+                verbose = true;
+            } else {
+                std::cerr << "Unknown argument " << arg << std::endl;
+                return 2;
+            }
+        }
+    } catch (...) {
+        std::cerr << "Invalid arguments" << std::endl;
+        return 2;
+    }
+    if (path.empty()) {
+        std::cerr << "Missing --capture FILE" << std::endl;
+        return 2;
+    }
+
+    Capture capture;
+    std::string error;
+    if (!readCapture(path, capture, error)) {
+        std::cerr << "Cannot read capture: " << error << std::endl;
+        return 1;
+    }
+
+    ReplayClock clock;
+    CountingTransport transport;
+    setServerClock(&clock);
+    setServerTransport(&transport);
+    auto* coutBuf = std::cout.rdbuf();
+    if (!verbose) std::cout.rdbuf(nullptr);
+
+    std::map<std::string, CommandStats> stats;
+    auto measure = [&](const std::string& name, auto&& fn) {
+        CommandStats& s = stats[name]; // mimo měření: vložení do mapy alokuje
+        std::uint64_t allocs = allocationCount;
+        std::uint64_t bytes = allocatedBytes;
+        std::uint64_t cpu = threadCpuNs();
+        fn();
+        s.cpuNs += threadCpuNs() - cpu;
+        s.allocations += allocationCount - allocs;
+        s.bytes += allocatedBytes - bytes;
+        ++s.count;
+    };
+
+    auto wallStart = std::chrono::steady_clock::now();
+    const std::uint64_t idleUs = static_cast<std::uint64_t>(std::max(1, capture.config.timeoutCheckIntervalMs)) * 1000;
+    for (int r = 0; r < repeat; ++r) {
+        ServerState server;
+        server.config = capture.config;
+        server.limits = capture.limits;
+        server.sockfd = 3; // jen symbolicky, odesílá se přes Transport
+        server.bots = std::make_unique<BotPool>(0);
+        server.analysis = std::make_unique<AnalysisPool>(0, static_cast<std::size_t>(analysisTableMb));
+        seedServerRandom(capture.seed);
+        clock.nowUs = 0;
+        server.lastTimeoutCheck = steadyNow();
+
+        // main.cpp volá processIdle po každém probuzení; bez provozu vyprší poll jednou za idleUs
+        std::uint64_t lastActivityUs = 0;
+        for (const CapturedDatagram& d : capture.datagrams) {
+            while (lastActivityUs + idleUs <= d.atUs) {
+                lastActivityUs += idleUs;
+                clock.nowUs = lastActivityUs;
+                measure("<idle>", [&] {
+                    processIdle(server);
+                    flushDatagrams();
+                });
+            }
+            clock.nowUs = d.atUs;
+            lastActivityUs = d.atUs;
+            measure("<idle>", [&] {
+                processIdle(server);
+                flushDatagrams();
+            });
+            measure(commandOf(d.data), [&] {
+                processDatagram(server, d.data.data(), d.data.size(), d.from, addrLength(d.from));
+                flushDatagrams();
+            });
+            // hledání bota a rozbory jako samostatné řádky, jen když něco čeká
+            if (server.bots->backlog() > 0) {
+                measure("<bot>", [&] {
+                    processBotResults(server);
+                    flushDatagrams();
+                });
+            }
+            if (server.analysis->backlog() > 0) {
+                measure("<analysis>", [&] {
+                    processAnalysisResults(server);
+                    flushDatagrams();
+                });
+            }
+        }
+    }
+    auto wallMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - wallStart).count();
+
+    std::cout.rdbuf(coutBuf);
+    std::cout.clear();
+    setServerTransport(nullptr);
+    setServerClock(nullptr);
+
+    std::uint64_t spanUs = capture.datagrams.empty() ? 0 : capture.datagrams.back().atUs;
+    std::cout << "[REPLAY] capture=" << path
+              << " datagrams=" << capture.datagrams.size()
+              << " span=" << spanUs / 1000000 << "s"
+              << " repeat=" << repeat
+              << " wall=" << wallMs << "ms"
+              << " sent=" << transport.datagrams / static_cast<std::uint64_t>(repeat)
+              << " messages=" << transport.messages / static_cast<std::uint64_t>(repeat)
+              << " sentBytes=" << transport.bytes / static_cast<std::uint64_t>(repeat)
+              << " errors=" << transport.errors / static_cast<std::uint64_t>(repeat) << std::endl;
+
+    std::vector<std::pair<std::string, CommandStats>> rows(stats.begin(), stats.end());
+    std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) { return a.second.cpuNs > b.second.cpuNs; });
+    std::printf("%-20s %10s %12s %10s %10s %12s\n", "command", "count", "cpu_ms", "us/op", "allocs/op", "bytes/op");
+    for (const auto& [name, s] : rows) {
+        double count = static_cast<double>(s.count);
+        std::printf("%-20s %10llu %12.3f %10.2f %10.2f %12.1f\n", name.c_str(),
+                    static_cast<unsigned long long>(s.count), s.cpuNs / 1e6, s.cpuNs / 1e3 / count,
+                    s.allocations / count, s.bytes / count);
+    }
+    return 0;
+}
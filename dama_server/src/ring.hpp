@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Kruhová fronta bez zámků pro jednoho zapisovatele a jednoho čtenáře (SPSC).
+// Sloty jsou předalokované a zůstávají na místě: zapisovatel plní volné sloty přímo
+// (recvmmsg do nich čte, std::string v nich si nechá kapacitu) a publish je zveřejní,
+// čtenář je zpracuje na místě a release je vrátí. Indexy rostou bez přetečení modulo,
+// pozice slotu je index & (kapacita - 1).
+//
+// Každá strana si drží kopii indexu druhé strany a atomický index čte až ve chvíli,
+// kdy jí podle kopie nestačí místo / data, takže se sdílená cache line přenáší jen
+// jednou za dávku.
+template <typename T>
+class SpscRing {
+public:
+    // capacity se zaokrouhlí nahoru na mocninu dvou
+    explicit SpscRing(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity) size <<= 1;
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t capacity() const { return slots_.size(); }
+    // Přibližná obsazenost (pro statistiky z libovolného vlákna)
+    std::size_t size() const {
+        std::size_t tail = tail_.load(std::memory_order_acquire); // nejdřív tail: head >= tail vždy
+        return head_.load(std::memory_order_acquire) - tail;
+    }
+
+    // --- zapisovatel ---
+    // Počet volných slotů; atomický index čtenáře se čte, jen když jich podle kopie je méně než want
+    std::size_t freeSlots(std::size_t want = 1) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (slots_.size() - (head - tailCache_) < want) tailCache_ = tail_.load(std::memory_order_acquire);
+        return slots_.size() - (head - tailCache_);
+    }
+    // i-tý volný slot (i < freeSlots())
+    T& freeAt(std::size_t i) { return slots_[(head_.load(std::memory_order_relaxed) + i) & mask_]; }
+    void publish(std::size_t count = 1) {
+        head_.store(head_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // --- čtenář ---
+    // Počet připravených slotů; obdobně jako freeSlots
+    std::size_t ready(std::size_t want = 1) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (headCache_ - tail < want) headCache_ = head_.load(std::memory_order_acquire);
+        return headCache_ - tail;
+    }
+    // i-tý připravený slot (i < ready())
+    T& readyAt(std::size_t i) { return slots_[(tail_.load(std::memory_order_relaxed) + i) & mask_]; }
+    void release(std::size_t count = 1) {
+        tail_.store(tail_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+private:
+    std::vector<T> slots_;
+    std::size_t mask_ = 0;
+    alignas(64) std::atomic<std::size_t> head_{0}; // zapisuje jen zapisovatel
+    std::size_t tailCache_ = 0;
+    alignas(64) std::atomic<std::size_t> tail_{0}; // zapisuje jen čtenář
+    std::size_t headCache_ = 0;
+};
@@ -0,0 +1,561 @@
+#include "rules.hpp"
+#include "rays.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+bool isDarkSquare(int row, int col) {
+    return ((row + col) % 2) == 1;
+}
+
+PieceColor pieceColor(char piece) {
+    if (piece == 'w' || piece == 'W') return PieceColor::WHITE;
+    if (piece == 'b' || piece == 'B') return PieceColor::BLACK;
+    return PieceColor::NONE;
+}
+
+bool isKing(char piece) {
+    return piece == 'W' || piece == 'B';
+}
+
+bool inBoard(const Room& room, int row, int col) {
+    int size = boardSize(room);
+    return row >= 0 && row < size && col >= 0 && col < size;
+}
+
+namespace {
+
+// Uvnitř šablon se pracuje s indexy desky a tabulkami RAYS; tmavé pole sq je číslo 0..N*N/2-1
+template <class R>
+constexpr const RayTables<R::size>& rays() {
+    return RAYS<R::size>;
+}
+
+// Index desky pro (row, col) na tmavém poli, jinak -1
+template <class R>
+int boardSquare(int row, int col) {
+    if (!R::inBoard(row, col)) return -1;
+    int idx = R::index(row, col);
+    return rays<R>().darkOf[idx] == NO_SQUARE ? -1 : idx;
+}
+
+// Smí piece přeskočit target? (soupeřova figurka; v italské dámě pěšec nebere dámu)
+template <class R>
+bool canJumpOver(char piece, char target) {
+    PieceColor mine = pieceColor(piece);
+    PieceColor other = pieceColor(target);
+    if (other == PieceColor::NONE || other == mine) return false;
+    if constexpr (!R::menCaptureKings) {
+        if (!isKing(piece) && isKing(target)) return false;
+    }
+    return true;
+}
+
+// Cílová pole (index desky) jednoho skoku figurky piece z tmavého pole sq; visit vrací false = dost
+template <class R, class Visit>
+void forEachCapture(const Room& room, int sq, char piece, Visit&& visit) {
+    const auto& t = rays<R>();
+    bool king = isKing(piece);
+    if (!king || !R::flyingKings) {
+        std::span<const int> dirs = king ? std::span<const int>(ALL_DIRECTIONS)
+                                         : manCaptureDirections<R>(pieceColor(piece) == PieceColor::WHITE);
+        for (int d : dirs) {
+            int dst = t.jump[sq][d];
+            if (dst == NO_SQUARE || room.board[dst] != '.') continue;
+            if (!canJumpOver<R>(piece, room.board[t.neighbor[sq][d]])) continue;
+            if (!visit(dst)) return;
+        }
+        return;
+    }
+
+    PieceColor myColor = pieceColor(piece);
+    for (int d : ALL_DIRECTIONS) {
+        const auto& ray = t.ray[sq][d];
+        bool enemyFound = false;
+        for (int i = 0; i < t.rayLength[sq][d]; ++i) {
+            char cur = room.board[ray[i]];
+            if (cur == '.') {
+                // našli jsme nepřítele a za ním volné pole
+                if (enemyFound && !visit(ray[i])) return;
+            } else if (pieceColor(cur) == myColor || enemyFound) {
+                break; // vlastní figura nebo druhá figurka v řadě
+            } else {
+                enemyFound = true;
+            }
+        }
+    }
+}
+
+// Cílová pole (index desky) tahu bez skoku z tmavého pole sq; visit vrací false = dost
+template <class R, class Visit>
+void forEachSimpleMove(const Room& room, int sq, char piece, Visit&& visit) {
+    const auto& t = rays<R>();
+    bool king = isKing(piece);
+    std::span<const int> dirs = king ? std::span<const int>(ALL_DIRECTIONS)
+                                     : manDirections<R>(pieceColor(piece) == PieceColor::WHITE);
+    int reach = (king && R::flyingKings) ? R::size : 1;
+    for (int d : dirs) {
+        const auto& ray = t.ray[sq][d];
+        int len = std::min<int>(t.rayLength[sq][d], reach);
+        for (int i = 0; i < len && room.board[ray[i]] == '.'; ++i) {
+            if (!visit(ray[i])) return;
+        }
+    }
+}
+
+template <class R>
+bool canCaptureFromT(const Room& room, int sq, char piece) {
+    bool found = false;
+    forEachCapture<R>(room, sq, piece, [&](int) {
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+template <class R>
+bool playerHasAnyCaptureT(const Room& room, PieceColor color) {
+    const auto& t = rays<R>();
+    int left = pieceCount(room, color); // po posledním kameni strany už nic nehledáme
+    for (int sq = 0; left > 0 && sq < RayTables<R::size>::DARK_SQUARES; ++sq) {
+        char p = room.board[t.boardIndex[sq]];
+        if (pieceColor(p) != color) continue;
+        --left;
+        if (canCaptureFromT<R>(room, sq, p)) return true;
+    }
+    return false;
+}
+
+template <class R>
+bool playerHasAnySimpleMoveT(const Room& room, PieceColor color) {
+    const auto& t = rays<R>();
+    int left = pieceCount(room, color);
+    for (int sq = 0; left > 0 && sq < RayTables<R::size>::DARK_SQUARES; ++sq) {
+        char p = room.board[t.boardIndex[sq]];
+        if (pieceColor(p) != color) continue;
+        --left;
+        bool found = false;
+        forEachSimpleMove<R>(room, sq, p, [&](int) {
+            found = true;
+            return false;
+        });
+        if (found) return true;
+    }
+    return false;
+}
+
+template <class R>
+void playMoveT(Room& room, int fromRow, int fromCol, int toRow, int toCol, MoveResult& result) {
+    const auto& t = rays<R>();
+    int from = R::index(fromRow, fromCol);
+    int to = R::index(toRow, toCol);
+
+    result = MoveResult{};
+    char pieceFrom = room.board[from];
+    result.kingMove = isKing(pieceFrom);
+    result.movedPiece = pieceFrom;
+    result.previousLock = room.captureLock;
+    result.previousTurn = room.turn;
+    bool isWhite = pieceColor(pieceFrom) == PieceColor::WHITE;
+
+    int d = directionIndex(toRow - fromRow, toCol - fromCol);
+    const auto& ray = t.ray[t.darkOf[from]][d];
+    for (int i = 0; ray[i] != to; ++i) {
+        char cur = room.board[ray[i]];
+        if (cur != '.') {
+            result.capture = true;
+            result.capturedRow = ray[i] / R::size;
+            result.capturedCol = ray[i] % R::size;
+            result.capturedPiece = cur;
+            break;
+        }
+    }
+
+    if (result.capture) {
+        setPiece(room, result.capturedRow, result.capturedCol, '.');
+    }
+    setPiece(room, toRow, toCol, pieceFrom);
+    setPiece(room, fromRow, fromCol, '.');
+
+    // povýšení na dámu
+    char placed = pieceFrom;
+    int toSq = t.darkOf[to];
+    bool lastRow = isWhite ? toRow == 0 : toRow == R::size - 1;
+    if (!isKing(placed) && lastRow) {
+        bool promote = true;
+        if constexpr (R::promotion == PromotionRule::END_OF_CHAIN) {
+            // pěšec, který může skákat dál, jen prochází poslední řadou
+            promote = !(result.capture && canCaptureFromT<R>(room, toSq, placed));
+        }
+        if (promote) {
+            placed = isWhite ? 'W' : 'B';
+            setPiece(room, toRow, toCol, placed);
+            result.promoted = true;
+        }
+    }
+
+    if (result.capture) {
+        if (R::promotion == PromotionRule::ENDS_MOVE && result.promoted) {
+            result.captureContinues = false;
+        } else {
+            result.captureContinues = canCaptureFromT<R>(room, toSq, placed);
+        }
+    }
+
+    if (result.captureContinues) {
+        setCaptureLock(room, std::make_pair(toRow, toCol));
+    } else {
+        setCaptureLock(room, std::nullopt);
+        setTurn(room, (room.turn == Turn::PLAYER1) ? Turn::PLAYER2 : Turn::PLAYER1);
+    }
+}
+
+template <class R>
+std::string validateMoveT(const Room& room, bool isWhite, int fromRow, int fromCol, int toRow, int toCol,
+                          bool& captureAvailable) {
+    if (room.captureLock.has_value()) {
+        auto [lockRow, lockCol] = *room.captureLock;
+        if (fromRow != lockRow || fromCol != lockCol) {
+            return "MUST_CONTINUE_CAPTURE";
+        }
+    }
+
+    if (!R::inBoard(fromRow, fromCol) || !R::inBoard(toRow, toCol)) {
+        return "OUT_OF_BOARD";
+    }
+    int from = boardSquare<R>(fromRow, fromCol);
+    int to = boardSquare<R>(toRow, toCol);
+    if (from < 0 || to < 0) {
+        return "INVALID_SQUARE";
+    }
+
+    char pieceFrom = room.board[from];
+    char pieceTo   = room.board[to];
+    if (pieceFrom == '.') {
+        return "NO_PIECE";
+    }
+
+    PieceColor currentColor = isWhite ? PieceColor::WHITE : PieceColor::BLACK;
+    if (pieceColor(pieceFrom) != currentColor) {
+        return "NOT_YOUR_PIECE";
+    }
+    if (pieceTo != '.') {
+        return "DEST_NOT_EMPTY";
+    }
+
+    int dRow = toRow - fromRow;
+    int dCol = toCol - fromCol;
+    int distance = std::abs(dRow);
+    if (distance != std::abs(dCol) || dRow == 0) {
+        return "INVALID_MOVE";
+    }
+
+    captureAvailable = playerHasAnyCaptureT<R>(room, currentColor);
+    const auto& ray = rays<R>().ray[rays<R>().darkOf[from]][directionIndex(dRow, dCol)];
+
+    if (isKing(pieceFrom) && R::flyingKings) {
+        int enemies = 0;
+        for (int i = 0; i < distance - 1; ++i) {
+            char cur = room.board[ray[i]];
+            if (cur == '.') continue;
+            if (pieceColor(cur) == currentColor || ++enemies > 1) {
+                return "INVALID_MOVE";
+            }
+        }
+        if (enemies == 0 && captureAvailable) {
+            return "MUST_CAPTURE";
+        }
+        return "";
+    }
+
+    // pěšec, nebo dáma bez dlouhého tahu
+    bool isSimple = distance == 1;
+    bool shortCapture = distance == 2;
+    if (!isSimple && !shortCapture) {
+        return "INVALID_MOVE";
+    }
+    bool backward = (isWhite && dRow > 0) || (!isWhite && dRow < 0);
+    if (!isKing(pieceFrom) && backward && !(shortCapture && R::menCaptureBackward)) {
+        return "INVALID_DIRECTION";
+    }
+    if (isSimple && captureAvailable) {
+        return "MUST_CAPTURE";
+    }
+    if (shortCapture) {
+        char middlePiece = room.board[ray[0]];
+        if (pieceColor(middlePiece) == PieceColor::NONE || pieceColor(middlePiece) == currentColor) {
+            return "NO_OPPONENT_TO_CAPTURE";
+        }
+        if (!canJumpOver<R>(pieceFrom, middlePiece)) {
+            return "MAN_CANNOT_CAPTURE_KING";
+        }
+    }
+    return "";
+}
+
+// Cílová pole skoků (Captures) nebo tahů figurky piece na (row, col) jako dvojice
+template <class R, bool Captures>
+MoveTargets collectSquares(const Room& room, int row, int col, char piece) {
+    MoveTargets out;
+    int from = boardSquare<R>(row, col);
+    if (from < 0) return out;
+    auto add = [&](int idx) {
+        out.push_back(idx / R::size, idx % R::size);
+        return true;
+    };
+    if constexpr (Captures) {
+        forEachCapture<R>(room, rays<R>().darkOf[from], piece, add);
+    } else {
+        forEachSimpleMove<R>(room, rays<R>().darkOf[from], piece, add);
+    }
+    return out;
+}
+
+} // namespace
+
+bool canCaptureFrom(const Room& room, int row, int col, char piece) {
+    return withVariantRules(room.variant, [&](auto rules) {
+        using R = decltype(rules);
+        int from = boardSquare<R>(row, col);
+        return from >= 0 && canCaptureFromT<R>(room, rays<R>().darkOf[from], piece);
+    });
+}
+
+bool playerHasAnyCapture(const Room& room, PieceColor color) {
+    return withVariantRules(room.variant, [&](auto rules) {
+        return playerHasAnyCaptureT<decltype(rules)>(room, color);
+    });
+}
+
+int pieceCount(const Room& room, PieceColor color) {
+    const Material& m = room.material;
+    if (color == PieceColor::WHITE) return m.whiteMen + m.whiteKings;
+    if (color == PieceColor::BLACK) return m.blackMen + m.blackKings;
+    return 0;
+}
+
+bool hasAnyPiece(const Room& room, PieceColor color) {
+    return pieceCount(room, color) > 0;
+}
+
+bool playerHasAnySimpleMove(const Room& room, PieceColor color) {
+    return withVariantRules(room.variant, [&](auto rules) {
+        return playerHasAnySimpleMoveT<decltype(rules)>(room, color);
+    });
+}
+
+bool playerHasAnyMove(const Room& room, PieceColor color) {
+    if (playerHasAnyCapture(room, color)) return true;
+    return playerHasAnySimpleMove(room, color);
+}
+
+MoveTargets kingSimpleMoves(const Room& room, int row, int col) {
+    return withVariantRules(room.variant, [&](auto rules) {
+        return collectSquares<decltype(rules), false>(room, row, col, 'W');
+    });
+}
+
+MoveTargets kingCaptureMoves(const Room& room, int row, int col, PieceColor myColor) {
+    char king = myColor == PieceColor::WHITE ? 'W' : 'B';
+    return withVariantRules(room.variant, [&](auto rules) {
+        return collectSquares<decltype(rules), true>(room, row, col, king);
+    });
+}
+
+MoveTargets manSimpleMoves(const Room& room, int row, int col, bool isWhite) {
+    return withVariantRules(room.variant, [&](auto rules) {
+        return collectSquares<decltype(rules), false>(room, row, col, isWhite ? 'w' : 'b');
+    });
+}
+
+MoveTargets manCaptureMoves(const Room& room, int row, int col, bool isWhite, PieceColor) {
+    return withVariantRules(room.variant, [&](auto rules) {
+        return collectSquares<decltype(rules), true>(room, row, col, isWhite ? 'w' : 'b');
+    });
+}
+
+void copyPosition(Room& into, const Room& from) {
+    into.variant = from.variant;
+    into.board = from.board;
+    into.turn = from.turn;
+    into.captureLock = from.captureLock;
+    into.maxCaptureRule = from.maxCaptureRule;
+    into.hash = from.hash;
+    into.material = from.material;
+}
+
+Room scratchPosition(const Room& room) {
+    Room position;
+    copyPosition(position, room);
+    return position;
+}
+
+Room makePosition(Variant variant, const std::string& board, Turn turn,
+                  const std::optional<std::pair<int, int>>& captureLock, bool maxCaptureRule) {
+    Room position;
+    position.variant = variant;
+    position.board = board;
+    position.turn = turn;
+    position.captureLock = captureLock;
+    position.maxCaptureRule = maxCaptureRule;
+    position.hash = computePositionHash(position);
+    position.material = computeMaterial(position);
+    return position;
+}
+
+void playMove(Room& room, int fromRow, int fromCol, int toRow, int toCol, MoveResult& result) {
+    withVariantRules(room.variant, [&](auto rules) {
+        playMoveT<decltype(rules)>(room, fromRow, fromCol, toRow, toCol, result);
+    });
+}
+
+std::string applyMove(Room& room, bool isWhite, int fromRow, int fromCol, int toRow, int toCol, MoveResult& result) {
+    bool captureAvailable = false;
+    std::string error = withVariantRules(room.variant, [&](auto rules) {
+        return validateMoveT<decltype(rules)>(room, isWhite, fromRow, fromCol, toRow, toCol, captureAvailable);
+    });
+    if (!error.empty()) {
+        return error;
+    }
+
+    if (room.maxCaptureRule && (captureAvailable || room.captureLock.has_value())) {
+        thread_local CaptureChainGenerator chains;
+        chains.generate(room);
+        if (!chains.startsLongestChain(fromRow, fromCol, toRow, toCol)) {
+            return "MUST_CAPTURE_MAX";
+        }
+    }
+
+    playMove(room, fromRow, fromCol, toRow, toCol, result);
+    return "";
+}
+
+void undoMove(Room& room, int fromRow, int fromCol, int toRow, int toCol, const MoveResult& result) {
+    setPiece(room, toRow, toCol, '.');
+    setPiece(room, fromRow, fromCol, result.movedPiece);
+    if (result.capture) {
+        setPiece(room, result.capturedRow, result.capturedCol, result.capturedPiece);
+    }
+    setCaptureLock(room, result.previousLock);
+    setTurn(room, result.previousTurn);
+}
+
+void appendCaptureHops(const Room& room, int row, int col, MoveTargets& out) {
+    char piece = getPiece(room, row, col);
+    if (pieceColor(piece) == PieceColor::NONE) return;
+
+    withVariantRules(room.variant, [&](auto rules) {
+        using R = decltype(rules);
+        int from = boardSquare<R>(row, col);
+        if (from < 0) return;
+        forEachCapture<R>(room, rays<R>().darkOf[from], piece, [&](int idx) {
+            out.push_back(idx / R::size, idx % R::size);
+            return true;
+        });
+    });
+}
+
+std::size_t CaptureChainGenerator::generate(const Room& room, int fromRow, int fromCol) {
+    squares.clear();
+    offsets.clear();
+    longest = 0;
+
+    copyPosition(scratch, room); // přiřazení do scratch si nechá kapacitu desky
+
+    PieceColor side = room.turn == Turn::PLAYER2 ? PieceColor::BLACK : PieceColor::WHITE;
+    auto startFrom = [&](int r, int c) {
+        path.clear();
+        path.emplace_back(r, c);
+        extend();
+    };
+
+    if (room.captureLock.has_value()) {
+        startFrom(room.captureLock->first, room.captureLock->second);
+    } else if (fromRow >= 0) {
+        if (pieceColor(getPiece(room, fromRow, fromCol)) == side) {
+            startFrom(fromRow, fromCol);
+        }
+    } else {
+        int size = boardSize(room);
+        for (int r = 0; r < size; ++r) {
+            for (int c = 0; c < size; ++c) {
+                if (pieceColor(getPiece(room, r, c)) == side) startFrom(r, c);
+            }
+        }
+    }
+    return offsets.size();
+}
+
+void CaptureChainGenerator::extend() {
+    auto [row, col] = path.back();
+    // skoky této hloubky leží na zásobníku rekurze, hlubší úroveň je nepřepíše
+    MoveTargets hops;
+    appendCaptureHops(scratch, row, col, hops);
+
+    for (auto [toRow, toCol] : hops) {
+        MoveResult result;
+        playMove(scratch, row, col, toRow, toCol, result);
+        path.emplace_back(toRow, toCol);
+        if (result.captureContinues) {
+            extend();
+        } else {
+            emit();
+        }
+        path.pop_back();
+        undoMove(scratch, row, col, toRow, toCol, result);
+    }
+}
+
+void CaptureChainGenerator::emit() {
+    offsets.push_back(squares.size());
+    squares.insert(squares.end(), path.begin(), path.end());
+    longest = std::max(longest, static_cast<int>(path.size()) - 1);
+}
+
+std::span<const std::pair<int, int>> CaptureChainGenerator::chain(std::size_t i) const {
+    std::size_t begin = offsets[i];
+    std::size_t end = (i + 1 < offsets.size()) ? offsets[i + 1] : squares.size();
+    return {squares.data() + begin, end - begin};
+}
+
+bool CaptureChainGenerator::startsLongestChain(int fromRow, int fromCol, int toRow, int toCol) const {
+    for (std::size_t i = 0; i < size(); ++i) {
+        auto c = chain(i);
+        if (static_cast<int>(c.size()) - 1 != longest) continue;
+        if (c[0] == std::make_pair(fromRow, fromCol) && c[1] == std::make_pair(toRow, toCol)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void startPositionHistory(Room& room) {
+    room.positionHistory.clear();
+    room.positionHistory.push_back(room.hash);
+    room.noProgressPlies = 0;
+}
+
+void recordPosition(Room& room, const MoveResult& result) {
+    if (result.capture || !result.kingMove) {
+        // do dřívějších pozic se už nejde vrátit
+        room.positionHistory.clear();
+        room.noProgressPlies = 0;
+    } else {
+        room.noProgressPlies++;
+    }
+    room.positionHistory.push_back(room.hash);
+}
+
+std::string drawReason(const Room& room) {
+    if (room.captureLock.has_value()) {
+        return ""; // uprostřed skoku se nerozhoduje
+    }
+    auto repeats = std::count(room.positionHistory.begin(), room.positionHistory.end(), room.hash);
+    if (repeats >= REPETITION_LIMIT) {
+        return "DRAW_REPETITION";
+    }
+    if (room.noProgressPlies >= NO_PROGRESS_LIMIT) {
+        return "DRAW_NO_PROGRESS";
+    }
+    return "";
+}
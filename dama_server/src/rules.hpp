@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "models.hpp"
+#include "movelist.hpp"
+
+// Pravidla dámy nad deskou Room::board (tmavá pole, bílý začíná dole) podle Room::variant.
+// Sdílí je handlery, simulace i testy; varianty jsou policy z variants.hpp.
+
+bool isDarkSquare(int row, int col);
+PieceColor pieceColor(char piece);
+bool isKing(char piece);
+bool inBoard(const Room& room, int row, int col);
+
+// Pozice bez stolu (varianta, deska, tah, captureLock, pravidlo skoku, hash a kameny).
+// Kopie pro zkoušení tahů se dělají jen takhle: generátory tahů věří Room::material
+// a hashi, takže kopie bez některého pole by tiše přestala vidět skoky.
+void copyPosition(Room& into, const Room& from);
+Room scratchPosition(const Room& room);
+// Pozice z polí úlohy nebo zprávy; hash a kameny spočítá od nuly
+Room makePosition(Variant variant, const std::string& board, Turn turn,
+                  const std::optional<std::pair<int, int>>& captureLock, bool maxCaptureRule);
+
+bool canCaptureFrom(const Room& room, int row, int col, char piece);
+bool playerHasAnyCapture(const Room& room, PieceColor color);
+int pieceCount(const Room& room, PieceColor color); // z Room::material, bez skenování desky
+bool hasAnyPiece(const Room& room, PieceColor color);
+bool playerHasAnySimpleMove(const Room& room, PieceColor color);
+bool playerHasAnyMove(const Room& room, PieceColor color);
+
+// cílová pole pro danou figurku (seznam na zásobníku, bez alokace)
+MoveTargets kingSimpleMoves(const Room& room, int row, int col);
+MoveTargets kingCaptureMoves(const Room& room, int row, int col, PieceColor myColor);
+MoveTargets manSimpleMoves(const Room& room, int row, int col, bool isWhite);
+MoveTargets manCaptureMoves(const Room& room, int row, int col, bool isWhite, PieceColor myColor);
+
+// Výsledek provedeného tahu (skok, povýšení, pokračování skoku)
+struct MoveResult {
+    bool capture = false;
+    int capturedRow = -1;
+    int capturedCol = -1;
+    char capturedPiece = '.';
+    bool promoted = false;
+    bool captureContinues = false;
+    bool kingMove = false; // táhla dáma (před tahem), ne pěšec
+    // pro undoMove
+    char movedPiece = '.';
+    std::optional<std::pair<int, int>> previousLock;
+    Turn previousTurn = Turn::NONE;
+};
+
+// Provede tah, o kterém už víme, že je platný: deska, povýšení, captureLock a střídání tahu.
+void playMove(Room& room, int fromRow, int fromCol, int toRow, int toCol, MoveResult& result);
+
+// Vrátí tah provedený playMove (make/unmake při prohledávání místo kopie Room)
+void undoMove(Room& room, int fromRow, int fromCol, int toRow, int toCol, const MoveResult& result);
+
+// Ověří tah hráče dané barvy a při úspěchu ho provede přes playMove a vrátí "".
+// Jinak vrátí chybový kód protokolu (OUT_OF_BOARD, MUST_CAPTURE, MAN_CANNOT_CAPTURE_KING, ...)
+// a místnost nemění.
+std::string applyMove(Room& room, bool isWhite, int fromRow, int fromCol, int toRow, int toCol, MoveResult& result);
+
+// Cílová pole jednoho skoku figurky na (row, col) přidá na konec out
+void appendCaptureHops(const Room& room, int row, int col, MoveTargets& out);
+
+// Úplné řetězy skoků strany na tahu jako strom prohledaný do hloubky (playMove/undoMove
+// nad vlastní kopií pozice). Skoky jedné hloubky jsou MoveTargets na zásobníku, cesta
+// i výstup se používají znovu, takže po prvních voláních generování nealokuje. Řetěz i je [start, dopad1, dopad2, ...].
+class CaptureChainGenerator {
+public:
+    // Při captureLock jen z uzamčené figurky; fromRow/fromCol >= 0 omezí start na jednu figurku.
+    // Vrací počet úplných řetězů (0 = žádný skok).
+    std::size_t generate(const Room& room, int fromRow = -1, int fromCol = -1);
+
+    std::size_t size() const { return offsets.size(); }
+    std::span<const std::pair<int, int>> chain(std::size_t i) const;
+    int maxHops() const { return longest; } // počet skoků nejdelšího řetězu
+
+    // Je (from -> to) prvním skokem některého nejdelšího řetězu?
+    bool startsLongestChain(int fromRow, int fromCol, int toRow, int toCol) const;
+
+private:
+    void extend();
+    void emit();
+
+    Room scratch;
+    std::vector<std::pair<int, int>> path;
+    std::vector<std::pair<int, int>> squares;
+    std::vector<std::size_t> offsets;
+    int longest = 0;
+};
+
+// Remízy: trojí opakování pozice a 30 tahů (15 za každou stranu) jen dámami bez skoku
+constexpr int REPETITION_LIMIT = 3;
+constexpr int NO_PROGRESS_LIMIT = 30;
+
+// Začne historii pozic nové partie (po nastavení desky a hashe)
+void startPositionHistory(Room& room);
+
+// Zapíše pozici po tahu; skok nebo tah pěšcem je nevratný a historii i počítadlo nuluje
+void recordPosition(Room& room, const MoveResult& result);
+
+// "DRAW_REPETITION", "DRAW_NO_PROGRESS" nebo "" pokud se hraje dál
+std::string drawReason(const Room& room);
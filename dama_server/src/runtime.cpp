@@ -0,0 +1,196 @@
+#include "runtime.hpp"
+
+#include "protocol.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct SystemClock : Clock {
+    std::chrono::steady_clock::time_point now() const override {
+        return std::chrono::steady_clock::now();
+    }
+    std::chrono::system_clock::time_point wallNow() const override {
+        return std::chrono::system_clock::now();
+    }
+};
+
+struct SocketTransport : Transport {
+    void send(int sockfd, const std::string& data, const sockaddr_storage& addr, socklen_t addrLen) override {
+        sendto(sockfd, data.c_str(), data.size(), 0,
+               reinterpret_cast<const sockaddr*>(&addr), addrLen);
+    }
+};
+
+SystemClock systemClock;
+SocketTransport socketTransport;
+Clock* activeClock = &systemClock;
+Transport* activeTransport = &socketTransport;
+std::vector<GameRecorder*> recorders;
+
+// Rozpracovaný datagram pro jednoho adresáta; sloty se mezi iteracemi nemažou, aby
+// buffery zůstaly alokované. Slot adresáta se hledá v pendingSlot (broadcast stolu nebo
+// turnaje by lineárním hledáním byl kvadratický), pořadí odeslání určuje pending.
+struct PendingDatagram {
+    int sockfd = -1;
+    sockaddr_storage addr{};
+    socklen_t addrLen = 0;
+    std::string data;
+};
+std::size_t egressMtuBytes = DEFAULT_EGRESS_MTU;
+std::vector<PendingDatagram> pending;
+std::size_t pendingUsed = 0;
+std::unordered_map<EndpointKey, std::size_t, EndpointKeyHash> pendingSlot; // použité sloty
+
+using RoomDeadline = std::pair<std::chrono::steady_clock::time_point, int>;
+std::priority_queue<RoomDeadline, std::vector<RoomDeadline>, std::greater<RoomDeadline>> roomDeadlines;
+// jediný platný termín každého stolu; položky haldy, které s ním nesouhlasí, jsou přepsané
+std::unordered_map<int, std::chrono::steady_clock::time_point> liveDeadlines;
+
+bool liveDeadline(const RoomDeadline& d) {
+    auto it = liveDeadlines.find(d.second);
+    return it != liveDeadlines.end() && it->second == d.first;
+}
+
+// přepsané termíny z vrcholu haldy pryč, aby nebudily poll
+void dropStaleDeadlines() {
+    while (!roomDeadlines.empty() && !liveDeadline(roomDeadlines.top())) roomDeadlines.pop();
+}
+
+std::mt19937_64& rng() {
+    static std::mt19937_64 engine{std::random_device{}()};
+    return engine;
+}
+
+} // namespace
+
+void setServerClock(Clock* clock) {
+    activeClock = clock ? clock : &systemClock;
+}
+
+void setServerTransport(Transport* transport) {
+    flushDatagrams(); // co se složilo, patří ještě starému transportu
+    activeTransport = transport ? transport : &socketTransport;
+}
+
+void addGameRecorder(GameRecorder* recorder) {
+    recorders.push_back(recorder);
+}
+
+void removeGameRecorder(GameRecorder* recorder) {
+    recorders.erase(std::remove(recorders.begin(), recorders.end(), recorder), recorders.end());
+}
+
+std::chrono::steady_clock::time_point steadyNow() {
+    return activeClock->now();
+}
+
+std::chrono::system_clock::time_point systemNow() {
+    return activeClock->wallNow();
+}
+
+void setEgressMtu(std::size_t bytes) {
+    flushDatagrams();
+    egressMtuBytes = bytes;
+}
+
+std::size_t egressMtu() {
+    return egressMtuBytes;
+}
+
+void sendDatagram(int sockfd, const std::string& data, const sockaddr_storage& addr, socklen_t addrLen) {
+    if (egressMtuBytes == 0) {
+        activeTransport->send(sockfd, data, addr, addrLen);
+        return;
+    }
+    auto [index, added] = pendingSlot.try_emplace(endpointKey(addr), pendingUsed);
+    if (added && pendingUsed == pending.size()) pending.emplace_back();
+    PendingDatagram& slot = pending[index->second];
+    if (added) {
+        ++pendingUsed;
+        slot.data.clear();
+    } else if (slot.sockfd != sockfd || slot.data.size() + data.size() > egressMtuBytes) {
+        // nevejde se (nebo jde z jiného socketu): dosavadní obsah odejde hned, pořadí zpráv
+        // k adresátovi zůstane
+        activeTransport->send(slot.sockfd, slot.data, slot.addr, slot.addrLen);
+        slot.data.clear();
+    }
+    slot.sockfd = sockfd;
+    slot.addr = addr;
+    slot.addrLen = addrLen;
+    slot.data += data; // zpráva delší než MTU odejde sama
+}
+
+void flushDatagrams() {
+    for (std::size_t i = 0; i < pendingUsed; ++i) {
+        PendingDatagram& d = pending[i];
+        activeTransport->send(d.sockfd, d.data, d.addr, d.addrLen);
+        d.data.clear();
+    }
+    pendingUsed = 0;
+    pendingSlot.clear();
+    activeTransport->flush();
+}
+
+void recordFinishedGame(const Room& room, const std::string& reason, const std::string& winner) {
+    for (GameRecorder* recorder : recorders) recorder->gameFinished(room, reason, winner);
+}
+
+void seedServerRandom(std::uint64_t seed) {
+    rng().seed(seed);
+}
+
+std::uint64_t serverRandom() {
+    return rng()();
+}
+
+void armRoomDeadline(int roomId, std::chrono::steady_clock::time_point at) {
+    auto [it, added] = liveDeadlines.try_emplace(roomId, at);
+    if (!added) {
+        if (it->second == at) return;
+        it->second = at;
+    }
+    roomDeadlines.emplace(at, roomId);
+    // přepsané termíny hluboko v haldě: jednou za čas halda znovu jen z platných
+    if (roomDeadlines.size() > 2 * liveDeadlines.size() + 64) {
+        std::vector<RoomDeadline> live;
+        live.reserve(liveDeadlines.size());
+        for (const auto& [id, when] : liveDeadlines) live.emplace_back(when, id);
+        roomDeadlines = decltype(roomDeadlines)(std::greater<RoomDeadline>{}, std::move(live));
+    }
+}
+
+void cancelRoomDeadline(int roomId) {
+    liveDeadlines.erase(roomId);
+    dropStaleDeadlines();
+}
+
+std::optional<std::chrono::steady_clock::time_point> nextRoomDeadline() {
+    dropStaleDeadlines();
+    if (roomDeadlines.empty()) return std::nullopt;
+    return roomDeadlines.top().first;
+}
+
+std::vector<int> takeDueRoomDeadlines(std::chrono::steady_clock::time_point now) {
+    std::vector<int> due;
+    for (dropStaleDeadlines(); !roomDeadlines.empty() && roomDeadlines.top().first <= now; dropStaleDeadlines()) {
+        due.push_back(roomDeadlines.top().second);
+        liveDeadlines.erase(roomDeadlines.top().second);
+        roomDeadlines.pop();
+    }
+    return due;
+}
+
+std::size_t pendingRoomDeadlines() {
+    return roomDeadlines.size();
+}
+
+void clearRoomDeadlines() {
+    roomDeadlines = {};
+    liveDeadlines.clear();
+}
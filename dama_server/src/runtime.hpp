@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// Vstupy "z venku", které handlery potřebují: čas, odesílání datagramů a náhoda.
+// Server používá systémové implementace, simulace (dama_sim) si podstrčí vlastní
+// virtuální hodiny a síť, aby timeouty šly testovat deterministicky.
+
+struct Clock {
+    virtual ~Clock() = default;
+    virtual std::chrono::steady_clock::time_point now() const = 0;     // monotónní čas (timery)
+    virtual std::chrono::system_clock::time_point wallNow() const = 0; // epoch čas pro klienty (resumeBy)
+};
+
+struct Transport {
+    virtual ~Transport() = default;
+    virtual void send(int sockfd, const std::string& data, const sockaddr_storage& addr, socklen_t addrLen) = 0;
+    // konec iterace smyčky (po flushDatagrams); fronta odchozích datagramů tu probudí odesílání
+    virtual void flush() {}
+};
+
+struct Room;
+
+// Dohrané partie (kniha zahájení, archiv); volá se z konce hry ještě před uvolněním stolu
+struct GameRecorder {
+    virtual ~GameRecorder() = default;
+    virtual void gameFinished(const Room& room, const std::string& reason, const std::string& winner) = 0;
+};
+
+// nullptr vrací zpět systémové hodiny / skutečný sendto
+void setServerClock(Clock* clock);
+void setServerTransport(Transport* transport);
+
+// Recorderů může být víc (log pro knihu, archiv); bez nich se partie nikam nezapisují
+void addGameRecorder(GameRecorder* recorder);
+void removeGameRecorder(GameRecorder* recorder);
+
+std::chrono::steady_clock::time_point steadyNow();
+std::chrono::system_clock::time_point systemNow();
+
+// Odchozí zprávy (každá končí \n) se v rámci jedné iterace smyčky serveru skládají
+// po adresátech do jednoho datagramu až do velikosti egress MTU; flushDatagrams je
+// odešle. Klient dělí datagram podle \n, takže se protokol nemění. Výchozí velikost
+// se vejde do minimálního MTU IPv6 (1280 B bez hlaviček IP a UDP) bez fragmentace.
+constexpr std::size_t DEFAULT_EGRESS_MTU = 1232;
+
+// 0 vypne skládání (každá zpráva hned jako vlastní datagram)
+void setEgressMtu(std::size_t bytes);
+std::size_t egressMtu();
+
+// Jediné místo, kudy odchází datagram ze serveru; se zapnutým skládáním jen do fronty
+void sendDatagram(int sockfd, const std::string& data, const sockaddr_storage& addr, socklen_t addrLen);
+// Odešle složené datagramy; volá se na konci každé iterace smyčky (main, simulace, replay)
+void flushDatagrams();
+
+// Předá dohranou partii všem přidaným GameRecorder (v pořadí přidání)
+void recordFinishedGame(const Room& room, const std::string& reason, const std::string& winner);
+
+// Náhodná čísla pro tokeny; simulace nastaví seed kvůli reprodukovatelnosti
+void seedServerRandom(std::uint64_t seed);
+std::uint64_t serverRandom();
+
+// Přesné termíny stolů (pád praporku Room::flagAt, tah bota): min-halda, ze které server
+// budí poll. Stůl má nejvýš jeden platný termín; nový ho nahradí a přepsaný se z haldy
+// zahodí, jakmile se dostane na vrchol (nextRoomDeadline ho nikdy nevrátí).
+void armRoomDeadline(int roomId, std::chrono::steady_clock::time_point at);
+// Stůl už termín nemá (pauza, konec hry)
+void cancelRoomDeadline(int roomId);
+std::optional<std::chrono::steady_clock::time_point> nextRoomDeadline();
+// Stoly s termínem nejpozději now (vyjme je z haldy, každý stůl nejvýš jednou)
+std::vector<int> takeDueRoomDeadlines(std::chrono::steady_clock::time_point now);
+// Položky haldy včetně přepsaných (pro testy)
+std::size_t pendingRoomDeadlines();
+void clearRoomDeadlines();
@@ -0,0 +1,621 @@
+#include "server.hpp"
+
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "protocol.hpp"
+#include "runtime.hpp"
+
+namespace {
+
+void runTimeoutCheck(ServerState& server) {
+    const ServerConfig& cfg = server.config;
+    int effectiveHeartbeatMs = cfg.timeoutMs * cfg.timeoutGrace;
+    int pauseThresholdMs = std::min(12000, effectiveHeartbeatMs);
+    checkTimeouts(server.players, server.rooms, effectiveHeartbeatMs, pauseThresholdMs, cfg.turnTimeoutMs,
+                  server.sockfd, cfg.reconnectWindowMs, server.endpointToToken);
+}
+
+// Je-li u stolu na tahu bot, zadá hledání do poolu (nejvýš jedno naráz); volá processDeadlines
+// pro termín, který handlery nastaví, když tah přejde na bota
+void scheduleBotMove(ServerState& server, Room& room) {
+    if (!server.bots || room.botThinking || !botToMove(room, server.players)) return;
+    BotJob job;
+    job.roomId = room.id;
+    job.level = room.botLevel;
+    job.variant = room.variant;
+    job.board = room.board;
+    job.turn = room.turn;
+    job.captureLock = room.captureLock;
+    job.hash = room.hash;
+    job.maxCaptureRule = room.maxCaptureRule;
+    room.botThinking = true;
+    server.bots->submit(std::move(job));
+}
+
+// V clusteru dostane nový stůl nejbližší id, které patří tomuto uzlu (HashRing)
+void alignRoomId(ServerState& server) {
+    if (server.cluster) server.nextRoomId = server.cluster->nextOwnedRoomId(server.nextRoomId);
+}
+
+// GOSSIP ostatním uzlům clusteru, nejvýš jednou za CLUSTER_GOSSIP_MS
+void runCluster(ServerState& server) {
+    if (!server.cluster) return;
+    for (const auto& [node, datagram] : server.cluster->tick(steadyNow())) {
+        sockaddr_storage addr{};
+        if (parseNodeAddress(node, addr)) {
+            addr = toSocketFamily(addr, server.sockFamily);
+            sendDatagram(server.sockfd, datagram, addr, addrLength(addr));
+        }
+    }
+}
+
+// Zatížení pro vlákno discovery; p99 z datagramů od posledního zveřejnění
+void publishLoad(ServerState& server) {
+    auto now = steadyNow();
+    if (std::chrono::duration_cast<std::chrono::milliseconds>(now - server.lastLoadPublish).count() < LOAD_PUBLISH_MS) {
+        return;
+    }
+    server.lastLoadPublish = now;
+    int freeRooms = std::max(0, server.limits.maxRooms - static_cast<int>(server.rooms.size()));
+    for (const auto& [roomId, room] : server.rooms) {
+        if (room.status == RoomStatus::WAITING && room.playerKeys.empty() && room.botLevel == 0) ++freeRooms;
+    }
+    server.load.players.store(static_cast<int>(server.players.size()), std::memory_order_relaxed);
+    server.load.maxPlayers.store(server.limits.maxPlayers, std::memory_order_relaxed);
+    server.load.freeRooms.store(freeRooms, std::memory_order_relaxed);
+    server.load.p99Us.store(server.latency.percentile(0.99), std::memory_order_relaxed);
+    server.latency.clear();
+}
+
+// Stoly pro jedno kolo zakládání partií (QUICK_MATCH, turnaje): nejdřív prázdné stoly bez
+// bota, pak nové do limitu místností. Kdo už u některého stolu sedí, je v seated.
+struct RoomAllocator {
+    explicit RoomAllocator(ServerState& server) : server(server) {
+        for (const auto& [roomId, room] : server.rooms) {
+            if (room.status == RoomStatus::WAITING && room.playerKeys.empty() && room.botLevel == 0) {
+                freeRooms.push_back(roomId);
+            }
+            seated.insert(room.playerKeys.begin(), room.playerKeys.end());
+        }
+    }
+
+    std::size_t capacity() const {
+        std::size_t total = freeRooms.size() - nextFree;
+        if (server.rooms.size() < static_cast<std::size_t>(server.limits.maxRooms)) {
+            total += static_cast<std::size_t>(server.limits.maxRooms) - server.rooms.size();
+        }
+        return total;
+    }
+
+    // Stůl pro dvojici (obsadí je rovnou do seated); nullptr, když žádný nezbyl
+    Room* take(const std::string& white, const std::string& black) {
+        if (capacity() == 0) return nullptr;
+        Room* room = nullptr;
+        if (nextFree < freeRooms.size()) {
+            room = &server.rooms[freeRooms[nextFree++]];
+        } else {
+            Room fresh;
+            alignRoomId(server);
+            fresh.id = server.nextRoomId++;
+            fresh.name = "Stůl " + std::to_string(server.limits.nextTableIndex++);
+            fresh.status = RoomStatus::WAITING;
+            fresh.turn = Turn::NONE;
+            room = &(server.rooms[fresh.id] = fresh);
+        }
+        room->playerKeys = {white, black};
+        room->timeControl = TimeControl{}; // prázdný stůl po CREATE_ROOM s hodinami
+        seated.insert(white);
+        seated.insert(black);
+        return room;
+    }
+
+    ServerState& server;
+    std::vector<int> freeRooms;
+    std::size_t nextFree = 0;
+    std::unordered_set<std::string> seated;
+};
+
+// Kolo párování QUICK_MATCH: dvojice dostanou prázdný stůl bez bota, jinak nový do
+// limitu místností; na koho stůl nezbyl, čeká do dalšího kola
+void runMatchmaking(ServerState& server) {
+    auto now = steadyNow();
+    if (server.matches.size() < 2 ||
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - server.lastMatchTick).count() < MATCH_TICK_MS) {
+        return;
+    }
+    server.lastMatchTick = now;
+
+    RoomAllocator allocator(server);
+    auto eligible = [&](const std::string& token) {
+        auto it = server.players.find(token);
+        return it != server.players.end() && it->second.connected && !it->second.paused &&
+               !allocator.seated.count(token);
+    };
+    for (const MatchPair& pair : server.matches.pairUp(now, allocator.capacity(), eligible)) {
+        Room* room = allocator.take(pair.white, pair.black);
+        room->variant = pair.variant;
+        room->maxCaptureRule = pair.maxCaptureRule;
+
+        std::cout << "[INFO] MATCH room=" << room->id
+                  << " white=" << pair.white
+                  << " black=" << pair.black
+                  << " variant=" << variantName(pair.variant)
+                  << " waiting=" << server.matches.size() << std::endl;
+        startGame(0, *room, server.players, server.sockfd, server.config.turnTimeoutMs);
+    }
+}
+
+// Konec turnaje: každý přítomný hráč dostane své umístění
+void announceTournamentEnd(ServerState& server, const Tournament& tournament,
+                           const std::unordered_map<std::string, std::string>& tokenOfNick) {
+    auto standings = tournament.standings();
+    for (std::size_t rank = 0; rank < standings.size(); ++rank) {
+        const TournamentEntrant& e = tournament.entrants[static_cast<std::size_t>(standings[rank].entrant)];
+        auto it = tokenOfNick.find(e.nick);
+        if (it == tokenOfNick.end()) continue;
+        const Player& p = server.players.at(it->second);
+        std::string msg = "0;TOURNAMENT_END;tournament=" + std::to_string(tournament.id) +
+                          ";rank=" + std::to_string(rank + 1) +
+                          ";score=" + formatScore(e.score) +
+                          ";players=" + std::to_string(tournament.entrants.size()) + "\n";
+        sendDatagram(server.sockfd, msg, p.addr, addrLength(p.addr));
+    }
+    std::cout << "[INFO] TOURNAMENT_END tournament=" << tournament.id
+              << " rounds=" << tournament.round
+              << " rematches=" << tournament.rematches;
+    if (!standings.empty()) {
+        std::cout << " winner=" << tournament.entrants[static_cast<std::size_t>(standings[0].entrant)].nick;
+    }
+    std::cout << std::endl;
+}
+
+// Kolo turnajů: dohrané kolo -> další (nebo konec), nespárované desky ke stolům, jakmile
+// jsou oba hráči online a volní. Kdo do TOURNAMENT_FORFEIT_MS od začátku kola nezasedne
+// (offline, hraje jinde), prohrává kontumačně.
+void runTournaments(ServerState& server) {
+    auto now = steadyNow();
+    if (server.tournaments.byId.empty() ||
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - server.lastTournamentTick).count() < TOURNAMENT_TICK_MS) {
+        return;
+    }
+    server.lastTournamentTick = now;
+
+    std::unordered_map<std::string, std::string> tokenOfNick;
+    for (const auto& [token, player] : server.players) {
+        if (!player.isBot && player.connected && !player.nick.empty()) tokenOfNick[player.nick] = token;
+    }
+    RoomAllocator allocator(server);
+    auto sendTo = [&](const std::string& nick, const std::string& msg) {
+        auto it = tokenOfNick.find(nick);
+        if (it == tokenOfNick.end()) return;
+        const Player& p = server.players.at(it->second);
+        sendDatagram(server.sockfd, msg, p.addr, addrLength(p.addr));
+    };
+    // token hráče, který může hned zasednout, jinak prázdný
+    auto readyToken = [&](const TournamentEntrant& e) -> std::string {
+        auto it = tokenOfNick.find(e.nick);
+        if (it == tokenOfNick.end() || server.players.at(it->second).paused || allocator.seated.count(it->second)) {
+            return {};
+        }
+        return it->second;
+    };
+
+    for (auto& [tournamentId, tournament] : server.tournaments.byId) {
+        if (tournament.status != TournamentStatus::RUNNING) continue;
+
+        // stůl se uvolnil bez výsledku (resetRoom po odpadnutí obou hráčů)
+        for (std::size_t b = 0; b < tournament.boards.size(); ++b) {
+            TournamentBoard& board = tournament.boards[b];
+            if (board.finished || board.roomId == 0) continue;
+            auto itRoom = server.rooms.find(board.roomId);
+            const std::string& whiteNick = tournament.entrants[static_cast<std::size_t>(board.white)].nick;
+            if (itRoom == server.rooms.end() || itRoom->second.status != RoomStatus::IN_GAME ||
+                itRoom->second.whiteNick != whiteNick) {
+                server.tournaments.releaseRoom(board.roomId, tournamentId, b);
+                tournament.recordResult(b, 0, 0);
+            }
+        }
+
+        if (tournament.roundComplete()) {
+            if (!tournament.startNextRound(now)) {
+                announceTournamentEnd(server, tournament, tokenOfNick);
+                continue;
+            }
+            std::cout << "[INFO] TOURNAMENT_ROUND tournament=" << tournamentId
+                      << " round=" << tournament.round
+                      << " boards=" << tournament.boards.size() << std::endl;
+        }
+
+        std::string prefix = "0;TOURNAMENT_";
+        std::string idField = "tournament=" + std::to_string(tournamentId) + ";round=" + std::to_string(tournament.round);
+        bool forfeitDue = std::chrono::duration_cast<std::chrono::milliseconds>(
+                              now - tournament.roundStartedAt).count() >= TOURNAMENT_FORFEIT_MS;
+        for (std::size_t b = 0; b < tournament.boards.size(); ++b) {
+            TournamentBoard& board = tournament.boards[b];
+            const TournamentEntrant& white = tournament.entrants[static_cast<std::size_t>(board.white)];
+            if (board.black < 0) {
+                if (!board.announced) sendTo(white.nick, prefix + "BYE;" + idField + "\n");
+                board.announced = true;
+                continue;
+            }
+            if (board.finished || board.roomId != 0) continue;
+            const TournamentEntrant& black = tournament.entrants[static_cast<std::size_t>(board.black)];
+            std::string whiteToken = readyToken(white);
+            std::string blackToken = readyToken(black);
+            if (whiteToken.empty() || blackToken.empty()) {
+                if (forfeitDue) tournament.recordResult(b, whiteToken.empty() ? 0 : 1, blackToken.empty() ? 0 : 1);
+                continue;
+            }
+            Room* room = allocator.take(whiteToken, blackToken);
+            if (!room) continue; // čeká na volný stůl, bez kontumace
+            room->variant = tournament.variant;
+            room->maxCaptureRule = tournament.maxCaptureRule;
+            board.roomId = room->id;
+            board.announced = true;
+            server.tournaments.bindRoom(room->id, tournamentId, b);
+
+            std::string notice = prefix + "GAME;" + idField +
+                                 ";board=" + std::to_string(b + 1) +
+                                 ";room=" + std::to_string(room->id) + "\n";
+            sendTo(white.nick, notice);
+            sendTo(black.nick, notice);
+            startGame(0, *room, server.players, server.sockfd, server.config.turnTimeoutMs);
+        }
+    }
+}
+
+} // namespace
+
+void processDeadlines(ServerState& server) {
+    for (int roomId : takeDueRoomDeadlines(steadyNow())) {
+        auto it = server.rooms.find(roomId);
+        if (it == server.rooms.end()) continue;
+        Room& room = it->second;
+        checkFlagFall(room, server.players, server.sockfd);
+        scheduleBotMove(server, room);
+        // termín tahu bota nahradil pád praporku, ten zase platí
+        if (room.flagAt != std::chrono::steady_clock::time_point{}) armRoomDeadline(room.id, room.flagAt);
+    }
+}
+
+void processBotResults(ServerState& server) {
+    if (!server.bots) return;
+    processDeadlines(server); // tah bota po pádu praporku už neplatí
+    for (const auto& result : server.bots->takeResults()) {
+        auto itRoom = server.rooms.find(result.job.roomId);
+        if (itRoom == server.rooms.end()) continue;
+        Room& room = itRoom->second;
+        room.botThinking = false;
+
+        // mezitím se pozice změnila (konec hry, odchod hráče) -> výsledek neplatí
+        if (!botToMove(room, server.players)) continue;
+        if (room.hash != result.job.hash || !result.search.found) {
+            scheduleBotMove(server, room);
+            continue;
+        }
+
+        std::cout << "[BOT] room=" << room.id
+                  << " level=" << result.job.level
+                  << " depth=" << result.search.depth
+                  << " nodes=" << result.search.nodes
+                  << " ms=" << result.search.elapsedMs << std::endl;
+        applyBotMove(room, server.players, server.sockfd, server.config.turnTimeoutMs, result.search.move);
+    }
+    // pokračování skoku: finishMove nastavil termín stolu
+    processDeadlines(server);
+}
+
+void processAnalysisResults(ServerState& server) {
+    if (!server.analysis) return;
+    for (const auto& result : server.analysis->takeResults()) {
+        sendAnalysisResult(result, server.players, server.sockfd);
+    }
+}
+
+void processIdle(ServerState& server) {
+    processDeadlines(server);
+    auto nowTimeout = steadyNow();
+    if (std::chrono::duration_cast<std::chrono::milliseconds>(
+            nowTimeout - server.lastTimeoutCheck).count() > server.config.timeoutCheckIntervalMs) {
+        runTimeoutCheck(server);
+        server.lastTimeoutCheck = nowTimeout;
+    }
+    runCluster(server);
+    runTournaments(server);
+    runMatchmaking(server);
+    publishLoad(server);
+}
+
+void processDatagram(ServerState& server, const char* data, std::size_t len,
+                     const sockaddr_storage& clientAddr, socklen_t clientLen) {
+    processDeadlines(server); // čas, který vypršel před tímto datagramem, má přednost
+    const int sockfd = server.sockfd;
+    const ServerConfig& cfg = server.config;
+    PlayersMap& players = server.players;
+    EndpointMap& endpointToToken = server.endpointToToken;
+    RoomsMap& rooms = server.rooms;
+
+    bool hasBinary = false;
+    for (std::size_t i = 0; i < len; ++i) {
+        unsigned char ch = static_cast<unsigned char>(data[i]);
+        if (ch == 0x09 || ch == 0x0A || ch == 0x0D) {
+            continue;
+        }
+        if (ch < 0x20 || ch == 0x7F) {
+            hasBinary = true;
+            break;
+        }
+    }
+    if (hasBinary) {
+        std::cerr << "Invalid binary data from " << addrToKey(clientAddr) << std::endl;
+        EndpointKey invalidKey = endpointKey(clientAddr);
+        auto itInvalidEndpoint = endpointToToken.find(invalidKey);
+        if (itInvalidEndpoint != endpointToToken.end()) {
+            registerInvalidMessage(itInvalidEndpoint->second, players, rooms, sockfd, "BINARY_DATA");
+            std::string resp = "0;ERROR;INVALID_FORMAT;Binary data\n";
+            sendDatagram(sockfd, resp, clientAddr, clientLen);
+        }
+        return;
+    }
+
+    std::string line(data, len);
+    rtrim(line);
+
+    Message msg;
+    // gossip clusteru jde mimo hráče (a mimo log, chodí několikrát za sekundu) a má vlastní
+    // limit délky (CLUSTER_GOSSIP_BYTES); neověřený nebo bez clusteru se zahodí bez odpovědi,
+    // ERROR patří klientům
+    if (line.size() < CLUSTER_GOSSIP_BYTES && line.find(";GOSSIP;") != std::string::npos &&
+        parseMessage(line, msg) && msg.type == "GOSSIP") {
+        if (server.cluster) server.cluster->receive(line, msg, clientAddr, steadyNow());
+        return;
+    }
+
+    if (line.size() > 256) {
+        std::string resp = "0;ERROR;INVALID_FORMAT;Message too long\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        return;
+    }
+
+    std::cout << "Received: [" << line << "]" << std::endl;
+
+    if (!parseMessage(line, msg)) {
+        std::cerr << "Invalid message format" << std::endl;
+        std::string resp = "0;ERROR;INVALID_FORMAT;Cannot parse message\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        EndpointKey invalidKey = endpointKey(clientAddr);
+        auto itInvalidEndpoint = endpointToToken.find(invalidKey);
+        if (itInvalidEndpoint != endpointToToken.end()) {
+            registerInvalidMessage(itInvalidEndpoint->second, players, rooms, sockfd, "INVALID_FORMAT");
+        }
+        return;
+    }
+
+    EndpointKey clientKey = endpointKey(clientAddr);
+    std::string playerToken;
+    auto now = steadyNow();
+
+    auto itEndpoint = endpointToToken.find(clientKey);
+    if (itEndpoint != endpointToToken.end()) {
+        playerToken = itEndpoint->second;
+        auto itPlayerSeen = players.find(playerToken);
+        if (itPlayerSeen != players.end()) {
+            itPlayerSeen->second.lastSeen = now;
+            if (!itPlayerSeen->second.paused) {
+                itPlayerSeen->second.connected = true;
+                itPlayerSeen->second.addr = clientAddr;
+            }
+        } else {
+            endpointToToken.erase(itEndpoint);
+            playerToken.clear();
+        }
+    }
+
+    auto sendNotLoggedIn = [&]() {
+        std::string resp = std::to_string(msg.id) + ";ERROR;NOT_LOGGED_IN\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+    };
+
+    if (msg.type == "LOGIN") {
+        handleLogin(msg, clientKey, players, server.nextPlayerId, server.limits,
+                    sockfd, clientAddr, clientLen, cfg.turnTimeoutMs, cfg.reconnectWindowMs, endpointToToken,
+                    server.accounts.get());
+    }
+    else if (msg.type == "PING") {
+        if (!playerToken.empty()) {
+            std::cout << "[PING] token=" << playerToken
+                      << " addr=" << clientKey << std::endl;
+        }
+        auto pit = players.find(playerToken);
+        handlePing(msg, pit != players.end() ? &pit->second : nullptr, sockfd, clientAddr, clientLen);
+    }
+    else if (msg.type == "LIST_ROOMS") {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            handleListRooms(msg, rooms, server.cluster.get(), sockfd, clientAddr, clientLen);
+        }
+    }
+    else if (msg.type == "CREATE_ROOM") {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            alignRoomId(server);
+            handleCreateRoom(msg, playerToken, rooms, players, server.nextRoomId, server.limits,
+                             sockfd, clientAddr, clientLen, server.limits);
+        }
+    }
+    else if (msg.type == "JOIN_ROOM") {
+        std::string owner;
+        if (server.cluster && !msg.rawParams.empty()) {
+            try {
+                int joinId = std::stoi(msg.rawParams[0]);
+                if (!rooms.count(joinId)) owner = server.cluster->ownerOfRoom(joinId);
+            } catch (...) {
+                // neplatné id ohlásí handleJoinRoom
+            }
+        }
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else if (!owner.empty() && owner != server.cluster->self()) {
+            // stůl patří jinému uzlu: klient se má přihlásit tam
+            std::string resp = std::to_string(msg.id) + ";ERROR;WRONG_NODE;" + owner + "\n";
+            sendDatagram(sockfd, resp, clientAddr, clientLen);
+        } else {
+            handleJoinRoom(msg, playerToken, rooms, players,
+                           sockfd, clientAddr, clientLen, cfg.turnTimeoutMs);
+        }
+    }
+    else if (msg.type == "QUICK_MATCH") {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            handleQuickMatch(msg, playerToken, players, rooms, server.matches, server.ratings,
+                             sockfd, clientAddr, clientLen);
+        }
+    }
+    else if (msg.type == "QUICK_MATCH_CANCEL") {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            handleQuickMatchCancel(msg, playerToken, server.matches, sockfd, clientAddr, clientLen);
+        }
+    }
+    else if (msg.type == "TOURNAMENT_CREATE") {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            handleTournamentCreate(msg, playerToken, players, rooms, server.tournaments,
+                                   sockfd, clientAddr, clientLen);
+        }
+    }
+    else if (msg.type == "TOURNAMENT_JOIN") {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            handleTournamentJoin(msg, playerToken, players, rooms, server.tournaments, server.ratings,
+                                 sockfd, clientAddr, clientLen);
+        }
+    }
+    else if (msg.type == "TOURNAMENT_LEAVE") {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            handleTournamentLeave(msg, playerToken, players, rooms, server.tournaments,
+                                  sockfd, clientAddr, clientLen);
+        }
+    }
+    else if (msg.type == "TOURNAMENT_START") {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            handleTournamentStart(msg, playerToken, players, rooms, server.tournaments,
+                                  sockfd, clientAddr, clientLen);
+        }
+    }
+    else if (msg.type == "TOURNAMENT_STANDINGS") {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            handleTournamentStandings(msg, playerToken, players, rooms, server.tournaments,
+                                      sockfd, clientAddr, clientLen);
+        }
+    }
+    else if (msg.type == "MOVE") {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            handleMove(msg, playerToken, rooms, players,
+                       sockfd, clientAddr, clientLen, cfg.turnTimeoutMs);
+        }
+    }
+    else if (msg.type == "MOVE_SEQ") {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            handleMoveSeq(msg, playerToken, rooms, players,
+                          sockfd, clientAddr, clientLen, cfg.turnTimeoutMs);
+        }
+    }
+    else if (msg.type == "LEAVE_ROOM") {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            handleLeaveRoom(msg, playerToken, rooms, players,
+                            sockfd, clientAddr, clientLen, cfg.reconnectWindowMs);
+        }
+    }
+    else if (msg.type == "LEGAL_MOVES") {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            handleLegalMoves(msg, playerToken, rooms, players,
+                             sockfd, clientAddr, clientLen,
+                             server.tablebases.empty() ? nullptr : &server.tablebases);
+        }
+    }
+    else if (msg.type == "ANALYZE" && server.analysis) {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            handleAnalyze(msg, playerToken, players, rooms, *server.analysis,
+                          sockfd, clientAddr, clientLen);
+        }
+    }
+    else if ((msg.type == "GAMES" || msg.type == "REPLAY") && server.archive) {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else if (msg.type == "GAMES") {
+            handleGames(msg, playerToken, players, rooms, *server.archive, sockfd, clientAddr, clientLen);
+        } else {
+            handleReplay(msg, playerToken, players, rooms, *server.archive, sockfd, clientAddr, clientLen);
+        }
+    }
+    else if (msg.type == "BYE") {
+        if (playerToken.empty()) {
+            sendNotLoggedIn();
+        } else {
+            handleBye(msg, playerToken, players, rooms, endpointToToken, sockfd, clientAddr, clientLen);
+            endpointToToken.erase(clientKey);
+        }
+        return;
+    }
+    else if (msg.type == "CONFIG_ACK") {
+        auto pit = players.find(playerToken);
+        if (pit != players.end()) {
+            pit->second.configAcked = true;
+            std::cout << "[INFO] CONFIG_ACK from " << clientKey << std::endl;
+        }
+    }
+    else if (msg.type == "RECONNECT") {
+        // zpracuje se níže, až po kontrole timeoutů
+    }
+    else {
+        std::string resp = std::to_string(msg.id) +
+                           ";ERROR;UNSUPPORTED_TYPE;Nepodporovaný typ zprávy\n";
+        sendDatagram(sockfd, resp, clientAddr, clientLen);
+        if (!playerToken.empty()) {
+            registerInvalidMessage(playerToken, players, rooms, sockfd, "UNSUPPORTED_TYPE");
+        }
+    }
+
+    auto pit = players.find(playerToken);
+    if (pit != players.end() && !pit->second.configAcked) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - pit->second.lastConfigSent).count();
+        if (pit->second.lastConfigSent == std::chrono::steady_clock::time_point{} || elapsed > pit->second.sync.rtoMs()) {
+            sendConfig(pit->second, sockfd, pit->second.turnTimeoutMs);
+            std::cout << "[INFO] RESEND_CONFIG to " << clientKey
+                      << " timeoutMs=" << pit->second.turnTimeoutMs << std::endl;
+        }
+    }
+
+    if (msg.type == "RECONNECT") {
+        handleReconnect(msg, clientKey, players, rooms, endpointToToken,
+                        sockfd, clientAddr, clientLen, cfg.turnTimeoutMs, cfg.reconnectWindowMs);
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <chrono>
+#include <memory>
+#include <netinet/in.h>
+
+#include "models.hpp"
+#include "handlers.hpp"
+#include "bot.hpp"
+#include "cluster.hpp"
+#include "load.hpp"
+#include "analysis.hpp"
+#include "runtime.hpp"
+
+// Časové parametry serveru (nastavují se z příkazové řádky)
+struct ServerConfig {
+    int timeoutMs = 20000;
+    int timeoutGrace = 1;
+    int turnTimeoutMs = 60000;
+    int timeoutCheckIntervalMs = 500;
+    int reconnectWindowMs = 60000;
+};
+
+// Celý stav herního serveru; main.cpp i simulace nad ním volají stejné funkce
+struct ServerState {
+    // hodnocení a turnaje se mění s každou dohranou partií (GameRecorder po dobu života stavu)
+    ServerState() {
+        addGameRecorder(&ratings);
+        addGameRecorder(&tournaments);
+    }
+    ~ServerState() {
+        removeGameRecorder(&tournaments);
+        removeGameRecorder(&ratings);
+        clearRoomDeadlines();
+    }
+    ServerState(const ServerState&) = delete;
+    ServerState& operator=(const ServerState&) = delete;
+
+    int sockfd = -1;
+    int sockFamily = AF_INET; // AF_INET6 u socketu pro obě rodiny (--host ::)
+    ServerLimits limits;
+    ServerConfig config;
+    PlayersMap players;
+    EndpointMap endpointToToken; // clientKey -> token
+    RoomsMap rooms;
+    int nextPlayerId = 1;
+    int nextRoomId   = 1;
+    std::chrono::steady_clock::time_point lastTimeoutCheck{};
+    std::unique_ptr<AccountStore> accounts; // účty a hodnocení na disku (--accounts); před ratings, které do nich píše
+    RatingTable ratings;
+    MatchQueue matches; // QUICK_MATCH, páruje se jednou za MATCH_TICK_MS
+    std::chrono::steady_clock::time_point lastMatchTick{};
+    TournamentSet tournaments; // TOURNAMENT_*, kola se zakládají jednou za TOURNAMENT_TICK_MS
+    std::chrono::steady_clock::time_point lastTournamentTick{};
+    TablebaseSet tablebases; // databáze koncovek (--tablebase); před pooly, které z ní čtou
+    std::unique_ptr<OpeningBook> book; // kniha zahájení (--book), stejně jako tablebases
+    std::unique_ptr<GameArchive> archive; // archiv partií (--archive); bez něj GAMES/REPLAY odpoví UNSUPPORTED_TYPE
+    std::unique_ptr<BotPool> bots; // bez poolu bot u stolu nikdy netáhne
+    std::unique_ptr<AnalysisPool> analysis; // bez poolu ANALYZE odpoví UNSUPPORTED_TYPE
+    std::unique_ptr<Cluster> cluster; // --cluster/--join; bez něj jediný uzel se všemi id stolů
+    LatencyHistogram latency; // datagramy od posledního zveřejnění (main.cpp zapisuje po zpracování)
+    LoadHints load;           // čte vlákno discovery
+    std::chrono::steady_clock::time_point lastLoadPublish{};
+};
+
+// Zpracuje jeden přijatý datagram: kontrola dat, parsování a dispatch na handler
+void processDatagram(ServerState& server, const char* data, std::size_t len,
+                     const sockaddr_storage& clientAddr, socklen_t clientLen);
+
+// Periodické úlohy, každá se svým intervalem: checkTimeouts, párování QUICK_MATCH, kola
+// turnajů, gossip clusteru a jednou za LOAD_PUBLISH_MS zatížení (LoadHints). main.cpp volá
+// po každém probuzení, i když fronta datagramů nestihne opadnout; processDatagram je nespouští.
+void processIdle(ServerState& server);
+
+// Termíny stolů, které už nastaly (nextRoomDeadline): pád praporku a tah bota (handlery nastaví
+// termín, když tah přejde na bota). main.cpp podle nejbližšího termínu nastaví timeout poll,
+// simulace volá v čase termínu; processIdle, processDatagram a processBotResults ho volají také.
+void processDeadlines(ServerState& server);
+
+// Vyzvedne hotové tahy bota z BotPool, zahodí zastaralé a provede zbytek;
+// main.cpp volá po probuzení přes BotPool::wakeFd(), simulace po každé události
+void processBotResults(ServerState& server);
+
+// Pošle hotové rozbory z AnalysisPool hráčům, kteří je zadali (main.cpp po probuzení
+// přes AnalysisPool::wakeFd(), simulace po každé události)
+void processAnalysisResults(ServerState& server);
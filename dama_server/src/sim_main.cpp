@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <chrono>
+
+#include "runtime.hpp"
+#include "simulation.hpp"
+
+// dama_sim – deterministická simulace serveru na virtuálním čase.
+// Použití: dama_sim [--seed N] [--seeds K] [--days D | --hours H] [--clients C]
+//                   [--drop P] [--dup P] [--latency-ms MIN MAX]
+//                   [--turn-timeout-ms T] [--timeout-ms T] [--reconnect-window-ms T]
+//                   [--players X] [--rooms Y] [--trace-client I] [--capture FILE] [--mtu BYTES] [--verbose]
+// --capture zapíše příchozí datagramy serveru pro dama_replay (při --seeds poslední seed).
+// Při porušení invariantu vypíše seed a skončí s kódem 1.
+int main(int argc, char* argv[]) {
+    SimOptions opt;
+    std::uint64_t seeds = 1;
+    bool verbose = false;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument(arg);
+                return argv[++i];
+            };
+            if (arg == "--seed") {
+                opt.seed = std::stoull(next());
+            } else if (arg == "--seeds") {
+                seeds = std::stoull(next());
+            } else if (arg == "--days") {
+                opt.simulatedHours = std::stod(next()) * 24.0;
+            } else if (arg == "--hours") {
+                opt.simulatedHours = std::stod(next());
+            } else if (arg == "--clients") {
+                opt.clients = std::stoi(next());
+            } else if (arg == "--drop") {
+                opt.dropRate = std::stod(next());
+            } else if (arg == "--dup") {
+                opt.duplicateRate = std::stod(next());
+            } else if (arg == "--latency-ms") {
+                opt.minLatencyMs = std::stoi(next());
+                opt.maxLatencyMs = std::stoi(next());
+            } else if (arg == "--turn-timeout-ms") {
+                opt.config.turnTimeoutMs = std::stoi(next());
+            } else if (arg == "--timeout-ms") {
+                opt.config.timeoutMs = std::stoi(next());
+            } else if (arg == "--reconnect-window-ms") {
+                opt.config.reconnectWindowMs = std::stoi(next());
+            } else if (arg == "--players") {
+                opt.limits.maxPlayers = std::stoi(next());
+            } else if (arg == "--rooms") {
+                opt.limits.maxRooms = std::stoi(next());
+            } else if (arg == "--trace-client") {
+                opt.traceClient = std::stoi(next());
+            } else if (arg == "--capture") {
+                opt.capturePath = next();
+            } else if (arg == "--mtu") {
+                setEgressMtu(static_cast<std::size_t>(std::max(0, std::stoi(next()))));
+            } else if (arg == "--verbose") {
+                verbose = true;
+            } else {
+                std::cerr << "Unknown argument " << arg << std::endl;
+                return 2;
+            }
+        }
+    } catch (...) {
+        std::cerr << "Invalid arguments" << std::endl;
+        return 2;
+    }
+
+    // logy serveru by simulaci zahltily
+    auto* coutBuf = std::cout.rdbuf();
+    auto* cerrBuf = std::cerr.rdbuf();
+
+    int exitCode = 0;
+    const std::uint64_t firstSeed = opt.seed;
+    for (std::uint64_t s = 0; s < seeds; ++s) {
+        opt.seed = firstSeed + s;
+        if (!verbose) {
+            std::cout.rdbuf(nullptr);
+            std::cerr.rdbuf(nullptr);
+        }
+        auto wallStart = std::chrono::steady_clock::now();
+        SimReport report = runSimulation(opt);
+        auto wallMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - wallStart).count();
+        std::cout.rdbuf(coutBuf);
+        std::cerr.rdbuf(cerrBuf);
+        std::cout.clear();
+        std::cerr.clear();
+
+        std::cout << "[SIM] seed=" << report.seed
+                  << " simulated=" << report.simulatedMs / 1000 << "s"
+                  << " wall=" << wallMs << "ms"
+                  << " events=" << report.events
+                  << " toServer=" << report.toServer
+                  << " toClients=" << report.toClients
+                  << " dropped=" << report.dropped
+                  << " duplicated=" << report.duplicated
+                  << " games=" << report.gamesStarted
+                  << " botGames=" << report.botGames
+                  << " matchedGames=" << report.matchedGames
+                  << " tournamentGames=" << report.tournamentGames
+                  << (report.tournamentFinished ? "/finished" : "")
+                  << " bookGames=" << report.bookGames
+                  << " moves=" << report.movesSent
+                  << " moveSeq=" << report.moveSeqSent
+                  << " analyses=" << report.analyses << "/" << report.analysesCached << "cached"
+                  << " resyncs=" << report.reconnects << std::endl;
+        for (const auto& [reason, count] : report.gameEnds) {
+            std::cout << "[SIM]   GAME_END " << reason << " x" << count << std::endl;
+        }
+        for (const auto& v : report.violations) {
+            std::cerr << "[SIM] VIOLATION " << v << std::endl;
+        }
+        if (!report.violations.empty()) {
+            exitCode = 1;
+        }
+    }
+    return exitCode;
+}
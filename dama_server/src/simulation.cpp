@@ -0,0 +1,898 @@
+#include "simulation.hpp"
+
+#include <queue>
+#include <random>
+#include <optional>
+#include <algorithm>
+#include <array>
+#include <sstream>
+#include <iostream>
+#include <arpa/inet.h>
+
+#include "book.hpp"
+#include "capture.hpp"
+#include "protocol.hpp"
+#include "rules.hpp"
+#include "runtime.hpp"
+#include "transposition.hpp"
+
+namespace {
+
+using TimePoint = std::chrono::steady_clock::time_point;
+
+// Virtuální čas v ms od začátku simulace. Nikdy nevrací time_point{}, protože
+// ten server používá jako "nenastaveno".
+struct SimClock : Clock {
+    std::int64_t nowMs = 0;
+
+    TimePoint now() const override {
+        return TimePoint{} + std::chrono::hours(1) + std::chrono::milliseconds(nowMs);
+    }
+    std::chrono::system_clock::time_point wallNow() const override {
+        return std::chrono::system_clock::time_point{} +
+               std::chrono::milliseconds(1700000000000LL + nowMs);
+    }
+};
+
+enum class EventType {
+    TO_SERVER,
+    TO_CLIENT,
+    CLIENT_TIMER,
+    SERVER_IDLE,
+    SERVER_DEADLINE // nejbližší nextRoomDeadline (pád praporku)
+};
+
+struct Event {
+    std::int64_t at = 0;
+    std::uint64_t seq = 0; // stabilní pořadí událostí ve stejném čase
+    EventType type = EventType::SERVER_IDLE;
+    int client = -1;
+    uint16_t port = 0;     // cílový port (TO_CLIENT) nebo zdrojový (TO_SERVER)
+    std::string data;
+};
+
+struct EventLater {
+    bool operator()(const Event& a, const Event& b) const {
+        if (a.at != b.at) return a.at > b.at;
+        return a.seq > b.seq;
+    }
+};
+
+enum class Phase {
+    OFFLINE,
+    LOGIN_SENT,
+    LOBBY,
+    MATCHING, // QUICK_MATCH, čeká na GAME_START
+    IN_ROOM,
+    PLAYING
+};
+
+struct SimClient {
+    int index = 0;
+    std::string nick;
+    EndpointKey addr;  // sudí klienti IPv4 (10.0.0.x), lichí IPv6 (2001:db8::x)
+    Phase phase = Phase::OFFLINE;
+    int nextMsgId = 1;
+    std::string token;
+    int roomId = -1;
+    bool white = false;
+    std::string board;
+    std::string turn;
+    std::optional<std::pair<int, int>> lock;
+    std::int64_t phaseSince = 0;
+    std::int64_t lastPingAt = 0;
+    std::int64_t stateAt = 0;     // poslední GAME_STATE
+    std::int64_t moveAt = -1;     // naplánovaný tah
+    std::int64_t movedAt = -1;    // tah odeslán, čeká se na GAME_STATE
+    std::int64_t darkUntil = -1;  // klient je odpojený od sítě
+    bool listSent = false;
+    int pendingJoin = -1;         // JOIN_ROOM bez odpovědi
+    std::int64_t lastMatchSent = 0; // poslední QUICK_MATCH
+    bool tournamentCreated = false;   // pořadatel (klient 0) dostal TOURNAMENT_CREATE_OK
+    bool tournamentJoined = false;
+    bool tournamentDone = false;      // konec turnaje, dál hraje jako ostatní
+    bool tournamentBoard = false;     // TOURNAMENT_GAME, čeká se na GAME_START
+    std::int64_t lastTournamentSent = -1;
+    std::vector<std::pair<int, int>> lobbyRooms; // id, počet hráčů (jen WAITING)
+    Variant variant = Variant::CZECH; // pravidla aktuální partie (z GAME_START)
+    bool maxCapture = false;          // pravidlo nejdelšího skoku u aktuálního stolu
+    std::optional<Room> analyzed;     // pozice odeslaná v ANALYZE, čeká se na ANALYSIS
+    std::int64_t analyzeAt = -1;
+    std::int64_t skewMs = 0;          // hodiny klienta jdou napřed o tolik proti serveru
+    std::int64_t pongT2 = -1;         // t2 posledního PONGu (-1: žádný)
+    std::int64_t pongT3 = 0;          // kdy dorazil, v hodinách klienta
+    bool offsetKnown = false;         // server už poslal odhad posunu
+};
+
+std::vector<std::array<int, 4>> legalMovesFor(Variant variant, const std::string& board, bool white,
+                                              const std::optional<std::pair<int, int>>& lock) {
+    std::vector<std::array<int, 4>> out;
+    Room r;
+    r.variant = variant;
+    if (board.size() != static_cast<std::size_t>(boardSize(r) * boardSize(r))) return out;
+
+    r = makePosition(variant, board, Turn::NONE, std::nullopt, false);
+    PieceColor me = white ? PieceColor::WHITE : PieceColor::BLACK;
+    bool mustCapture = lock.has_value() || playerHasAnyCapture(r, me);
+
+    for (int row = 0; row < boardSize(r); ++row) {
+        for (int col = 0; col < boardSize(r); ++col) {
+            if (lock && (lock->first != row || lock->second != col)) continue;
+            char p = getPiece(r, row, col);
+            if (pieceColor(p) != me) continue;
+
+            MoveTargets dests;
+            if (mustCapture) {
+                dests = isKing(p) ? kingCaptureMoves(r, row, col, me)
+                                  : manCaptureMoves(r, row, col, white, me);
+            } else {
+                dests = isKing(p) ? kingSimpleMoves(r, row, col)
+                                  : manSimpleMoves(r, row, col, white);
+            }
+            for (auto [tr, tc] : dests) {
+                out.push_back({row, col, tr, tc});
+            }
+        }
+    }
+    return out;
+}
+
+class Simulation : public Transport, public GameRecorder {
+public:
+    explicit Simulation(const SimOptions& options)
+        : opt_(options), rng_(options.seed) {
+        report_.seed = options.seed;
+        server_.config = options.config;
+        server_.limits = options.limits;
+        server_.sockfd = 3; // jen symbolicky, odesílá se přes Transport
+        server_.bots = std::make_unique<BotPool>(0); // synchronní, deterministický bot
+        server_.analysis = std::make_unique<AnalysisPool>(0, 4);
+
+        clients_.resize(static_cast<std::size_t>(std::max(0, options.clients)));
+        for (std::size_t i = 0; i < clients_.size(); ++i) {
+            SimClient& c = clients_[i];
+            c.index = static_cast<int>(i);
+            c.nick = "sim" + std::to_string(i);
+            auto host = static_cast<uint32_t>(i) + 1;
+            if (i % 2 == 0) {
+                c.addr.ip[10] = 0xFF; // ::ffff:10.0.0.x
+                c.addr.ip[11] = 0xFF;
+                c.addr.ip[12] = 10;
+            } else {
+                c.addr.ip[0] = 0x20; // 2001:db8::x
+                c.addr.ip[1] = 0x01;
+                c.addr.ip[2] = 0x0D;
+                c.addr.ip[3] = 0xB8;
+            }
+            c.addr.ip[13] = static_cast<std::uint8_t>(host >> 16);
+            c.addr.ip[14] = static_cast<std::uint8_t>(host >> 8);
+            c.addr.ip[15] = static_cast<std::uint8_t>(host);
+            c.skewMs = static_cast<std::int64_t>((i * 7919) % 6001) - 3000; // ±3 s, bez zásahu do rng_
+            bindNewPort(c);
+        }
+    }
+
+    SimReport run() {
+        setServerClock(&clock_);
+        setServerTransport(this);
+        addGameRecorder(this);
+        seedServerRandom(opt_.seed);
+
+        server_.lastTimeoutCheck = steadyNow();
+        if (!opt_.capturePath.empty()) {
+            std::string error;
+            if (!capture_.open(opt_.capturePath, opt_.seed, server_.config, server_.limits, error)) {
+                violation("capture: " + error);
+            }
+        }
+        schedule(opt_.config.timeoutCheckIntervalMs, EventType::SERVER_IDLE, -1, 0, {});
+        for (auto& c : clients_) {
+            schedule(uniform(0, 3000), EventType::CLIENT_TIMER, c.index, 0, {});
+        }
+
+        const auto endMs = static_cast<std::int64_t>(opt_.simulatedHours * 3600.0 * 1000.0);
+        while (!queue_.empty() && queue_.top().at <= endMs &&
+               report_.violations.size() < opt_.maxViolations) {
+            Event ev = queue_.top();
+            queue_.pop();
+            clock_.nowMs = ev.at;
+            report_.events++;
+
+            switch (ev.type) {
+                case EventType::TO_SERVER: {
+                    EndpointKey key = clients_[static_cast<std::size_t>(ev.client)].addr;
+                    key.port = ev.port;
+                    sockaddr_storage from = endpointAddress(key);
+                    if (capture_.isOpen()) capture_.record(from, ev.data.data(), ev.data.size());
+                    processIdle(server_); // main.cpp po každém probuzení, před dávkou datagramů
+                    processDatagram(server_, ev.data.data(), ev.data.size(), from, addrLength(from));
+                    processBotResults(server_);
+                    processAnalysisResults(server_);
+                    checkInvariants();
+                    break;
+                }
+                case EventType::TO_CLIENT: {
+                    SimClient& c = clients_[static_cast<std::size_t>(ev.client)];
+                    if (c.addr.port != ev.port || c.darkUntil >= 0) break;
+                    for (auto& line : split(ev.data, '\n')) {
+                        rtrim(line);
+                        if (!line.empty()) onClientMessage(c, line);
+                    }
+                    break;
+                }
+                case EventType::CLIENT_TIMER: {
+                    SimClient& c = clients_[static_cast<std::size_t>(ev.client)];
+                    onClientTimer(c);
+                    schedule(uniform(500, 1500), EventType::CLIENT_TIMER, c.index, 0, {});
+                    break;
+                }
+                case EventType::SERVER_IDLE:
+                    processIdle(server_);
+                    processBotResults(server_);
+                    checkInvariants();
+                    schedule(opt_.config.timeoutCheckIntervalMs, EventType::SERVER_IDLE, -1, 0, {});
+                    break;
+                case EventType::SERVER_DEADLINE:
+                    if (ev.at >= deadlineEventAt_) deadlineEventAt_ = -1;
+                    processDeadlines(server_);
+                    processBotResults(server_);
+                    checkInvariants();
+                    break;
+            }
+            flushDatagrams(); // konec iterace jako v main.cpp
+            scheduleDeadline();
+        }
+
+        report_.simulatedMs = clock_.nowMs;
+        removeGameRecorder(this);
+        setServerTransport(nullptr);
+        setServerClock(nullptr);
+        return report_;
+    }
+
+    // Konec partie: záznam kroků (kniha zahájení, archiv) se musí dát přehrát od
+    // výchozí pozice se stejnými klíči (jinak by kniha radila z nesprávných pozic)
+    void gameFinished(const Room& room, const std::string& reason, const std::string& winner) override {
+        if (bookGameResult(reason, winner) && !room.steps.empty()) report_.bookGames++;
+        Room replay = makePosition(room.variant, createInitialBoard(room.variant), Turn::PLAYER1, std::nullopt,
+                                   room.maxCaptureRule);
+        for (std::size_t i = 0; i < room.steps.size(); ++i) {
+            const GameStep& move = room.steps[i];
+            bool white = replay.turn == Turn::PLAYER1;
+            if (move.key != tableKey(replay) || move.white != white) {
+                violation("room " + std::to_string(room.id) + " recorded game diverges at step " + std::to_string(i));
+                return;
+            }
+            MoveResult result;
+            std::string error = applyMove(replay, white, move.fromSquare / MAX_BOARD_SIZE, move.fromSquare % MAX_BOARD_SIZE,
+                                          move.toSquare / MAX_BOARD_SIZE, move.toSquare % MAX_BOARD_SIZE, result);
+            if (!error.empty()) {
+                violation("room " + std::to_string(room.id) + " recorded step " + std::to_string(i) + " " + error);
+                return;
+            }
+        }
+    }
+
+    // server -> klient
+    void send(int, const std::string& data, const sockaddr_storage& addr, socklen_t) override {
+        uint16_t port = endpointKey(addr).port;
+        auto it = portOwner_.find(port);
+        if (it == portOwner_.end()) return;
+        report_.toClients++;
+        deliver(EventType::TO_CLIENT, it->second, port, data);
+    }
+
+private:
+    int uniform(int lo, int hi) {
+        return std::uniform_int_distribution<int>(lo, hi)(rng_);
+    }
+
+    bool chance(double p) {
+        return std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < p;
+    }
+
+    // Jako main.cpp: server se probudí přesně v nejbližším termínu stolu
+    void scheduleDeadline() {
+        auto deadline = nextRoomDeadline();
+        if (!deadline) return;
+        auto atMs = std::chrono::ceil<std::chrono::milliseconds>(*deadline - clock_.now()).count() + clock_.nowMs;
+        atMs = std::max(atMs, clock_.nowMs);
+        if (deadlineEventAt_ >= 0 && deadlineEventAt_ <= atMs) return;
+        deadlineEventAt_ = atMs;
+        schedule(atMs - clock_.nowMs, EventType::SERVER_DEADLINE, -1, 0, {});
+    }
+
+    void schedule(std::int64_t delayMs, EventType type, int client, uint16_t port, std::string data) {
+        Event ev;
+        ev.at = clock_.nowMs + delayMs;
+        ev.seq = nextSeq_++;
+        ev.type = type;
+        ev.client = client;
+        ev.port = port;
+        ev.data = std::move(data);
+        queue_.push(std::move(ev));
+    }
+
+    // ztráta / duplikace / náhodná latence (=> přeházení)
+    void deliver(EventType type, int client, uint16_t port, const std::string& data) {
+        if (chance(opt_.dropRate)) {
+            report_.dropped++;
+            return;
+        }
+        int copies = chance(opt_.duplicateRate) ? 2 : 1;
+        if (copies == 2) report_.duplicated++;
+        for (int i = 0; i < copies; ++i) {
+            schedule(uniform(opt_.minLatencyMs, opt_.maxLatencyMs), type, client, port, data);
+        }
+    }
+
+    void bindNewPort(SimClient& c) {
+        uint16_t port = nextPort_++;
+        c.addr.port = port;
+        portOwner_[port] = c.index;
+    }
+
+    void clientSend(SimClient& c, const std::string& body) {
+        if (c.darkUntil >= 0) return;
+        std::string line = std::to_string(c.nextMsgId++) + ";" + body + "\n";
+        trace(c, "-> " + line.substr(0, line.size() - 1));
+        report_.toServer++;
+        deliver(EventType::TO_SERVER, c.index, c.addr.port, line);
+    }
+
+    std::int64_t clientWallMs(const SimClient& c) const {
+        return 1700000000000LL + clock_.nowMs + c.skewMs;
+    }
+
+    void setPhase(SimClient& c, Phase phase) {
+        c.phase = phase;
+        c.phaseSince = clock_.nowMs;
+        c.listSent = false;
+        c.pendingJoin = -1;
+        c.lobbyRooms.clear();
+        if (phase != Phase::PLAYING) {
+            c.moveAt = -1;
+            c.movedAt = -1;
+        }
+    }
+
+    void resetClient(SimClient& c) {
+        c.token.clear();
+        c.pongT2 = -1; // nový hráč na serveru začíná bez odhadu
+        c.offsetKnown = false;
+        c.roomId = -1;
+        setPhase(c, Phase::OFFLINE);
+    }
+
+    bool myTurn(const SimClient& c) const {
+        return (c.white && c.turn == "PLAYER1") || (!c.white && c.turn == "PLAYER2");
+    }
+
+    // Hráč turnaje čeká v lobby, stoly mu zakládá server; stav turnaje si občas vyžádá
+    // (odpovědi i TOURNAMENT_END se můžou ztratit). V simulaci je to vždy turnaj 1.
+    void tournamentLobby(SimClient& c) {
+        std::int64_t now = clock_.nowMs;
+        if (c.lastTournamentSent >= 0 && now - c.lastTournamentSent < 5000) return;
+        c.lastTournamentSent = now;
+        if (c.index == 0 && !c.tournamentCreated) {
+            clientSend(c, "TOURNAMENT_CREATE;sim-open;format=swiss;rounds=3");
+        } else if (!c.tournamentJoined) {
+            clientSend(c, "TOURNAMENT_JOIN;1");
+        } else {
+            clientSend(c, "TOURNAMENT_STANDINGS;1");
+        }
+    }
+
+    void resync(SimClient& c) {
+        clientSend(c, "RECONNECT;" + c.token);
+        report_.reconnects++;
+    }
+
+    void onClientTimer(SimClient& c) {
+        std::int64_t now = clock_.nowMs;
+
+        if (c.darkUntil >= 0) {
+            if (now < c.darkUntil) return;
+            c.darkUntil = -1;
+            if (chance(0.5)) {
+                bindNewPort(c); // NAT rebinding: klient se vrací z jiného portu
+            }
+            if (c.token.empty()) {
+                resetClient(c);
+            } else {
+                resync(c);
+            }
+            return;
+        }
+
+        if (c.phase >= Phase::LOBBY && chance(opt_.disconnectPerMinute / 60.0)) {
+            c.darkUntil = now + uniform(3000, 150000);
+            return;
+        }
+
+        if (chance(opt_.junkRate)) {
+            clientSend(c, "NONSENSE;x");
+        }
+
+        if (c.phase >= Phase::LOBBY && now - c.lastPingAt >= 5000) {
+            std::string ping = "PING;t0=" + std::to_string(clientWallMs(c));
+            if (c.pongT2 >= 0) ping += ";t2=" + std::to_string(c.pongT2) + ";t3=" + std::to_string(c.pongT3);
+            clientSend(c, ping);
+            c.lastPingAt = now;
+        }
+
+        switch (c.phase) {
+            case Phase::OFFLINE:
+                clientSend(c, "LOGIN;" + c.nick);
+                setPhase(c, Phase::LOGIN_SENT);
+                break;
+            case Phase::LOGIN_SENT:
+                if (now - c.phaseSince > 2000) {
+                    clientSend(c, "LOGIN;" + c.nick);
+                    c.phaseSince = now;
+                }
+                break;
+            case Phase::LOBBY:
+                if (c.index < opt_.tournamentPlayers && !c.tournamentDone) {
+                    tournamentLobby(c);
+                } else if (c.pendingJoin >= 0) {
+                    if (now - c.phaseSince > 2000) {
+                        // odpověď se mohla ztratit, zkusí stejný stůl znovu
+                        clientSend(c, "JOIN_ROOM;" + std::to_string(c.pendingJoin));
+                        c.phaseSince = now;
+                    }
+                } else if (!c.listSent || now - c.phaseSince > 5000) {
+                    c.lobbyRooms.clear();
+                    clientSend(c, "LIST_ROOMS");
+                    c.listSent = true;
+                    c.phaseSince = now;
+                } else if (now - c.phaseSince > 400 && chance(opt_.quickMatchRate)) {
+                    clientSend(c, "QUICK_MATCH");
+                    setPhase(c, Phase::MATCHING);
+                    c.lastMatchSent = now;
+                } else if (now - c.phaseSince > 400) {
+                    // nejdřív room s čekajícím soupeřem, pak prázdná, jinak nová
+                    std::sort(c.lobbyRooms.begin(), c.lobbyRooms.end(),
+                              [](const auto& a, const auto& b) { return a.second > b.second; });
+                    if (!c.lobbyRooms.empty()) {
+                        c.pendingJoin = c.lobbyRooms.front().first;
+                        clientSend(c, "JOIN_ROOM;" + std::to_string(c.pendingJoin));
+                    } else {
+                        std::string create = "CREATE_ROOM;sim";
+                        if (chance(opt_.botRoomRate)) {
+                            create += ";bot=" + std::to_string(uniform(1, 2));
+                        }
+                        if (chance(opt_.variantRoomRate)) {
+                            Variant v = ALL_VARIANTS[static_cast<std::size_t>(uniform(1, static_cast<int>(ALL_VARIANTS.size()) - 1))];
+                            create += ";variant=" + variantName(v);
+                        }
+                        if (chance(opt_.maxCaptureRoomRate)) {
+                            create += ";maxCapture=1";
+                        }
+                        if (chance(opt_.clockRoomRate)) {
+                            create += ";clockMs=" + std::to_string(uniform(20, 300) * 1000) +
+                                      ";incrementMs=" + std::to_string(uniform(0, 5) * 1000);
+                            if (chance(0.3)) create += ";bronstein=1";
+                        }
+                        clientSend(c, create);
+                    }
+                    c.listSent = false;
+                    c.phaseSince = now;
+                }
+                break;
+            case Phase::MATCHING:
+                if (now - c.phaseSince > 60000) {
+                    clientSend(c, "QUICK_MATCH_CANCEL");
+                    setPhase(c, Phase::LOBBY);
+                } else if (now - c.lastMatchSent > 5000) {
+                    // ztracený QUICK_MATCH; opakování nezkracuje čekání ve frontě
+                    clientSend(c, "QUICK_MATCH");
+                    c.lastMatchSent = now;
+                }
+                break;
+            case Phase::IN_ROOM:
+                if (now - c.phaseSince > 90000) {
+                    clientSend(c, "LEAVE_ROOM;" + std::to_string(c.roomId));
+                    setPhase(c, Phase::LOBBY);
+                }
+                break;
+            case Phase::PLAYING:
+                if (c.moveAt >= 0 && now >= c.moveAt && myTurn(c)) {
+                    auto moves = legalMovesFor(c.variant, c.board, c.white, c.lock);
+                    c.moveAt = -1;
+                    if (!moves.empty()) {
+                        std::string cmd = captureCommand(c);
+                        if (cmd.empty()) {
+                            const auto& m = moves[static_cast<std::size_t>(uniform(0, static_cast<int>(moves.size()) - 1))];
+                            cmd = "MOVE;" + std::to_string(c.roomId) + ";" +
+                                  std::to_string(m[0]) + ";" + std::to_string(m[1]) + ";" +
+                                  std::to_string(m[2]) + ";" + std::to_string(m[3]);
+                        }
+                        if (cmd.rfind("MOVE_SEQ;", 0) == 0) report_.moveSeqSent++;
+                        clientSend(c, cmd);
+                        report_.movesSent++;
+                        c.movedAt = now;
+                    }
+                } else if (!myTurn(c) && !c.board.empty() && !c.turn.empty() &&
+                           (!c.analyzed || now - c.analyzeAt > 5000) && chance(opt_.analyzeRate)) {
+                    analyze(c);
+                } else if (c.movedAt >= 0 && now - c.movedAt > 4000) {
+                    resync(c); // odpověď na tah se ztratila
+                    c.movedAt = now;
+                } else if (now - c.stateAt > 15000) {
+                    resync(c);
+                    c.stateAt = now;
+                }
+                break;
+        }
+    }
+
+    // Skok vybraný z úplných řetězů: u stolu s maxCapture jen z nejdelších,
+    // bez captureLock občas celý řetěz jedním MOVE_SEQ. "" = žádný skok není.
+    std::string captureCommand(const SimClient& c) {
+        Room r = makePosition(c.variant, c.board, c.white ? Turn::PLAYER1 : Turn::PLAYER2, c.lock, false);
+        if (chains_.generate(r) == 0) return {};
+
+        std::vector<std::size_t> picks;
+        for (std::size_t i = 0; i < chains_.size(); ++i) {
+            if (!c.maxCapture || static_cast<int>(chains_.chain(i).size()) - 1 == chains_.maxHops()) {
+                picks.push_back(i);
+            }
+        }
+        auto chain = chains_.chain(picks[static_cast<std::size_t>(uniform(0, static_cast<int>(picks.size()) - 1))]);
+        std::string room = std::to_string(c.roomId);
+        if (!c.lock && chance(opt_.moveSeqRate)) {
+            std::string cmd = "MOVE_SEQ;" + room;
+            for (auto [row, col] : chain) {
+                cmd += ";" + std::to_string(row) + "," + std::to_string(col);
+            }
+            return cmd;
+        }
+        return "MOVE;" + room + ";" + std::to_string(chain[0].first) + ";" + std::to_string(chain[0].second) +
+               ";" + std::to_string(chain[1].first) + ";" + std::to_string(chain[1].second);
+    }
+
+    // Rozbor pozice, na kterou klient čeká; malý limit uzlů, synchronní pool počítá hned
+    void analyze(SimClient& c) {
+        Room r = makePosition(c.variant, c.board, c.turn == "PLAYER1" ? Turn::PLAYER1 : Turn::PLAYER2, c.lock,
+                              c.maxCapture);
+        std::string cmd = "ANALYZE;" + c.board + ";" + c.turn + ";variant=" + variantName(c.variant) +
+                          ";maxCapture=" + (c.maxCapture ? "1" : "0") + ";depth=4;nodes=5000";
+        if (c.lock) {
+            cmd += ";lock=" + std::to_string(c.lock->first) + "," + std::to_string(c.lock->second);
+        }
+        clientSend(c, cmd);
+        c.analyzed = r;
+        c.analyzeAt = clock_.nowMs;
+    }
+
+    // Nejlepší tah z ANALYSIS musí být legální v odeslané pozici a začínat hlavní variantu
+    void checkAnalysis(SimClient& c, const std::map<std::string, std::string>& kv) {
+        if (!c.analyzed) return; // duplikát nebo odpověď po timeoutu
+        const Room& r = *c.analyzed;
+        report_.analyses++;
+        if (kv.count("cached") && kv.at("cached") == "1") report_.analysesCached++;
+        std::string best = kv.count("best") ? kv.at("best") : std::string{};
+        std::string pv = kv.count("pv") ? kv.at("pv") : std::string{};
+        auto moves = legalMovesFor(r.variant, r.board, r.turn == Turn::PLAYER1, r.captureLock);
+        bool legal = best.empty() == moves.empty();
+        if (!best.empty()) {
+            legal = legal && std::any_of(moves.begin(), moves.end(), [&](const std::array<int, 4>& m) {
+                return best == std::to_string(m[0]) + "," + std::to_string(m[1]) + ">" +
+                               std::to_string(m[2]) + "," + std::to_string(m[3]);
+            });
+        }
+        if (!legal || pv.rfind(best, 0) != 0) {
+            violation("ANALYSIS best=" + best + " pv=" + pv + " not legal for board " + r.board);
+        }
+        c.analyzed.reset();
+    }
+
+    void trace(const SimClient& c, const std::string& what) {
+        if (c.index != opt_.traceClient) return;
+        std::clog << "[SIM] t=" << clock_.nowMs << " " << c.nick << " " << what << std::endl;
+    }
+
+    void onClientMessage(SimClient& c, const std::string& line) {
+        trace(c, "<- " + line);
+        Message msg;
+        if (!parseMessage(line, msg)) return;
+        const auto& kv = msg.kvParams;
+        auto kvInt = [&](const char* key, int fallback) {
+            auto it = kv.find(key);
+            if (it == kv.end()) return fallback;
+            try {
+                return std::stoi(it->second);
+            } catch (...) {
+                return fallback;
+            }
+        };
+
+        if (msg.type == "LOGIN_OK") {
+            auto it = kv.find("token");
+            if (it != kv.end()) c.token = it->second;
+            if (c.phase <= Phase::LOGIN_SENT) setPhase(c, Phase::LOBBY);
+            clientSend(c, "CONFIG_ACK");
+        } else if (msg.type == "TOURNAMENT_CREATE_OK") {
+            c.tournamentCreated = true;
+            c.lastTournamentSent = -1;
+        } else if (msg.type == "TOURNAMENT_JOIN_OK") {
+            c.tournamentJoined = true;
+        } else if (msg.type == "TOURNAMENT") {
+            auto status = kv.find("status");
+            if (status != kv.end() && status->second == "FINISHED") {
+                c.tournamentDone = true;
+            } else if (c.index == 0 && status != kv.end() && status->second == "REGISTERING" &&
+                       kvInt("players", 0) >= opt_.tournamentPlayers) {
+                clientSend(c, "TOURNAMENT_START;1");
+            }
+        } else if (msg.type == "TOURNAMENT_GAME") {
+            c.tournamentBoard = true;
+        } else if (msg.type == "TOURNAMENT_END") {
+            c.tournamentDone = true;
+            if (kvInt("rank", 0) == 1) report_.tournamentFinished = true;
+        } else if (msg.type == "CONFIG") {
+            clientSend(c, "CONFIG_ACK");
+        } else if (msg.type == "PONG") {
+            auto t2 = kv.find("t2");
+            if (t2 != kv.end()) {
+                c.pongT2 = std::stoll(t2->second);
+                c.pongT3 = clientWallMs(c);
+            }
+            // chyba odhadu je nejvýš polovina nesouměrnosti cesty
+            auto offset = kv.find("offset");
+            if (offset != kv.end()) {
+                c.offsetKnown = true;
+                std::int64_t error = std::stoll(offset->second) - c.skewMs;
+                if (std::abs(error) > opt_.maxLatencyMs) {
+                    violation("PONG offset off by " + std::to_string(error) + "ms: " + line);
+                }
+            }
+        } else if (msg.type == "GAME_PAUSED") {
+            // resumeBy je v hodinách klienta: zbývá nejvýš celé okno pro návrat
+            auto resumeBy = kv.find("resumeBy");
+            if (c.offsetKnown && resumeBy != kv.end()) {
+                std::int64_t left = std::stoll(resumeBy->second) - clientWallMs(c);
+                if (left < -2 * opt_.maxLatencyMs || left > server_.config.reconnectWindowMs + opt_.maxLatencyMs) {
+                    violation("GAME_PAUSED resumeBy " + std::to_string(left) + "ms ahead of the client clock: " + line);
+                }
+            }
+        } else if (msg.type == "ROOM") {
+            auto status = kv.find("status");
+            int players = kvInt("players", 0);
+            if (status != kv.end() && status->second == "WAITING" && players < 2) {
+                c.lobbyRooms.emplace_back(kvInt("id", -1), players);
+            }
+        } else if (msg.type == "CREATE_ROOM_OK") {
+            if (c.phase == Phase::LOBBY && c.pendingJoin < 0) {
+                c.pendingJoin = kvInt("room", -1);
+                clientSend(c, "JOIN_ROOM;" + std::to_string(c.pendingJoin));
+                c.phaseSince = clock_.nowMs;
+            }
+        } else if (msg.type == "JOIN_ROOM_OK") {
+            c.roomId = kvInt("room", -1);
+            if (c.phase == Phase::LOBBY) setPhase(c, Phase::IN_ROOM);
+        } else if (msg.type == "GAME_START") {
+            c.roomId = kvInt("room", -1);
+            auto you = kv.find("you");
+            c.white = you != kv.end() && you->second == "WHITE";
+            auto variant = kv.find("variant");
+            c.variant = variant != kv.end() ? parseVariant(variant->second).value_or(Variant::CZECH) : Variant::CZECH;
+            c.maxCapture = kvInt("maxCapture", 0) == 1;
+            if (c.phase == Phase::MATCHING && c.white) report_.matchedGames++;
+            if (c.tournamentBoard && c.white) report_.tournamentGames++;
+            c.tournamentBoard = false;
+            setPhase(c, Phase::PLAYING);
+            c.stateAt = clock_.nowMs;
+            if (c.white) report_.gamesStarted++;
+            auto opponent = kv.find("opponent");
+            if (opponent != kv.end() && opponent->second.rfind("Bot-", 0) == 0) report_.botGames++;
+        } else if (msg.type == "GAME_STATE") {
+            if (c.phase != Phase::PLAYING) setPhase(c, Phase::PLAYING);
+            c.roomId = kvInt("room", c.roomId);
+            c.board = kv.count("board") ? kv.at("board") : std::string{};
+            auto materialIt = kv.find("material");
+            if (materialIt != kv.end()) {
+                Room counted;
+                counted.board = c.board;
+                Material m = computeMaterial(counted);
+                std::string expected = std::to_string(m.whiteMen) + "," + std::to_string(m.whiteKings) + "," +
+                                       std::to_string(m.blackMen) + "," + std::to_string(m.blackKings);
+                if (materialIt->second != expected) {
+                    violation("GAME_STATE material=" + materialIt->second + " does not match board " + c.board);
+                }
+            }
+            c.turn = kv.count("turn") ? kv.at("turn") : std::string{};
+            if (kv.count("whiteMs") && kv.count("remainingMs") &&
+                kv.at("remainingMs") != kv.at(c.turn == "PLAYER2" ? "blackMs" : "whiteMs")) {
+                violation("GAME_STATE remainingMs is not the clock of the side to move: " + line);
+            }
+            c.lock.reset();
+            auto lockIt = kv.find("lock");
+            if (lockIt != kv.end()) {
+                auto parts = split(lockIt->second, ',');
+                if (parts.size() == 2) {
+                    c.lock = std::make_pair(std::stoi(parts[0]), std::stoi(parts[1]));
+                }
+            }
+            c.stateAt = clock_.nowMs;
+            c.movedAt = -1;
+            c.moveAt = -1;
+            if (myTurn(c)) {
+                c.moveAt = clock_.nowMs + (chance(opt_.slowMoveRate)
+                                               ? opt_.config.turnTimeoutMs + uniform(100, 5000)
+                                               : uniform(100, 4000));
+            }
+        } else if (msg.type == "ANALYSIS") {
+            checkAnalysis(c, kv);
+        } else if (msg.type == "GAME_END") {
+            auto reason = kv.find("reason");
+            report_.gameEnds[reason != kv.end() ? reason->second : "?"]++;
+            c.roomId = -1;
+            if (chance(0.1)) {
+                clientSend(c, "BYE");
+                resetClient(c);
+            } else {
+                setPhase(c, Phase::LOBBY);
+            }
+        } else if (msg.type == "ERROR" && !msg.rawParams.empty()) {
+            const std::string& code = msg.rawParams[0];
+            if (code == "NOT_LOGGED_IN" || code == "TOKEN_NOT_FOUND" || code == "TOKEN_EXPIRED") {
+                resetClient(c);
+            } else if (code == "ROOM_FULL" || code == "ROOM_NOT_AVAILABLE" ||
+                       code == "ROOM_NOT_FOUND" || code == "SERVER_FULL") {
+                if (c.phase == Phase::LOBBY || c.phase == Phase::IN_ROOM) setPhase(c, Phase::LOBBY);
+            } else if (code == "INVALID_BOARD") {
+                violation("ANALYZE of a board from GAME_STATE rejected: " + line);
+            } else if (code == "ALREADY_IN_ROOM" && c.phase == Phase::MATCHING) {
+                // spárovaný, ale GAME_START se ztratil
+                resync(c);
+            } else if (code == "ALREADY_IN_ROOM" && c.phase == Phase::LOBBY) {
+                int seated = c.pendingJoin;
+                setPhase(c, Phase::IN_ROOM);
+                c.roomId = seated;
+            }
+        }
+    }
+
+    void violation(const std::string& what) {
+        std::stringstream ss;
+        ss << "t=" << clock_.nowMs << "ms seed=" << opt_.seed << ": " << what;
+        report_.violations.push_back(ss.str());
+    }
+
+    // Kontroly konzistence stavu serveru po každé události
+    void checkInvariants() {
+        auto now = steadyNow();
+        const ServerConfig& cfg = server_.config;
+        const auto slackMs = 2LL * cfg.timeoutCheckIntervalMs;
+
+        if (server_.players.size() > static_cast<std::size_t>(server_.limits.maxPlayers)) {
+            violation("players over limit: " + std::to_string(server_.players.size()));
+        }
+        if (server_.rooms.size() > static_cast<std::size_t>(server_.limits.maxRooms)) {
+            violation("rooms over limit: " + std::to_string(server_.rooms.size()));
+        }
+
+        std::map<std::string, int> seatCount;
+        for (const auto& [roomId, room] : server_.rooms) {
+            for (const auto& key : room.playerKeys) {
+                if (++seatCount[key] > 1) {
+                    violation("player " + key + " seated in more rooms");
+                }
+            }
+            for (std::size_t i = 0; i < room.playerKeys.size(); ++i) {
+                auto pit = server_.players.find(room.playerKeys[i]);
+                if (pit != server_.players.end() && pit->second.isBot &&
+                    (room.botLevel == 0 || i != 1 || room.playerKeys[i] != "bot-" + std::to_string(roomId))) {
+                    violation("bot " + room.playerKeys[i] + " seated wrongly in room " + std::to_string(roomId));
+                }
+            }
+            if (room.hash != computePositionHash(room)) {
+                violation("room " + std::to_string(roomId) + " Zobrist hash out of sync");
+            }
+            if (room.material != computeMaterial(room)) {
+                violation("room " + std::to_string(roomId) + " piece counts out of sync");
+            }
+            if (room.playerKeys.size() > ROOM_CAPACITY) {
+                violation("room " + std::to_string(roomId) + " over capacity");
+            }
+            if (room.remainingTurnMs < -1 || room.remainingTurnMs > cfg.turnTimeoutMs) {
+                violation("room " + std::to_string(roomId) + " remainingTurnMs=" +
+                          std::to_string(room.remainingTurnMs));
+            }
+            if (room.status != RoomStatus::IN_GAME) {
+                turnTimers_.erase(roomId);
+                continue;
+            }
+            if (room.board.size() != static_cast<std::size_t>(boardSize(room) * boardSize(room))) {
+                violation("room " + std::to_string(roomId) + " in game without board");
+            }
+            // v synchronním režimu bot odpoví hned; bez zadaného hledání by hra visela
+            if (botToMove(room, server_.players) && !room.botThinking) {
+                violation("room " + std::to_string(roomId) + " waits for a bot move that was never scheduled");
+            }
+            if (room.positionHistory.size() > static_cast<std::size_t>(NO_PROGRESS_LIMIT) + 1) {
+                violation("room " + std::to_string(roomId) + " should have ended in DRAW_NO_PROGRESS");
+            }
+            if (room.playerKeys.size() != ROOM_CAPACITY) {
+                violation("room " + std::to_string(roomId) + " in game with " +
+                          std::to_string(room.playerKeys.size()) + " players");
+            }
+            // časovač tahu se smí posunout jen tahem nebo po pauze (zmrazení)
+            auto& seen = turnTimers_[roomId];
+            bool positionChanged = seen.board != room.board || seen.turn != room.turn ||
+                                   seen.lock != room.captureLock;
+            if (room.lastTurnAt == TimePoint{}) {
+                seen.frozen = true;
+            } else if (!positionChanged && !seen.frozen && seen.lastTurnAt != TimePoint{} &&
+                       room.lastTurnAt > seen.lastTurnAt) {
+                violation("room " + std::to_string(roomId) + " turn timer restarted without a move (+" +
+                          std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                              room.lastTurnAt - seen.lastTurnAt).count()) + "ms)");
+            }
+            if (room.lastTurnAt != TimePoint{}) {
+                seen.frozen = false;
+            }
+            seen.board = room.board;
+            seen.turn = room.turn;
+            seen.lock = room.captureLock;
+            seen.lastTurnAt = room.lastTurnAt;
+
+            if (room.timeControl.baseMs > 0) {
+                // pád praporku má přesný termín, ne kolo checkTimeouts
+                if (room.flagAt != TimePoint{} && now - room.flagAt > std::chrono::milliseconds(1)) {
+                    violation("room " + std::to_string(roomId) + " flag fall overdue by " +
+                              std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  now - room.flagAt).count()) + "ms");
+                }
+                if (room.clockMs[0] < 0 || room.clockMs[1] < 0) {
+                    violation("room " + std::to_string(roomId) + " negative clock");
+                }
+            } else if (room.lastTurnAt != TimePoint{}) {
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - room.lastTurnAt).count();
+                if (elapsed > cfg.turnTimeoutMs + slackMs) {
+                    violation("room " + std::to_string(roomId) + " turn timer overdue by " +
+                              std::to_string(elapsed - cfg.turnTimeoutMs) + "ms");
+                }
+            }
+        }
+
+        for (const auto& [key, player] : server_.players) {
+            if (!player.paused || player.resumeDeadline == TimePoint{}) continue;
+            auto overdue = std::chrono::duration_cast<std::chrono::milliseconds>(now - player.resumeDeadline).count();
+            if (overdue > slackMs) {
+                violation("paused player " + key + " not expired, overdue " + std::to_string(overdue) + "ms");
+            }
+        }
+    }
+
+    SimOptions opt_;
+    std::mt19937_64 rng_;
+    SimClock clock_;
+    ServerState server_;
+    CaptureWriter capture_; // SimOptions::capturePath
+    std::int64_t deadlineEventAt_ = -1; // naplánovaná SERVER_DEADLINE
+    std::vector<SimClient> clients_;
+    std::map<uint16_t, int> portOwner_; // port -> index klienta
+    CaptureChainGenerator chains_;
+    struct TurnTimerSnapshot {
+        std::string board;
+        Turn turn = Turn::NONE;
+        std::optional<std::pair<int, int>> lock;
+        TimePoint lastTurnAt{};
+        bool frozen = false;
+    };
+    std::map<int, TurnTimerSnapshot> turnTimers_; // roomId -> poslední viděný stav časovače
+    uint16_t nextPort_ = 20000;
+    std::priority_queue<Event, std::vector<Event>, EventLater> queue_;
+    std::uint64_t nextSeq_ = 0;
+    SimReport report_;
+};
+
+} // namespace
+
+SimReport runSimulation(const SimOptions& options) {
+    Simulation sim(options);
+    return sim.run();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "models.hpp"
+#include "server.hpp"
+
+// Deterministická simulace serveru: virtuální hodiny, virtuální síť (ztráty,
+// duplikace, přeházení datagramů) a simulovaní klienti. Stejný seed = stejný běh,
+// takže chyby v časovačích (checkTimeouts, pauseRoom, RECONNECT) jdou přehrát.
+
+struct SimOptions {
+    std::uint64_t seed = 1;
+    double simulatedHours = 24.0;
+    int clients = 8;
+
+    // virtuální síť
+    double dropRate = 0.02;       // pravděpodobnost ztráty datagramu
+    double duplicateRate = 0.01;  // pravděpodobnost doručení dvakrát
+    int minLatencyMs = 2;
+    int maxLatencyMs = 120;       // rozptyl latence => přeházené pořadí
+
+    // chování klientů
+    double disconnectPerMinute = 0.05; // šance, že klient na chvíli "zmizí"
+    double slowMoveRate = 0.01;        // tah až po vypršení turn timeoutu
+    double junkRate = 0.002;           // nevalidní zpráva
+    double botRoomRate = 0.15;         // nový stůl s botem (úroveň 1-2)
+    double maxCaptureRoomRate = 0.2;   // nový stůl s povinností nejdelšího skoku
+    double variantRoomRate = 0.3;      // nový stůl s jinou variantou než czech
+    double clockRoomRate = 0.3;        // nový stůl se šachovými hodinami (clockMs=, incrementMs=)
+    double moveSeqRate = 0.5;          // řetěz skoků celý jedním MOVE_SEQ
+    double analyzeRate = 0.01;         // ANALYZE aktuální pozice, když klient čeká na soupeře
+    double quickMatchRate = 0.25;      // QUICK_MATCH místo výběru stolu z LIST_ROOMS
+    int tournamentPlayers = 4;         // klienti 0..n-1 hrají jeden švýcarský turnaj, 0 pořádá (0 = bez turnaje)
+
+    ServerConfig config;
+    ServerLimits limits;
+
+    std::string capturePath; // příchozí datagramy serveru jako --capture (pro dama_replay)
+
+    std::size_t maxViolations = 10;
+    int traceClient = -1; // index klienta, jehož provoz se vypisuje na std::clog
+};
+
+struct SimReport {
+    std::uint64_t seed = 0;
+    std::int64_t simulatedMs = 0;
+    std::uint64_t events = 0;
+    std::uint64_t toServer = 0;
+    std::uint64_t toClients = 0;
+    std::uint64_t dropped = 0;
+    std::uint64_t duplicated = 0;
+    std::uint64_t gamesStarted = 0;
+    std::uint64_t movesSent = 0;
+    std::uint64_t moveSeqSent = 0;
+    std::uint64_t analyses = 0;       // odpovědi ANALYSIS
+    std::uint64_t analysesCached = 0; // z toho hned z transpoziční tabulky
+    std::uint64_t reconnects = 0;
+    std::uint64_t botGames = 0;
+    std::uint64_t matchedGames = 0;   // partie z fronty QUICK_MATCH
+    std::uint64_t tournamentGames = 0; // partie u turnajových stolů
+    bool tournamentFinished = false;  // vítěz dostal TOURNAMENT_END
+    std::uint64_t bookGames = 0;      // dohrané partie, jejichž začátek by šel do knihy zahájení
+    std::map<std::string, std::uint64_t> gameEnds; // reason -> počet (jak je viděli klienti)
+    std::vector<std::string> violations;
+};
+
+SimReport runSimulation(const SimOptions& options);
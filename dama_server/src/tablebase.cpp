@@ -0,0 +1,588 @@
+#include "tablebase.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <span>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "binio.hpp"
+#include "rays.hpp"
+#include "rules.hpp"
+
+namespace {
+
+constexpr std::size_t HEADER_SIZE = 16;    // magic, varianta, maxCapture, maxPieces, rezerva, počet materiálů
+constexpr std::size_t DIRECTORY_ENTRY = 20; // wm, wk, bm, bk, offset (u64), velikost (u64)
+constexpr int MAX_DISTANCE = 127;
+
+constexpr auto& TB_RAYS = RAYS<TABLEBASE_SIZE>;
+
+// Kombinační čísla C(n, k) pro n <= 32, k <= TABLEBASE_MAX_PIECES
+constexpr auto makeBinomials() {
+    std::array<std::array<std::uint64_t, TABLEBASE_MAX_PIECES + 1>, TABLEBASE_SQUARES + 1> c{};
+    for (int n = 0; n <= TABLEBASE_SQUARES; ++n) {
+        c[n][0] = 1;
+        for (int k = 1; k <= TABLEBASE_MAX_PIECES; ++k) {
+            c[n][k] = (n == 0) ? 0 : c[n - 1][k - 1] + c[n - 1][k];
+        }
+    }
+    return c;
+}
+
+constexpr auto BINOMIAL = makeBinomials();
+
+static_assert(BINOMIAL[32][2] == 496 && BINOMIAL[4][4] == 1 && BINOMIAL[3][4] == 0, "binomials");
+
+// Druhy kamenů v pořadí indexu
+constexpr std::array<char, 4> PIECE_KINDS = {'w', 'W', 'b', 'B'};
+
+std::array<int, 4> kindCounts(const TablebaseMaterial& m) {
+    return {m.whiteMen, m.whiteKings, m.blackMen, m.blackKings};
+}
+
+TablebaseMaterial toTablebaseMaterial(const Material& m) {
+    return TablebaseMaterial{m.whiteMen, m.whiteKings, m.blackMen, m.blackKings};
+}
+
+// Pořadí rostoucí posloupnosti tmavých polí v kombinatorické číselné soustavě
+std::uint64_t rankSquares(const int* squares, int count) {
+    std::uint64_t rank = 0;
+    for (int i = 0; i < count; ++i) {
+        rank += BINOMIAL[squares[i]][i + 1];
+    }
+    return rank;
+}
+
+void unrankSquares(std::uint64_t rank, int count, int* squares) {
+    int sq = TABLEBASE_SQUARES - 1;
+    for (int i = count; i >= 1; --i) {
+        while (BINOMIAL[sq][i] > rank) --sq;
+        squares[i - 1] = sq;
+        rank -= BINOMIAL[sq][i];
+        --sq;
+    }
+}
+
+// Pořadí hodnot pro stranu, která táhne do pozice after (hodnota after je z pohledu soupeře):
+// soupeřova prohra je nejlepší (čím dřív, tím líp), pak remíza, soupeřova výhra co nejpozději
+int preference(const TablebaseValue& after) {
+    switch (after.outcome) {
+        case TablebaseOutcome::LOSS: return 1000 - after.moves;
+        case TablebaseOutcome::DRAW: return 0;
+        case TablebaseOutcome::WIN:  break;
+    }
+    return -1000 + after.moves;
+}
+
+// Hodnota pozice z nejlepšího následníka (z pohledu soupeře)
+TablebaseValue valueBefore(const TablebaseValue& bestAfter) {
+    switch (bestAfter.outcome) {
+        case TablebaseOutcome::LOSS: return TablebaseValue{TablebaseOutcome::WIN, bestAfter.moves + 1};
+        case TablebaseOutcome::DRAW: return TablebaseValue{};
+        case TablebaseOutcome::WIN:  break;
+    }
+    return TablebaseValue{TablebaseOutcome::LOSS, bestAfter.moves + 1};
+}
+
+// Celé tahy strany na tahu (řetězy skoků, s maxCaptureRule jen nejdelší, jinak jednoduché tahy).
+// Tah se na room zahraje, zavolá se f(room, tah) a zase vrátí. Vrací true, pokud jde o skoky.
+class FullMoves {
+public:
+    template <class F>
+    bool forEach(Room& room, F&& f) {
+        PieceColor side = room.turn == Turn::PLAYER2 ? PieceColor::BLACK : PieceColor::WHITE;
+        if (room.captureLock.has_value() || playerHasAnyCapture(room, side)) {
+            chains.generate(room);
+            for (std::size_t i = 0; i < chains.size(); ++i) {
+                auto chain = chains.chain(i);
+                if (room.maxCaptureRule && static_cast<int>(chain.size()) - 1 != chains.maxHops()) continue;
+                play(room, chain, f);
+            }
+            return true;
+        }
+
+        const int size = boardSize(room);
+        for (int r = 0; r < size; ++r) {
+            for (int c = 0; c < size; ++c) {
+                char piece = getPiece(room, r, c);
+                if (pieceColor(piece) != side) continue;
+                MoveTargets targets = isKing(piece) ? kingSimpleMoves(room, r, c)
+                                                    : manSimpleMoves(room, r, c, side == PieceColor::WHITE);
+                for (auto to : targets) {
+                    std::array<std::pair<int, int>, 2> move = {std::make_pair(r, c), to};
+                    play(room, move, f);
+                }
+            }
+        }
+        return false;
+    }
+
+private:
+    template <class F>
+    void play(Room& room, std::span<const std::pair<int, int>> move, F& f) {
+        undo.resize(move.size() - 1);
+        for (std::size_t i = 1; i < move.size(); ++i) {
+            playMove(room, move[i - 1].first, move[i - 1].second, move[i].first, move[i].second, undo[i - 1]);
+        }
+        f(static_cast<const Room&>(room), move);
+        for (std::size_t i = move.size() - 1; i >= 1; --i) {
+            undoMove(room, move[i - 1].first, move[i - 1].second, move[i].first, move[i].second, undo[i - 1]);
+        }
+    }
+
+    CaptureChainGenerator chains;
+    std::vector<MoveResult> undo;
+};
+
+// Prázdná pozice 8x8 pro generátor a test
+Room emptyPosition(Variant variant, bool maxCaptureRule) {
+    Room room;
+    room.variant = variant;
+    room.maxCaptureRule = maxCaptureRule;
+    room.board.assign(TABLEBASE_SIZE * TABLEBASE_SIZE, '.');
+    room.turn = Turn::PLAYER1;
+    return room;
+}
+
+// Retrográdní analýza po vrstvách podle počtu kamenů. Skok kámen ubere, takže pozice se skokem
+// se spočítají hned z nižší vrstvy; tiché tahy (i s proměnou) zůstávají ve vrstvě a řeší se
+// průchody: v průchodu p se určí výhry za p (některý následník prohrává za p-1) a prohry za p
+// (všichni následníci vyhrávají, nejpozději za p-1). Co se nevyřeší, je remíza.
+class Generator {
+public:
+    Generator(Variant variant, bool maxCaptureRule, int maxPieces)
+        : variant(variant), maxCaptureRule(maxCaptureRule), maxPieces(maxPieces) {
+        for (auto& a : materialIds) for (auto& b : a) for (auto& c : b) for (auto& d : c) d = -1;
+    }
+
+    void run() {
+        for (int pieces = 2; pieces <= maxPieces; ++pieces) {
+            auto started = std::chrono::steady_clock::now();
+            solveLayer(pieces);
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - started).count();
+            std::cout << "[INFO] Tablebase " << variantName(variant) << " " << pieces << " pieces: "
+                      << layerPositions << " positions, " << layerWins << " wins, " << layerLosses
+                      << " losses, " << layerPasses << " passes, " << ms << " ms" << std::endl;
+        }
+    }
+
+    // Soubor podle formátu z tablebase.hpp
+    std::string serialize() const {
+        std::string out(TABLEBASE_MAGIC, sizeof(TABLEBASE_MAGIC));
+        out.push_back(static_cast<char>(variant));
+        out.push_back(static_cast<char>(maxCaptureRule ? 1 : 0));
+        out.push_back(static_cast<char>(maxPieces));
+        out.push_back(0);
+        putU32(out, static_cast<std::uint32_t>(materials.size()));
+
+        std::uint64_t offset = HEADER_SIZE + DIRECTORY_ENTRY * materials.size();
+        for (std::size_t i = 0; i < materials.size(); ++i) {
+            for (int count : kindCounts(materials[i])) out.push_back(static_cast<char>(count));
+            putU64(out, offset);
+            putU64(out, values[i].size());
+            offset += values[i].size();
+        }
+        for (const auto& v : values) {
+            out.append(reinterpret_cast<const char*>(v.data()), v.size());
+        }
+        return out;
+    }
+
+private:
+    enum State : std::uint8_t { UNKNOWN, WIN, LOSS, DRAW };
+
+    int materialId(const TablebaseMaterial& m) const {
+        return materialIds[m.whiteMen][m.whiteKings][m.blackMen][m.blackKings];
+    }
+
+    // Hodnota pozice z dokončené nižší vrstvy (nebo bez kamenů strany na tahu)
+    TablebaseValue finalValue(const Room& room) const {
+        if (pieceCount(room, room.turn == Turn::PLAYER2 ? PieceColor::BLACK : PieceColor::WHITE) == 0) {
+            return TablebaseValue{TablebaseOutcome::LOSS, 0};
+        }
+        int id = materialId(toTablebaseMaterial(room.material));
+        return decodeTablebaseValue(values[id][*tablebaseIndex(room)]);
+    }
+
+    static bool capturedAny(const Material& a, const Room& after) {
+        const Material& b = after.material;
+        return a.whiteMen + a.whiteKings + a.blackMen + a.blackKings != b.whiteMen + b.whiteKings + b.blackMen + b.blackKings;
+    }
+
+    // Index v rámci vrstvy (přes všechny její materiály)
+    std::uint32_t layerIndex(const Room& room) const {
+        int id = materialId(toTablebaseMaterial(room.material));
+        return static_cast<std::uint32_t>(layerBase[id] + *tablebaseIndex(room));
+    }
+
+    void solveLayer(int pieces) {
+        // materiály vrstvy: každá strana aspoň jeden kámen
+        std::vector<int> ids;
+        std::uint64_t total = 0;
+        for (int white = 1; white < pieces; ++white) {
+            int black = pieces - white;
+            for (int wk = 0; wk <= white; ++wk) {
+                for (int bk = 0; bk <= black; ++bk) {
+                    TablebaseMaterial m{white - wk, wk, black - bk, bk};
+                    int id = static_cast<int>(materials.size());
+                    materials.push_back(m);
+                    values.emplace_back(tablebaseEntries(m), 0);
+                    materialIds[m.whiteMen][m.whiteKings][m.blackMen][m.blackKings] = id;
+                    layerBase.push_back(total);
+                    total += tablebaseEntries(m);
+                    ids.push_back(id);
+                }
+            }
+        }
+
+        std::vector<State> state(total, UNKNOWN);
+        std::vector<std::uint16_t> distance(total, 0);
+        // následníci tichých tahů (indexy ve vrstvě), jen pro nevyřešené pozice
+        std::vector<std::uint32_t> pending;
+        std::vector<std::uint64_t> succBegin;
+        std::vector<std::uint32_t> successors;
+        int maxResolved = 0;
+        layerPositions = 0;
+
+        Room room = emptyPosition(variant, maxCaptureRule);
+        FullMoves moves;
+        for (int id : ids) {
+            const TablebaseMaterial& m = materials[id];
+            for (std::uint64_t index = 0; index < values[id].size(); ++index) {
+                std::uint64_t at = layerBase[id] + index;
+                if (!tablebasePosition(m, index, room)) {
+                    state[at] = DRAW; // nemůže nastat
+                    continue;
+                }
+                ++layerPositions;
+
+                std::size_t first = successors.size();
+                const Material before = room.material; // forEach hraje tahy přímo na room
+                bool any = false;
+                TablebaseValue bestAfter;
+                int bestPreference = -1000000;
+                bool captures = moves.forEach(room, [&](const Room& after, std::span<const std::pair<int, int>>) {
+                    any = true;
+                    if (!capturedAny(before, after)) {
+                        successors.push_back(layerIndex(after)); // tichý tah, i s proměnou
+                        return;
+                    }
+                    TablebaseValue v = finalValue(after);
+                    if (preference(v) > bestPreference) {
+                        bestPreference = preference(v);
+                        bestAfter = v;
+                    }
+                });
+                if (captures || !any) {
+                    successors.resize(first);
+                    TablebaseValue v = any ? valueBefore(bestAfter) : TablebaseValue{TablebaseOutcome::LOSS, 0};
+                    state[at] = v.outcome == TablebaseOutcome::WIN ? WIN
+                              : v.outcome == TablebaseOutcome::LOSS ? LOSS : DRAW;
+                    distance[at] = static_cast<std::uint16_t>(v.moves);
+                    maxResolved = std::max(maxResolved, v.moves);
+                    continue;
+                }
+                pending.push_back(static_cast<std::uint32_t>(at));
+                succBegin.push_back(first);
+            }
+        }
+        succBegin.push_back(successors.size());
+
+        // pořadí v pending odpovídá succBegin; vyřešené se v průchodu vyřadí
+        std::vector<std::uint32_t> order(pending.size());
+        for (std::uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+        layerPasses = 0;
+        for (int pass = 1;; ++pass) {
+            bool changed = false;
+            std::size_t kept = 0;
+            for (std::uint32_t k : order) {
+                std::uint32_t at = pending[k];
+                bool win = false;
+                bool allWin = true;
+                int latestWin = -1;
+                for (std::uint64_t s = succBegin[k]; s < succBegin[k + 1]; ++s) {
+                    std::uint32_t next = successors[s];
+                    if (state[next] == LOSS && distance[next] == pass - 1) {
+                        win = true;
+                        break;
+                    }
+                    if (state[next] == WIN) {
+                        latestWin = std::max<int>(latestWin, distance[next]);
+                    } else {
+                        allWin = false;
+                    }
+                }
+                if (win || (allWin && latestWin == pass - 1)) {
+                    state[at] = win ? WIN : LOSS;
+                    distance[at] = static_cast<std::uint16_t>(pass);
+                    changed = true;
+                } else {
+                    order[kept++] = k;
+                }
+            }
+            order.resize(kept);
+            layerPasses = pass;
+            if (order.empty() || (!changed && pass > maxResolved)) break;
+        }
+        // order: zbyly remízy, state[] u nich zůstává UNKNOWN
+
+        layerWins = 0;
+        layerLosses = 0;
+        for (int id : ids) {
+            for (std::uint64_t index = 0; index < values[id].size(); ++index) {
+                std::uint64_t at = layerBase[id] + index;
+                TablebaseValue v;
+                if (state[at] == WIN) {
+                    v = TablebaseValue{TablebaseOutcome::WIN, distance[at]};
+                    ++layerWins;
+                } else if (state[at] == LOSS) {
+                    v = TablebaseValue{TablebaseOutcome::LOSS, distance[at]};
+                    ++layerLosses;
+                }
+                values[id][index] = encodeTablebaseValue(v);
+            }
+        }
+    }
+
+    Variant variant;
+    bool maxCaptureRule;
+    int maxPieces;
+    std::vector<TablebaseMaterial> materials;
+    std::vector<std::vector<std::uint8_t>> values; // zakódované hodnoty podle materiálu
+    std::vector<std::uint64_t> layerBase;          // začátek materiálu v indexech jeho vrstvy
+    int materialIds[TABLEBASE_MAX_PIECES + 1][TABLEBASE_MAX_PIECES + 1][TABLEBASE_MAX_PIECES + 1][TABLEBASE_MAX_PIECES + 1];
+    std::uint64_t layerPositions = 0;
+    std::uint64_t layerWins = 0;
+    std::uint64_t layerLosses = 0;
+    int layerPasses = 0;
+};
+
+} // namespace
+
+std::uint8_t encodeTablebaseValue(const TablebaseValue& value) {
+    int moves = std::clamp(value.moves, 0, MAX_DISTANCE);
+    switch (value.outcome) {
+        case TablebaseOutcome::WIN:  return static_cast<std::uint8_t>(std::max(moves, 1));
+        case TablebaseOutcome::LOSS: return static_cast<std::uint8_t>(128 + moves);
+        case TablebaseOutcome::DRAW: break;
+    }
+    return 0;
+}
+
+TablebaseValue decodeTablebaseValue(std::uint8_t byte) {
+    if (byte == 0) return TablebaseValue{};
+    if (byte < 128) return TablebaseValue{TablebaseOutcome::WIN, byte};
+    return TablebaseValue{TablebaseOutcome::LOSS, byte - 128};
+}
+
+std::uint64_t tablebaseEntries(const TablebaseMaterial& material) {
+    std::uint64_t entries = 2;
+    for (int count : kindCounts(material)) {
+        entries *= BINOMIAL[TABLEBASE_SQUARES][count];
+    }
+    return entries;
+}
+
+std::optional<std::uint64_t> tablebaseIndex(const Room& room) {
+    if (boardSize(room) != TABLEBASE_SIZE || room.captureLock.has_value()) return std::nullopt;
+    if (static_cast<int>(room.board.size()) != TABLEBASE_SIZE * TABLEBASE_SIZE) return std::nullopt;
+
+    int squares[4][TABLEBASE_MAX_PIECES];
+    int counts[4] = {0, 0, 0, 0};
+    for (int sq = 0; sq < TABLEBASE_SQUARES; ++sq) {
+        char piece = room.board[TB_RAYS.boardIndex[sq]];
+        if (piece == '.') continue;
+        for (int kind = 0; kind < 4; ++kind) {
+            if (PIECE_KINDS[kind] != piece) continue;
+            if (counts[kind] == TABLEBASE_MAX_PIECES) return std::nullopt;
+            squares[kind][counts[kind]++] = sq;
+        }
+    }
+
+    std::uint64_t index = 0;
+    for (int kind = 3; kind >= 0; --kind) {
+        index = index * BINOMIAL[TABLEBASE_SQUARES][counts[kind]] + rankSquares(squares[kind], counts[kind]);
+    }
+    return index * 2 + (room.turn == Turn::PLAYER2 ? 1 : 0);
+}
+
+bool tablebasePosition(const TablebaseMaterial& material, std::uint64_t index, Room& room) {
+    room.board.assign(TABLEBASE_SIZE * TABLEBASE_SIZE, '.');
+    room.captureLock.reset();
+    room.turn = (index % 2 == 1) ? Turn::PLAYER2 : Turn::PLAYER1;
+    index /= 2;
+
+    bool possible = true;
+    auto counts = kindCounts(material);
+    for (int kind = 0; kind < 4; ++kind) {
+        std::uint64_t combinations = BINOMIAL[TABLEBASE_SQUARES][counts[kind]];
+        int squares[TABLEBASE_MAX_PIECES];
+        unrankSquares(index % combinations, counts[kind], squares);
+        index /= combinations;
+        for (int i = 0; i < counts[kind]; ++i) {
+            int at = TB_RAYS.boardIndex[squares[i]];
+            int row = at / TABLEBASE_SIZE;
+            if (room.board[at] != '.') possible = false;
+            if ((PIECE_KINDS[kind] == 'w' && row == 0) || (PIECE_KINDS[kind] == 'b' && row == TABLEBASE_SIZE - 1)) {
+                possible = false; // pěšec na řadě proměny už je dáma
+            }
+            room.board[at] = PIECE_KINDS[kind];
+        }
+    }
+    room.hash = computePositionHash(room);
+    room.material = computeMaterial(room);
+    return possible;
+}
+
+std::string formatTablebaseValue(const TablebaseValue& value) {
+    const char* outcome = value.outcome == TablebaseOutcome::WIN ? "WIN"
+                        : value.outcome == TablebaseOutcome::LOSS ? "LOSS" : "DRAW";
+    return std::string(outcome) + ":" + std::to_string(value.moves);
+}
+
+std::unique_ptr<Tablebase> Tablebase::open(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "cannot open " + path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(HEADER_SIZE)) {
+        close(fd);
+        error = path + ": not a tablebase file";
+        return nullptr;
+    }
+    void* map = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        error = "cannot map " + path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+
+    std::unique_ptr<Tablebase> tb(new Tablebase());
+    tb->map_ = map;
+    tb->mapSize_ = static_cast<std::size_t>(st.st_size);
+
+    const auto* bytes = static_cast<const std::uint8_t*>(map);
+    if (std::memcmp(bytes, TABLEBASE_MAGIC, sizeof(TABLEBASE_MAGIC)) != 0 ||
+        bytes[8] >= ALL_VARIANTS.size() || variantBoardSize(ALL_VARIANTS[bytes[8]]) != TABLEBASE_SIZE ||
+        bytes[10] > TABLEBASE_MAX_PIECES) {
+        error = path + ": not a tablebase file";
+        return nullptr;
+    }
+    tb->variant_ = ALL_VARIANTS[bytes[8]];
+    tb->maxCapture_ = bytes[9] != 0;
+    tb->maxPieces_ = bytes[10];
+
+    std::uint64_t count = readLittleEndian(bytes + 12, 4);
+    if (HEADER_SIZE + DIRECTORY_ENTRY * count > tb->mapSize_) {
+        error = path + ": truncated directory";
+        return nullptr;
+    }
+    for (std::uint64_t i = 0; i < count; ++i) {
+        const std::uint8_t* entry = bytes + HEADER_SIZE + DIRECTORY_ENTRY * i;
+        TablebaseMaterial m{entry[0], entry[1], entry[2], entry[3]};
+        std::uint64_t offset = readLittleEndian(entry + 4, 8);
+        std::uint64_t size = readLittleEndian(entry + 12, 8);
+        if (m.total() > tb->maxPieces_ || size != tablebaseEntries(m) ||
+            offset > tb->mapSize_ || size > tb->mapSize_ - offset) {
+            error = path + ": corrupt directory entry " + std::to_string(i);
+            return nullptr;
+        }
+        tb->slice(m) = Slice{bytes + offset, size};
+    }
+    return tb;
+}
+
+Tablebase::~Tablebase() {
+    if (map_) munmap(map_, mapSize_);
+}
+
+std::optional<TablebaseValue> Tablebase::probe(const Room& room) const {
+    if (room.variant != variant_ || room.maxCaptureRule != maxCapture_ || room.captureLock.has_value()) {
+        return std::nullopt;
+    }
+    const Material& m = room.material;
+    int white = m.whiteMen + m.whiteKings;
+    int black = m.blackMen + m.blackKings;
+    if (white + black > maxPieces_) return std::nullopt;
+    int toMove = room.turn == Turn::PLAYER2 ? black : white;
+    int waiting = room.turn == Turn::PLAYER2 ? white : black;
+    if (toMove == 0) return TablebaseValue{TablebaseOutcome::LOSS, 0};
+    if (waiting == 0) return std::nullopt; // hra už skončila
+
+    const Slice& s = slice(toTablebaseMaterial(m));
+    auto index = tablebaseIndex(room);
+    if (!s.data || !index || *index >= s.size) return std::nullopt;
+    return decodeTablebaseValue(s.data[*index]);
+}
+
+std::optional<TablebaseValue> TablebaseSet::probe(const Room& room) const {
+    for (const auto& t : tables) {
+        if (t->variant() == room.variant && t->maxCaptureRule() == room.maxCaptureRule) {
+            return t->probe(room);
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<TablebaseMoves> tablebaseBestMoves(const TablebaseSet& tablebases, const Room& room) {
+    if (tablebases.empty()) return std::nullopt;
+    const Material& m = room.material;
+    if (m.whiteMen + m.whiteKings + m.blackMen + m.blackKings > TABLEBASE_MAX_PIECES) return std::nullopt;
+
+    thread_local FullMoves moves;
+    Room position = room;
+    TablebaseMoves out;
+    int best = -1000000;
+    bool covered = true;
+    moves.forEach(position, [&](const Room& after, std::span<const std::pair<int, int>> move) {
+        auto v = tablebases.probe(after);
+        if (!v) {
+            covered = false;
+            return;
+        }
+        int p = preference(*v);
+        if (p > best) {
+            best = p;
+            out.value = valueBefore(*v);
+            out.best.clear();
+        }
+        if (p == best) {
+            out.best.emplace_back(move.begin(), move.end());
+        }
+    });
+    if (!covered || out.best.empty()) return std::nullopt;
+    return out;
+}
+
+bool generateTablebase(Variant variant, bool maxCaptureRule, int maxPieces, const std::string& path, std::string& error) {
+    if (variantBoardSize(variant) != TABLEBASE_SIZE) {
+        error = "tablebases exist only for 8x8 variants";
+        return false;
+    }
+    if (maxPieces < 2 || maxPieces > TABLEBASE_MAX_PIECES) {
+        error = "pieces must be in range 2-" + std::to_string(TABLEBASE_MAX_PIECES);
+        return false;
+    }
+
+    Generator generator(variant, maxCaptureRule, maxPieces);
+    generator.run();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    std::string data = generator.serialize();
+    if (!file || !file.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
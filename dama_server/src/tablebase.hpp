@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "models.hpp"
+
+// Databáze koncovek pro varianty 8x8: pro každou pozici s nejvýš maxPieces kameny
+// (bez captureLock) výhra/remíza/prohra strany na tahu a počet tahů do konce.
+// Generuje ji offline dama_tbgen (retrográdní analýza), server soubor mapuje přes mmap
+// a čte přímo z mapované paměti.
+//
+// Soubor: hlavička (TABLEBASE_MAGIC, varianta, maxCapture, maxPieces, počet materiálů),
+// adresář materiálů (wm, wk, bm, bk, offset, velikost) a data: jeden bajt na pozici.
+// Index pozice v materiálu: strana na tahu + pořadí množiny polí každého druhu kamenů
+// (kombinatorická čísla nad 32 tmavými poli), viz tablebaseIndex.
+// Bajt: 0 = remíza (nebo pozice, která nemůže nastat), 1..127 = výhra za n tahů,
+// 128 + n = prohra za n tahů (128 = strana na tahu nemá tah ani kámen).
+// Tah je celý tah včetně řetězu skoků; pravidlo 30 tahů bez postupu tabulka nezná.
+
+constexpr int TABLEBASE_SIZE = 8;
+constexpr int TABLEBASE_SQUARES = TABLEBASE_SIZE * TABLEBASE_SIZE / 2;
+constexpr int TABLEBASE_MAX_PIECES = 4;
+constexpr char TABLEBASE_MAGIC[8] = {'D', 'A', 'M', 'A', 'T', 'B', '1', '\n'};
+
+enum class TablebaseOutcome {
+    WIN,
+    DRAW,
+    LOSS
+};
+
+struct TablebaseValue {
+    TablebaseOutcome outcome = TablebaseOutcome::DRAW;
+    int moves = 0; // do výhry/prohry při nejlepší hře obou stran
+
+    bool operator==(const TablebaseValue&) const = default;
+};
+
+// Počty kamenů jednoho materiálu
+struct TablebaseMaterial {
+    int whiteMen = 0;
+    int whiteKings = 0;
+    int blackMen = 0;
+    int blackKings = 0;
+
+    int total() const { return whiteMen + whiteKings + blackMen + blackKings; }
+};
+
+std::uint8_t encodeTablebaseValue(const TablebaseValue& value);
+TablebaseValue decodeTablebaseValue(std::uint8_t byte);
+
+// Počet indexů materiálu (obě strany na tahu, včetně nemožných kombinací)
+std::uint64_t tablebaseEntries(const TablebaseMaterial& material);
+
+// Index pozice v jejím materiálu; nullopt pro desku jiné velikosti nebo se zámkem skoku
+std::optional<std::uint64_t> tablebaseIndex(const Room& room);
+
+// Opak tablebaseIndex: deska a strana na tahu; false = nemožná pozice (překryv kamenů,
+// pěšec na řadě proměny)
+bool tablebasePosition(const TablebaseMaterial& material, std::uint64_t index, Room& room);
+
+// "WIN:7", "DRAW:0", "LOSS:3" pro protokol
+std::string formatTablebaseValue(const TablebaseValue& value);
+
+// Jeden soubor databáze namapovaný do paměti (jen pro čtení)
+class Tablebase {
+public:
+    // nullptr a zpráva v error, pokud soubor nejde otevřít nebo nemá správný formát
+    static std::unique_ptr<Tablebase> open(const std::string& path, std::string& error);
+    ~Tablebase();
+
+    Tablebase(const Tablebase&) = delete;
+    Tablebase& operator=(const Tablebase&) = delete;
+
+    Variant variant() const { return variant_; }
+    bool maxCaptureRule() const { return maxCapture_; }
+    int maxPieces() const { return maxPieces_; }
+
+    // Hodnota pro stranu na tahu; nullopt mimo databázi (jiná varianta, víc kamenů, captureLock)
+    std::optional<TablebaseValue> probe(const Room& room) const;
+
+private:
+    Tablebase() = default;
+
+    struct Slice {
+        const std::uint8_t* data = nullptr;
+        std::uint64_t size = 0;
+    };
+
+    // adresář materiálů podle [wm][wk][bm][bk]
+    Slice& slice(const TablebaseMaterial& m) {
+        return slices_[m.whiteMen][m.whiteKings][m.blackMen][m.blackKings];
+    }
+    const Slice& slice(const TablebaseMaterial& m) const {
+        return slices_[m.whiteMen][m.whiteKings][m.blackMen][m.blackKings];
+    }
+
+    void* map_ = nullptr;
+    std::size_t mapSize_ = 0;
+    Variant variant_ = Variant::CZECH;
+    bool maxCapture_ = false;
+    int maxPieces_ = 0;
+    Slice slices_[TABLEBASE_MAX_PIECES + 1][TABLEBASE_MAX_PIECES + 1][TABLEBASE_MAX_PIECES + 1][TABLEBASE_MAX_PIECES + 1];
+};
+
+// Načtené databáze; pro pozici se vybere ta se stejnou variantou a pravidlem nejdelšího skoku
+class TablebaseSet {
+public:
+    void add(std::unique_ptr<Tablebase> tablebase) { tables.push_back(std::move(tablebase)); }
+    bool empty() const { return tables.empty(); }
+
+    std::optional<TablebaseValue> probe(const Room& room) const;
+
+private:
+    std::vector<std::unique_ptr<Tablebase>> tables;
+};
+
+// Nejlepší celé tahy z pozice podle databáze (i uprostřed řetězu, podle captureLock).
+// Každý tah je [start, dopad1, ...]; value je hodnota pozice pro stranu na tahu.
+struct TablebaseMoves {
+    TablebaseValue value;
+    std::vector<std::vector<std::pair<int, int>>> best;
+};
+std::optional<TablebaseMoves> tablebaseBestMoves(const TablebaseSet& tablebases, const Room& room);
+
+// Vygeneruje databázi pro variantu 8x8 a zapíše ji do path; průběh na std::cout.
+// false a zpráva v error při chybě (jiná velikost desky, zápis souboru).
+bool generateTablebase(Variant variant, bool maxCaptureRule, int maxPieces, const std::string& path, std::string& error);
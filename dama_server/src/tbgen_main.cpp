@@ -0,0 +1,54 @@
+#include <iostream>
+#include <string>
+
+#include "tablebase.hpp"
+
+// dama_tbgen – offline generátor databáze koncovek (retrográdní analýza) pro varianty 8x8.
+// Použití: dama_tbgen [--variant czech|russian|italian] [--max-capture 0|1] [--pieces N] --out FILE
+// Bez --max-capture platí výchozí pravidlo varianty; soubor pak server načte přes --tablebase FILE.
+int main(int argc, char* argv[]) {
+    Variant variant = Variant::CZECH;
+    int maxCapture = -1;
+    int pieces = 3;
+    std::string out;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument(arg);
+                return argv[++i];
+            };
+            if (arg == "--variant") {
+                auto v = parseVariant(next());
+                if (!v) throw std::invalid_argument(arg);
+                variant = *v;
+            } else if (arg == "--max-capture") {
+                maxCapture = std::stoi(next()) != 0 ? 1 : 0;
+            } else if (arg == "--pieces") {
+                pieces = std::stoi(next());
+            } else if (arg == "--out") {
+                out = next();
+            } else {
+                std::cerr << "Unknown argument " << arg << std::endl;
+                return 2;
+            }
+        }
+    } catch (...) {
+        std::cerr << "Invalid arguments" << std::endl;
+        return 2;
+    }
+    if (out.empty()) {
+        std::cerr << "Missing --out FILE" << std::endl;
+        return 2;
+    }
+
+    bool maxCaptureRule = maxCapture < 0 ? variantMaxCapture(variant) : maxCapture == 1;
+    std::string error;
+    if (!generateTablebase(variant, maxCaptureRule, pieces, out, error)) {
+        std::cerr << "Tablebase generation failed: " << error << std::endl;
+        return 1;
+    }
+    std::cout << "[INFO] Tablebase written to " << out << std::endl;
+    return 0;
+}
@@ -0,0 +1,333 @@
+#include "tournament.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+constexpr int SWISS_COLOUR_LOOKAHEAD = 4; // kolik dalších soupeřů se stejnými body zkusit kvůli barvě
+constexpr int SWISS_SWAP_LOOKBACK = 64;   // kolik už hotových dvojic zkusit rozbít místo opakovaného setkání
+
+// +1 chce bílou, -1 černou, 0 je mu to jedno
+int colourPreference(const TournamentEntrant& e) {
+    if (e.colourBalance != 0) return e.colourBalance < 0 ? 1 : -1;
+    return -e.lastColour;
+}
+
+bool coloursFit(const TournamentEntrant& a, const TournamentEntrant& b) {
+    int pa = colourPreference(a);
+    int pb = colourPreference(b);
+    return pa == 0 || pb == 0 || pa != pb;
+}
+
+} // namespace
+
+std::string tournamentFormatName(TournamentFormat format) {
+    return format == TournamentFormat::SWISS ? "swiss" : "roundrobin";
+}
+
+std::optional<TournamentFormat> parseTournamentFormat(const std::string& name) {
+    if (name == "swiss") return TournamentFormat::SWISS;
+    if (name == "roundrobin") return TournamentFormat::ROUND_ROBIN;
+    return std::nullopt;
+}
+
+std::string tournamentStatusName(TournamentStatus status) {
+    switch (status) {
+        case TournamentStatus::REGISTERING: return "REGISTERING";
+        case TournamentStatus::RUNNING: return "RUNNING";
+        case TournamentStatus::FINISHED: return "FINISHED";
+    }
+    return "?";
+}
+
+std::string formatScore(double score) {
+    long halves = std::lround(score * 2);
+    return std::to_string(halves / 2) + (halves % 2 ? ".5" : "");
+}
+
+int Tournament::addEntrant(const std::string& nick, int rating) {
+    if (auto existing = entrantOf(nick)) return *existing;
+    int limit = format == TournamentFormat::ROUND_ROBIN ? TOURNAMENT_MAX_ROUND_ROBIN : TOURNAMENT_MAX_PLAYERS;
+    if (static_cast<int>(entrants.size()) >= limit) return -1;
+    TournamentEntrant entrant;
+    entrant.nick = nick;
+    entrant.rating = rating;
+    entrants.push_back(std::move(entrant));
+    return static_cast<int>(entrants.size()) - 1;
+}
+
+std::optional<int> Tournament::entrantOf(const std::string& nick) const {
+    for (std::size_t i = 0; i < entrants.size(); ++i) {
+        if (entrants[i].nick == nick) return static_cast<int>(i);
+    }
+    return std::nullopt;
+}
+
+bool Tournament::startNextRound(std::chrono::steady_clock::time_point now) {
+    int n = static_cast<int>(entrants.size());
+    if (round == 0) {
+        if (format == TournamentFormat::ROUND_ROBIN) {
+            rounds = n % 2 == 0 ? n - 1 : n;
+        } else if (rounds == 0) {
+            rounds = std::max(1, static_cast<int>(std::ceil(std::log2(std::max(2, n)))));
+        }
+        rounds = std::min({rounds, TOURNAMENT_MAX_ROUNDS, std::max(1, n - 1 + n % 2)});
+    }
+    if (round >= rounds) {
+        status = TournamentStatus::FINISHED;
+        boards.clear();
+        return false;
+    }
+    status = TournamentStatus::RUNNING;
+    ++round;
+    boards.clear();
+    roundStartedAt = now;
+    if (format == TournamentFormat::ROUND_ROBIN) {
+        pairRoundRobin();
+    } else {
+        pairSwiss();
+    }
+    return true;
+}
+
+bool Tournament::met(int a, int b) const {
+    const auto& opponents = entrants[static_cast<std::size_t>(a)].opponents;
+    return std::find(opponents.begin(), opponents.end(), b) != opponents.end();
+}
+
+// a je výš v pořadí; při stejné bilanci bílou ten, kdo naposled hrál černými
+int Tournament::preferredWhite(int a, int b) const {
+    const TournamentEntrant& ea = entrants[static_cast<std::size_t>(a)];
+    const TournamentEntrant& eb = entrants[static_cast<std::size_t>(b)];
+    if (ea.colourBalance != eb.colourBalance) return ea.colourBalance < eb.colourBalance ? a : b;
+    if (ea.lastColour != eb.lastColour) return ea.lastColour < eb.lastColour ? a : b;
+    return round % 2 == 1 ? a : b;
+}
+
+void Tournament::addBoard(int white, int black) {
+    TournamentBoard board;
+    board.white = white;
+    board.black = black;
+    boards.push_back(board);
+
+    TournamentEntrant& w = entrants[static_cast<std::size_t>(white)];
+    w.opponents.push_back(black);
+    w.results.push_back(0);
+    if (black < 0) {
+        w.hadBye = true;
+        recordResult(boards.size() - 1, 1.0, 0.0);
+        return;
+    }
+    TournamentEntrant& b = entrants[static_cast<std::size_t>(black)];
+    b.opponents.push_back(white);
+    b.results.push_back(0);
+    w.colourBalance++;
+    w.lastColour = 1;
+    b.colourBalance--;
+    b.lastColour = -1;
+    // každý s každým páruje i odstoupivší hráče: jejich partie se kontumují hned
+    if (w.withdrawn || b.withdrawn) {
+        recordResult(boards.size() - 1, w.withdrawn ? 0.0 : 1.0, b.withdrawn ? 0.0 : 1.0);
+    }
+}
+
+void Tournament::pairSwiss() {
+    std::vector<int> order;
+    for (std::size_t i = 0; i < entrants.size(); ++i) {
+        if (!entrants[i].withdrawn) order.push_back(static_cast<int>(i));
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        const TournamentEntrant& ea = entrants[static_cast<std::size_t>(a)];
+        const TournamentEntrant& eb = entrants[static_cast<std::size_t>(b)];
+        if (ea.score != eb.score) return ea.score > eb.score;
+        if (ea.rating != eb.rating) return ea.rating > eb.rating;
+        return a < b;
+    });
+
+    int bye = -1;
+    if (order.size() % 2 == 1) {
+        auto it = std::find_if(order.rbegin(), order.rend(),
+                               [this](int i) { return !entrants[static_cast<std::size_t>(i)].hadBye; });
+        bye = it != order.rend() ? *it : order.back();
+        order.erase(std::find(order.begin(), order.end(), bye));
+    }
+
+    pairingSteps = 0;
+    std::vector<char> paired(entrants.size(), 0);
+    std::vector<std::pair<int, int>> pairs; // (výš postavený, níž postavený)
+    pairs.reserve(order.size() / 2);
+    for (std::size_t a = 0; a < order.size(); ++a) {
+        int p = order[a];
+        if (paired[static_cast<std::size_t>(p)]) continue;
+        const TournamentEntrant& ep = entrants[static_cast<std::size_t>(p)];
+
+        int chosen = -1;
+        int firstFree = -1;
+        int tried = 0;
+        for (std::size_t b = a + 1; b < order.size(); ++b) {
+            int q = order[b];
+            ++pairingSteps;
+            if (paired[static_cast<std::size_t>(q)]) continue;
+            if (firstFree < 0) firstFree = q;
+            if (met(p, q)) continue;
+            const TournamentEntrant& eq = entrants[static_cast<std::size_t>(q)];
+            if (chosen < 0) {
+                chosen = q;
+                if (coloursFit(ep, eq)) break;
+                continue;
+            }
+            if (eq.score != entrants[static_cast<std::size_t>(chosen)].score || ++tried > SWISS_COLOUR_LOOKAHEAD) break;
+            if (coloursFit(ep, eq)) {
+                chosen = q;
+                break;
+            }
+        }
+
+        if (chosen < 0) {
+            // zbyl jen soupeř, se kterým už hrál: zkusit prohodit s některou hotovou dvojicí
+            int q = firstFree;
+            bool swapped = false;
+            int lookback = 0;
+            for (auto it = pairs.rbegin(); it != pairs.rend() && lookback < SWISS_SWAP_LOOKBACK; ++it, ++lookback) {
+                auto [x, y] = *it;
+                ++pairingSteps;
+                if (!met(p, x) && !met(q, y)) {
+                    *it = {x, p};
+                    pairs.emplace_back(y, q);
+                    swapped = true;
+                } else if (!met(p, y) && !met(q, x)) {
+                    *it = {x, q};
+                    pairs.emplace_back(y, p);
+                    swapped = true;
+                }
+                if (swapped) break;
+            }
+            paired[static_cast<std::size_t>(p)] = paired[static_cast<std::size_t>(q)] = 1;
+            if (!swapped) {
+                pairs.emplace_back(p, q);
+                ++rematches;
+            }
+            continue;
+        }
+        paired[static_cast<std::size_t>(p)] = paired[static_cast<std::size_t>(chosen)] = 1;
+        pairs.emplace_back(p, chosen);
+    }
+
+    for (auto [high, low] : pairs) {
+        int white = preferredWhite(high, low);
+        addBoard(white, white == high ? low : high);
+    }
+    if (bye >= 0) addBoard(bye, -1);
+}
+
+void Tournament::pairRoundRobin() {
+    int n = static_cast<int>(entrants.size());
+    int m = n + n % 2; // při lichém počtu je hráč m-1 volno
+    int r = round - 1;
+    auto add = [&](int white, int black) {
+        if (white >= n) {
+            addBoard(black, -1);
+        } else if (black >= n) {
+            addBoard(white, -1);
+        } else {
+            addBoard(white, black);
+        }
+    };
+    // kruhová metoda: hráč m-1 stojí, ostatní se každé kolo posunou o jedno místo
+    int fixed = m - 1;
+    if (r % 2 == 0) {
+        add(r, fixed);
+    } else {
+        add(fixed, r);
+    }
+    for (int k = 1; k < m / 2; ++k) {
+        int x = (r + k) % (m - 1);
+        int y = (r - k + (m - 1)) % (m - 1);
+        if (k % 2 == 1) {
+            add(x, y);
+        } else {
+            add(y, x);
+        }
+    }
+}
+
+void Tournament::recordResult(std::size_t board, double whiteScore, double blackScore) {
+    if (board >= boards.size() || boards[board].finished) return;
+    TournamentBoard& b = boards[board];
+    b.finished = true;
+    TournamentEntrant& w = entrants[static_cast<std::size_t>(b.white)];
+    w.results.back() = whiteScore;
+    w.score += whiteScore;
+    if (b.black >= 0) {
+        TournamentEntrant& bl = entrants[static_cast<std::size_t>(b.black)];
+        bl.results.back() = blackScore;
+        bl.score += blackScore;
+    }
+}
+
+bool Tournament::roundComplete() const {
+    return std::all_of(boards.begin(), boards.end(), [](const TournamentBoard& b) { return b.finished; });
+}
+
+std::vector<TournamentStanding> Tournament::standings() const {
+    std::vector<TournamentStanding> out;
+    out.reserve(entrants.size());
+    for (std::size_t i = 0; i < entrants.size(); ++i) {
+        const TournamentEntrant& e = entrants[i];
+        TournamentStanding s;
+        s.entrant = static_cast<int>(i);
+        s.score = e.score;
+        for (std::size_t r = 0; r < e.opponents.size(); ++r) {
+            if (e.opponents[r] < 0) continue;
+            double opponentScore = entrants[static_cast<std::size_t>(e.opponents[r])].score;
+            s.buchholz += opponentScore;
+            s.sonnebornBerger += e.results[r] * opponentScore;
+        }
+        out.push_back(s);
+    }
+    std::sort(out.begin(), out.end(), [this](const TournamentStanding& a, const TournamentStanding& b) {
+        if (a.score != b.score) return a.score > b.score;
+        if (a.buchholz != b.buchholz) return a.buchholz > b.buchholz;
+        if (a.sonnebornBerger != b.sonnebornBerger) return a.sonnebornBerger > b.sonnebornBerger;
+        int ra = entrants[static_cast<std::size_t>(a.entrant)].rating;
+        int rb = entrants[static_cast<std::size_t>(b.entrant)].rating;
+        if (ra != rb) return ra > rb;
+        return a.entrant < b.entrant;
+    });
+    return out;
+}
+
+void TournamentSet::bindRoom(int roomId, int tournamentId, std::size_t board) {
+    boardOfRoom[roomId] = {tournamentId, board};
+}
+
+void TournamentSet::releaseRoom(int roomId, int tournamentId, std::size_t board) {
+    auto it = boardOfRoom.find(roomId);
+    if (it != boardOfRoom.end() && it->second == std::make_pair(tournamentId, board)) boardOfRoom.erase(it);
+}
+
+void TournamentSet::gameFinished(const Room& room, const std::string& reason, const std::string& winner) {
+    auto it = boardOfRoom.find(room.id);
+    if (it == boardOfRoom.end()) return;
+    auto [tournamentId, board] = it->second;
+    boardOfRoom.erase(it);
+    auto itTournament = byId.find(tournamentId);
+    if (itTournament == byId.end()) return;
+
+    double whiteScore = 0;
+    double blackScore = 0;
+    if (reason.rfind("DRAW_", 0) == 0) {
+        whiteScore = blackScore = 0.5;
+    } else if (winner == "WHITE") {
+        whiteScore = 1;
+    } else if (winner == "BLACK") {
+        blackScore = 1;
+    }
+    itTournament->second.recordResult(board, whiteScore, blackScore);
+    std::cout << "[INFO] TOURNAMENT_RESULT tournament=" << tournamentId
+              << " round=" << itTournament->second.round
+              << " board=" << board + 1
+              << " result=" << formatScore(whiteScore) << "-" << formatScore(blackScore) << std::endl;
+}
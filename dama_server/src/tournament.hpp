@@ -0,0 +1,139 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "models.hpp"
+#include "runtime.hpp"
+#include "variants.hpp"
+
+// Turnaje (TOURNAMENT_*): švýcarský systém a každý s každým. Tournament je jen logika
+// párování a pořadí, bez sítě; stoly pro kolo zakládá server (runTournaments v
+// server.cpp) a výsledky přicházejí přes GameRecorder z GAME_END.
+//
+// Švýcarský systém: hráči seřazení podle bodů a nasazení, shora se každému hledá
+// nejbližší hráč pod ním, se kterým ještě nehrál (v rámci stejného počtu bodů přednost
+// barevně vhodnějšímu). Kolo pro 2000 hráčů projde jen několik tisíc kandidátů
+// (pairingSteps); když na konci nezbude jiný soupeř, připustí se opakované setkání
+// (počítá se v rematches).
+// Lichý hráč dostane volno (bod) odspodu, každý nejvýš jednou.
+// Každý s každým: Bergerovy tabulky (kruhová metoda), u lichého počtu volno.
+//
+// Pomocná hodnocení: Buchholz (součet bodů soupeřů) a Sonneborn–Berger (body soupeřů
+// násobené výsledkem proti nim); volno se do nich nepočítá.
+
+constexpr int TOURNAMENT_MAX_PLAYERS = 4096;
+constexpr int TOURNAMENT_MAX_ROUND_ROBIN = 20; // víc hráčů jen švýcarským systémem
+constexpr int TOURNAMENT_MAX_ROUNDS = 30;
+constexpr int TOURNAMENT_FORFEIT_MS = 60000;   // hráč, který do té doby nezasedne, prohrává kontumačně
+constexpr int TOURNAMENT_TICK_MS = 1000;
+constexpr int TOURNAMENT_MAX_OPEN = 16;           // rozběhnuté a přihlašovací najednou
+constexpr std::size_t TOURNAMENT_STANDINGS_LIMIT = 10;
+
+enum class TournamentFormat {
+    SWISS,
+    ROUND_ROBIN
+};
+
+enum class TournamentStatus {
+    REGISTERING,
+    RUNNING,
+    FINISHED
+};
+
+std::string tournamentFormatName(TournamentFormat format);
+std::optional<TournamentFormat> parseTournamentFormat(const std::string& name);
+std::string tournamentStatusName(TournamentStatus status);
+
+// "2", "2.5"
+std::string formatScore(double score);
+
+struct TournamentEntrant {
+    std::string nick;
+    int rating = 0;                // nasazení (hodnocení při přihlášení)
+    double score = 0;
+    std::vector<int> opponents;    // soupeř po kolech, -1 volno
+    std::vector<double> results;   // body po kolech (nedohraná partie 0)
+    int colourBalance = 0;         // bílé minus černé
+    int lastColour = 0;            // +1 bílá, -1 černá
+    bool hadBye = false;
+    bool withdrawn = false;
+};
+
+struct TournamentBoard {
+    int white = -1;
+    int black = -1;                // -1: volno pro bílého
+    int roomId = 0;                // 0: ještě nezasedli
+    bool finished = false;
+    bool announced = false;        // hráči dostali TOURNAMENT_GAME / TOURNAMENT_BYE
+};
+
+struct TournamentStanding {
+    int entrant = 0;
+    double score = 0;
+    double buchholz = 0;
+    double sonnebornBerger = 0;
+};
+
+class Tournament {
+public:
+    int id = 0;
+    std::string name;
+    std::string organizer; // přezdívka; jen on smí TOURNAMENT_START
+    TournamentFormat format = TournamentFormat::SWISS;
+    Variant variant = Variant::CZECH;
+    bool maxCaptureRule = false;
+    int rounds = 0;        // 0: švýcarský systém dopočítá při startu
+    int round = 0;         // aktuální kolo od 1
+    TournamentStatus status = TournamentStatus::REGISTERING;
+    std::chrono::steady_clock::time_point roundStartedAt{};
+    int rematches = 0;
+    std::uint64_t pairingSteps = 0; // kandidáti prošlí párováním posledního kola (švýcarský systém)
+
+    std::vector<TournamentEntrant> entrants;
+    std::vector<TournamentBoard> boards; // aktuální kolo
+
+    // -1, pokud už je plno; jinak index hráče (opakované přihlášení vrátí stejný)
+    int addEntrant(const std::string& nick, int rating);
+    std::optional<int> entrantOf(const std::string& nick) const;
+
+    // Spáruje další kolo; false (a FINISHED), když už žádné není
+    bool startNextRound(std::chrono::steady_clock::time_point now);
+
+    // Body bílého a černého na desce (kontumace 1:0, dvojitá kontumace 0:0)
+    void recordResult(std::size_t board, double whiteScore, double blackScore);
+    bool roundComplete() const;
+
+    std::vector<TournamentStanding> standings() const;
+
+private:
+    void pairSwiss();
+    void pairRoundRobin();
+    void addBoard(int white, int black);
+    bool met(int a, int b) const;
+    int preferredWhite(int a, int b) const;
+};
+
+// Všechny turnaje serveru; jako GameRecorder zapisuje výsledky partií u turnajových stolů
+class TournamentSet : public GameRecorder {
+public:
+    std::map<int, Tournament> byId;
+    int nextId = 1;
+
+    // Stůl roomId hraje desku board turnaje tournamentId
+    void bindRoom(int roomId, int tournamentId, std::size_t board);
+    // Stůl se uvolnil bez GAME_END (oba hráči odpadli); vazba se zruší, jen pokud pořád platí
+    void releaseRoom(int roomId, int tournamentId, std::size_t board);
+
+    void gameFinished(const Room& room, const std::string& reason, const std::string& winner) override;
+
+private:
+    std::unordered_map<int, std::pair<int, std::size_t>> boardOfRoom;
+};
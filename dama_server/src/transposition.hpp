@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "models.hpp"
+
+// Transpoziční tabulka sdílená vlákny analýzy bez zámků: každý slot jsou dvě
+// atomická slova (key ^ data, data). Zápis z jiného vlákna uprostřed čtení se
+// pozná tak, že key ^ data nesedí, a slot se bere jako prázdný.
+
+enum class Bound : std::uint8_t {
+    EXACT,
+    LOWER, // skóre je aspoň tolik (beta řez)
+    UPPER  // skóre je nejvýš tolik (žádný tah nepřekonal alfa)
+};
+
+constexpr int NO_TABLE_SQUARE = 127; // pole mimo desku = bez tahu
+
+struct TableEntry {
+    int score = 0;
+    int depth = 0;
+    Bound bound = Bound::EXACT;
+    int fromSquare = NO_TABLE_SQUARE; // row * MAX_BOARD_SIZE + col
+    int toSquare = NO_TABLE_SQUARE;
+};
+
+// Klíč pozice: Room::hash plus varianta a pravidlo nejdelšího skoku (mění legální tahy)
+inline std::uint64_t tableKey(const Room& room) {
+    std::uint64_t key = room.hash ^ ((static_cast<std::uint64_t>(room.variant) + 1) * 0x9E3779B97F4A7C15ULL);
+    if (room.maxCaptureRule) key ^= 0xD6E8FEB86659FD93ULL;
+    return key;
+}
+
+class TranspositionTable {
+public:
+    explicit TranspositionTable(std::size_t megabytes) {
+        std::size_t wanted = megabytes * 1024 * 1024 / sizeof(Slot);
+        count = 1;
+        while (count * 2 <= wanted) count *= 2;
+        slots = std::make_unique<Slot[]>(count);
+    }
+
+    bool probe(std::uint64_t key, TableEntry& out) const {
+        const Slot& slot = slots[key & (count - 1)];
+        std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+        std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if ((check ^ data) != key || data == 0) return false;
+        out = unpack(data);
+        return true;
+    }
+
+    // Přepíše slot, pokud patří jiné pozici nebo nový výsledek není mělčí
+    void store(std::uint64_t key, const TableEntry& entry) {
+        Slot& slot = slots[key & (count - 1)];
+        TableEntry old;
+        if (probe(key, old) && old.depth > entry.depth) return;
+        std::uint64_t data = pack(entry);
+        slot.data.store(data, std::memory_order_relaxed);
+        slot.check.store(key ^ data, std::memory_order_relaxed);
+    }
+
+    std::size_t size() const { return count; }
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> check{0};
+        std::atomic<std::uint64_t> data{0};
+    };
+
+    // skóre 32 b | hloubka 8 b | mez 2 b | odkud 7 b | kam 7 b | 1 = obsazeno
+    static std::uint64_t pack(const TableEntry& e) {
+        return static_cast<std::uint64_t>(static_cast<std::uint32_t>(e.score)) |
+               static_cast<std::uint64_t>(e.depth & 0xFF) << 32 |
+               static_cast<std::uint64_t>(e.bound) << 40 |
+               static_cast<std::uint64_t>(e.fromSquare & 0x7F) << 42 |
+               static_cast<std::uint64_t>(e.toSquare & 0x7F) << 49 |
+               1ULL << 56;
+    }
+
+    static TableEntry unpack(std::uint64_t data) {
+        TableEntry e;
+        e.score = static_cast<std::int32_t>(static_cast<std::uint32_t>(data));
+        e.depth = static_cast<int>((data >> 32) & 0xFF);
+        e.bound = static_cast<Bound>((data >> 40) & 0x3);
+        e.fromSquare = static_cast<int>((data >> 42) & 0x7F);
+        e.toSquare = static_cast<int>((data >> 49) & 0x7F);
+        return e;
+    }
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t count = 0;
+};
+
+static_assert(MAX_BOARD_SIZE * MAX_BOARD_SIZE <= NO_TABLE_SQUARE, "squares must fit into 7 bits");
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <span>
+#include <string>
+
+// Varianty pravidel jako policy struktury vyhodnocené při překladu. Pravidla v rules.cpp
+// jsou šablony nad policy; Room::variant se rozhoduje jen na vstupu do pravidel
+// (withVariantRules), smyčky uvnitř už běží nad konstantami konkrétní varianty.
+
+enum class Variant {
+    CZECH,
+    RUSSIAN,
+    ITALIAN,
+    INTERNATIONAL
+};
+
+constexpr std::array<Variant, 4> ALL_VARIANTS = {
+    Variant::CZECH, Variant::RUSSIAN, Variant::ITALIAN, Variant::INTERNATIONAL
+};
+
+constexpr int MAX_BOARD_SIZE = 10;
+
+struct Direction {
+    int dr;
+    int dc;
+};
+
+constexpr std::array<Direction, 4> KING_DIRECTIONS = {{{-1, -1}, {-1, 1}, {1, -1}, {1, 1}}};
+
+// Směry jako indexy do KING_DIRECTIONS (podle nich jsou i tabulky v rays.hpp)
+constexpr std::array<int, 4> ALL_DIRECTIONS = {0, 1, 2, 3};
+constexpr std::array<int, 2> WHITE_MAN_DIRECTIONS = {0, 1}; // bílý táhne nahoru
+constexpr std::array<int, 2> BLACK_MAN_DIRECTIONS = {2, 3};
+
+// Kdy se pěšec na poslední řadě stává dámou
+enum class PromotionRule {
+    CONTINUE_AS_KING, // hned, i uprostřed skoku; v řetězu pokračuje jako dáma
+    ENDS_MOVE,        // hned a tah tím končí
+    END_OF_CHAIN      // jen když na poslední řadě tah skončí; jinak skáče dál jako pěšec
+};
+
+template <int N>
+struct BoardGeometry {
+    static constexpr int size = N;
+    static constexpr int squares = N * N;
+
+    static constexpr bool inBoard(int row, int col) {
+        return row >= 0 && row < N && col >= 0 && col < N;
+    }
+    static constexpr int index(int row, int col) {
+        return row * N + col;
+    }
+};
+
+// Česká dáma (výchozí): létající dáma, pěšec skáče jen dopředu, skok se volí libovolně
+struct CzechRules : BoardGeometry<8> {
+    static constexpr Variant variant = Variant::CZECH;
+    static constexpr const char* name = "czech";
+    static constexpr int rowsPerSide = 3;
+    static constexpr bool flyingKings = true;
+    static constexpr bool menCaptureBackward = false;
+    static constexpr bool menCaptureKings = true;
+    static constexpr bool maxCapture = false;
+    static constexpr PromotionRule promotion = PromotionRule::CONTINUE_AS_KING;
+};
+
+// Ruská dáma: pěšec skáče i dozadu, povýšený uprostřed skoku pokračuje jako dáma
+struct RussianRules : BoardGeometry<8> {
+    static constexpr Variant variant = Variant::RUSSIAN;
+    static constexpr const char* name = "russian";
+    static constexpr int rowsPerSide = 3;
+    static constexpr bool flyingKings = true;
+    static constexpr bool menCaptureBackward = true;
+    static constexpr bool menCaptureKings = true;
+    static constexpr bool maxCapture = false;
+    static constexpr PromotionRule promotion = PromotionRule::CONTINUE_AS_KING;
+};
+
+// Italská dáma: dáma jen o jedno pole, pěšec nesmí brát dámu, povinný nejdelší skok
+struct ItalianRules : BoardGeometry<8> {
+    static constexpr Variant variant = Variant::ITALIAN;
+    static constexpr const char* name = "italian";
+    static constexpr int rowsPerSide = 3;
+    static constexpr bool flyingKings = false;
+    static constexpr bool menCaptureBackward = false;
+    static constexpr bool menCaptureKings = false;
+    static constexpr bool maxCapture = true;
+    static constexpr PromotionRule promotion = PromotionRule::ENDS_MOVE;
+};
+
+// Mezinárodní dáma 10x10: pěšec skáče i dozadu, povinný nejdelší skok, povýšení až na konci tahu
+struct InternationalRules : BoardGeometry<10> {
+    static constexpr Variant variant = Variant::INTERNATIONAL;
+    static constexpr const char* name = "international";
+    static constexpr int rowsPerSide = 4;
+    static constexpr bool flyingKings = true;
+    static constexpr bool menCaptureBackward = true;
+    static constexpr bool menCaptureKings = true;
+    static constexpr bool maxCapture = true;
+    static constexpr PromotionRule promotion = PromotionRule::END_OF_CHAIN;
+};
+
+static_assert(InternationalRules::size == MAX_BOARD_SIZE, "MAX_BOARD_SIZE must cover the largest variant");
+
+// Zavolá f(policy) s policy varianty; f je generická lambda, tělo se instancuje pro každou variantu
+template <class F>
+decltype(auto) withVariantRules(Variant variant, F&& f) {
+    switch (variant) {
+        case Variant::RUSSIAN:       return f(RussianRules{});
+        case Variant::ITALIAN:       return f(ItalianRules{});
+        case Variant::INTERNATIONAL: return f(InternationalRules{});
+        case Variant::CZECH:         break;
+    }
+    return f(CzechRules{});
+}
+
+template <class R>
+constexpr std::span<const int> manDirections(bool white) {
+    if (white) return WHITE_MAN_DIRECTIONS;
+    return BLACK_MAN_DIRECTIONS;
+}
+
+template <class R>
+constexpr std::span<const int> manCaptureDirections(bool white) {
+    if constexpr (R::menCaptureBackward) {
+        return ALL_DIRECTIONS;
+    } else {
+        return manDirections<R>(white);
+    }
+}
+
+inline int variantBoardSize(Variant variant) {
+    return withVariantRules(variant, [](auto rules) { return decltype(rules)::size; });
+}
+
+inline bool variantMaxCapture(Variant variant) {
+    return withVariantRules(variant, [](auto rules) { return decltype(rules)::maxCapture; });
+}
+
+inline std::string variantName(Variant variant) {
+    return withVariantRules(variant, [](auto rules) { return std::string(decltype(rules)::name); });
+}
+
+inline std::optional<Variant> parseVariant(const std::string& name) {
+    for (Variant v : ALL_VARIANTS) {
+        if (variantName(v) == name) return v;
+    }
+    return std::nullopt;
+}
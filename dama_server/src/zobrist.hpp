@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "variants.hpp"
+
+// Zobrist klíče pro 64bitový hash pozice (figurky na polích, strana na tahu,
+// pole s captureLock). Generují se při překladu ze splitmix64 s pevným seedem,
+// takže hash stejné pozice je stejný v každém běhu i mezi procesy.
+// Tabulky pokrývají největší desku; menší varianty používají jen začátek.
+
+constexpr int ZOBRIST_SQUARES = MAX_BOARD_SIZE * MAX_BOARD_SIZE;
+
+struct ZobristKeys {
+    std::array<std::array<std::uint64_t, 4>, ZOBRIST_SQUARES> piece{}; // w, W, b, B
+    std::array<std::uint64_t, ZOBRIST_SQUARES> lock{};
+    std::uint64_t blackToMove = 0;
+};
+
+constexpr std::uint64_t splitmix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys() {
+    ZobristKeys keys;
+    std::uint64_t state = 0x64616D61ull; // "dama"
+    for (auto& square : keys.piece) {
+        for (auto& key : square) {
+            key = splitmix64(state);
+        }
+    }
+    for (auto& key : keys.lock) {
+        key = splitmix64(state);
+    }
+    keys.blackToMove = splitmix64(state);
+    return keys;
+}
+
+inline constexpr ZobristKeys ZOBRIST = makeZobristKeys();
+
+// Klíč figurky na poli idx; prázdné pole (a cokoliv jiného) má klíč 0
+constexpr std::uint64_t zobristPiece(int idx, char piece) {
+    switch (piece) {
+        case 'w': return ZOBRIST.piece[idx][0];
+        case 'W': return ZOBRIST.piece[idx][1];
+        case 'b': return ZOBRIST.piece[idx][2];
+        case 'B': return ZOBRIST.piece[idx][3];
+        default:  return 0;
+    }
+}
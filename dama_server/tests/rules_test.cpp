@@ -0,0 +1,1727 @@
+// Testy pravidel nad Room: náhodné partie přes applyMove a kontrola invariantů.
+// Spouští se přes ctest (rules_test); při chybě vypíše popis a skončí s kódem 1.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "accounts.hpp"
+#include "affinitypool.hpp"
+#include "alloccount.hpp"
+#include "archive.hpp"
+#include "book.hpp"
+#include "bot.hpp"
+#include "clocksync.hpp"
+#include "cluster.hpp"
+#include "matchmaking.hpp"
+#include "models.hpp"
+#include "protocol.hpp"
+#include "rating.hpp"
+#include "ring.hpp"
+#include "rules.hpp"
+#include "runtime.hpp"
+#include "server.hpp"
+#include "kvstore.hpp"
+#include "load.hpp"
+#include "tablebase.hpp"
+#include "tournament.hpp"
+#include "transposition.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int BOARD = CzechRules::size; // testy bez uvedené varianty hrají českou dámu
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        ++failures;
+        std::cerr << "FAIL: " << what << std::endl;
+    }
+}
+
+struct TestMove {
+    int fromRow, fromCol, toRow, toCol;
+};
+
+std::vector<TestMove> legalMoves(const Room& room) {
+    std::vector<TestMove> out;
+    int size = boardSize(room);
+    PieceColor side = room.turn == Turn::PLAYER1 ? PieceColor::WHITE : PieceColor::BLACK;
+    bool white = side == PieceColor::WHITE;
+    bool captures = room.captureLock.has_value() || playerHasAnyCapture(room, side);
+    CaptureChainGenerator chains;
+    if (captures && room.maxCaptureRule) chains.generate(room);
+
+    auto addFrom = [&](int r, int c) {
+        char p = getPiece(room, r, c);
+        MoveTargets dests;
+        if (isKing(p)) {
+            dests = captures ? kingCaptureMoves(room, r, c, side) : kingSimpleMoves(room, r, c);
+        } else {
+            dests = captures ? manCaptureMoves(room, r, c, white, side) : manSimpleMoves(room, r, c, white);
+        }
+        for (auto [tr, tc] : dests) {
+            if (captures && room.maxCaptureRule && !chains.startsLongestChain(r, c, tr, tc)) continue;
+            out.push_back(TestMove{r, c, tr, tc});
+        }
+    };
+
+    if (room.captureLock) {
+        addFrom(room.captureLock->first, room.captureLock->second);
+        return out;
+    }
+    for (int r = 0; r < size; ++r) {
+        for (int c = 0; c < size; ++c) {
+            if (pieceColor(getPiece(room, r, c)) == side) addFrom(r, c);
+        }
+    }
+    return out;
+}
+
+Room startRoom(Variant variant = Variant::CZECH) {
+    Room room;
+    room.variant = variant;
+    room.maxCaptureRule = variantMaxCapture(variant);
+    room.status = RoomStatus::IN_GAME;
+    room.turn = Turn::PLAYER1;
+    room.board = createInitialBoard(variant);
+    room.hash = computePositionHash(room);
+    room.material = computeMaterial(room);
+    return room;
+}
+
+// Náhodné partie všech variant: inkrementální hash a počty kamenů po každém tahu = spočítané od nuly
+void testIncrementalHash() {
+    std::mt19937_64 rng(2024);
+    int positions = 0;
+    for (int game = 0; game < 400; ++game) {
+        Room room = startRoom(ALL_VARIANTS[static_cast<std::size_t>(game) % ALL_VARIANTS.size()]);
+        for (int ply = 0; ply < 300; ++ply) {
+            auto moves = legalMoves(room);
+            if (moves.empty()) break;
+            const TestMove& m = moves[rng() % moves.size()];
+            bool white = room.turn == Turn::PLAYER1;
+            MoveResult result;
+            std::string error = applyMove(room, white, m.fromRow, m.fromCol, m.toRow, m.toCol, result);
+            check(error.empty(), "generated move rejected: " + error);
+            if (!error.empty()) return;
+            ++positions;
+            if (room.hash != computePositionHash(room)) {
+                check(false, variantName(room.variant) + ": incremental hash differs in game " + std::to_string(game) +
+                             " ply " + std::to_string(ply) + " board " + room.board);
+                return;
+            }
+            if (room.material != computeMaterial(room)) {
+                check(false, variantName(room.variant) + ": piece counts differ in game " + std::to_string(game) +
+                             " ply " + std::to_string(ply) + " board " + room.board);
+                return;
+            }
+        }
+    }
+    check(positions > 10000, "too few positions checked: " + std::to_string(positions));
+}
+
+// Strana na tahu i captureLock musí hash změnit
+void testHashComponents() {
+    Room a = startRoom();
+    Room b = a;
+    setTurn(b, Turn::PLAYER2);
+    check(a.hash != b.hash, "side to move not part of hash");
+    setTurn(b, Turn::PLAYER1);
+    check(a.hash == b.hash, "setTurn not reversible");
+
+    setCaptureLock(b, std::make_pair(5, 0));
+    check(a.hash != b.hash, "capture lock not part of hash");
+    setCaptureLock(b, std::nullopt);
+    check(a.hash == b.hash, "setCaptureLock not reversible");
+
+    char piece = getPiece(b, 5, 0);
+    setPiece(b, 5, 0, '.');
+    setPiece(b, 5, 0, piece);
+    check(a.hash == b.hash, "setPiece not reversible");
+    check(b.hash == computePositionHash(b), "hash mismatch after setPiece");
+}
+
+Room roomFromBoard(const std::string& rows, Turn turn, Variant variant = Variant::CZECH) {
+    Room room;
+    room.variant = variant;
+    room.status = RoomStatus::IN_GAME;
+    room.turn = turn;
+    room.board = rows;
+    room.hash = computePositionHash(room);
+    room.material = computeMaterial(room);
+    startPositionHistory(room);
+    return room;
+}
+
+void play(Room& room, int fromRow, int fromCol, int toRow, int toCol) {
+    MoveResult result;
+    std::string error = applyMove(room, room.turn == Turn::PLAYER1, fromRow, fromCol, toRow, toCol, result);
+    check(error.empty(), "move rejected: " + error);
+    recordPosition(room, result);
+}
+
+// Skok, povýšení a undoMove mění Room::material; bez kamenů konec hry bez skenování
+void testMaterialCounts() {
+    std::string board(BOARD * BOARD, '.');
+    board[3 * BOARD + 2] = 'w';
+    board[2 * BOARD + 3] = 'b';
+    board[1 * BOARD + 6] = 'w';
+    Room room = roomFromBoard(board, Turn::PLAYER1);
+    check(room.material == Material{2, 0, 1, 0}, "initial piece counts");
+
+    MoveResult result;
+    playMove(room, 1, 6, 0, 5, result); // jen pro počítadla, jinak by byl povinný skok
+    check(room.material == Material{1, 1, 1, 0}, "promotion not counted");
+    undoMove(room, 1, 6, 0, 5, result);
+    check(room.material == Material{2, 0, 1, 0}, "undoMove did not restore piece counts");
+
+    check(applyMove(room, true, 3, 2, 1, 4, result).empty(), "capture rejected");
+    check(room.material == Material{2, 0, 0, 0}, "capture not counted");
+    check(pieceCount(room, PieceColor::WHITE) == 2 && !hasAnyPiece(room, PieceColor::BLACK),
+          "black should have no pieces left");
+    check(!playerHasAnyMove(room, PieceColor::BLACK), "black without pieces has a move");
+}
+
+// Dvě dámy tahají tam a zpět: potřetí stejná pozice = DRAW_REPETITION
+void testDrawRepetition() {
+    std::string board(BOARD * BOARD, '.');
+    board[7 * BOARD + 2] = 'W';
+    board[0 * BOARD + 1] = 'B';
+    Room room = roomFromBoard(board, Turn::PLAYER1);
+
+    for (int cycle = 0; cycle < 2; ++cycle) {
+        check(drawReason(room).empty(), "draw reported too early");
+        play(room, 7, 2, 6, 1);
+        play(room, 0, 1, 1, 0);
+        play(room, 6, 1, 7, 2);
+        play(room, 1, 0, 0, 1);
+    }
+    check(drawReason(room) == "DRAW_REPETITION", "threefold repetition not detected");
+}
+
+// Tah pěšcem historii nuluje; jinak po NO_PROGRESS_LIMIT tazích dámami remíza
+void testDrawNoProgress() {
+    std::string board(BOARD * BOARD, '.');
+    board[7 * BOARD + 2] = 'W';
+    board[5 * BOARD + 6] = 'w';
+    board[0 * BOARD + 1] = 'B';
+    Room room = roomFromBoard(board, Turn::PLAYER1);
+
+    room.noProgressPlies = NO_PROGRESS_LIMIT - 2;
+    play(room, 5, 6, 4, 7); // pěšec
+    check(room.noProgressPlies == 0 && room.positionHistory.size() == 1, "man move did not reset draw counters");
+
+    room.noProgressPlies = NO_PROGRESS_LIMIT - 1;
+    play(room, 0, 1, 1, 0);
+    check(drawReason(room) == "DRAW_NO_PROGRESS", "no-progress draw not detected");
+}
+
+// Každý řetěz z CaptureChainGenerator jde přes applyMove odehrát celý a skončí bez captureLock
+void testChainsReplayable() {
+    std::mt19937_64 rng(77);
+    CaptureChainGenerator gen;
+    std::size_t chainsChecked = 0;
+    for (int game = 0; game < 100; ++game) {
+        Room room = startRoom(ALL_VARIANTS[static_cast<std::size_t>(game) % ALL_VARIANTS.size()]);
+        room.maxCaptureRule = false; // odehrát jde každý řetěz, ne jen nejdelší
+        for (int ply = 0; ply < 200; ++ply) {
+            if (!room.captureLock && gen.generate(room) > 0) {
+                for (std::size_t i = 0; i < gen.size(); ++i) {
+                    auto chain = gen.chain(i);
+                    Room trial = room;
+                    bool white = trial.turn == Turn::PLAYER1;
+                    MoveResult result;
+                    for (std::size_t k = 1; k < chain.size(); ++k) {
+                        std::string error = applyMove(trial, white, chain[k - 1].first, chain[k - 1].second,
+                                                      chain[k].first, chain[k].second, result);
+                        if (!error.empty()) {
+                            check(false, "chain hop rejected: " + error + " board " + room.board);
+                            return;
+                        }
+                    }
+                    check(!trial.captureLock.has_value(), "chain ends with capture lock, board " + room.board);
+                    ++chainsChecked;
+                }
+            }
+            auto moves = legalMoves(room);
+            if (moves.empty()) break;
+            const TestMove& m = moves[rng() % moves.size()];
+            MoveResult result;
+            applyMove(room, room.turn == Turn::PLAYER1, m.fromRow, m.fromCol, m.toRow, m.toCol, result);
+        }
+    }
+    check(chainsChecked > 1000, "too few chains checked: " + std::to_string(chainsChecked));
+}
+
+// Dvojskok 5,0 -> 3,2 -> 1,4 proti jednoduchému skoku 7,6 -> 5,4
+void testMaxCapture() {
+    std::string board(BOARD * BOARD, '.');
+    board[5 * BOARD + 0] = 'w';
+    board[4 * BOARD + 1] = 'b';
+    board[2 * BOARD + 3] = 'b';
+    board[7 * BOARD + 6] = 'w';
+    board[6 * BOARD + 5] = 'b';
+    board[0 * BOARD + 7] = 'b';
+    Room room = roomFromBoard(board, Turn::PLAYER1);
+
+    CaptureChainGenerator gen;
+    check(gen.generate(room) == 2, "expected two capture chains");
+    check(gen.maxHops() == 2, "longest chain should have two hops");
+    check(gen.startsLongestChain(5, 0, 3, 2), "double jump not recognised as longest");
+    check(!gen.startsLongestChain(7, 6, 5, 4), "single jump marked as longest");
+    check(gen.generate(room, 7, 6) == 1 && gen.maxHops() == 1, "start filter ignored");
+
+    MoveResult result;
+    Room free = room;
+    check(applyMove(free, true, 7, 6, 5, 4, result).empty(), "shorter capture rejected without the rule");
+
+    room.maxCaptureRule = true;
+    Room strict = room;
+    check(applyMove(strict, true, 7, 6, 5, 4, result) == "MUST_CAPTURE_MAX", "shorter capture accepted under the rule");
+    check(applyMove(strict, true, 5, 0, 3, 2, result).empty(), "longest chain rejected");
+    check(strict.captureLock == std::make_pair(3, 2), "capture lock missing after first hop");
+    check(applyMove(strict, true, 3, 2, 1, 4, result).empty(), "second hop rejected");
+    check(!strict.captureLock && strict.turn == Turn::PLAYER2, "turn not passed after the chain");
+}
+
+// Počáteční rozestavení podle velikosti desky varianty
+void testVariantSetup() {
+    for (Variant v : ALL_VARIANTS) {
+        std::string board = createInitialBoard(v);
+        int size = variantBoardSize(v);
+        int perSide = size == 10 ? 20 : 12;
+        check(board.size() == static_cast<std::size_t>(size * size), variantName(v) + ": wrong board size");
+        check(std::count(board.begin(), board.end(), 'w') == perSide, variantName(v) + ": wrong white men count");
+        check(std::count(board.begin(), board.end(), 'b') == perSide, variantName(v) + ": wrong black men count");
+        check(parseVariant(variantName(v)) == v, variantName(v) + ": name does not round-trip");
+    }
+    check(!parseVariant("checkers").has_value(), "unknown variant accepted");
+}
+
+// Pěšec skáče dozadu jen v ruské a mezinárodní dámě
+void testBackwardManCapture() {
+    std::string board(BOARD * BOARD, '.');
+    board[3 * BOARD + 2] = 'w';
+    board[4 * BOARD + 3] = 'b';
+    board[0 * BOARD + 7] = 'b';
+
+    MoveResult result;
+    Room czech = roomFromBoard(board, Turn::PLAYER1, Variant::CZECH);
+    check(!playerHasAnyCapture(czech, PieceColor::WHITE), "czech man captures backward");
+    check(applyMove(czech, true, 3, 2, 5, 4, result) == "INVALID_DIRECTION", "czech backward capture accepted");
+
+    Room russian = roomFromBoard(board, Turn::PLAYER1, Variant::RUSSIAN);
+    check(playerHasAnyCapture(russian, PieceColor::WHITE), "russian backward capture not found");
+    check(applyMove(russian, true, 3, 2, 2, 1, result) == "MUST_CAPTURE", "russian simple move while capture available");
+    check(applyMove(russian, true, 3, 2, 5, 4, result).empty(), "russian backward capture rejected");
+    check(result.capture && getPiece(russian, 4, 3) == '.', "russian backward capture did not remove the piece");
+}
+
+// Italská dáma: krátká dáma a pěšec nesmí přeskočit dámu
+void testItalianRules() {
+    std::string board(BOARD * BOARD, '.');
+    board[7 * BOARD + 0] = 'W';
+    board[5 * BOARD + 2] = 'w';
+    board[4 * BOARD + 3] = 'B';
+
+    Room czech = roomFromBoard(board, Turn::PLAYER1, Variant::CZECH);
+    Room italian = roomFromBoard(board, Turn::PLAYER1, Variant::ITALIAN);
+    check(kingSimpleMoves(czech, 7, 0).size() == 1, "czech king should be blocked after one square");
+    check(manCaptureMoves(czech, 5, 2, true, PieceColor::WHITE).size() == 1, "czech man cannot capture a king");
+    check(manCaptureMoves(italian, 5, 2, true, PieceColor::WHITE).empty(), "italian man captures a king");
+    check(!playerHasAnyCapture(italian, PieceColor::WHITE), "italian capture reported");
+
+    MoveResult result;
+    check(applyMove(italian, true, 5, 2, 3, 4, result) == "MAN_CANNOT_CAPTURE_KING", "italian man took a king");
+
+    std::string open(BOARD * BOARD, '.');
+    open[7 * BOARD + 0] = 'W';
+    open[0 * BOARD + 7] = 'B';
+    Room flying = roomFromBoard(open, Turn::PLAYER1, Variant::CZECH);
+    Room shortKing = roomFromBoard(open, Turn::PLAYER1, Variant::ITALIAN);
+    check(kingSimpleMoves(flying, 7, 0).size() == 6, "czech king does not fly");
+    check(kingSimpleMoves(shortKing, 7, 0).size() == 1, "italian king flies");
+    check(applyMove(shortKing, true, 7, 0, 5, 2, result) == "NO_OPPONENT_TO_CAPTURE", "italian king moved two squares");
+    check(applyMove(shortKing, true, 7, 0, 4, 3, result) == "INVALID_MOVE", "italian king moved three squares");
+}
+
+// Pěšec doskočí na poslední řadu a může skákat dál (dozadu): povýšení podle varianty
+void testPromotionDuringCapture() {
+    auto position = [](Variant v) {
+        int size = variantBoardSize(v);
+        std::string board(static_cast<std::size_t>(size * size), '.');
+        board[2 * size + 1] = 'w';
+        board[1 * size + 2] = 'b';
+        board[1 * size + 4] = 'b';
+        board[(size - 1) * size + 0] = 'w';
+        return roomFromBoard(board, Turn::PLAYER1, v);
+    };
+    MoveResult result;
+
+    Room russian = position(Variant::RUSSIAN);
+    check(applyMove(russian, true, 2, 1, 0, 3, result).empty(), "russian capture rejected");
+    check(result.promoted && russian.captureLock.has_value(), "russian man should promote and continue");
+
+    Room international = position(Variant::INTERNATIONAL);
+    international.maxCaptureRule = true;
+    check(applyMove(international, true, 2, 1, 0, 3, result).empty(), "international capture rejected");
+    check(!result.promoted && getPiece(international, 0, 3) == 'w', "international man promoted mid-chain");
+    check(applyMove(international, true, 0, 3, 2, 5, result).empty(), "international continuation rejected");
+    check(!result.promoted && getPiece(international, 2, 5) == 'w' && international.turn == Turn::PLAYER2,
+          "international chain should end as a man");
+
+    Room italian = position(Variant::ITALIAN);
+    check(applyMove(italian, true, 2, 1, 0, 3, result).empty(), "italian capture rejected");
+    check(result.promoted && !italian.captureLock && italian.turn == Turn::PLAYER2, "italian promotion should end the move");
+}
+
+// Referenční generátor tahů krokováním po diagonále (inBoard/isDarkSquare v každém kroku),
+// proti kterému se ověřují tabulky z rays.hpp
+template <class R>
+std::vector<std::pair<int, int>> referenceMoves(const Room& room, int row, int col, char piece, bool captures) {
+    std::vector<std::pair<int, int>> out;
+    bool king = isKing(piece);
+    bool white = pieceColor(piece) == PieceColor::WHITE;
+    auto onDark = [](int r, int c) { return R::inBoard(r, c) && isDarkSquare(r, c); };
+    auto at = [&](int r, int c) { return room.board[r * R::size + c]; };
+    auto enemy = [&](char target) {
+        PieceColor other = pieceColor(target);
+        if (other == PieceColor::NONE || other == pieceColor(piece)) return false;
+        return R::menCaptureKings || king || !isKing(target);
+    };
+
+    for (auto [dr, dc] : KING_DIRECTIONS) {
+        bool forward = white ? dr < 0 : dr > 0;
+        if (!king && !forward && !(captures && R::menCaptureBackward)) continue;
+        bool flying = king && R::flyingKings;
+        if (!captures) {
+            for (int r = row + dr, c = col + dc; onDark(r, c) && at(r, c) == '.'; r += dr, c += dc) {
+                out.emplace_back(r, c);
+                if (!flying) break;
+            }
+        } else if (!flying) {
+            if (onDark(row + 2 * dr, col + 2 * dc) && at(row + 2 * dr, col + 2 * dc) == '.' &&
+                enemy(at(row + dr, col + dc))) {
+                out.emplace_back(row + 2 * dr, col + 2 * dc);
+            }
+        } else {
+            bool enemyFound = false;
+            for (int r = row + dr, c = col + dc; onDark(r, c); r += dr, c += dc) {
+                char cur = at(r, c);
+                if (cur == '.') {
+                    if (enemyFound) out.emplace_back(r, c);
+                } else if (pieceColor(cur) == pieceColor(piece) || enemyFound) {
+                    break;
+                } else {
+                    enemyFound = true;
+                }
+            }
+        }
+    }
+    return out;
+}
+
+std::vector<std::pair<int, int>> sortedSquares(const MoveTargets& targets) {
+    std::vector<std::pair<int, int>> out(targets.begin(), targets.end());
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+// Náhodné pozice všech variant: generátory nad tabulkami = referenční krokování
+void testRayTablesMatchReference() {
+    std::mt19937_64 rng(32);
+    std::size_t squaresChecked = 0;
+    for (Variant v : ALL_VARIANTS) {
+        withVariantRules(v, [&](auto rules) {
+            using R = decltype(rules);
+            for (int position = 0; position < 2000; ++position) {
+                Room room;
+                room.variant = v;
+                room.board.assign(R::squares, '.');
+                int density = 15 + static_cast<int>(rng() % 60);
+                for (int idx = 0; idx < R::squares; ++idx) {
+                    if (!isDarkSquare(idx / R::size, idx % R::size)) continue;
+                    if (static_cast<int>(rng() % 100) >= density) continue;
+                    room.board[idx] = "wWbB"[rng() % 4];
+                }
+                room.material = computeMaterial(room);
+
+                bool anyCapture[2] = {false, false};
+                bool anySimple[2] = {false, false};
+                for (int r = 0; r < R::size; ++r) {
+                    for (int c = 0; c < R::size; ++c) {
+                        char p = getPiece(room, r, c);
+                        if (p == '.') continue;
+                        bool white = pieceColor(p) == PieceColor::WHITE;
+                        auto captures = referenceMoves<R>(room, r, c, p, true);
+                        auto simple = referenceMoves<R>(room, r, c, p, false);
+                        auto gotCaptures = sortedSquares(isKing(p) ? kingCaptureMoves(room, r, c, pieceColor(p))
+                                                                   : manCaptureMoves(room, r, c, white, pieceColor(p)));
+                        auto gotSimple = sortedSquares(isKing(p) ? kingSimpleMoves(room, r, c)
+                                                                 : manSimpleMoves(room, r, c, white));
+                        std::sort(captures.begin(), captures.end());
+                        std::sort(simple.begin(), simple.end());
+                        if (captures != gotCaptures || simple != gotSimple ||
+                            canCaptureFrom(room, r, c, p) != !captures.empty()) {
+                            check(false, variantName(v) + ": ray tables differ at " + std::to_string(r) + "," +
+                                         std::to_string(c) + " board " + room.board);
+                            return;
+                        }
+                        anyCapture[white] = anyCapture[white] || !captures.empty();
+                        anySimple[white] = anySimple[white] || !simple.empty();
+                        ++squaresChecked;
+                    }
+                }
+                for (bool white : {false, true}) {
+                    PieceColor color = white ? PieceColor::WHITE : PieceColor::BLACK;
+                    check(playerHasAnyCapture(room, color) == anyCapture[white], variantName(v) + ": playerHasAnyCapture differs");
+                    check(playerHasAnySimpleMove(room, color) == anySimple[white], variantName(v) + ": playerHasAnySimpleMove differs");
+                }
+            }
+        });
+    }
+    check(squaresChecked > 100000, "too few squares checked: " + std::to_string(squaresChecked));
+}
+
+// Ověření tahu, generátory a konec partie bez alokací. Generátor řetězů v applyMove
+// (povinný nejdelší skok) má buffery zahřáté stejným tahem na kopii pozice.
+void testAllocationFree() {
+    std::mt19937_64 rng(33);
+    int checkedPlies = 0;
+    for (int game = 0; game < 120; ++game) {
+        Room room = startRoom(ALL_VARIANTS[static_cast<std::size_t>(game) % ALL_VARIANTS.size()]);
+        for (int ply = 0; ply < 200; ++ply) {
+            auto moves = legalMoves(room);
+            if (moves.empty()) break;
+            const TestMove& m = moves[rng() % moves.size()];
+            bool white = room.turn == Turn::PLAYER1;
+            Room warm = room;
+            MoveResult warmResult;
+            applyMove(warm, white, m.fromRow, m.fromCol, m.toRow, m.toCol, warmResult);
+
+            std::size_t before = allocationCount;
+            MoveResult result;
+            std::string error = applyMove(room, white, m.fromRow, m.fromCol, m.toRow, m.toCol, result);
+            PieceColor next = room.turn == Turn::PLAYER1 ? PieceColor::WHITE : PieceColor::BLACK;
+            bool over = !hasAnyPiece(room, next) || !playerHasAnyMove(room, next);
+            std::size_t targets = 0;
+            for (int r = 0; r < boardSize(room); ++r) {
+                for (int c = 0; c < boardSize(room); ++c) {
+                    char p = getPiece(room, r, c);
+                    if (p == '.') continue;
+                    PieceColor color = pieceColor(p);
+                    bool pieceWhite = color == PieceColor::WHITE;
+                    targets += isKing(p) ? kingCaptureMoves(room, r, c, color).size() + kingSimpleMoves(room, r, c).size()
+                                         : manCaptureMoves(room, r, c, pieceWhite, color).size() +
+                                           manSimpleMoves(room, r, c, pieceWhite).size();
+                }
+            }
+            std::size_t allocated = allocationCount - before;
+
+            check(error.empty(), variantName(room.variant) + ": legal move rejected: " + error);
+            if (allocated != 0) {
+                check(false, variantName(room.variant) + ": " + std::to_string(allocated) +
+                             " allocation(s) validating a move, board " + room.board);
+                return;
+            }
+            ++checkedPlies;
+            if (over || targets == 0) break;
+        }
+    }
+    check(checkedPlies > 5000, "too few plies checked: " + std::to_string(checkedPlies));
+}
+
+// Hledání s transpoziční tabulkou dává v pevné hloubce stejné skóre jako bez ní;
+// druhý dotaz na stejnou pozici vrátí tabulka bez hledání, s legální hlavní variantou
+void testTranspositionSearch() {
+    std::mt19937_64 rng(35);
+    TranspositionTable table(1);
+    int compared = 0;
+    for (int game = 0; game < 60; ++game) {
+        Room room = startRoom(ALL_VARIANTS[static_cast<std::size_t>(game) % ALL_VARIANTS.size()]);
+        int plies = 6 + static_cast<int>(rng() % 30);
+        for (int ply = 0; ply < plies; ++ply) {
+            auto moves = legalMoves(room);
+            if (moves.empty()) break;
+            const TestMove& m = moves[rng() % moves.size()];
+            MoveResult result;
+            applyMove(room, room.turn == Turn::PLAYER1, m.fromRow, m.fromCol, m.toRow, m.toCol, result);
+        }
+        if (legalMoves(room).size() < 2) continue;
+
+        SearchLimits limits{4, 0, 0};
+        SearchResult plain = searchBestMove(room, limits);
+        SearchResult withTable = searchBestMove(room, limits, &table);
+        std::string where = variantName(room.variant) + " board " + room.board;
+        check(plain.depth == 4 && withTable.depth == 4, "search did not finish depth 4: " + where);
+        check(plain.score == withTable.score, "table changed the score " + std::to_string(plain.score) + " -> " +
+                                              std::to_string(withTable.score) + ": " + where);
+
+        auto cached = tableResult(room, 4, table);
+        check(cached.has_value(), "searched position not in table: " + where);
+        if (cached) {
+            check(cached->score == withTable.score && cached->pv.size() >= 1, "cached result differs: " + where);
+            Room replay = room;
+            for (const BotMove& m : cached->pv) {
+                MoveResult result;
+                std::string error = applyMove(replay, replay.turn == Turn::PLAYER1,
+                                              m.fromRow, m.fromCol, m.toRow, m.toCol, result);
+                if (!error.empty()) {
+                    check(false, "principal variation not playable (" + error + "): " + where);
+                    break;
+                }
+            }
+        }
+        check(!tableResult(room, 5, table).has_value(), "table answered deeper than searched: " + where);
+        ++compared;
+    }
+    check(compared > 30, "too few positions compared: " + std::to_string(compared));
+
+    // vynucený tah: bot s tabulkou hraje hned (bez hledání), rozbor ho prohledá kvůli skóre
+    int forced = 0;
+    for (int game = 0; game < 200 && forced < 5; ++game) {
+        Room room = startRoom(ALL_VARIANTS[static_cast<std::size_t>(game) % ALL_VARIANTS.size()]);
+        for (int ply = 0; ply < 80; ++ply) {
+            auto moves = legalMoves(room);
+            if (moves.empty()) break;
+            if (moves.size() == 1) {
+                SearchResult bot = searchBestMove(room, botLimitsForLevel(5), &table);
+                SearchResult scored = searchBestMove(room, SearchLimits{3, 0, 0, true}, &table);
+                check(bot.found && bot.nodes == 0 && bot.depth == 0 && scored.found && scored.depth == 3,
+                      "forced move searched by the bot: " + room.board);
+                ++forced;
+                break;
+            }
+            const TestMove& m = moves[rng() % moves.size()];
+            MoveResult result;
+            applyMove(room, room.turn == Turn::PLAYER1, m.fromRow, m.fromCol, m.toRow, m.toCol, result);
+        }
+    }
+    check(forced > 0, "no forced position found");
+
+    TableEntry e{-SCORE_WIN + 7, 31, Bound::UPPER, 99, 88};
+    table.store(0x123456789ABCDEFULL, e);
+    TableEntry back;
+    check(table.probe(0x123456789ABCDEFULL, back) && back.score == e.score && back.depth == 31 &&
+          back.bound == Bound::UPPER && back.fromSquare == 99 && back.toSquare == 88, "table entry round trip");
+    check(!table.probe(0x123456789ABCDEFULL ^ (1ULL << 60), back), "probe hit for another key");
+}
+
+// Databáze koncovek z generátoru přes soubor a mmap: index tam a zpět, hodnota = nejlepší
+// následník a výhry/prohry na pár tahů najde i hledání bez databáze
+void testTablebase() {
+    char path[] = "/tmp/dama_tablebase_XXXXXX";
+    int fd = mkstemp(path);
+    check(fd >= 0, "cannot create temporary tablebase file");
+    if (fd < 0) return;
+    close(fd);
+    std::string error;
+    check(generateTablebase(Variant::CZECH, false, 3, path, error), "tablebase generation failed: " + error);
+    auto tablebase = Tablebase::open(path, error);
+    std::remove(path); // mapování platí i po smazání souboru
+    check(tablebase != nullptr, "tablebase did not open: " + error);
+    if (!tablebase) return;
+    check(tablebase->maxPieces() == 3 && tablebase->variant() == Variant::CZECH, "tablebase header");
+    TablebaseSet tablebases;
+    tablebases.add(std::move(tablebase));
+
+    // bílá dáma přeskočí jedinou černou dámu
+    Room capture = roomFromBoard(
+        "........"
+        "..B....."
+        ".W.W...."
+        "........"
+        "........"
+        "........"
+        "........"
+        "........", Turn::PLAYER1);
+    check(tablebases.probe(capture) == TablebaseValue{TablebaseOutcome::WIN, 1}, "immediate capture not a win in 1");
+    SearchResult root = searchBestMove(capture, SearchLimits{4, 0, 0}, nullptr, &tablebases);
+    check(root.found && root.tablebase == TablebaseValue{TablebaseOutcome::WIN, 1} && root.move.toRow == 0,
+          "search did not take the tablebase move");
+    check(!tablebases.probe(startRoom()).has_value(), "start position found in a 3-piece tablebase");
+
+    std::mt19937 rng(36);
+    TranspositionTable table(1); // s tabulkou hledání neodpoví na jediný tah bez skóre
+    const TablebaseMaterial materials[] = {{0, 2, 0, 1}, {1, 0, 0, 1}, {1, 1, 1, 0}, {0, 1, 1, 1}, {2, 0, 1, 0}};
+    Room room = startRoom();
+    int checked = 0;
+    int searched = 0;
+    for (const auto& material : materials) {
+        for (int i = 0; i < 300; ++i) {
+            std::uint64_t index = rng() % tablebaseEntries(material);
+            if (!tablebasePosition(material, index, room)) continue;
+            check(tablebaseIndex(room) == index, "tablebase index round trip, board " + room.board);
+            auto value = tablebases.probe(room);
+            auto best = tablebaseBestMoves(tablebases, room);
+            if (!value) {
+                check(false, "position missing in tablebase, board " + room.board);
+                continue;
+            }
+            if (!best) {
+                check(*value == TablebaseValue{TablebaseOutcome::LOSS, 0} && legalMoves(room).empty(),
+                      "tablebase position without moves, board " + room.board);
+                continue;
+            }
+            std::string where = formatTablebaseValue(*value) + " board " + room.board;
+            check(*value == best->value, "tablebase value differs from its successors: " + where);
+            ++checked;
+
+            if (value->moves > 3) continue;
+            int depth = value->outcome == TablebaseOutcome::DRAW ? 4 : 2 * value->moves;
+            SearchResult search = searchBestMove(room, SearchLimits{depth, 0, 0, true}, &table);
+            bool won = search.score >= SCORE_WIN - MAX_SEARCH_PLY;
+            bool lost = search.score <= -SCORE_WIN + MAX_SEARCH_PLY;
+            switch (value->outcome) {
+                case TablebaseOutcome::WIN:  check(won, "search misses tablebase win: " + where); break;
+                case TablebaseOutcome::LOSS: check(lost, "search misses tablebase loss: " + where); break;
+                case TablebaseOutcome::DRAW: check(!won && !lost, "search decides tablebase draw: " + where); break;
+            }
+            ++searched;
+        }
+    }
+    check(checked > 500 && searched > 200, "too few tablebase positions checked: " + std::to_string(checked) +
+                                           "/" + std::to_string(searched));
+}
+
+} // namespace
+
+// Kniha zahájení: log partií -> kniha, přírůstkové přestavění nad předchozí knihou a výběr kroku
+void testOpeningBook() {
+    check(bookGameResult("WHITE_WIN_NO_MOVES", "WHITE") == 'W' && bookGameResult("DRAW_REPETITION", "NONE") == 'D' &&
+              !bookGameResult("OPPONENT_LEFT", "BLACK") && !bookGameResult("TURN_TIMEOUT", "WHITE"),
+          "book game results");
+
+    std::string paths[3];
+    for (auto& path : paths) {
+        char name[] = "/tmp/dama_book_XXXXXX";
+        int fd = mkstemp(name);
+        check(fd >= 0, "cannot create temporary book file");
+        if (fd < 0) return;
+        close(fd);
+        path = name;
+    }
+    const std::string& firstLog = paths[0];
+    const std::string& secondLog = paths[1];
+    const std::string& bookPath = paths[2];
+
+    Room start = startRoom();
+    auto first = legalMoves(start);
+    check(first.size() >= 2, "start position has fewer than two moves");
+    if (first.size() < 2) return;
+    auto step = [](const Room& from, const TestMove& m) {
+        return GameStep{tableKey(from), static_cast<std::uint8_t>(m.fromRow * MAX_BOARD_SIZE + m.fromCol),
+                           static_cast<std::uint8_t>(m.toRow * MAX_BOARD_SIZE + m.toCol), from.turn == Turn::PLAYER1};
+    };
+    Room afterA = start;
+    MoveResult result;
+    applyMove(afterA, true, first[0].fromRow, first[0].fromCol, first[0].toRow, first[0].toCol, result);
+    TestMove reply = legalMoves(afterA).front();
+
+    Room game = start;
+    game.steps = {step(start, first[0]), step(afterA, reply)};
+    std::string lineA = bookLogLine(game, 'W');
+    game.steps = {step(start, first[1])};
+    std::string lineB = bookLogLine(game, 'D');
+    {
+        std::ofstream log(firstLog);
+        log << lineA << "\n" << lineA << "\n" << lineB << "\n";
+    }
+
+    std::size_t games = 0;
+    std::string error;
+    check(buildOpeningBook({firstLog}, "", bookPath, games, error) && games == 3, "book build failed: " + error);
+    {
+        auto book = OpeningBook::open(bookPath, error);
+        check(book != nullptr && book->size() == 3, "book did not open: " + error);
+        if (!book) return;
+        auto moves = book->moves(tableKey(start));
+        check(moves.size() == 2, "book moves from the start position");
+        for (const auto& e : moves) {
+            bool isA = e.fromSquare == first[0].fromRow * MAX_BOARD_SIZE + first[0].fromCol &&
+                       e.toSquare == first[0].toRow * MAX_BOARD_SIZE + first[0].toCol;
+            check(isA ? (e.games == 2 && e.wins == 2 && e.draws == 0) : (e.games == 1 && e.draws == 1),
+                  "book counts after the first log");
+        }
+        check(!bookMove(*book, start), "book played a step from fewer than BOOK_MIN_GAMES games");
+    }
+
+    // druhý log přičtený k předchozí knize, výstup přes stejný soubor
+    {
+        std::ofstream log(secondLog);
+        game.steps = {step(start, first[0]), step(afterA, reply)};
+        log << bookLogLine(game, 'B') << "\nczech X garbage\n";
+    }
+    check(buildOpeningBook({secondLog}, bookPath, bookPath, games, error) && games == 1,
+          "incremental book build failed: " + error);
+    auto book = OpeningBook::open(bookPath, error);
+    for (const auto& path : paths) std::remove(path.c_str());
+    check(book != nullptr, "rebuilt book did not open: " + error);
+    if (!book) return;
+    auto chosen = bookMove(*book, start);
+    check(chosen && chosen->games == 3 && chosen->wins == 2 && chosen->scorePermille() == 666,
+          "book step from the start position");
+    auto answer = bookResult(afterA, *book);
+    check(answer && answer->book && answer->book->wins == 1 && answer->move.fromRow == reply.fromRow &&
+              answer->move.toCol == reply.toCol,
+          "book reply for black");
+    check(!bookMove(*book, startRoom(Variant::RUSSIAN)), "book step found in another variant");
+}
+
+// Náhodná partie pro archiv: kroky s časy a desky po každém kroku
+ArchivedGame randomArchivedGame(Variant variant, std::mt19937& rng, std::vector<std::string>& boards) {
+    ArchivedGame game;
+    game.variant = variant;
+    game.maxCaptureRule = variantMaxCapture(variant);
+    Room room = startRoom(variant);
+    boards = {room.board};
+    for (int ply = 0; ply < 80; ++ply) {
+        auto moves = legalMoves(room);
+        if (moves.empty()) break;
+        const TestMove& m = moves[rng() % moves.size()];
+        bool white = room.turn == Turn::PLAYER1;
+        game.steps.push_back(GameStep{0, static_cast<std::uint8_t>(m.fromRow * MAX_BOARD_SIZE + m.fromCol),
+                                      static_cast<std::uint8_t>(m.toRow * MAX_BOARD_SIZE + m.toCol), white,
+                                      static_cast<std::uint32_t>(1500 * (ply + 1))});
+        MoveResult result;
+        applyMove(room, white, m.fromRow, m.fromCol, m.toRow, m.toCol, result);
+        boards.push_back(room.board);
+    }
+    game.reason = "WHITE_WIN_NO_MOVES";
+    game.winner = "WHITE";
+    return game;
+}
+
+// Archiv partií: zápis, index po hráčích a dnech, znovuotevření, useknutý záznam a PDN
+void testGameArchive() {
+    char dirTemplate[] = "/tmp/dama_archive_XXXXXX";
+    check(mkdtemp(dirTemplate) != nullptr, "cannot create temporary archive directory");
+    const std::string dir = dirTemplate;
+    const std::string segment = dir + "/segment-000001.dga";
+    std::int64_t day = *parseArchiveDay("2026-10-18");
+    check(formatArchiveDay(day) == "2026-10-18" && !parseArchiveDay("2026-02-30"), "archive day round trip");
+
+    std::mt19937 rng(38);
+    std::vector<std::string> boards;
+    ArchivedGame first = randomArchivedGame(Variant::CZECH, rng, boards);
+    first.white = "alice";
+    first.black = "bob";
+    first.startedMs = day * 86400000 + 3600000;
+    std::string error;
+    {
+        auto archive = GameArchive::open(dir, false, error);
+        check(archive != nullptr, "archive did not open: " + error);
+        if (!archive) return;
+        check(archive->append(first, error) == 1u, "first game id");
+        ArchivedGame second = first;
+        second.reason = "DRAW_REPETITION";
+        second.winner = "NONE";
+        check(archive->append(second, error) == 2u, "second game id");
+        std::vector<std::string> unused;
+        ArchivedGame third = randomArchivedGame(Variant::INTERNATIONAL, rng, unused);
+        third.white = "carol";
+        third.black = "alice";
+        third.startedMs = (day + 1) * 86400000;
+        check(archive->append(third, error) == 3u, "third game id");
+    }
+
+    auto archive = GameArchive::open(dir, true, error);
+    check(archive != nullptr && archive->size() == 3, "reopened archive: " + error);
+    if (!archive) return;
+    check((archive->gamesOf("alice", 0, 10) == std::vector<std::uint64_t>{3, 2, 1}) &&
+              (archive->gamesOf("alice", 3, 1) == std::vector<std::uint64_t>{2}) &&
+              (archive->gamesOf("bob", 0, 10) == std::vector<std::uint64_t>{2, 1}) &&
+              (archive->gamesOn(day, 0, 10) == std::vector<std::uint64_t>{2, 1}) &&
+              (archive->gamesOn(day + 1, 0, 10) == std::vector<std::uint64_t>{3}) &&
+              archive->gamesOf("dave", 0, 10).empty(),
+          "archive index by player and day");
+
+    auto game = archive->read(1);
+    check(game && game->white == "alice" && game->black == "bob" && game->reason == first.reason &&
+              game->startedMs == first.startedMs && game->steps.size() == first.steps.size(),
+          "archived game header");
+    if (!game) return;
+    Room room;
+    for (std::size_t ply = 0; ply < boards.size(); ++ply) {
+        check(replayArchivedGame(*game, ply, room) && room.board == boards[ply],
+              "archived game replay differs at ply " + std::to_string(ply));
+        if (ply > 0) check(game->steps[ply - 1].atMs == first.steps[ply - 1].atMs, "archived step time");
+    }
+
+    std::string pdn = exportPdn(*game);
+    check(pdn.find("[White \"alice\"]") != std::string::npos && pdn.find("[GameType \"29\"]") != std::string::npos &&
+              pdn.find("1. ") != std::string::npos && pdn.size() > 2 && pdn.substr(pdn.size() - 4) == "2-0\n",
+          "PDN export of a Czech game:\n" + pdn);
+    ArchivedGame opening = *game;
+    opening.steps = {GameStep{0, 5 * MAX_BOARD_SIZE + 2, 4 * MAX_BOARD_SIZE + 3, true, 0}};
+    check(exportPdn(opening).find("1. c3-d4 ") != std::string::npos, "PDN algebraic square names");
+    opening.variant = Variant::INTERNATIONAL;
+    opening.steps = {GameStep{0, 6 * MAX_BOARD_SIZE + 1, 5 * MAX_BOARD_SIZE + 0, true, 0}};
+    check(exportPdn(opening).find("1. 31-26 ") != std::string::npos, "PDN numeric square names");
+    opening.steps[0].toSquare = 4 * MAX_BOARD_SIZE + 0;
+    check(exportPdn(opening).empty(), "PDN of an illegal game");
+    archive.reset();
+
+    // pád uprostřed zápisu: useknutý poslední záznam se při otevření zahodí a přepíše
+    auto recordSize = [](const ArchivedGame& g) {
+        return 16 + 30 + g.reason.size() + g.winner.size() + g.white.size() + g.black.size() + 6 * g.steps.size();
+    };
+    ArchivedGame second = *GameArchive::open(dir, true, error)->read(2);
+    {
+        int fd = ::open(segment.c_str(), O_RDWR);
+        char junk = 0x55;
+        off_t third = static_cast<off_t>(recordSize(first) + recordSize(second));
+        check(fd >= 0 && pwrite(fd, &junk, 1, third + 16 + 40) == 1, "cannot damage the archive segment");
+        if (fd >= 0) close(fd);
+    }
+    auto damaged = GameArchive::open(dir, false, error);
+    check(damaged != nullptr && damaged->size() == 2, "damaged last record not treated as the archive end");
+    if (damaged) {
+        check(damaged->append(first, error) == 3u && damaged->gamesOf("carol", 0, 10).empty(),
+              "append over a damaged record");
+    }
+    damaged.reset();
+    auto recovered = GameArchive::open(dir, true, error);
+    check(recovered && recovered->size() == 3 && recovered->read(3)->white == "alice", "archive after recovery");
+
+    std::remove(segment.c_str());
+    rmdir(dir.c_str());
+}
+
+void testMatchmaking() {
+    check(eloExpected(1500, 1500) == 0.5 && eloUpdate(PlayerRating{}, 1500, 1.0) == 1520 &&
+              eloUpdate(PlayerRating{1500, RATING_PROVISIONAL_GAMES}, 1500, 0.0) == 1490,
+          "Elo update with provisional K");
+
+    RatingTable ratings;
+    Room room;
+    room.whiteNick = "alice";
+    room.blackNick = "bob";
+    ratings.gameFinished(room, "WHITE_WIN_NO_PIECES", "WHITE");
+    check(ratings.get("alice").rating == 1520 && ratings.get("bob").rating == 1480 && ratings.get("bob").games == 1,
+          "rating after a win");
+    ratings.gameFinished(room, "DRAW_REPETITION", "NONE");
+    check(ratings.get("alice").rating < 1520 && ratings.get("bob").rating > 1480, "draw moves ratings together");
+    int alice = ratings.get("alice").rating;
+    ratings.gameFinished(room, "OPPONENT_LEFT", "NONE");
+    room.botLevel = 2;
+    ratings.gameFinished(room, "WHITE_WIN_NO_PIECES", "WHITE");
+    check(ratings.get("alice").rating == alice && ratings.get("alice").games == 2,
+          "games without a result or against a bot are not rated");
+
+    using namespace std::chrono_literals;
+    seedServerRandom(40);
+    auto t0 = std::chrono::steady_clock::time_point{} + 1h;
+    auto everyone = [](const std::string&) { return true; };
+    MatchQueue queue;
+    queue.enqueue("a", 1500, Variant::CZECH, false, t0);
+    queue.enqueue("b", 1700, Variant::CZECH, false, t0);
+    queue.enqueue("c", 1500, Variant::RUSSIAN, false, t0);
+    check(queue.pairUp(t0, 10, everyone).empty() && queue.size() == 3, "rating gap beyond the initial window");
+    queue.enqueue("a", 1500, Variant::CZECH, false, t0 + 30s);
+    auto pairs = queue.pairUp(t0 + 20s, 10, everyone);
+    check(pairs.size() == 1 && queue.size() == 1 && queue.contains("c") &&
+              ((pairs[0].white == "a" && pairs[0].black == "b") || (pairs[0].white == "b" && pairs[0].black == "a")),
+          "window widens with waiting time (re-enqueue keeps the wait)");
+    queue.enqueue("d", 1500, Variant::RUSSIAN, true, t0);
+    check(queue.pairUp(t0 + 60s, 10, everyone).empty(), "different rules are never paired");
+    queue.enqueue("e", 1510, Variant::RUSSIAN, false, t0);
+    check(queue.pairUp(t0, 10, [](const std::string& token) { return token != "c"; }).empty() &&
+              !queue.contains("c") && queue.contains("e"),
+          "ineligible players leave the queue");
+    check(queue.cancel("d") && !queue.cancel("d") && queue.size() == 1, "QUICK_MATCH_CANCEL");
+
+    // velká fronta: každý hráč nejvýš v jedné dvojici, rozdíl v okně
+    MatchQueue crowd;
+    std::mt19937 rng(40);
+    std::uniform_int_distribution<int> rating(800, 2200);
+    std::map<std::string, int> ratingOf;
+    for (int i = 0; i < 50000; ++i) {
+        std::string token = "p" + std::to_string(i);
+        ratingOf[token] = rating(rng);
+        crowd.enqueue(token, ratingOf[token], Variant::CZECH, false, t0);
+    }
+    auto crowdPairs = crowd.pairUp(t0, 1000000, everyone);
+    std::set<std::string> paired;
+    bool withinWindow = true;
+    for (const MatchPair& pair : crowdPairs) {
+        paired.insert(pair.white);
+        paired.insert(pair.black);
+        withinWindow = withinWindow && std::abs(ratingOf[pair.white] - ratingOf[pair.black]) <= MATCH_WINDOW_BASE;
+    }
+    check(withinWindow && paired.size() == 2 * crowdPairs.size() && crowd.size() + paired.size() == 50000 &&
+              crowdPairs.size() > 24000,
+          "large pool pairing: " + std::to_string(crowdPairs.size()) + " pairs");
+    MatchQueue full;
+    for (int i = 0; i < 20; ++i) full.enqueue("q" + std::to_string(i), 1500, Variant::CZECH, false, t0);
+    check(full.pairUp(t0, 5, everyone).size() == 5 && full.size() == 10, "pairing stops at the number of free rooms");
+}
+
+void testAccountStore() {
+    char pathTemplate[] = "/tmp/dama_accounts_XXXXXX";
+    int tmpFd = mkstemp(pathTemplate);
+    check(tmpFd >= 0, "cannot create temporary account file");
+    if (tmpFd >= 0) close(tmpFd);
+    const std::string path = pathTemplate;
+    std::remove(path.c_str());
+    std::string error;
+
+    {
+        KvStore kv;
+        check(kv.open(path, error), "key-value store did not open: " + error);
+        kv.put("a", "1");
+        kv.put("b", "2");
+        kv.put("a", "3");
+        check(kv.erase("b") && !kv.erase("b") && *kv.get("a") == "3" && !kv.get("b"), "key-value put and erase");
+    }
+    {
+        KvStore kv;
+        check(kv.open(path, error) && kv.size() == 1 && *kv.get("a") == "3", "key-value store after reopen");
+    }
+    // pád uprostřed zápisu: useknutý poslední záznam se zahodí
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out.write("\x12\x34\x56\x78\x01\x05\x00", 7);
+    }
+    {
+        KvStore kv;
+        check(kv.open(path, error) && kv.size() == 1, "torn record not dropped: " + error);
+        kv.put("c", "4");
+    }
+    {
+        KvStore kv;
+        check(kv.open(path, error) && kv.size() == 2 && *kv.get("c") == "4", "write after a torn record");
+        std::string big(1000, 'x');
+        for (int i = 0; i < 3000; ++i) kv.put("hot", big + std::to_string(i));
+        kv.flush();
+        check(kv.compactions() > 0 && kv.fileBytes() < 2 * KV_COMPACT_MIN_BYTES, "key-value compaction");
+    }
+    {
+        KvStore kv;
+        check(kv.open(path, error) && kv.size() == 3 && *kv.get("hot") == std::string(1000, 'x') + "2999" &&
+                  *kv.get("a") == "3",
+              "key-value store after compaction");
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        check(static_cast<std::uint64_t>(in.tellg()) == kv.fileBytes(), "compacted file size");
+    }
+    std::remove(path.c_str());
+
+    // účty a hodnocení přežijí restart
+    std::uint64_t aliceId = 0;
+    {
+        auto accounts = AccountStore::open(path, error);
+        check(accounts != nullptr, "account store did not open: " + error);
+        if (!accounts) return;
+        aliceId = accounts->login("alice", 1000).id;
+        check(accounts->login("bob", 2000).id == aliceId + 1 && accounts->login("alice", 3000).id == aliceId,
+              "account ids");
+        RatingTable ratings;
+        ratings.attach(accounts.get());
+        Room room;
+        room.whiteNick = "alice";
+        room.blackNick = "bob";
+        ratings.gameFinished(room, "WHITE_WIN_NO_PIECES", "WHITE");
+    }
+    auto accounts = AccountStore::open(path, error);
+    check(accounts && accounts->size() == 2, "account store after restart: " + error);
+    if (!accounts) return;
+    auto alice = accounts->find("alice");
+    auto bob = accounts->find("bob");
+    check(alice && alice->id == aliceId && alice->logins == 2 && alice->createdMs == 1000 &&
+              alice->lastLoginMs == 3000 && alice->rating.rating == 1520 && alice->rating.wins == 1,
+          "alice's account after restart");
+    check(bob && bob->rating.rating == 1480 && bob->rating.losses == 1 && bob->rating.games == 1,
+          "bob's account after restart");
+    check(accounts->login("carol", 4000).id == aliceId + 2, "account ids continue after restart");
+    accounts.reset();
+    std::remove(path.c_str());
+}
+
+void testRoomDeadlines() {
+    using namespace std::chrono_literals;
+    auto t0 = std::chrono::steady_clock::time_point{} + 1h;
+    clearRoomDeadlines();
+    check(!nextRoomDeadline(), "no deadlines");
+    armRoomDeadline(3, t0 + 300ms);
+    armRoomDeadline(1, t0 + 100ms);
+    armRoomDeadline(2, t0 + 200ms);
+    check(nextRoomDeadline() == t0 + 100ms, "earliest deadline first");
+    armRoomDeadline(1, t0 + 250ms); // posunutý termín stolu 1 nahradí starý
+    check(nextRoomDeadline() == t0 + 200ms, "replaced deadline is not the next one");
+    check(takeDueRoomDeadlines(t0 + 199ms).empty(), "nothing due before the deadline");
+    check(takeDueRoomDeadlines(t0 + 250ms) == std::vector<int>({2, 1}) && nextRoomDeadline() == t0 + 300ms,
+          "due deadlines in time order, each room once");
+    cancelRoomDeadline(3);
+    check(!nextRoomDeadline(), "cancelled deadline dropped");
+
+    // partie s hodinami přesouvá termín každým tahem: halda nepřeroste počet stolů
+    for (int move = 0; move < 10000; ++move) {
+        for (int room = 1; room <= 4; ++room) armRoomDeadline(room, t0 + 1s + std::chrono::milliseconds(move));
+    }
+    check(pendingRoomDeadlines() <= 2 * 4 + 64 + 1 && nextRoomDeadline() == t0 + 1s + 9999ms &&
+          takeDueRoomDeadlines(t0 + 1h) == std::vector<int>({1, 2, 3, 4}),
+          "moved deadlines do not pile up");
+    armRoomDeadline(5, t0);
+    clearRoomDeadlines();
+    check(!nextRoomDeadline() && pendingRoomDeadlines() == 0, "deadlines cleared");
+}
+
+// Server řízený ručními hodinami; odpovědi se ukládají po adresátech
+struct ManualClock : Clock {
+    std::chrono::steady_clock::time_point t = std::chrono::steady_clock::time_point{} + std::chrono::hours(1);
+    std::chrono::steady_clock::time_point now() const override { return t; }
+    std::chrono::system_clock::time_point wallNow() const override {
+        return std::chrono::system_clock::time_point{} + std::chrono::hours(24 * 365 * 50) + (t.time_since_epoch());
+    }
+};
+
+struct ReplyRecorder : Transport {
+    std::vector<std::pair<std::string, std::string>> sent; // adresát, zpráva
+    void send(int, const std::string& data, const sockaddr_storage& addr, socklen_t) override {
+        sent.emplace_back(addrToKey(addr), data);
+    }
+    bool anyContains(const std::string& part) const {
+        return std::any_of(sent.begin(), sent.end(), [&](const auto& s) { return s.second.find(part) != std::string::npos; });
+    }
+};
+
+void testChessClock() {
+    using namespace std::chrono_literals;
+    ManualClock clock;
+    ReplyRecorder replies;
+    setServerClock(&clock);
+    setServerTransport(&replies);
+    setEgressMtu(0);
+    clearRoomDeadlines();
+    {
+        ServerState server;
+        server.config.timeoutMs = 5000;
+        server.config.turnTimeoutMs = 10000; // u stolu s hodinami neplatí
+        server.config.reconnectWindowMs = 300000;
+        sockaddr_storage white{};
+        sockaddr_storage black{};
+        parseAddress("10.0.0.1", 4000, white);
+        parseAddress("10.0.0.2", 4000, black);
+        auto send = [&](const sockaddr_storage& from, const std::string& line) {
+            processDatagram(server, line.data(), line.size(), from, addrLength(from));
+        };
+        // ms kroků po sekundě: PING od vybraných hráčů, pak processIdle a termíny
+        auto wait = [&](long long ms, bool whitePings, bool blackPings) {
+            for (; ms > 0; ms -= 1000) {
+                clock.t += std::chrono::milliseconds(std::min(ms, 1000LL));
+                if (whitePings) send(white, "9;PING");
+                if (blackPings) send(black, "9;PING");
+                processIdle(server);
+            }
+        };
+        send(white, "1;LOGIN;clockwhite");
+        send(black, "1;LOGIN;clockblack");
+        send(white, "2;CREATE_ROOM;fischer;clockMs=60000;incrementMs=2000");
+        send(white, "3;JOIN_ROOM;1");
+        send(black, "3;JOIN_ROOM;1");
+        Room& room = server.rooms.at(1);
+        check(room.status == RoomStatus::IN_GAME && room.clockMs[0] == 60000 && room.flagAt == clock.t + 60000ms,
+              "clock starts with the game");
+
+        // Fischer: celý přídavek po každém tahu
+        wait(5000, true, true);
+        send(white, "4;MOVE;1;5;0;4;1");
+        check(room.clockMs[0] == 57000 && room.turn == Turn::PLAYER2 && room.flagAt == clock.t + 60000ms,
+              "fischer: 60000 - 5000 + 2000");
+
+        // limit tahu (turnTimeoutMs 10 s) u stolu s hodinami neplatí
+        wait(15000, true, true);
+        check(room.status == RoomStatus::IN_GAME && !replies.anyContains("TURN_TIMEOUT"),
+              "turnTimeoutMs ignored at a clocked table");
+        send(black, "4;MOVE;1;2;1;3;0");
+        check(room.clockMs[1] == 47000, "fischer: 60000 - 15000 + 2000");
+
+        // pauza (bílý přestal odpovídat) zmrazí hodiny, po RECONNECT běží dál od zbytku
+        wait(6000, false, true);
+        check(room.flagAt == std::chrono::steady_clock::time_point{} && room.turnUsedMs == 6000,
+              "pause freezes the clock");
+        wait(100000, false, true); // bez pauzy by bílému dávno došel čas
+        processDeadlines(server);
+        check(room.status == RoomStatus::IN_GAME && !replies.anyContains("GAME_END"), "no flag fall while paused");
+        std::string whiteToken;
+        for (const auto& [token, player] : server.players) {
+            if (player.nick == "clockwhite") whiteToken = token;
+        }
+        send(white, "5;RECONNECT;" + whiteToken);
+        check(room.flagAt == clock.t + 51000ms, "resume: 57000 - 6000 left");
+
+        // pád praporku přesně v termínu
+        wait(50000, true, true);
+        clock.t += 999ms;
+        processDeadlines(server);
+        check(room.status == RoomStatus::IN_GAME, "flag still up before the deadline");
+        clock.t += 1ms;
+        replies.sent.clear();
+        processDeadlines(server);
+        check(room.status == RoomStatus::WAITING && replies.sent.size() == 2 &&
+                  replies.anyContains("GAME_END;room=1;reason=FLAG_FALL;winner=BLACK"),
+              "flag fall ends the game");
+
+        // Bronstein: přídavek nejvýš spotřebovaný čas tahu
+        send(white, "6;CREATE_ROOM;bronstein;clockMs=60000;incrementMs=2000;bronstein=1");
+        int bronsteinId = server.nextRoomId - 1;
+        send(white, "7;JOIN_ROOM;" + std::to_string(bronsteinId));
+        send(black, "7;JOIN_ROOM;" + std::to_string(bronsteinId));
+        Room& capped = server.rooms.at(bronsteinId);
+        clock.t += 500ms;
+        send(white, "8;MOVE;" + std::to_string(bronsteinId) + ";5;0;4;1");
+        check(capped.clockMs[0] == 60000, "bronstein: increment capped at the 500 ms used");
+        wait(3000, true, true);
+        send(black, "8;MOVE;" + std::to_string(bronsteinId) + ";2;1;3;0");
+        check(capped.clockMs[1] == 59000, "bronstein: 60000 - 3000 + 2000");
+    }
+    clearRoomDeadlines();
+    setEgressMtu(DEFAULT_EGRESS_MTU);
+    setServerTransport(nullptr);
+    setServerClock(nullptr);
+}
+
+void testClockSync() {
+    ClockSync sync;
+    check(!sync.synced() && sync.rtoMs() == RTO_MAX_MS && sync.oneWayMs() == 0, "no samples: default timeout");
+
+    // hodiny klienta jdou o 5 s napřed; cesta tam 40 ms, zpět 20 ms, server drží PONG 1 ms
+    const std::int64_t skew = 5000;
+    std::int64_t server = 1700000000000LL;
+    check(!sync.completed(server, server + skew), "t3 without a PONG ignored");
+    for (int i = 0; i < 10; ++i) {
+        std::int64_t t0 = server + skew;
+        std::int64_t t1 = server + 40;
+        std::int64_t t2 = t1 + 1;
+        sync.ponged(t0, t1, t2);
+        check(sync.completed(t2, t2 + 20 + skew), "exchange completed");
+        server += 5000;
+    }
+    check(!sync.completed(server, server), "exchange completed once");
+    check(sync.samples == 10 && std::abs(sync.srttMs - 60) < 1e-9, "smoothed RTT");
+    check(sync.offsetMs == skew - 10, "offset off by half the path asymmetry");
+    check(sync.toClientMs(server) == server + skew - 10, "deadline in the client clock");
+    check(sync.oneWayMs() == 30 && sync.rtoMs() == RTO_MIN_MS, "steady RTT: minimal timeout");
+
+    // pomalejší výměna posun nezmění (bere se vzorek s nejmenším RTT), RTO vzroste
+    sync.ponged(server + skew, server + 900, server + 901);
+    check(sync.completed(server + 901, server + 1801 + skew), "slow exchange completed");
+    check(sync.offsetMs == skew - 10 && sync.rtoMs() > RTO_MIN_MS, "slow sample: same offset, longer timeout");
+}
+
+void testCluster() {
+    using namespace std::chrono_literals;
+
+    // konzistentní hashování: odchod uzlu přesune jen jeho id, příchod zhruba 1/N
+    const int keys = 20000;
+    std::vector<std::string> nodes = {"10.0.0.1:5000", "10.0.0.2:5000", "10.0.0.3:5000", "10.0.0.4:5000"};
+    HashRing four(nodes);
+    std::map<std::string, int> share;
+    for (int id = 1; id <= keys; ++id) ++share[four.ownerOfRoom(id)];
+    bool balanced = share.size() == 4;
+    for (const auto& [node, count] : share) balanced = balanced && count > keys / 8 && count < keys * 3 / 8;
+    check(balanced, "hash ring spreads rooms over all nodes");
+
+    HashRing three({nodes[0], nodes[1], nodes[3]});
+    std::vector<std::string> five = nodes;
+    five.push_back("10.0.0.5:5000");
+    HashRing joined(five);
+    int leftWrong = 0;
+    int moved = 0;
+    int movedElsewhere = 0;
+    for (int id = 1; id <= keys; ++id) {
+        const std::string& before = four.ownerOfRoom(id);
+        if (before != nodes[2] && three.ownerOfRoom(id) != before) ++leftWrong;
+        if (joined.ownerOfRoom(id) != before) {
+            ++moved;
+            if (joined.ownerOfRoom(id) != five.back()) ++movedElsewhere;
+        }
+    }
+    check(leftWrong == 0, "leaving node moves only its own rooms");
+    check(movedElsewhere == 0 && moved > keys / 10 && moved < keys * 3 / 10, "joining node takes about 1/N of the rooms");
+
+    // gossip v paměti se sdíleným tajemstvím: a zná jen b, c zná jen a; po pár kolech
+    // znají všichni všechny
+    auto t = std::chrono::steady_clock::time_point{} + 1h;
+    const std::string secret = "test-secret";
+    std::map<std::string, std::unique_ptr<Cluster>> cluster;
+    cluster["127.0.0.1:5001"] =
+        std::make_unique<Cluster>("127.0.0.1:5001", std::vector<std::string>{"127.0.0.1:5002"}, secret);
+    cluster["127.0.0.1:5002"] = std::make_unique<Cluster>("127.0.0.1:5002", std::vector<std::string>{}, secret);
+    cluster["127.0.0.1:5003"] =
+        std::make_unique<Cluster>("127.0.0.1:5003", std::vector<std::string>{"127.0.0.1:5001"}, secret);
+    // doručí gossip jako processDatagram (řádek bez \n, zdrojová adresa odesílatele)
+    auto deliver = [&](Cluster& to, const std::string& fromNode, std::string datagram) {
+        rtrim(datagram);
+        Message msg;
+        sockaddr_storage from{};
+        return parseMessage(datagram, msg) && parseNodeAddress(fromNode, from) && to.receive(datagram, msg, from, t);
+    };
+    std::string lastDatagram;
+    auto round = [&](const std::set<std::string>& down) {
+        t += std::chrono::milliseconds(CLUSTER_GOSSIP_MS);
+        for (auto& [self, node] : cluster) {
+            if (down.count(self)) continue;
+            for (const auto& [target, datagram] : node->tick(t)) {
+                lastDatagram = datagram;
+                if (!down.count(target) && cluster.count(target)) deliver(*cluster[target], self, datagram);
+            }
+        }
+    };
+    for (int i = 0; i < 6; ++i) round({});
+    bool converged = true;
+    for (const auto& [self, node] : cluster) converged = converged && node->aliveNodes().size() == 3;
+    check(converged, "gossip spreads membership");
+    int owned = 0;
+    for (int id = 1; id <= 300; ++id) {
+        int mine = 0;
+        for (const auto& [self, node] : cluster) mine += node->owns(id) ? 1 : 0;
+        owned += mine == 1 ? 1 : 0;
+    }
+    check(owned == 300, "every room id has exactly one owner");
+    check(cluster["127.0.0.1:5001"]->nextOwnedRoomId(1) >= 1 &&
+          cluster["127.0.0.1:5001"]->owns(cluster["127.0.0.1:5001"]->nextOwnedRoomId(1)), "next owned room id");
+
+    // výpadek c: ostatní ho po CLUSTER_FAIL_MS prohlásí za mrtvého
+    for (int i = 0; i < 2 * CLUSTER_FAIL_MS / CLUSTER_GOSSIP_MS; ++i) round({"127.0.0.1:5003"});
+    check(cluster["127.0.0.1:5001"]->aliveNodes().size() == 2 && cluster["127.0.0.1:5002"]->aliveNodes().size() == 2,
+          "silent node declared dead");
+    Cluster& a = *cluster["127.0.0.1:5001"];
+    check(!deliver(a, "127.0.0.1:5002", "0;GOSSIP;from=nowhere;hb=1"), "invalid gossip rejected");
+
+    // klient na herním portu nepřidá uzel: bez kódu, se změněným obsahem ani s jiným tajemstvím
+    std::uint64_t rejectedBefore = a.rejectedGossip();
+    check(!deliver(a, "10.9.9.9:4000", "0;GOSSIP;from=10.9.9.9:4000;hb=99;members="), "gossip without mac rejected");
+    std::string forged = lastDatagram;
+    auto hbAt = forged.find(";hb=") + 4;
+    forged.insert(hbAt, "9");
+    check(lastDatagram.find(";mac=") != std::string::npos && !deliver(a, "127.0.0.1:5002", forged),
+          "gossip with a tampered body rejected");
+    Cluster stranger("10.9.9.9:4000", {"127.0.0.1:5001"}, "other-secret");
+    std::string strangerGossip = stranger.tick(t).front().second;
+    check(!deliver(a, "10.9.9.9:4000", strangerGossip) && a.aliveNodes().size() == 2 &&
+              a.rejectedGossip() == rejectedBefore + 3,
+          "gossip signed with another secret rejected");
+
+    // bez tajemství jen ze zdrojové adresy startovního uzlu nebo známého člena
+    Cluster open("127.0.0.1:6001", {"127.0.0.1:6002"});
+    Cluster seed("127.0.0.1:6002", {"127.0.0.1:6001"});
+    std::string seedGossip = seed.tick(t).front().second;
+    check(deliver(open, "127.0.0.1:6002", seedGossip) && open.aliveNodes().size() == 2, "gossip from a seed accepted");
+    Cluster intruder("127.0.0.1:6003", {"127.0.0.1:6001"});
+    check(!deliver(open, "127.0.0.1:6003", intruder.tick(t).front().second) &&
+              !deliver(open, "127.0.0.1:6003", seedGossip) && open.aliveNodes().size() == 2,
+          "gossip from an unknown source rejected");
+}
+
+// Pět uzlů s dlouhými IPv6 adresami: GOSSIP přesáhne 256 znaků zpráv klientů, přesto ho
+// processDatagram přijme bez odpovědi a členství se rozšíří
+void testClusterIpv6Gossip() {
+    ManualClock clock;
+    ReplyRecorder replies;
+    setServerClock(&clock);
+    setServerTransport(&replies);
+    setEgressMtu(0);
+    {
+        const std::string secret = "test-secret";
+        std::vector<std::string> nodes;
+        for (int i = 1; i <= 5; ++i) {
+            nodes.push_back("[2001:db8:aaaa:bbbb:cccc:dddd:eeee:" + std::to_string(1000 + i) + "]:5000" + std::to_string(i));
+        }
+        ServerState server;
+        server.sockFamily = AF_INET6;
+        server.cluster = std::make_unique<Cluster>(nodes[0], std::vector<std::string>{}, secret);
+        std::map<std::string, std::unique_ptr<Cluster>> others;
+        for (std::size_t i = 1; i < nodes.size(); ++i) {
+            others[nodes[i]] = std::make_unique<Cluster>(nodes[i], std::vector<std::string>{nodes[0]}, secret);
+        }
+        std::size_t longest = 0;
+        bool allFit = true;
+        auto deliver = [&](const std::string& fromNode, const std::string& target, std::string datagram) {
+            longest = std::max(longest, datagram.size());
+            allFit = allFit && datagram.size() <= CLUSTER_GOSSIP_BYTES;
+            sockaddr_storage from{};
+            if (!parseNodeAddress(fromNode, from)) return;
+            if (target == nodes[0]) {
+                processDatagram(server, datagram.data(), datagram.size(), from, addrLength(from));
+                return;
+            }
+            rtrim(datagram);
+            Message msg;
+            if (others.count(target) && parseMessage(datagram, msg)) others[target]->receive(datagram, msg, from, clock.t);
+        };
+        for (int round = 0; round < 8; ++round) {
+            clock.t += std::chrono::milliseconds(CLUSTER_GOSSIP_MS);
+            for (const auto& [target, datagram] : server.cluster->tick(clock.t)) deliver(nodes[0], target, datagram);
+            for (auto& [self, node] : others) {
+                for (const auto& [target, datagram] : node->tick(clock.t)) deliver(self, target, datagram);
+            }
+        }
+        check(longest > 256 && allFit, "IPv6 gossip longer than a client message, within CLUSTER_GOSSIP_BYTES");
+        bool converged = server.cluster->aliveNodes().size() == nodes.size();
+        for (const auto& [self, node] : others) converged = converged && node->aliveNodes().size() == nodes.size();
+        check(converged && server.cluster->rejectedGossip() == 0, "IPv6 gossip spreads membership");
+        check(replies.sent.empty(), "accepted gossip gets no reply");
+    }
+    setEgressMtu(DEFAULT_EGRESS_MTU);
+    setServerTransport(nullptr);
+    setServerClock(nullptr);
+}
+
+void testLatencyHistogram() {
+    LatencyHistogram h;
+    check(h.percentile(0.99) == 0, "empty histogram");
+    bool bounds = true;
+    for (std::int64_t us : {0LL, 1LL, 15LL, 16LL, 17LL, 100LL, 1000LL, 123456LL, 9999999LL}) {
+        std::int64_t upper = LatencyHistogram::bucketUpperUs(LatencyHistogram::bucketOf(us));
+        bounds = bounds && upper >= us && upper <= us + us / 8;
+    }
+    check(bounds, "latency buckets within 12.5%");
+    for (int i = 0; i < 990; ++i) h.record(100);
+    for (int i = 0; i < 10; ++i) h.record(50000);
+    check(h.percentile(0.99) >= 100 && h.percentile(0.99) < 113, "p99 below the slow tail");
+    h.record(50000);
+    check(h.percentile(0.99) >= 50000 && h.percentile(0.99) < 56250, "p99 in the slow tail");
+    h.clear();
+    check(h.count() == 0 && h.percentile(0.5) == 0, "histogram cleared");
+}
+
+void testEndpoints() {
+    // IPv4 a IPv4 mapovaná do IPv6 (z dual-stack socketu) jsou tentýž klient
+    sockaddr_storage v4{};
+    sockaddr_storage mapped{};
+    sockaddr_storage v6{};
+    check(parseAddress("10.0.0.1", 5000, v4) && parseAddress("::ffff:10.0.0.1", 5000, mapped) &&
+          parseAddress("2001:db8::1", 5000, v6) && !parseAddress("10.0.0.256", 5000, v4) && parseAddress("10.0.0.1", 5000, v4),
+          "parse addresses");
+    check(v4.ss_family == AF_INET && v6.ss_family == AF_INET6, "address families");
+    check(endpointKey(v4) == endpointKey(mapped) && !(endpointKey(v4) == endpointKey(v6)), "mapped IPv4 endpoint");
+    check(EndpointKeyHash{}(endpointKey(v4)) == EndpointKeyHash{}(endpointKey(mapped)), "mapped IPv4 hash");
+    check(addrToKey(v4) == "10.0.0.1:5000" && addrToKey(mapped) == "10.0.0.1:5000" && addrToKey(v6) == "[2001:db8::1]:5000",
+          "endpoint text");
+    check(endpointAddress(endpointKey(mapped)).ss_family == AF_INET && addrToKey(endpointAddress(endpointKey(v6))) == addrToKey(v6),
+          "endpoint round trip");
+
+    sockaddr_storage node{};
+    check(nodeAddress("::1", 6001) == "[::1]:6001" && parseNodeAddress("[::1]:6001", node) && addrHost(node) == "::1",
+          "IPv6 node address");
+    check(!parseNodeAddress("::1:6001", node) && !parseNodeAddress("[10.0.0.1]:6001", node), "bad node address");
+
+    // link-local na dvou rozhraních: různé klíče, scope v textu i zpět v adrese
+    sockaddr_storage lo2{};
+    sockaddr_storage lo3{};
+    check(parseAddress("fe80::1%2", 5000, lo2) && parseAddress("fe80::1%3", 5000, lo3) &&
+          !parseAddress("fe80::1%", 5000, lo3) && parseAddress("fe80::1%3", 5000, lo3),
+          "parse scoped addresses");
+    check(!(endpointKey(lo2) == endpointKey(lo3)) && EndpointKeyHash{}(endpointKey(lo2)) != EndpointKeyHash{}(endpointKey(lo3)),
+          "scope is part of the endpoint key");
+    sockaddr_storage back = endpointAddress(endpointKey(lo2));
+    check(addrToKey(lo2) == "[fe80::1%2]:5000" && reinterpret_cast<const sockaddr_in6&>(back).sin6_scope_id == 2,
+          "scoped endpoint text and round trip");
+    check(parseNodeAddress("[fe80::1%2]:5000", node) && endpointKey(node) == endpointKey(lo2), "scoped node address");
+}
+
+void testEgressCoalescing() {
+    struct Recorder : Transport {
+        std::vector<std::pair<std::string, std::string>> sent; // adresát, datagram
+        void send(int, const std::string& data, const sockaddr_storage& addr, socklen_t) override {
+            sent.emplace_back(addrToKey(addr), data);
+        }
+    } recorder;
+    setServerTransport(&recorder);
+    setEgressMtu(64);
+    sockaddr_storage a{};
+    sockaddr_storage b{};
+    parseAddress("10.0.0.1", 5000, a);
+    parseAddress("2001:db8::1", 5000, b);
+    sendDatagram(3, "1;JOIN_ROOM_OK;room=1\n", a, addrLength(a));
+    sendDatagram(3, "0;GAME_START;room=1\n", b, addrLength(b));
+    sendDatagram(3, "0;GAME_START;room=1\n", a, addrLength(a));
+    check(recorder.sent.empty(), "messages wait for the end of the iteration");
+    sendDatagram(3, "0;GAME_STATE;room=1;turn=WHITE;board=................\n", a, addrLength(a));
+    check(recorder.sent.size() == 1 && recorder.sent[0].second == "1;JOIN_ROOM_OK;room=1\n0;GAME_START;room=1\n",
+          "full datagram leaves before the MTU is exceeded");
+    flushDatagrams();
+    check(recorder.sent.size() == 3 && recorder.sent[1].first == "10.0.0.1:5000" &&
+          recorder.sent[1].second.rfind("0;GAME_STATE;", 0) == 0 && recorder.sent[2].first == "[2001:db8::1]:5000",
+          "flush sends one datagram per endpoint");
+    std::string big(100, 'x');
+    sendDatagram(3, big + "\n", a, addrLength(a));
+    flushDatagrams();
+    flushDatagrams();
+    check(recorder.sent.size() == 4 && recorder.sent[3].second.size() == 101, "oversized message sent alone");
+    // broadcast mnoha adresátům dvakrát za sebou: jeden datagram na adresáta v pořadí prvních zpráv
+    std::vector<sockaddr_storage> crowd(500);
+    for (std::size_t i = 0; i < crowd.size(); ++i) {
+        parseAddress("10.1." + std::to_string(i / 250) + "." + std::to_string(i % 250), 5000, crowd[i]);
+    }
+    for (const char* msg : {"0;GAME_STATE;room=2\n", "0;GAME_END;room=2\n"}) {
+        for (const auto& to : crowd) sendDatagram(3, msg, to, addrLength(to));
+    }
+    flushDatagrams();
+    bool perEndpoint = recorder.sent.size() == 4 + crowd.size();
+    for (std::size_t i = 0; perEndpoint && i < crowd.size(); ++i) {
+        const auto& [to, datagram] = recorder.sent[4 + i];
+        perEndpoint = to == addrToKey(crowd[i]) && datagram == "0;GAME_STATE;room=2\n0;GAME_END;room=2\n";
+    }
+    check(perEndpoint, "broadcast coalesced per endpoint in first-send order");
+    recorder.sent.resize(4);
+    setEgressMtu(0);
+    sendDatagram(3, "0;PONG\n", a, addrLength(a));
+    check(recorder.sent.size() == 5, "mtu 0 sends immediately");
+    setEgressMtu(DEFAULT_EGRESS_MTU);
+    setServerTransport(nullptr);
+}
+
+void testSpscRing() {
+    SpscRing<int> ring(5);
+    check(ring.capacity() == 8 && ring.freeSlots() == 8 && ring.ready() == 0, "ring rounds capacity up");
+    for (int i = 0; i < 8; ++i) ring.freeAt(static_cast<std::size_t>(i)) = i;
+    ring.publish(8);
+    check(ring.freeSlots() == 0 && ring.ready() == 8 && ring.readyAt(7) == 7, "full ring");
+    ring.release(3);
+    check(ring.freeSlots(3) == 3 && ring.size() == 5, "released slots reusable");
+    ring.freeAt(0) = 8;
+    ring.publish();
+    check(ring.ready(6) == 6 && ring.readyAt(0) == 3 && ring.readyAt(5) == 8, "ring wraps around");
+
+    // dvě vlákna: pořadí zachované, nic se neztratí
+    SpscRing<std::uint64_t> queue(64);
+    const std::uint64_t items = 200000;
+    std::thread producer([&]() {
+        for (std::uint64_t i = 0; i < items;) {
+            std::size_t free = queue.freeSlots(16);
+            std::size_t batch = static_cast<std::size_t>(std::min<std::uint64_t>(free, items - i));
+            for (std::size_t k = 0; k < batch; ++k) queue.freeAt(k) = i + k;
+            queue.publish(batch);
+            i += batch;
+        }
+    });
+    std::uint64_t expected = 0;
+    bool ordered = true;
+    while (expected < items) {
+        std::size_t ready = queue.ready(16);
+        for (std::size_t k = 0; k < ready; ++k) ordered = ordered && queue.readyAt(k) == expected + k;
+        queue.release(ready);
+        expected += ready;
+    }
+    producer.join();
+    check(ordered && queue.size() == 0, "ring keeps order across threads");
+}
+
+struct PoolJob {
+    int roomId = 0;
+};
+
+struct PoolResult {
+    PoolJob job;
+    int worker = -1;
+};
+
+void testAffinityPool() {
+    // synchronní režim: spočítá se až v takeResults, nic se nepřiřazuje
+    AffinityPool<PoolJob, PoolResult> sync(0, [](const PoolJob& job, bool useTimeBudget, int worker) {
+        return PoolResult{job, useTimeBudget ? -1 : worker};
+    });
+    sync.submit({7});
+    sync.submit({8});
+    check(sync.backlog() == 2 && sync.workerOf(7) == -1, "sync affinity pool defers jobs");
+    auto syncResults = sync.takeResults();
+    check(syncResults.size() == 2 && syncResults[0].job.roomId == 7 && syncResults[1].worker == 0 && sync.backlog() == 0,
+          "sync affinity pool runs jobs in order");
+
+    // workery čekají na bránu, takže rozpracované úlohy jsou při přiřazování známé
+    std::atomic<bool> open{false};
+    AffinityPool<PoolJob, PoolResult> pool(2, [&open](const PoolJob& job, bool, int worker) {
+        while (!open.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return PoolResult{job, worker};
+    });
+    auto collect = [&pool](std::size_t count) {
+        std::vector<PoolResult> out;
+        for (int spins = 0; out.size() < count && spins < 5000; ++spins) {
+            for (auto& result : pool.takeResults()) out.push_back(result);
+            if (out.size() < count) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return out;
+    };
+
+    for (int room = 1; room <= 6; ++room) pool.submit({room});
+    check(pool.workerOf(1) == 0 && pool.workerOf(3) == 0 && pool.workerOf(5) == 0 && pool.workerOf(2) == 1 &&
+              pool.workerOf(4) == 1 && pool.workerOf(6) == 1,
+          "new rooms go to the least loaded worker");
+    open = true;
+    auto results = collect(6);
+    bool affine = results.size() == 6;
+    for (const auto& result : results) affine = affine && result.worker == (result.job.roomId % 2 == 1 ? 0 : 1);
+    check(affine && pool.backlog() == 0 && pool.migrations() == 0, "jobs run on the room's worker");
+
+    // všechny tři stoly workeru 0 naráz: třetí se přestěhuje k nečinnému workeru 1
+    open = false;
+    pool.submit({1});
+    pool.submit({3});
+    check(pool.migrations() == 0 && pool.workerOf(3) == 0, "small imbalance keeps the room");
+    pool.submit({5});
+    check(pool.migrations() == 1 && pool.workerOf(5) == 1, "room migrates to the idle worker");
+    open = true;
+    results = collect(3);
+    bool migrated = results.size() == 3;
+    for (const auto& result : results) migrated = migrated && result.worker == (result.job.roomId == 5 ? 1 : 0);
+    auto stats = pool.workerStats();
+    check(migrated && pool.backlog() == 0 && stats.size() == 2 && stats[0].jobs == 5 && stats[1].jobs == 4 &&
+              stats[1].rooms == 4 && stats[1].migratedIn == 1 && stats[0].inFlight == 0,
+          "migrated room runs on its new worker");
+}
+
+void testTournament() {
+    using namespace std::chrono_literals;
+    auto t0 = std::chrono::steady_clock::time_point{} + 1h;
+
+    // každý s každým, lichý počet: každá dvojice právě jednou, každý jedno volno
+    Tournament roundRobin;
+    roundRobin.format = TournamentFormat::ROUND_ROBIN;
+    for (int i = 0; i < 7; ++i) roundRobin.addEntrant("rr" + std::to_string(i), 1500);
+    check(roundRobin.addEntrant("rr3", 1500) == 3 && roundRobin.entrants.size() == 7, "repeated join keeps the entrant");
+    std::map<std::pair<int, int>, int> meetings;
+    int byes = 0;
+    while (roundRobin.startNextRound(t0)) {
+        for (std::size_t b = 0; b < roundRobin.boards.size(); ++b) {
+            const TournamentBoard& board = roundRobin.boards[b];
+            if (board.black < 0) {
+                ++byes;
+                continue;
+            }
+            ++meetings[{std::min(board.white, board.black), std::max(board.white, board.black)}];
+            roundRobin.recordResult(b, 1, 0);
+        }
+        check(roundRobin.roundComplete(), "round robin round complete");
+    }
+    bool onceEach = meetings.size() == 21;
+    for (const auto& [pair, count] : meetings) onceEach = onceEach && count == 1;
+    check(onceEach && byes == 7 && roundRobin.round == 7 && roundRobin.status == TournamentStatus::FINISHED,
+          "round robin of 7: every pair once, one bye each");
+
+    // Buchholz a Sonneborn–Berger: t0 vyhraje všechno, ostatní spolu remizují
+    Tournament small;
+    small.format = TournamentFormat::ROUND_ROBIN;
+    for (int i = 0; i < 4; ++i) small.addEntrant("t" + std::to_string(i), 1500 - i);
+    while (small.startNextRound(t0)) {
+        for (std::size_t b = 0; b < small.boards.size(); ++b) {
+            const TournamentBoard& board = small.boards[b];
+            if (board.white == 0 || board.black == 0) {
+                small.recordResult(b, board.white == 0 ? 1 : 0, board.black == 0 ? 1 : 0);
+            } else {
+                small.recordResult(b, 0.5, 0.5);
+            }
+        }
+    }
+    auto smallStandings = small.standings();
+    check(smallStandings[0].entrant == 0 && smallStandings[0].score == 3 && smallStandings[0].buchholz == 3 &&
+              smallStandings[0].sonnebornBerger == 3 && smallStandings[1].entrant == 1 &&
+              smallStandings[1].buchholz == 5 && smallStandings[1].sonnebornBerger == 1,
+          "Buchholz and Sonneborn-Berger");
+
+    // výsledek partie u turnajového stolu přes GameRecorder
+    TournamentSet set;
+    Tournament& duel = set.byId[1];
+    duel.id = 1;
+    duel.addEntrant("white", 1500);
+    duel.addEntrant("black", 1500);
+    duel.startNextRound(t0);
+    set.bindRoom(9, 1, 0);
+    Room room;
+    room.id = 9;
+    set.gameFinished(room, "DRAW_REPETITION", "NONE");
+    set.gameFinished(room, "WHITE_WIN_NO_PIECES", "WHITE");
+    check(duel.roundComplete() && duel.entrants[0].score == 0.5 && duel.entrants[1].score == 0.5,
+          "tournament result from GAME_END (room bound once)");
+
+    // švýcarský systém pro 2000 hráčů: všichni spárovaní, žádné opakované setkání a párování
+    // prochází kandidáty lineárně (ne každý s každým)
+    Tournament swiss;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> rating(800, 2200);
+    for (int i = 0; i < 2001; ++i) swiss.addEntrant("s" + std::to_string(i), rating(rng));
+    std::uniform_int_distribution<int> outcome(0, 2);
+    bool everyonePaired = true;
+    std::uint64_t mostSteps = 0;
+    for (;;) {
+        if (!swiss.startNextRound(t0)) break;
+        mostSteps = std::max(mostSteps, swiss.pairingSteps);
+        std::vector<int> seen(swiss.entrants.size(), 0);
+        for (std::size_t b = 0; b < swiss.boards.size(); ++b) {
+            const TournamentBoard& board = swiss.boards[b];
+            ++seen[static_cast<std::size_t>(board.white)];
+            if (board.black < 0) continue;
+            ++seen[static_cast<std::size_t>(board.black)];
+            int o = outcome(rng);
+            swiss.recordResult(b, o == 0 ? 1 : o == 1 ? 0.5 : 0, o == 0 ? 0 : o == 1 ? 0.5 : 1);
+        }
+        everyonePaired = everyonePaired && swiss.roundComplete() &&
+                         std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; });
+    }
+    int byeCount = 0;
+    for (const TournamentEntrant& e : swiss.entrants) byeCount += e.hadBye ? 1 : 0;
+    check(swiss.rounds == 11 && swiss.round == 11 && everyonePaired && byeCount == 11,
+          "swiss: 11 rounds, everyone on exactly one board, one bye per round to different players");
+    check(swiss.rematches == 0, "swiss: no rematches (" + std::to_string(swiss.rematches) + ")");
+    check(mostSteps > 0 && mostSteps <= 4 * swiss.entrants.size(),
+          "swiss pairing of 2001 players: " + std::to_string(mostSteps) + " candidate steps");
+}
+
+int main() {
+    testIncrementalHash();
+    testHashComponents();
+    testDrawRepetition();
+    testDrawNoProgress();
+    testMaterialCounts();
+    testChainsReplayable();
+    testMaxCapture();
+    testVariantSetup();
+    testBackwardManCapture();
+    testItalianRules();
+    testPromotionDuringCapture();
+    testRayTablesMatchReference();
+    testAllocationFree();
+    testTranspositionSearch();
+    testTablebase();
+    testOpeningBook();
+    testGameArchive();
+    testMatchmaking();
+    testAccountStore();
+    testTournament();
+    testRoomDeadlines();
+    testChessClock();
+    testClockSync();
+    testCluster();
+    testClusterIpv6Gossip();
+    testLatencyHistogram();
+    testEndpoints();
+    testEgressCoalescing();
+    testSpscRing();
+    testAffinityPool();
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "rules_test OK" << std::endl;
+    return 0;
+}